@@ -112,7 +112,38 @@ auto Binder::BindCreate(duckdb_libpgquery::PGCreateStmt *pg_stmt) -> std::unique
     throw bustub::Exception("should have at least 1 column");
   }
 
-  return std::make_unique<CreateStatement>(std::move(table), std::move(columns));
+  auto layout = TableLayout::Row;
+  auto encoding = TableEncoding::Plain;
+  if (pg_stmt->options != nullptr) {
+    for (auto cell = pg_stmt->options->head; cell != nullptr; cell = cell->next) {
+      auto option = reinterpret_cast<duckdb_libpgquery::PGDefElem *>(cell->data.ptr_value);
+      if (strcmp(option->defname, "layout") == 0) {
+        if (option->arg == nullptr || option->arg->type != duckdb_libpgquery::T_PGString) {
+          throw bustub::Exception("layout expects 'row' or 'pax', e.g. layout = 'pax'");
+        }
+        auto name = StringUtil::Lower(reinterpret_cast<duckdb_libpgquery::PGValue *>(option->arg)->val.str);
+        if (name == "pax") {
+          layout = TableLayout::PAX;
+        } else if (name != "row") {
+          throw NotImplementedException(fmt::format("unsupported table layout: {}", name));
+        }
+      } else if (strcmp(option->defname, "encoding") == 0) {
+        if (option->arg == nullptr || option->arg->type != duckdb_libpgquery::T_PGString) {
+          throw bustub::Exception("encoding expects 'plain' or 'dictionary', e.g. encoding = 'dictionary'");
+        }
+        auto name = StringUtil::Lower(reinterpret_cast<duckdb_libpgquery::PGValue *>(option->arg)->val.str);
+        if (name == "dictionary") {
+          encoding = TableEncoding::Dictionary;
+        } else if (name != "plain") {
+          throw NotImplementedException(fmt::format("unsupported table encoding: {}", name));
+        }
+      } else {
+        throw NotImplementedException(fmt::format("unsupported table option: {}", option->defname));
+      }
+    }
+  }
+
+  return std::make_unique<CreateStatement>(std::move(table), std::move(columns), layout, encoding);
 }
 
 auto Binder::BindIndex(duckdb_libpgquery::PGIndexStmt *stmt) -> std::unique_ptr<IndexStatement> {
@@ -129,7 +160,39 @@ auto Binder::BindIndex(duckdb_libpgquery::PGIndexStmt *stmt) -> std::unique_ptr<
     }
   }
 
-  return std::make_unique<IndexStatement>(stmt->idxname, std::move(table), std::move(cols));
+  // the parser has no INCLUDE clause, covering columns are given as WITH (include = 'col, ...')
+  std::vector<std::unique_ptr<BoundColumnRef>> include_cols;
+  if (stmt->options != nullptr) {
+    for (auto cell = stmt->options->head; cell != nullptr; cell = cell->next) {
+      auto option = reinterpret_cast<duckdb_libpgquery::PGDefElem *>(cell->data.ptr_value);
+      if (strcmp(option->defname, "include") != 0) {
+        throw NotImplementedException(fmt::format("unsupported index option: {}", option->defname));
+      }
+      if (option->arg == nullptr || option->arg->type != duckdb_libpgquery::T_PGString) {
+        throw bustub::Exception("include expects a comma-separated list of columns, e.g. include = 'v1, v2'");
+      }
+      auto names = StringUtil::Split(reinterpret_cast<duckdb_libpgquery::PGValue *>(option->arg)->val.str, ',');
+      for (const auto &name : names) {
+        auto column_ref = ResolveColumn(*table, std::vector{StringUtil::Strip(name, ' ')});
+        include_cols.emplace_back(std::make_unique<BoundColumnRef>(dynamic_cast<const BoundColumnRef &>(*column_ref)));
+      }
+    }
+  }
+
+  // 没写USING时解析器给的是默认的"btree"(见pg_definitions.hpp的DEFAULT_INDEX_TYPE)
+  auto index_type = IndexType::BPlusTreeIndex;
+  if (stmt->accessMethod != nullptr && strcmp(stmt->accessMethod, "hash") == 0) {
+    index_type = IndexType::HashTableIndex;
+  } else if (stmt->accessMethod != nullptr && strcmp(stmt->accessMethod, "buffered") == 0) {
+    index_type = IndexType::BufferedBPlusTreeIndex;
+  } else if (stmt->accessMethod != nullptr && strcmp(stmt->accessMethod, "art") == 0) {
+    index_type = IndexType::ARTIndex;
+  } else if (stmt->accessMethod != nullptr && strcmp(stmt->accessMethod, "btree") != 0) {
+    throw NotImplementedException(fmt::format("unsupported index type: {}", stmt->accessMethod));
+  }
+
+  return std::make_unique<IndexStatement>(stmt->idxname, std::move(table), std::move(cols), stmt->unique,
+                                          std::move(include_cols), index_type);
 }
 
 }  // namespace bustub
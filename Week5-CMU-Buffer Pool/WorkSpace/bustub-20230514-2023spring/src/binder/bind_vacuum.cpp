@@ -0,0 +1,31 @@
+#include <memory>
+
+#include "binder/binder.h"
+#include "binder/statement/analyze_statement.h"
+#include "binder/statement/vacuum_statement.h"
+#include "binder/table_ref/bound_base_table_ref.h"
+#include "common/exception.h"
+#include "nodes/parsenodes.hpp"
+
+namespace bustub {
+
+auto Binder::BindVacuum(duckdb_libpgquery::PGVacuumStmt *stmt) -> std::unique_ptr<BoundStatement> {
+  // ANALYZE和VACUUM在parser里是同一种语句,用options区分
+  bool vacuum = (stmt->options & duckdb_libpgquery::PG_VACOPT_VACUUM) != 0;
+  if (vacuum && (stmt->options & duckdb_libpgquery::PG_VACOPT_ANALYZE) != 0) {
+    throw NotImplementedException("VACUUM ANALYZE is not supported, run VACUUM and ANALYZE separately");
+  }
+  if (stmt->va_cols != nullptr) {
+    throw NotImplementedException("VACUUM or ANALYZE on a column list is not supported");
+  }
+  std::unique_ptr<BoundBaseTableRef> table = nullptr;
+  if (stmt->relation != nullptr) {
+    table = BindBaseTableRef(stmt->relation->relname, std::nullopt);
+  }
+  if (vacuum) {
+    return std::make_unique<VacuumStatement>(std::move(table));
+  }
+  return std::make_unique<AnalyzeStatement>(std::move(table));
+}
+
+}  // namespace bustub
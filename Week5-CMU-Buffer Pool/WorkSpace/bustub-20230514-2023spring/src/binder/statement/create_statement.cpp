@@ -5,11 +5,23 @@
 
 namespace bustub {
 
-CreateStatement::CreateStatement(std::string table, std::vector<Column> columns)
-    : BoundStatement(StatementType::CREATE_STATEMENT), table_(std::move(table)), columns_(std::move(columns)) {}
+CreateStatement::CreateStatement(std::string table, std::vector<Column> columns, TableLayout layout,
+                                 TableEncoding encoding)
+    : BoundStatement(StatementType::CREATE_STATEMENT),
+      table_(std::move(table)),
+      columns_(std::move(columns)),
+      layout_(layout),
+      encoding_(encoding) {}
 
 auto CreateStatement::ToString() const -> std::string {
-  return fmt::format("BoundCreate {{\n  table={}\n  columns={}\n}}", table_, columns_);
+  std::string options;
+  if (layout_ == TableLayout::PAX) {
+    options += "  layout=pax\n";
+  }
+  if (encoding_ == TableEncoding::Dictionary) {
+    options += "  encoding=dictionary\n";
+  }
+  return fmt::format("BoundCreate {{\n  table={}\n  columns={}\n{}}}", table_, columns_, options);
 }
 
 }  // namespace bustub
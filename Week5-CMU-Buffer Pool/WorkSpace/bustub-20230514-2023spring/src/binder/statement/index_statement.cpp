@@ -7,14 +7,27 @@
 namespace bustub {
 
 IndexStatement::IndexStatement(std::string index_name, std::unique_ptr<BoundBaseTableRef> table,
-                               std::vector<std::unique_ptr<BoundColumnRef>> cols)
+                               std::vector<std::unique_ptr<BoundColumnRef>> cols, bool unique,
+                               std::vector<std::unique_ptr<BoundColumnRef>> include_cols, IndexType index_type)
     : BoundStatement(StatementType::INDEX_STATEMENT),
       index_name_(std::move(index_name)),
       table_(std::move(table)),
-      cols_(std::move(cols)) {}
+      cols_(std::move(cols)),
+      unique_(unique),
+      include_cols_(std::move(include_cols)),
+      index_type_(index_type) {}
 
 auto IndexStatement::ToString() const -> std::string {
-  return fmt::format("BoundIndex {{ index_name={}, table={}, cols={} }}", index_name_, *table_, cols_);
+  std::string type = "btree";
+  if (index_type_ == IndexType::HashTableIndex) {
+    type = "hash";
+  } else if (index_type_ == IndexType::BufferedBPlusTreeIndex) {
+    type = "buffered";
+  } else if (index_type_ == IndexType::ARTIndex) {
+    type = "art";
+  }
+  return fmt::format("BoundIndex {{ index_name={}, table={}, cols={}, unique={}, include={}, type={} }}", index_name_,
+                     *table_, cols_, unique_, include_cols_, type);
 }
 
 }  // namespace bustub
@@ -71,6 +71,8 @@ auto Binder::BindStatement(duckdb_libpgquery::PGNode *stmt) -> std::unique_ptr<B
       return BindVariableSet(reinterpret_cast<duckdb_libpgquery::PGVariableSetStmt *>(stmt));
     case duckdb_libpgquery::T_PGVariableShowStmt:
       return BindVariableShow(reinterpret_cast<duckdb_libpgquery::PGVariableShowStmt *>(stmt));
+    case duckdb_libpgquery::T_PGVacuumStmt:
+      return BindVacuum(reinterpret_cast<duckdb_libpgquery::PGVacuumStmt *>(stmt));
     default:
       throw NotImplementedException(NodeTagToString(stmt->type));
   }
@@ -12,6 +12,8 @@
 
 #include "buffer/buffer_pool_manager.h"
 
+#include <algorithm>
+
 #include "common/exception.h"
 #include "common/macros.h"
 #include "storage/page/page_guard.h"
@@ -20,7 +22,10 @@ namespace bustub {
 
 BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, size_t replacer_k,
                                      LogManager *log_manager)
-    : pool_size_(pool_size), disk_manager_(disk_manager), log_manager_(log_manager) {
+    : pool_size_(pool_size),
+      resident_budget_(std::max<size_t>(2, pool_size / RESIDENT_FRAMES_DIVISOR)),
+      disk_manager_(disk_manager),
+      log_manager_(log_manager) {
   // TODO(students): remove this line after you have implemented the buffer pool manager
   // throw NotImplementedException(
   //     "BufferPoolManager is not implemented yet. If you have finished implementing BPM, please remove the throw "
@@ -70,6 +75,8 @@ auto BufferPoolManager::NewPage(page_id_t *page_id) -> Page * {
     this->page_table_.erase(this->pages_[evict_frame_id].page_id_);
 
     Page *page = &this->pages_[evict_frame_id];
+    // 牺牲掉的frame里还是旧页的数据,新页要从全0开始(哈希表的目录页和桶页都没有单独的Init)
+    page->ResetMemory();
     page->page_id_ = new_page_id;
     page_table_[new_page_id] = evict_frame_id;
     page->pin_count_ = 1;
@@ -181,6 +188,21 @@ void BufferPoolManager::FlushAllPages() {
   }
 }
 
+auto BufferPoolManager::ReserveResidentFrames(size_t num_frames) -> bool {
+  size_t reserved = resident_frames_.load();
+  do {
+    if (reserved + num_frames > resident_budget_) {
+      return false;
+    }
+  } while (!resident_frames_.compare_exchange_weak(reserved, reserved + num_frames));
+  return true;
+}
+
+void BufferPoolManager::ReleaseResidentFrames(size_t num_frames) {
+  BUSTUB_ASSERT(resident_frames_.load() >= num_frames, "releasing more resident frames than reserved");
+  resident_frames_ -= num_frames;
+}
+
 auto BufferPoolManager::DeletePage(page_id_t page_id) -> bool {
   std::lock_guard<std::mutex> lock(latch_);
   auto it = this->page_table_.find(page_id);
@@ -234,6 +256,19 @@ auto BufferPoolManager::FetchPageWrite(page_id_t page_id) -> WritePageGuard {
   return new_write_page_guard;
 }
 
+auto BufferPoolManager::TryFetchPageWrite(page_id_t page_id) -> std::optional<WritePageGuard> {
+  Page *fetch_page_frame = this->FetchPage(page_id);
+  if (fetch_page_frame == nullptr) {
+    return std::nullopt;
+  }
+  // 拿不到写锁就把pin还回去,guard要等拿到锁以后再建,否则析构的时候会去放一把没拿到的锁
+  if (!fetch_page_frame->TryWLatch()) {
+    this->UnpinPage(page_id, false);
+    return std::nullopt;
+  }
+  return WritePageGuard(this, fetch_page_frame);
+}
+
 auto BufferPoolManager::NewPageGuarded(page_id_t *page_id) -> BasicPageGuard {
   Page *new_page_frame = this->NewPage(page_id);
   BasicPageGuard new_page_guard = BasicPageGuard(this, new_page_frame);
@@ -1,19 +1,24 @@
-// DDL (Data Definition Language) statement handling in BusTub, including create table, create index, and set/show
-// variable.
+// DDL (Data Definition Language) statement handling in BusTub, including create table, create index, analyze, vacuum,
+// and set/show variable.
 
+#include <algorithm>
 #include <optional>
 #include <shared_mutex>
 #include <string>
 #include <tuple>
+#include <utility>
+#include <vector>
 
 #include "binder/binder.h"
 #include "binder/bound_expression.h"
 #include "binder/bound_statement.h"
+#include "binder/statement/analyze_statement.h"
 #include "binder/statement/create_statement.h"
 #include "binder/statement/explain_statement.h"
 #include "binder/statement/index_statement.h"
 #include "binder/statement/select_statement.h"
 #include "binder/statement/set_show_statement.h"
+#include "binder/statement/vacuum_statement.h"
 #include "buffer/buffer_pool_manager.h"
 #include "catalog/schema.h"
 #include "catalog/table_generator.h"
@@ -42,7 +47,7 @@ namespace bustub {
 
 void BustubInstance::HandleCreateStatement(Transaction *txn, const CreateStatement &stmt, ResultWriter &writer) {
   std::unique_lock<std::shared_mutex> l(catalog_lock_);
-  auto info = catalog_->CreateTable(txn, stmt.table_, Schema(stmt.columns_));
+  auto info = catalog_->CreateTable(txn, stmt.table_, Schema(stmt.columns_), true, stmt.layout_, stmt.encoding_);
   l.unlock();
 
   if (info == nullptr) {
@@ -51,31 +56,84 @@ void BustubInstance::HandleCreateStatement(Transaction *txn, const CreateStateme
   WriteOneCell(fmt::format("Table created with id = {}", info->oid_), writer);
 }
 
+/** Build an index of the statement's type whose keys are stored in GenericKey<KeySize>. */
+template <size_t KeySize>
+static auto BuildIndexWithKeySize(Catalog *catalog, Transaction *txn, const IndexStatement &stmt,
+                                  TableInfo *table_info, const Schema &key_schema, const std::vector<uint32_t> &col_ids,
+                                  const std::vector<uint32_t> &include_ids) -> std::unique_ptr<IndexInfo> {
+  return catalog->BuildIndex<GenericKey<KeySize>, RID, GenericComparator<KeySize>>(
+      txn, stmt.index_name_, table_info, stmt.table_->schema_, key_schema, col_ids, KeySize,
+      HashFunction<GenericKey<KeySize>>{}, stmt.unique_, include_ids, stmt.index_type_);
+}
+
 void BustubInstance::HandleIndexStatement(Transaction *txn, const IndexStatement &stmt, ResultWriter &writer) {
   std::vector<uint32_t> col_ids;
   for (const auto &col : stmt.cols_) {
     auto idx = stmt.table_->schema_.GetColIdx(col->col_name_.back());
     col_ids.push_back(idx);
-    if (stmt.table_->schema_.GetColumn(idx).GetType() != TypeId::INTEGER) {
-      throw NotImplementedException("only support creating index on integer column");
+    if (stmt.table_->schema_.GetColumn(idx).GetType() == TypeId::INVALID) {
+      throw NotImplementedException("cannot create index on column of invalid type");
     }
   }
+  if (col_ids.empty()) {
+    throw NotImplementedException("index must have at least one column");
+  }
   auto key_schema = Schema::CopySchema(&stmt.table_->schema_, col_ids);
+  std::vector<uint32_t> include_ids;
+  if (stmt.index_type_ == IndexType::HashTableIndex && !stmt.include_cols_.empty()) {
+    throw NotImplementedException("hash index cannot include non-key columns");
+  }
+  for (const auto &col : stmt.include_cols_) {
+    include_ids.push_back(stmt.table_->schema_.GetColIdx(col->col_name_.back()));
+  }
+  auto entry_ids = col_ids;
+  entry_ids.insert(entry_ids.end(), include_ids.begin(), include_ids.end());
+  auto entry_schema = Schema::CopySchema(&stmt.table_->schema_, entry_ids);
 
-  // TODO(spring2023): If you want to support composite index key for leaderboard optimization, remove this assertion
-  // and create index with different key type that can hold multiple keys based on number of index columns.
-  //
-  // You can also create clustered index that directly stores value inside the index by modifying the value type.
-
-  if (col_ids.empty() || col_ids.size() > 2) {
-    throw NotImplementedException("only support creating index with exactly one or two columns");
+  // 按键最长可能占的字节数选最小的GenericKey,这样结点里能放下尽可能多的键;
+  // 非唯一索引还要在键后面存RID,覆盖索引还要存include的列,见BPlusTreeIndex::MakeTreeKey;
+  // 哈希表本身允许重复的键,RID存在value里,键只有索引列;
+  // ART存的是变长的编码,不受GenericKey大小的限制,模板参数只是走一遍CreateIndex
+  auto key_size =
+      GetMaxIndexKeySize(entry_schema, stmt.unique_ || stmt.index_type_ == IndexType::HashTableIndex);
+  if (key_size > MAX_INDEX_KEY_SIZE && stmt.index_type_ != IndexType::ARTIndex) {
+    throw NotImplementedException(fmt::format("index key can be up to {} bytes long, which exceeds the {}-byte limit",
+                                              key_size, MAX_INDEX_KEY_SIZE));
   }
 
-  std::unique_lock<std::shared_mutex> l(catalog_lock_);
-  auto info = catalog_->CreateIndex<IntegerKeyType, IntegerValueType, IntegerComparatorType>(
-      txn, stmt.index_name_, stmt.table_->table_, stmt.table_->schema_, key_schema, col_ids, TWO_INTEGER_SIZE,
-      IntegerHashFunctionType{});
+  std::shared_lock<std::shared_mutex> l(catalog_lock_);
+  auto *table_info = catalog_->GetTable(stmt.table_->table_);
+  bool exists = catalog_->GetIndex(stmt.index_name_, stmt.table_->table_) != Catalog::NULL_INDEX_INFO;
   l.unlock();
+  if (exists) {
+    throw bustub::Exception("Failed to create index");
+  }
+
+  // 建索引期间用表上的S锁挡住写入,查询照常进行;扫表建树的时候不持有catalog的锁,
+  // 最后发布到catalog时才短暂地加一下写锁
+  try {
+    if (!lock_manager_->LockTable(txn, LockManager::LockMode::SHARED, table_info->oid_)) {
+      throw bustub::Exception("Failed to lock the table for index creation");
+    }
+  } catch (TransactionAbortException &e) {
+    throw bustub::Exception(e.GetInfo());
+  }
+  std::unique_ptr<IndexInfo> index_info;
+  if (key_size <= 4) {
+    index_info = BuildIndexWithKeySize<4>(catalog_, txn, stmt, table_info, key_schema, col_ids, include_ids);
+  } else if (key_size <= 8) {
+    index_info = BuildIndexWithKeySize<8>(catalog_, txn, stmt, table_info, key_schema, col_ids, include_ids);
+  } else if (key_size <= 16) {
+    index_info = BuildIndexWithKeySize<16>(catalog_, txn, stmt, table_info, key_schema, col_ids, include_ids);
+  } else if (key_size <= 32) {
+    index_info = BuildIndexWithKeySize<32>(catalog_, txn, stmt, table_info, key_schema, col_ids, include_ids);
+  } else {
+    index_info = BuildIndexWithKeySize<64>(catalog_, txn, stmt, table_info, key_schema, col_ids, include_ids);
+  }
+
+  std::unique_lock<std::shared_mutex> publish_lock(catalog_lock_);
+  auto *info = catalog_->PublishIndex(std::move(index_info));
+  publish_lock.unlock();
 
   if (info == nullptr) {
     throw bustub::Exception("Failed to create index");
@@ -83,6 +141,75 @@ void BustubInstance::HandleIndexStatement(Transaction *txn, const IndexStatement
   WriteOneCell(fmt::format("Index created with id = {}", info->index_oid_), writer);
 }
 
+void BustubInstance::HandleAnalyzeStatement(Transaction *txn, const AnalyzeStatement &stmt, ResultWriter &writer) {
+  // 重新统计只扫索引,不改catalog,拿读锁就够了,索引自己处理并发的插入删除
+  std::shared_lock<std::shared_mutex> l(catalog_lock_);
+  std::vector<std::string> table_names;
+  if (stmt.table_ != nullptr) {
+    table_names.push_back(stmt.table_->table_);
+  } else {
+    table_names = catalog_->GetTableNames();
+  }
+  size_t num_indexes = 0;
+  for (const auto &table_name : table_names) {
+    for (auto *index_info : catalog_->GetTableIndexes(table_name)) {
+      index_info->index_->RefreshStatistics();
+      num_indexes++;
+    }
+  }
+  l.unlock();
+  WriteOneCell(fmt::format("Statistics refreshed for {} indexes", num_indexes), writer);
+}
+
+void BustubInstance::HandleVacuumStatement(Transaction *txn, const VacuumStatement &stmt, ResultWriter &writer) {
+  std::shared_lock<std::shared_mutex> l(catalog_lock_);
+  std::vector<std::string> table_names;
+  if (stmt.table_ != nullptr) {
+    table_names.push_back(stmt.table_->table_);
+  } else {
+    table_names = catalog_->GetTableNames();
+  }
+  std::vector<std::pair<TableInfo *, std::vector<IndexInfo *>>> tables;
+  for (const auto &table_name : table_names) {
+    auto *table_info = catalog_->GetTable(table_name);
+    // mock表没有table heap
+    if (table_info->table_ != nullptr) {
+      tables.emplace_back(table_info, catalog_->GetTableIndexes(table_name));
+    }
+  }
+  // 等表锁的时候不能占着catalog的锁,拿着这张表IX锁的事务可能正要建表
+  l.unlock();
+
+  VacuumResult total;
+  for (const auto &[info, table_indexes] : tables) {
+    auto *table_info = info;
+    const auto &indexes = table_indexes;
+    // 拿到表的X锁,删过这张表里的行的事务都已经提交或者回滚完,打了删除标记的行不会再复活
+    if (!lock_manager_->LockTable(txn, LockManager::LockMode::EXCLUSIVE, table_info->oid_)) {
+      throw bustub::Exception(fmt::format("Failed to lock table {} for vacuum", table_info->name_));
+    }
+    auto result = table_info->table_->Vacuum([&](const Tuple &tuple, RID rid) {
+      // 死行的槽可能被新行重用,还指着它的索引项(比如回滚掉的插入留下的)要先删掉。
+      // 唯一索引按键删除,只有索引里这个键确实指着这一行才删
+      for (auto *index_info : indexes) {
+        auto key = tuple.KeyFromTuple(table_info->schema_, *index_info->index_->GetKeySchema(),
+                                      index_info->index_->GetKeyAttrs());
+        std::vector<RID> rids;
+        index_info->index_->ScanKey(key, &rids, txn);
+        if (std::find(rids.begin(), rids.end(), rid) != rids.end()) {
+          index_info->index_->DeleteEntry(key, rid, txn);
+        }
+      }
+    });
+    total.tuples_ += result.tuples_;
+    total.bytes_ += result.bytes_;
+    total.pages_emptied_ += result.pages_emptied_;
+  }
+  WriteOneCell(fmt::format("Vacuumed {} tables, reclaimed {} tuples, {} bytes, {} empty pages", tables.size(),
+                           total.tuples_, total.bytes_, total.pages_emptied_),
+               writer);
+}
+
 void BustubInstance::HandleExplainStatement(Transaction *txn, const ExplainStatement &stmt, ResultWriter &writer) {
   std::string output;
 
@@ -6,11 +6,13 @@
 #include "binder/binder.h"
 #include "binder/bound_expression.h"
 #include "binder/bound_statement.h"
+#include "binder/statement/analyze_statement.h"
 #include "binder/statement/create_statement.h"
 #include "binder/statement/explain_statement.h"
 #include "binder/statement/index_statement.h"
 #include "binder/statement/select_statement.h"
 #include "binder/statement/set_show_statement.h"
+#include "binder/statement/vacuum_statement.h"
 #include "buffer/buffer_pool_manager.h"
 #include "catalog/schema.h"
 #include "catalog/table_generator.h"
@@ -149,6 +151,12 @@ void BustubInstance::CmdDisplayIndices(ResultWriter &writer) {
   writer.WriteHeaderCell("index_oid");
   writer.WriteHeaderCell("index_name");
   writer.WriteHeaderCell("index_cols");
+  writer.WriteHeaderCell("entries");
+  writer.WriteHeaderCell("distinct_keys");
+  writer.WriteHeaderCell("height");
+  writer.WriteHeaderCell("leaf_pages");
+  writer.WriteHeaderCell("leaf_fill");
+  writer.WriteHeaderCell("histogram");
   writer.EndHeader();
   for (const auto &table_name : table_names) {
     for (const auto *index_info : catalog_->GetTableIndexes(table_name)) {
@@ -157,6 +165,27 @@ void BustubInstance::CmdDisplayIndices(ResultWriter &writer) {
       writer.WriteCell(fmt::format("{}", index_info->index_oid_));
       writer.WriteCell(index_info->name_);
       writer.WriteCell(index_info->key_schema_.ToString());
+      // 不维护统计信息的索引这几列留空
+      auto stats = index_info->index_->GetStatistics(true);
+      if (!stats.has_value()) {
+        for (int i = 0; i < 6; i++) {
+          writer.WriteCell("");
+        }
+        writer.EndRow();
+        continue;
+      }
+      writer.WriteCell(fmt::format("{}", stats->num_entries_));
+      writer.WriteCell(fmt::format("{}", stats->GetDistinctKeys()));
+      writer.WriteCell(fmt::format("{}", stats->height_));
+      writer.WriteCell(fmt::format("{}", stats->leaf_pages_));
+      writer.WriteCell(fmt::format("{:.2f}", stats->leaf_fill_));
+      if (stats->histogram_counts_.empty()) {
+        writer.WriteCell("");
+      } else {
+        writer.WriteCell(fmt::format("{} buckets [{}, {}]", stats->histogram_counts_.size(),
+                                     stats->histogram_bounds_.front().ToString(),
+                                     stats->histogram_bounds_.back().ToString()));
+      }
       writer.EndRow();
     }
   }
@@ -175,7 +204,7 @@ void BustubInstance::CmdDisplayHelp(ResultWriter &writer) {
   std::string help = R"(Welcome to the BusTub shell!
 
 \dt: show all tables
-\di: show all indices
+\di: show all indices with their statistics, `analyze <table>` refreshes them
 \help: show this message again
 
 BusTub shell currently only supports a small set of Postgres queries. We'll set
@@ -261,6 +290,16 @@ auto BustubInstance::ExecuteSqlTxn(const std::string &sql, ResultWriter &writer,
         HandleExplainStatement(txn, explain_stmt, writer);
         continue;
       }
+      case StatementType::ANALYZE_STATEMENT: {
+        const auto &analyze_stmt = dynamic_cast<const AnalyzeStatement &>(*statement);
+        HandleAnalyzeStatement(txn, analyze_stmt, writer);
+        continue;
+      }
+      case StatementType::VACUUM_STATEMENT: {
+        const auto &vacuum_stmt = dynamic_cast<const VacuumStatement &>(*statement);
+        HandleVacuumStatement(txn, vacuum_stmt, writer);
+        continue;
+      }
       case StatementType::DELETE_STATEMENT:
       case StatementType::UPDATE_STATEMENT:
         is_delete = true;
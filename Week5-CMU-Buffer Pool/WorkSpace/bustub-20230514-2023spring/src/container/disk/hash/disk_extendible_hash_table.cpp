@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <utility>
@@ -26,7 +27,21 @@ template <typename KeyType, typename ValueType, typename KeyComparator>
 HASH_TABLE_TYPE::DiskExtendibleHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
                                          const KeyComparator &comparator, HashFunction<KeyType> hash_fn)
     : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {
-  //  implement me!
+  // 初始状态:全局深度为0,目录里只有一个指向空桶的槽位
+  Page *dir_raw = buffer_pool_manager_->NewPage(&directory_page_id_);
+  BUSTUB_ASSERT(dir_raw != nullptr, "cannot allocate the directory page");
+  auto *dir_page = reinterpret_cast<HashTableDirectoryPage *>(dir_raw->GetData());
+  dir_page->SetPageId(directory_page_id_);
+
+  page_id_t bucket_page_id;
+  Page *bucket_raw = buffer_pool_manager_->NewPage(&bucket_page_id);
+  BUSTUB_ASSERT(bucket_raw != nullptr, "cannot allocate the first bucket page");
+  reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(bucket_raw->GetData())->Init();
+  dir_page->SetBucketPageId(0, bucket_page_id);
+  dir_page->SetLocalDepth(0, 0);
+
+  buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+  buffer_pool_manager_->UnpinPage(directory_page_id_, true);
 }
 
 /*****************************************************************************
@@ -46,22 +61,138 @@ auto HASH_TABLE_TYPE::Hash(KeyType key) -> uint32_t {
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 inline auto HASH_TABLE_TYPE::KeyToDirectoryIndex(KeyType key, HashTableDirectoryPage *dir_page) -> uint32_t {
-  return 0;
+  return Hash(key) & dir_page->GetGlobalDepthMask();
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 inline auto HASH_TABLE_TYPE::KeyToPageId(KeyType key, HashTableDirectoryPage *dir_page) -> page_id_t {
-  return 0;
+  return dir_page->GetBucketPageId(KeyToDirectoryIndex(key, dir_page));
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::FetchDirectoryPage() -> HashTableDirectoryPage * {
-  return nullptr;
+  Page *page = buffer_pool_manager_->FetchPage(directory_page_id_);
+  BUSTUB_ASSERT(page != nullptr, "cannot fetch the directory page");
+  return reinterpret_cast<HashTableDirectoryPage *>(page->GetData());
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::FetchBucketPage(page_id_t bucket_page_id) -> HASH_TABLE_BUCKET_TYPE * {
-  return nullptr;
+  Page *page = buffer_pool_manager_->FetchPage(bucket_page_id);
+  BUSTUB_ASSERT(page != nullptr, "cannot fetch a bucket page");
+  return reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(page->GetData());
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_TYPE::ChainGetValue(HASH_TABLE_BUCKET_TYPE *bucket_page, const KeyType &key,
+                                    std::vector<ValueType> *result) -> bool {
+  bool found = bucket_page->GetValue(key, comparator_, result);
+  page_id_t page_id = bucket_page->GetOverflowPageId();
+  while (page_id != INVALID_PAGE_ID) {
+    HASH_TABLE_BUCKET_TYPE *overflow_page = FetchBucketPage(page_id);
+    found = overflow_page->GetValue(key, comparator_, result) || found;
+    page_id_t next_page_id = overflow_page->GetOverflowPageId();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+  return found;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_TYPE::ChainAppend(HASH_TABLE_BUCKET_TYPE *bucket_page, const KeyType &key, const ValueType &value,
+                                  bool grow) -> bool {
+  // page_id只记溢出页的,第一页由调用方pin着
+  HASH_TABLE_BUCKET_TYPE *page = bucket_page;
+  page_id_t page_id = INVALID_PAGE_ID;
+  bool inserted = false;
+  while (true) {
+    if (!page->IsFull()) {
+      inserted = page->Insert(key, value, comparator_);
+      break;
+    }
+    page_id_t next_page_id = page->GetOverflowPageId();
+    if (next_page_id == INVALID_PAGE_ID) {
+      Page *overflow_raw = grow ? buffer_pool_manager_->NewPage(&next_page_id) : nullptr;
+      if (overflow_raw != nullptr) {
+        auto *overflow_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(overflow_raw->GetData());
+        overflow_page->Init();
+        inserted = overflow_page->Insert(key, value, comparator_);
+        page->SetOverflowPageId(next_page_id);
+        buffer_pool_manager_->UnpinPage(next_page_id, true);
+      }
+      break;
+    }
+    if (page_id != INVALID_PAGE_ID) {
+      buffer_pool_manager_->UnpinPage(page_id, false);
+    }
+    page = FetchBucketPage(next_page_id);
+    page_id = next_page_id;
+  }
+  if (page_id != INVALID_PAGE_ID) {
+    buffer_pool_manager_->UnpinPage(page_id, inserted);
+  }
+  return inserted;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_TYPE::ChainRemove(HASH_TABLE_BUCKET_TYPE *bucket_page, const KeyType &key, const ValueType &value)
+    -> bool {
+  if (bucket_page->Remove(key, value, comparator_)) {
+    return true;
+  }
+  // prev_page_id同样只记溢出页的
+  HASH_TABLE_BUCKET_TYPE *prev_page = bucket_page;
+  page_id_t prev_page_id = INVALID_PAGE_ID;
+  page_id_t page_id = bucket_page->GetOverflowPageId();
+  bool removed = false;
+  while (page_id != INVALID_PAGE_ID) {
+    HASH_TABLE_BUCKET_TYPE *page = FetchBucketPage(page_id);
+    removed = page->Remove(key, value, comparator_);
+    if (removed && page->IsEmpty()) {
+      // 溢出页空了就从链上摘下来还给缓冲池
+      prev_page->SetOverflowPageId(page->GetOverflowPageId());
+      buffer_pool_manager_->UnpinPage(page_id, false);
+      buffer_pool_manager_->DeletePage(page_id);
+      break;
+    }
+    if (removed) {
+      buffer_pool_manager_->UnpinPage(page_id, true);
+      break;
+    }
+    if (prev_page_id != INVALID_PAGE_ID) {
+      buffer_pool_manager_->UnpinPage(prev_page_id, false);
+    }
+    prev_page = page;
+    prev_page_id = page_id;
+    page_id = page->GetOverflowPageId();
+  }
+  if (prev_page_id != INVALID_PAGE_ID) {
+    buffer_pool_manager_->UnpinPage(prev_page_id, removed);
+  }
+  return removed;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_TYPE::ChainCanSplit(HASH_TABLE_BUCKET_TYPE *bucket_page, const KeyType &key) -> bool {
+  uint32_t hash = Hash(key);
+  auto differs = [&](HASH_TABLE_BUCKET_TYPE *page) {
+    for (uint32_t slot = 0; slot < BUCKET_ARRAY_SIZE; slot++) {
+      if (page->IsReadable(slot) && Hash(page->KeyAt(slot)) != hash) {
+        return true;
+      }
+    }
+    return false;
+  };
+  bool can_split = differs(bucket_page);
+  page_id_t page_id = bucket_page->GetOverflowPageId();
+  while (!can_split && page_id != INVALID_PAGE_ID) {
+    HASH_TABLE_BUCKET_TYPE *overflow_page = FetchBucketPage(page_id);
+    can_split = differs(overflow_page);
+    page_id_t next_page_id = overflow_page->GetOverflowPageId();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+  return can_split;
 }
 
 /*****************************************************************************
@@ -69,7 +200,60 @@ auto HASH_TABLE_TYPE::FetchBucketPage(page_id_t bucket_page_id) -> HASH_TABLE_BU
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) -> bool {
-  return false;
+  table_latch_.RLock();
+  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
+  page_id_t bucket_page_id = KeyToPageId(key, dir_page);
+  Page *bucket_raw = buffer_pool_manager_->FetchPage(bucket_page_id);
+  BUSTUB_ASSERT(bucket_raw != nullptr, "cannot fetch a bucket page");
+  auto *bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(bucket_raw->GetData());
+
+  bucket_raw->RLatch();
+  bool found = ChainGetValue(bucket_page, key, result);
+  bucket_raw->RUnlatch();
+
+  buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+  buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+  table_latch_.RUnlock();
+  return found;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::GetAllKeys(Transaction *transaction, std::vector<KeyType> *result) {
+  table_latch_.RLock();
+  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
+  // 局部深度小于全局深度的桶在目录里出现好几次,每个桶只扫一遍
+  std::vector<page_id_t> bucket_page_ids;
+  for (uint32_t idx = 0; idx < dir_page->Size(); idx++) {
+    bucket_page_ids.push_back(dir_page->GetBucketPageId(idx));
+  }
+  std::sort(bucket_page_ids.begin(), bucket_page_ids.end());
+  bucket_page_ids.erase(std::unique(bucket_page_ids.begin(), bucket_page_ids.end()), bucket_page_ids.end());
+  auto collect = [&](HASH_TABLE_BUCKET_TYPE *page) {
+    for (uint32_t slot = 0; slot < BUCKET_ARRAY_SIZE; slot++) {
+      if (page->IsReadable(slot)) {
+        result->push_back(page->KeyAt(slot));
+      }
+    }
+  };
+  for (auto bucket_page_id : bucket_page_ids) {
+    Page *bucket_raw = buffer_pool_manager_->FetchPage(bucket_page_id);
+    BUSTUB_ASSERT(bucket_raw != nullptr, "cannot fetch a bucket page");
+    auto *bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(bucket_raw->GetData());
+    bucket_raw->RLatch();
+    collect(bucket_page);
+    page_id_t page_id = bucket_page->GetOverflowPageId();
+    while (page_id != INVALID_PAGE_ID) {
+      HASH_TABLE_BUCKET_TYPE *overflow_page = FetchBucketPage(page_id);
+      collect(overflow_page);
+      page_id_t next_page_id = overflow_page->GetOverflowPageId();
+      buffer_pool_manager_->UnpinPage(page_id, false);
+      page_id = next_page_id;
+    }
+    bucket_raw->RUnlatch();
+    buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+  }
+  buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+  table_latch_.RUnlock();
 }
 
 /*****************************************************************************
@@ -77,12 +261,155 @@ auto HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
-  return false;
+  // 乐观路径:目录只加读锁,桶没满的话直接在桶的写锁下插入,不同的桶可以并发写
+  table_latch_.RLock();
+  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
+  page_id_t bucket_page_id = KeyToPageId(key, dir_page);
+  Page *bucket_raw = buffer_pool_manager_->FetchPage(bucket_page_id);
+  BUSTUB_ASSERT(bucket_raw != nullptr, "cannot fetch a bucket page");
+  auto *bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(bucket_raw->GetData());
+
+  bucket_raw->WLatch();
+  bool full;
+  bool inserted;
+  if (bucket_page->GetOverflowPageId() == INVALID_PAGE_ID) {
+    full = bucket_page->IsFull();
+    inserted = !full && bucket_page->Insert(key, value, comparator_);
+  } else {
+    // 有溢出链的桶,相同的键值对可能在链上任何一页,先整条链查一遍重
+    std::vector<ValueType> existing;
+    ChainGetValue(bucket_page, key, &existing);
+    bool duplicate = std::find(existing.begin(), existing.end(), value) != existing.end();
+    inserted = !duplicate && ChainAppend(bucket_page, key, value, false);
+    full = !duplicate && !inserted;
+  }
+  bucket_raw->WUnlatch();
+
+  buffer_pool_manager_->UnpinPage(bucket_page_id, inserted);
+  buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+  table_latch_.RUnlock();
+  if (!full) {
+    return inserted;
+  }
+  return SplitInsert(transaction, key, value);
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
-  return false;
+  // 分裂要改目录,整张表加写锁;放锁和加锁之间别的线程可能已经分裂过了,所以每轮都重新定位桶
+  table_latch_.WLock();
+  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
+  bool dir_dirty = false;
+  bool inserted = false;
+  while (true) {
+    uint32_t bucket_idx = KeyToDirectoryIndex(key, dir_page);
+    page_id_t bucket_page_id = dir_page->GetBucketPageId(bucket_idx);
+    HASH_TABLE_BUCKET_TYPE *bucket_page = FetchBucketPage(bucket_page_id);
+    std::vector<ValueType> existing;
+    ChainGetValue(bucket_page, key, &existing);
+    if (std::find(existing.begin(), existing.end(), value) != existing.end()) {
+      buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+      break;
+    }
+    if (ChainAppend(bucket_page, key, value, false)) {
+      inserted = true;
+      buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+      break;
+    }
+
+    // 目录已经一页放不下了,或者桶里的项和新键哈希值全都一样、怎么分裂也分不开,就在桶后面接溢出页
+    uint32_t local_depth = dir_page->GetLocalDepth(bucket_idx);
+    bool dir_full = local_depth == dir_page->GetGlobalDepth() && dir_page->Size() * 2 > DIRECTORY_ARRAY_SIZE;
+    if (dir_full || !ChainCanSplit(bucket_page, key)) {
+      inserted = ChainAppend(bucket_page, key, value, true);
+      buffer_pool_manager_->UnpinPage(bucket_page_id, inserted);
+      break;
+    }
+
+    page_id_t image_page_id;
+    Page *image_raw = buffer_pool_manager_->NewPage(&image_page_id);
+    if (image_raw == nullptr) {
+      buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+      break;
+    }
+    auto *image_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(image_raw->GetData());
+    image_page->Init();
+    if (local_depth == dir_page->GetGlobalDepth()) {
+      dir_page->IncrGlobalDepth();
+    }
+
+    // 原来指向这个桶的槽位里,新的区分位为1的那一半改指向分裂出的新桶
+    uint32_t high_bit = 1U << local_depth;
+    for (uint32_t idx = 0; idx < dir_page->Size(); idx++) {
+      if (dir_page->GetBucketPageId(idx) != bucket_page_id) {
+        continue;
+      }
+      dir_page->IncrLocalDepth(idx);
+      if ((idx & high_bit) != 0) {
+        dir_page->SetBucketPageId(idx, image_page_id);
+      }
+    }
+    dir_dirty = true;
+
+    // 把整条链上的项收起来重新分到两个桶里。链上的溢出页留着给两边接着用,
+    // 两个桶加起来最多比原来多一页,也就是新桶那一页,中途不会再申请新页
+    std::vector<std::pair<KeyType, ValueType>> entries;
+    std::vector<page_id_t> spare_page_ids;
+    auto take_entries = [&](HASH_TABLE_BUCKET_TYPE *page) {
+      for (uint32_t slot = 0; slot < BUCKET_ARRAY_SIZE; slot++) {
+        if (page->IsReadable(slot)) {
+          entries.emplace_back(page->KeyAt(slot), page->ValueAt(slot));
+        }
+      }
+    };
+    take_entries(bucket_page);
+    for (page_id_t page_id = bucket_page->GetOverflowPageId(); page_id != INVALID_PAGE_ID;) {
+      HASH_TABLE_BUCKET_TYPE *overflow_page = FetchBucketPage(page_id);
+      take_entries(overflow_page);
+      spare_page_ids.push_back(page_id);
+      page_id_t next_page_id = overflow_page->GetOverflowPageId();
+      buffer_pool_manager_->UnpinPage(page_id, false);
+      page_id = next_page_id;
+    }
+    bucket_page->Init();
+
+    // tail是两个桶各自链上的最后一页,溢出页的page_id用完就unpin
+    struct Tail {
+      page_id_t page_id_;
+      HASH_TABLE_BUCKET_TYPE *page_;
+    };
+    Tail bucket_tail{INVALID_PAGE_ID, bucket_page};
+    Tail image_tail{INVALID_PAGE_ID, image_page};
+    for (const auto &[slot_key, slot_value] : entries) {
+      Tail &tail = (Hash(slot_key) & high_bit) != 0 ? image_tail : bucket_tail;
+      if (tail.page_->IsFull()) {
+        BUSTUB_ASSERT(!spare_page_ids.empty(), "a split bucket needs no more pages than it had");
+        page_id_t next_page_id = spare_page_ids.back();
+        spare_page_ids.pop_back();
+        HASH_TABLE_BUCKET_TYPE *next_page = FetchBucketPage(next_page_id);
+        next_page->Init();
+        tail.page_->SetOverflowPageId(next_page_id);
+        if (tail.page_id_ != INVALID_PAGE_ID) {
+          buffer_pool_manager_->UnpinPage(tail.page_id_, true);
+        }
+        tail = {next_page_id, next_page};
+      }
+      tail.page_->Insert(slot_key, slot_value, comparator_);
+    }
+    for (const auto &tail : {bucket_tail, image_tail}) {
+      if (tail.page_id_ != INVALID_PAGE_ID) {
+        buffer_pool_manager_->UnpinPage(tail.page_id_, true);
+      }
+    }
+    for (auto page_id : spare_page_ids) {
+      buffer_pool_manager_->DeletePage(page_id);
+    }
+    buffer_pool_manager_->UnpinPage(image_page_id, true);
+    buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+  }
+  buffer_pool_manager_->UnpinPage(directory_page_id_, dir_dirty);
+  table_latch_.WUnlock();
+  return inserted;
 }
 
 /*****************************************************************************
@@ -90,14 +417,75 @@ auto HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key,
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
-  return false;
+  table_latch_.RLock();
+  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
+  page_id_t bucket_page_id = KeyToPageId(key, dir_page);
+  Page *bucket_raw = buffer_pool_manager_->FetchPage(bucket_page_id);
+  BUSTUB_ASSERT(bucket_raw != nullptr, "cannot fetch a bucket page");
+  auto *bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(bucket_raw->GetData());
+
+  bucket_raw->WLatch();
+  bool removed = ChainRemove(bucket_page, key, value);
+  bool empty = bucket_page->IsEmpty() && bucket_page->GetOverflowPageId() == INVALID_PAGE_ID;
+  bucket_raw->WUnlatch();
+
+  buffer_pool_manager_->UnpinPage(bucket_page_id, removed);
+  buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+  table_latch_.RUnlock();
+  if (removed && empty) {
+    Merge(transaction, key, value);
+  }
+  return removed;
 }
 
 /*****************************************************************************
  * MERGE
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const ValueType &value) {}
+void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const ValueType &value) {
+  table_latch_.WLock();
+  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
+  bool dir_dirty = false;
+  // 合并之后新桶可能还能继续和它的镜像合并;之前因为镜像深度不同而留下的空桶也在这里一并收掉
+  while (true) {
+    uint32_t bucket_idx = KeyToDirectoryIndex(key, dir_page);
+    uint32_t local_depth = dir_page->GetLocalDepth(bucket_idx);
+    uint32_t image_idx = dir_page->GetSplitImageIndex(bucket_idx);
+    if (local_depth == 0 || dir_page->GetLocalDepth(image_idx) != local_depth) {
+      break;
+    }
+    page_id_t bucket_page_id = dir_page->GetBucketPageId(bucket_idx);
+    page_id_t image_page_id = dir_page->GetBucketPageId(image_idx);
+    // 放锁期间可能有别的线程又往桶里插了数据,所以要重新检查是否为空
+    HASH_TABLE_BUCKET_TYPE *bucket_page = FetchBucketPage(bucket_page_id);
+    bool bucket_empty = bucket_page->IsEmpty() && bucket_page->GetOverflowPageId() == INVALID_PAGE_ID;
+    buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+    HASH_TABLE_BUCKET_TYPE *image_page = FetchBucketPage(image_page_id);
+    bool image_empty = image_page->IsEmpty() && image_page->GetOverflowPageId() == INVALID_PAGE_ID;
+    buffer_pool_manager_->UnpinPage(image_page_id, false);
+    if (!bucket_empty && !image_empty) {
+      break;
+    }
+
+    page_id_t keep_page_id = bucket_empty ? image_page_id : bucket_page_id;
+    page_id_t drop_page_id = bucket_empty ? bucket_page_id : image_page_id;
+    for (uint32_t idx = 0; idx < dir_page->Size(); idx++) {
+      page_id_t page_id = dir_page->GetBucketPageId(idx);
+      if (page_id == bucket_page_id || page_id == image_page_id) {
+        dir_page->SetBucketPageId(idx, keep_page_id);
+        dir_page->SetLocalDepth(idx, local_depth - 1);
+      }
+    }
+    buffer_pool_manager_->DeletePage(drop_page_id);
+    dir_dirty = true;
+  }
+  while (dir_page->CanShrink()) {
+    dir_page->DecrGlobalDepth();
+    dir_dirty = true;
+  }
+  buffer_pool_manager_->UnpinPage(directory_page_id_, dir_dirty);
+  table_latch_.WUnlock();
+}
 
 /*****************************************************************************
  * GETGLOBALDEPTH - DO NOT TOUCH
@@ -1,84 +1,119 @@
-//===----------------------------------------------------------------------===//
-//
-//                         BusTub
-//
-// aggregation_executor.cpp
-//
-// Identification: src/execution/aggregation_executor.cpp
-//
-// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
-//
-//===----------------------------------------------------------------------===//
-#include <memory>
-#include <vector>
-
-#include "execution/executors/aggregation_executor.h"
-
-namespace bustub {
-
-AggregationExecutor::AggregationExecutor(ExecutorContext *exec_ctx, const AggregationPlanNode *plan,
-                                         std::unique_ptr<AbstractExecutor> &&child)
-    : AbstractExecutor(exec_ctx),
-      plan_(plan),
-      child_(std::move(child)),
-      aht_(SimpleAggregationHashTable(this->plan_->GetAggregates(), this->plan_->GetAggregateTypes())),
-      aht_iterator_(aht_.Begin()) {
-  // this->child_ = std::move(child);
-  // this->aht_ = std::move(SimpleAggregationHashTable(this->plan_->GetAggregates(),this->plan_->GetAggregateTypes()));
-}
-
-void AggregationExecutor::Init() {
-  child_->Init();
-  Tuple tuple{};
-  RID rid{};
-  aht_.Clear();
-  while (child_->Next(&tuple, &rid)) {
-    aht_.InsertCombine(MakeAggregateKey(&tuple), MakeAggregateValue(&tuple));
-  }
-  aht_iterator_ = aht_.Begin();
-  this->has_out_ = false;
-}
-
-auto AggregationExecutor::Next(Tuple *tuple, RID *rid) -> bool {
-  if (aht_.IsEmpty()) {
-    // std::cout<<"哈希表为空"<<std::endl;
-    // 假如这时候发现表为空,则要讨论是否有group by clause(子句)
-    if (plan_->GetGroupBys().empty()) {
-      // std::cout<<"group by为空"<<std::endl;
-      // 如果没有group by clause(子句),则需要查看是否特殊输出过一个tuple,如果没有则输出
-      if (!has_out_) {
-        std::vector<Value> values;
-        auto aggregate_types = plan_->GetAggregateTypes();
-        for (size_t i = 0; i < plan_->GetAggregates().size(); i++) {
-          if (aggregate_types[i] == AggregationType::CountStarAggregate) {
-            values.push_back(ValueFactory::GetIntegerValue(0));
-          } else {
-            values.push_back(ValueFactory::GetNullValueByType(TypeId::INTEGER));
-          }
-        }
-        *tuple = Tuple(values, &GetOutputSchema());
-        has_out_ = true;
-        return true;
-      }
-    }
-    return false;
-  }
-  if (aht_iterator_ != aht_.End()) {
-    std::vector<bustub::Value> vals{};
-    for (auto &group_by_val : aht_iterator_.Key().group_bys_) {
-      vals.push_back(group_by_val);
-    }
-    for (auto &aggregate_value : aht_iterator_.Val().aggregates_) {
-      vals.push_back(aggregate_value);
-    }
-    Tuple result{vals, &plan_->OutputSchema()};
-    *tuple = result;
-    ++aht_iterator_;
-    return true;
-  }
-  return false;
-}
-
-auto AggregationExecutor::GetChildExecutor() const -> const AbstractExecutor * { return child_.get(); }
-
-}  // namespace bustub
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// aggregation_executor.cpp
+//
+// Identification: src/execution/aggregation_executor.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "execution/executors/aggregation_executor.h"
+
+namespace bustub {
+
+AggregationExecutor::AggregationExecutor(ExecutorContext *exec_ctx, const AggregationPlanNode *plan,
+                                         std::unique_ptr<AbstractExecutor> &&child)
+    : AbstractExecutor(exec_ctx),
+      plan_(plan),
+      child_(std::move(child)),
+      aht_(SimpleAggregationHashTable(this->plan_->GetAggregates(), this->plan_->GetAggregateTypes())),
+      aht_iterator_(aht_.Begin()) {
+  // this->child_ = std::move(child);
+  // this->aht_ = std::move(SimpleAggregationHashTable(this->plan_->GetAggregates(),this->plan_->GetAggregateTypes()));
+}
+
+void AggregationExecutor::AggregateCodesIfPossible() {
+  auto *scan = dynamic_cast<SeqScanExecutor *>(child_.get());
+  auto *dictionary = scan == nullptr ? nullptr : scan->GetDictionary();
+  if (dictionary == nullptr) {
+    return;
+  }
+  std::vector<bool> decoded_group_bys;
+  for (const auto &expr : plan_->GetGroupBys()) {
+    auto use = SeqScanExecutor::GetCodeUse(expr, *dictionary);
+    if (use == SeqScanExecutor::CodeUse::Other) {
+      return;
+    }
+    decoded_group_bys.push_back(use == SeqScanExecutor::CodeUse::Column);
+  }
+  const auto &aggregate_types = plan_->GetAggregateTypes();
+  for (size_t i = 0; i < plan_->GetAggregates().size(); i++) {
+    auto use = SeqScanExecutor::GetCodeUse(plan_->GetAggregates()[i], *dictionary);
+    // 计数只看是不是NULL,NULL字符串存的就是NULL code;min/max比的是字符串的大小,code的顺序不是字符串的顺序
+    bool counts = aggregate_types[i] == AggregationType::CountStarAggregate ||
+                  aggregate_types[i] == AggregationType::CountAggregate;
+    if (use == SeqScanExecutor::CodeUse::Other || (use == SeqScanExecutor::CodeUse::Column && !counts)) {
+      return;
+    }
+  }
+  dictionary_ = dictionary;
+  decoded_group_bys_ = std::move(decoded_group_bys);
+  scan->EmitStoredTuples();
+}
+
+void AggregationExecutor::Init() {
+  if (dictionary_ == nullptr) {
+    AggregateCodesIfPossible();
+  }
+  child_->Init();
+  Tuple tuple{};
+  RID rid{};
+  aht_.Clear();
+  while (child_->Next(&tuple, &rid)) {
+    aht_.InsertCombine(MakeAggregateKey(&tuple), MakeAggregateValue(&tuple));
+  }
+  aht_iterator_ = aht_.Begin();
+  this->has_out_ = false;
+}
+
+auto AggregationExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  if (aht_.IsEmpty()) {
+    // std::cout<<"哈希表为空"<<std::endl;
+    // 假如这时候发现表为空,则要讨论是否有group by clause(子句)
+    if (plan_->GetGroupBys().empty()) {
+      // std::cout<<"group by为空"<<std::endl;
+      // 如果没有group by clause(子句),则需要查看是否特殊输出过一个tuple,如果没有则输出
+      if (!has_out_) {
+        std::vector<Value> values;
+        auto aggregate_types = plan_->GetAggregateTypes();
+        for (size_t i = 0; i < plan_->GetAggregates().size(); i++) {
+          if (aggregate_types[i] == AggregationType::CountStarAggregate) {
+            values.push_back(ValueFactory::GetIntegerValue(0));
+          } else {
+            values.push_back(ValueFactory::GetNullValueByType(TypeId::INTEGER));
+          }
+        }
+        *tuple = Tuple(values, &GetOutputSchema());
+        has_out_ = true;
+        return true;
+      }
+    }
+    return false;
+  }
+  if (aht_iterator_ != aht_.End()) {
+    std::vector<bustub::Value> vals{};
+    const auto &group_bys = aht_iterator_.Key().group_bys_;
+    for (size_t i = 0; i < group_bys.size(); i++) {
+      vals.push_back(dictionary_ != nullptr && decoded_group_bys_[i] ? dictionary_->DecodeValue(group_bys[i])
+                                                                      : group_bys[i]);
+    }
+    for (auto &aggregate_value : aht_iterator_.Val().aggregates_) {
+      vals.push_back(aggregate_value);
+    }
+    Tuple result{vals, &plan_->OutputSchema()};
+    *tuple = result;
+    ++aht_iterator_;
+    return true;
+  }
+  return false;
+}
+
+auto AggregationExecutor::GetChildExecutor() const -> const AbstractExecutor * { return child_.get(); }
+
+}  // namespace bustub
@@ -0,0 +1,62 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// column_bound.cpp
+//
+// Identification: src/execution/column_bound.cpp
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/column_bound.h"
+
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "execution/expressions/logic_expression.h"
+
+namespace bustub {
+
+void CollectColumnBounds(const AbstractExpressionRef &expr, std::vector<ColumnBound> &bounds) {
+  if (const auto *logic_expr = dynamic_cast<const LogicExpression *>(expr.get()); logic_expr != nullptr) {
+    if (logic_expr->logic_type_ == LogicType::And) {
+      CollectColumnBounds(logic_expr->GetChildAt(0), bounds);
+      CollectColumnBounds(logic_expr->GetChildAt(1), bounds);
+    }
+    return;
+  }
+  const auto *comp_expr = dynamic_cast<const ComparisonExpression *>(expr.get());
+  if (comp_expr == nullptr || comp_expr->comp_type_ == ComparisonType::NotEqual) {
+    return;
+  }
+  const auto *left_column = dynamic_cast<const ColumnValueExpression *>(comp_expr->GetChildAt(0).get());
+  const auto *right_column = dynamic_cast<const ColumnValueExpression *>(comp_expr->GetChildAt(1).get());
+  const auto *left_constant = dynamic_cast<const ConstantValueExpression *>(comp_expr->GetChildAt(0).get());
+  const auto *right_constant = dynamic_cast<const ConstantValueExpression *>(comp_expr->GetChildAt(1).get());
+  if (left_column != nullptr && right_constant != nullptr) {
+    bounds.push_back({left_column->GetColIdx(), comp_expr->comp_type_, right_constant->val_});
+    return;
+  }
+  if (left_constant != nullptr && right_column != nullptr) {
+    // `constant op column` 翻转成 `column op' constant`
+    auto comp_type = comp_expr->comp_type_;
+    switch (comp_type) {
+      case ComparisonType::LessThan:
+        comp_type = ComparisonType::GreaterThan;
+        break;
+      case ComparisonType::LessThanOrEqual:
+        comp_type = ComparisonType::GreaterThanOrEqual;
+        break;
+      case ComparisonType::GreaterThan:
+        comp_type = ComparisonType::LessThan;
+        break;
+      case ComparisonType::GreaterThanOrEqual:
+        comp_type = ComparisonType::LessThanOrEqual;
+        break;
+      default:
+        break;
+    }
+    bounds.push_back({right_column->GetColIdx(), comp_type, left_constant->val_});
+  }
+}
+
+}  // namespace bustub
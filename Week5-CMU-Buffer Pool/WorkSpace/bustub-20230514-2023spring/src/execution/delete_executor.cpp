@@ -25,6 +25,17 @@ DeleteExecutor::DeleteExecutor(ExecutorContext *exec_ctx, const DeletePlanNode *
 void DeleteExecutor::Init() {
   auto catalog = exec_ctx_->GetCatalog();
   auto table_oid = plan_->TableOid();
+  // 先拿表的IX锁再读索引列表:排在CREATE INDEX的S锁后面的语句,等到锁的时候新索引已经发布了,要一起维护
+  try {
+    bool success =
+        exec_ctx_->GetLockManager()->LockTable(exec_ctx_->GetTransaction(), LockManager::LockMode::INTENTION_EXCLUSIVE,
+                                               table_oid);
+    if (!success) {
+      throw ExecutionException("delete_executor acquire Table IX Lock Fail");
+    }
+  } catch (TransactionAbortException &e) {
+    throw ExecutionException(e.GetInfo());
+  }
   this->table_info_ = catalog->GetTable(table_oid);
   auto table_name = this->table_info_->name_;
   this->index_info_ = catalog->GetTableIndexes(table_name);
@@ -24,7 +24,7 @@ auto FilterExecutor::Next(Tuple *tuple, RID *rid) -> bool {
       return false;
     }
 
-    auto value = filter_expr->Evaluate(tuple, child_executor_->GetOutputSchema());
+    auto value = filter_expr->EvaluateView(TupleView(*tuple), child_executor_->GetOutputSchema());
     if (!value.IsNull() && value.GetAs<bool>()) {
       return true;
     }
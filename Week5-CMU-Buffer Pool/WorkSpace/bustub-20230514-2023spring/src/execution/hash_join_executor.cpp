@@ -12,8 +12,46 @@
 
 #include "execution/executors/hash_join_executor.h"
 
+#include "type/value_factory.h"
+
 namespace bustub {
 
+namespace {
+
+/**
+ * @return the dictionary of a side scanning a dictionary-encoded table, nullptr if it scans none or a key needs the
+ * decoded strings
+ * @param[out] encoded_keys which keys are encoded columns
+ */
+auto GetKeyDictionary(AbstractExecutor *child, const std::vector<AbstractExpressionRef> &keys,
+                      std::vector<bool> *encoded_keys) -> TableDictionary * {
+  auto *scan = dynamic_cast<SeqScanExecutor *>(child);
+  auto *dictionary = scan == nullptr ? nullptr : scan->GetDictionary();
+  if (dictionary == nullptr) {
+    return nullptr;
+  }
+  for (const auto &key : keys) {
+    auto use = SeqScanExecutor::GetCodeUse(key, *dictionary);
+    if (use == SeqScanExecutor::CodeUse::Other) {
+      return nullptr;
+    }
+    encoded_keys->push_back(use == SeqScanExecutor::CodeUse::Column);
+  }
+  return dictionary;
+}
+
+/** @return true if the keys of the other side facing encoded keys are strings to look up */
+auto CanLookUp(const std::vector<bool> &encoded_keys, const std::vector<AbstractExpressionRef> &other_keys) -> bool {
+  for (size_t i = 0; i < encoded_keys.size(); i++) {
+    if (encoded_keys[i] && other_keys[i]->GetReturnType() != TypeId::VARCHAR) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
 HashJoinExecutor::HashJoinExecutor(ExecutorContext *exec_ctx, const HashJoinPlanNode *plan,
                                    std::unique_ptr<AbstractExecutor> &&left_child,
                                    std::unique_ptr<AbstractExecutor> &&right_child)
@@ -28,22 +66,64 @@ HashJoinExecutor::HashJoinExecutor(ExecutorContext *exec_ctx, const HashJoinPlan
   // std::cout<<1<<std::endl;
 }
 
+void HashJoinExecutor::JoinCodesIfPossible() {
+  std::vector<bool> left_encoded;
+  std::vector<bool> right_encoded;
+  auto *left = GetKeyDictionary(left_executor_.get(), plan_->LeftJoinKeyExpressions(), &left_encoded);
+  auto *right = GetKeyDictionary(right_executor_.get(), plan_->RightJoinKeyExpressions(), &right_encoded);
+  if (left != nullptr && left == right && left_encoded == right_encoded) {
+    // 两边扫的是同一张表,code直接比
+    left_dictionary_ = left;
+    right_dictionary_ = right;
+  } else if (left != nullptr && CanLookUp(left_encoded, plan_->RightJoinKeyExpressions())) {
+    left_dictionary_ = left;
+    right_lookup_keys_ = std::move(left_encoded);
+  } else if (right != nullptr && CanLookUp(right_encoded, plan_->LeftJoinKeyExpressions())) {
+    right_dictionary_ = right;
+    left_lookup_keys_ = std::move(right_encoded);
+  }
+  if (left_dictionary_ != nullptr) {
+    dynamic_cast<SeqScanExecutor *>(left_executor_.get())->EmitStoredTuples();
+  }
+  if (right_dictionary_ != nullptr) {
+    dynamic_cast<SeqScanExecutor *>(right_executor_.get())->EmitStoredTuples();
+  }
+}
+
 void HashJoinExecutor::Init() {
   // std::cout<<1<<std::endl;
+  if (!codes_prepared_) {
+    JoinCodesIfPossible();
+    codes_prepared_ = true;
+  }
   this->left_executor_->Init();
   this->right_executor_->Init();
   this->left_ht_.clear();
   this->right_ht_.clear();
   // 1.首先要对左节点建立哈希表,将左节点的对应等值连接条件的列的值作为key,tuple本身作为value存储起来
+  // 字符串键要查成另一边字典里的code时,先把编码的那一边读完:它的行里有的字符串那时都已经有code了
   Tuple temp_tuple;
   RID temp_rid;
-  while (this->left_executor_->Next(&temp_tuple, &temp_rid)) {
-    this->AddTupleToHashTable(temp_tuple, this->left_ht_, this->plan_->LeftJoinKeyExpressions(),
-                              this->left_executor_->GetOutputSchema());
-  }
-  while (this->right_executor_->Next(&temp_tuple, &temp_rid)) {
-    this->AddTupleToHashTable(temp_tuple, this->right_ht_, this->plan_->RightJoinKeyExpressions(),
-                              this->right_executor_->GetOutputSchema());
+  auto build_left = [&]() {
+    while (this->left_executor_->Next(&temp_tuple, &temp_rid)) {
+      this->AddTupleToHashTable(temp_tuple, this->left_ht_, this->plan_->LeftJoinKeyExpressions(),
+                                GetChildSchema(*left_executor_, left_dictionary_), left_lookup_keys_,
+                                right_dictionary_);
+    }
+  };
+  auto build_right = [&]() {
+    while (this->right_executor_->Next(&temp_tuple, &temp_rid)) {
+      this->AddTupleToHashTable(temp_tuple, this->right_ht_, this->plan_->RightJoinKeyExpressions(),
+                                GetChildSchema(*right_executor_, right_dictionary_), right_lookup_keys_,
+                                left_dictionary_);
+    }
+  };
+  if (left_lookup_keys_.empty()) {
+    build_left();
+    build_right();
+  } else {
+    build_right();
+    build_left();
   }
   // std::cout<<1<<std::endl;
   this->left_ht_it_ = HashJoinTableIterator(left_ht_.begin(), left_ht_.end());
@@ -69,14 +149,8 @@ auto HashJoinExecutor::Next(Tuple *tuple, RID *rid) -> bool {
           auto right_tuple = **this->right_list_it_;
           // 现在需要根据谓词条件将左右两个tuple拼接在一起。
           std::vector<Value> value;
-          uint32_t left_siz = left_executor_->GetOutputSchema().GetColumnCount();
-          uint32_t right_siz = right_executor_->GetOutputSchema().GetColumnCount();
-          for (uint32_t i = 0; i < left_siz; i++) {
-            value.emplace_back(left_tuple.GetValue(&left_executor_->GetOutputSchema(), i));
-          }
-          for (uint32_t i = 0; i < right_siz; i++) {
-            value.emplace_back(right_tuple.GetValue(&right_executor_->GetOutputSchema(), i));
-          }
+          AppendColumns(left_tuple, *left_executor_, left_dictionary_, &value);
+          AppendColumns(right_tuple, *right_executor_, right_dictionary_, &value);
           *tuple = Tuple{value, &this->plan_->OutputSchema()};
           ++this->right_list_it_;
           // std::cout<<"true"<<std::endl;
@@ -104,14 +178,8 @@ auto HashJoinExecutor::Next(Tuple *tuple, RID *rid) -> bool {
           auto right_tuple = **this->right_list_it_;
           // 现在需要根据谓词条件将左右两个tuple拼接在一起。
           std::vector<Value> value;
-          uint32_t left_siz = left_executor_->GetOutputSchema().GetColumnCount();
-          uint32_t right_siz = right_executor_->GetOutputSchema().GetColumnCount();
-          for (uint32_t i = 0; i < left_siz; i++) {
-            value.emplace_back(left_tuple.GetValue(&left_executor_->GetOutputSchema(), i));
-          }
-          for (uint32_t i = 0; i < right_siz; i++) {
-            value.emplace_back(right_tuple.GetValue(&right_executor_->GetOutputSchema(), i));
-          }
+          AppendColumns(left_tuple, *left_executor_, left_dictionary_, &value);
+          AppendColumns(right_tuple, *right_executor_, right_dictionary_, &value);
           *tuple = Tuple{value, &this->plan_->OutputSchema()};
           ++this->right_list_it_;
           this->is_left_has_right_ = true;
@@ -122,11 +190,8 @@ auto HashJoinExecutor::Next(Tuple *tuple, RID *rid) -> bool {
         if (!this->is_left_has_right_) {
           // 需要特殊处理左连接
           std::vector<Value> value;
-          uint32_t left_siz = left_executor_->GetOutputSchema().GetColumnCount();
           uint32_t right_siz = right_executor_->GetOutputSchema().GetColumnCount();
-          for (uint32_t i = 0; i < left_siz; i++) {
-            value.emplace_back(left_tuple.GetValue(&left_executor_->GetOutputSchema(), i));
-          }
+          AppendColumns(left_tuple, *left_executor_, left_dictionary_, &value);
           for (uint32_t i = 0; i < right_siz; i++) {
             value.emplace_back(
                 ValueFactory::GetNullValueByType(right_executor_->GetOutputSchema().GetColumn(i).GetType()));
@@ -163,13 +228,39 @@ auto HashJoinExecutor::Next(Tuple *tuple, RID *rid) -> bool {
   return false;
 }
 
+void HashJoinExecutor::AppendColumns(const Tuple &tuple, const AbstractExecutor &child, TableDictionary *dictionary,
+                                     std::vector<Value> *values) {
+  const auto &schema = child.GetOutputSchema();
+  if (dictionary == nullptr) {
+    for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+      values->emplace_back(tuple.GetValue(&schema, i));
+    }
+    return;
+  }
+  auto decoded = dictionary->Decode(TupleView(tuple));
+  for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+    values->emplace_back(decoded.GetValue(&schema, i));
+  }
+}
+
 void HashJoinExecutor::AddTupleToHashTable(
     const Tuple &tuple, std::unordered_map<AggregateKey, std::list<std::unique_ptr<Tuple> > > &hash_table,
-    const std::vector<bustub::AbstractExpressionRef> &join_key_expressions, const Schema &son_schema) {
+    const std::vector<bustub::AbstractExpressionRef> &join_key_expressions, const Schema &son_schema,
+    const std::vector<bool> &lookup_keys, TableDictionary *lookup_dictionary) {
   AggregateKey v{};
   // v.reserve(left_expr.size());
-  for (auto &expr : join_key_expressions) {
-    v.group_bys_.emplace_back(expr->Evaluate(&tuple, son_schema));
+  for (size_t i = 0; i < join_key_expressions.size(); i++) {
+    auto key = join_key_expressions[i]->Evaluate(&tuple, son_schema);
+    if (!lookup_keys.empty() && lookup_keys[i]) {
+      if (key.IsNull()) {
+        key = ValueFactory::GetNullValueByType(TypeId::INTEGER);
+      } else {
+        // 字典里没有的字符串和另一边哪一行都不相等,给一个不会发出去的code
+        auto code = lookup_dictionary->Lookup(key);
+        key = ValueFactory::GetIntegerValue(code.has_value() ? *code : -1);
+      }
+    }
+    v.group_bys_.emplace_back(std::move(key));
   }
   std::list<std::unique_ptr<Tuple> > l;
   if (hash_table[v].empty()) {
@@ -10,48 +10,77 @@
 //
 //===----------------------------------------------------------------------===//
 #include "execution/executors/index_scan_executor.h"
+#include "type/value_factory.h"
 
 namespace bustub {
 IndexScanExecutor::IndexScanExecutor(ExecutorContext *exec_ctx, const IndexScanPlanNode *plan)
     : AbstractExecutor(exec_ctx),
       plan_(plan),
       index_info_(exec_ctx->GetCatalog()->GetIndex(plan->index_oid_)),
-      table_info_(exec_ctx->GetCatalog()->GetTable(index_info_->table_name_)),
-      iter_(dynamic_cast<BPlusTreeIndexForTwoIntegerColumn *>(this->index_info_->index_.get())->GetBeginIterator()) {}
+      table_info_(exec_ctx->GetCatalog()->GetTable(index_info_->table_name_)) {}
 
 void IndexScanExecutor::Init() {
   index_info_ = exec_ctx_->GetCatalog()->GetIndex(plan_->index_oid_);
   table_info_ = exec_ctx_->GetCatalog()->GetTable(index_info_->table_name_);
-  iter_ = dynamic_cast<BPlusTreeIndexForTwoIntegerColumn *>(this->index_info_->index_.get())->GetBeginIterator();
-  // auto catalog = exec_ctx_->GetCatalog();
-  // this->index_info_ = catalog->GetIndex(this->plan_->index_oid_);
-  // this->table_info_ = catalog->GetTable(this->index_info_->table_name_);
-  // // this->iter_ = std::move(dynamic_cast<BPlusTreeIndexForTwoIntegerColumn
-  // *>(this->index_info_->index_.get())->GetBeginIterator()); this->has_out_ = false;
+  // 只扫描[low, high]之间的叶子,迭代器越过终止的那一端之后就变成End
+  Tuple low_key = MakeBoundKey(plan_->low_key_);
+  Tuple high_key = MakeBoundKey(plan_->high_key_);
+  iter_ = index_info_->index_->MakeScanIterator(plan_->low_key_.empty() ? nullptr : &low_key, plan_->low_inclusive_,
+                                                plan_->high_key_.empty() ? nullptr : &high_key,
+                                                plan_->high_inclusive_, plan_->reverse_);
 }
 
 auto IndexScanExecutor::Next(Tuple *tuple, RID *rid) -> bool {
-  // auto iter =
   // 1.使用B+树的迭代器遍历每一个value(RID),利用这个rid去table堆里找对应的tuple
-  if (this->index_info_ != nullptr) {
-    while (!iter_.IsEnd()) {
-      // std::cout<<"正在遍历"<<std::endl;
-      auto rd = (*iter_).second;
-      auto tp = table_info_->table_->GetTuple(rd);
-      // if (tp.first.is_deleted_) {
-      //     ++iter_;
-      // } else {
-      *tuple = tp.second;
-      *rid = tuple->GetRid();
-      ++iter_;
-      return true;
-      // }
+  // 2.index_only的时候需要的列都在索引项里,不用再去table堆里随机读页
+  while (iter_ != nullptr && !iter_->IsEnd()) {
+    Tuple tp;
+    if (plan_->index_only_) {
+      tp = MakeTupleFromEntry(iter_->GetEntry());
+      tp.SetRid(iter_->GetRID());
+    } else {
+      tp = table_info_->table_->GetTuple(iter_->GetRID()).second;
     }
+    iter_->Next();
+    if (plan_->filter_predicate_ != nullptr) {
+      auto value = plan_->filter_predicate_->Evaluate(&tp, GetOutputSchema());
+      if (value.IsNull() || !value.GetAs<bool>()) {
+        continue;
+      }
+    }
+    *tuple = tp;
+    *rid = tuple->GetRid();
+    return true;
   }
-  // 2.检测刚刚拿出来的tuple是否是deleted的，如果不是则放入tuple中
   return false;
 }
 
+auto IndexScanExecutor::MakeBoundKey(const std::vector<Value> &prefix) const -> Tuple {
+  const Schema *key_schema = index_info_->index_->GetKeySchema();
+  std::vector<Value> values;
+  values.reserve(key_schema->GetColumnCount());
+  for (uint32_t i = 0; i < key_schema->GetColumnCount(); i++) {
+    auto type = key_schema->GetColumn(i).GetType();
+    values.push_back(i < prefix.size() ? prefix[i].CastAs(type) : ValueFactory::GetNullValueByType(type));
+  }
+  return {values, key_schema};
+}
+
+auto IndexScanExecutor::MakeTupleFromEntry(const Tuple &entry) const -> Tuple {
+  const Schema &schema = table_info_->schema_;
+  const auto &entry_attrs = index_info_->index_->GetEntryAttrs();
+  const Schema *entry_schema = index_info_->index_->GetEntrySchema();
+  std::vector<Value> values;
+  values.reserve(schema.GetColumnCount());
+  for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+    values.push_back(ValueFactory::GetNullValueByType(schema.GetColumn(i).GetType()));
+  }
+  for (uint32_t i = 0; i < entry_attrs.size(); i++) {
+    values[entry_attrs[i]] = entry.GetValue(entry_schema, i);
+  }
+  return {values, &schema};
+}
+
 }  // namespace bustub
 
 // //===----------------------------------------------------------------------===//
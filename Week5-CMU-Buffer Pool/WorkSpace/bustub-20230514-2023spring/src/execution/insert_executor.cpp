@@ -10,12 +10,35 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <cstdint>
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include "execution/executors/insert_executor.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "storage/index/index_builder.h"
 
 namespace bustub {
 
+namespace {
+
+/** 计划树里有没有顺序扫描这张表,有的话扫描会读到这条语句自己追加的页 */
+auto ScansTable(const AbstractPlanNode &plan, table_oid_t oid) -> bool {
+  if (plan.GetType() == PlanType::SeqScan && dynamic_cast<const SeqScanPlanNode &>(plan).GetTableOid() == oid) {
+    return true;
+  }
+  for (const auto &child : plan.GetChildren()) {
+    if (ScansTable(*child, oid)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
 InsertExecutor::InsertExecutor(ExecutorContext *exec_ctx, const InsertPlanNode *plan,
                                std::unique_ptr<AbstractExecutor> &&child_executor)
     : AbstractExecutor(exec_ctx), plan_(plan) {
@@ -25,11 +48,14 @@ InsertExecutor::InsertExecutor(ExecutorContext *exec_ctx, const InsertPlanNode *
 void InsertExecutor::Init() {
   auto catalog = exec_ctx_->GetCatalog();
   auto table_oid = plan_->TableOid();
+  // INSERT ... SELECT一次插很多行,直接拿表的X锁,不再一行一行地拿行锁;VALUES行数少,照旧走逐行插入
+  this->bulk_ = plan_->GetChildPlan()->GetType() != PlanType::Values;
   try {
-    bool success = exec_ctx_->GetLockManager()->LockTable(exec_ctx_->GetTransaction(),
-                                                          LockManager::LockMode::INTENTION_EXCLUSIVE, table_oid);
+    auto lock_mode = bulk_ ? LockManager::LockMode::EXCLUSIVE : LockManager::LockMode::INTENTION_EXCLUSIVE;
+    bool success = exec_ctx_->GetLockManager()->LockTable(exec_ctx_->GetTransaction(), lock_mode, table_oid);
     if (!success) {
-      throw ExecutionException("insert_executor acquire Table IX Lock Fail");
+      throw ExecutionException(bulk_ ? "insert_executor acquire Table X Lock Fail"
+                                     : "insert_executor acquire Table IX Lock Fail");
     }
   } catch (TransactionAbortException &e) {
     throw ExecutionException(e.GetInfo());
@@ -43,10 +69,13 @@ void InsertExecutor::Init() {
 
 auto InsertExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) -> bool {
   int sum = 0;
+  if (bulk_ && !has_out_) {
+    sum = BulkInsert();
+  }
   // 准备tuple和rid接收子算子的tuple
   Tuple temp_tuple;
   RID temp_rid;
-  while (this->child_executor_->Next(&temp_tuple, &temp_rid)) {
+  while (!bulk_ && this->child_executor_->Next(&temp_tuple, &temp_rid)) {
     // 插入一个Tuple,首先准备一个空的元数据
     TupleMeta tuple_meta = {INVALID_TXN_ID, INVALID_TXN_ID, false};
     // 插入tuple
@@ -68,8 +97,9 @@ auto InsertExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) -> bool {
         // auto index = dynamic_cast<BPlusTreeIndexForTwoIntegerColumn *>(index_info->index_.get());
         // index_info->
         // 首先拿到插入的这条tuple的key,可以看到在tuple.h中有一个KeyFromTuple的方法专门用于计算并获取一个tuple的key
-        auto tuple_key = insert_tuple.KeyFromTuple(this->table_info_->schema_, *(index_info->index_->GetKeySchema()),
-                                                   index_info->index_->GetKeyAttrs());
+        // 覆盖索引还要把include的列一起存进去,所以这里取的是整个索引项(键列加include列)
+        auto tuple_key = insert_tuple.KeyFromTuple(this->table_info_->schema_, *(index_info->index_->GetEntrySchema()),
+                                                   index_info->index_->GetEntryAttrs());
         // 更新索引
         // Value v1 = tuple_key.GetValue(index->GetKeySchema(),0);
         // std::cout<<"本次插入的tuple的key值为: "<<v1.ToString()<<std::endl;
@@ -92,4 +122,50 @@ auto InsertExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) -> bool {
   return !now_has_out;
 }
 
+auto InsertExecutor::BulkInsert() -> int {
+  auto txn = exec_ctx_->GetTransaction();
+  TupleMeta tuple_meta = {INVALID_TXN_ID, INVALID_TXN_ID, false};
+  // 从同一张表里选出来再插回去的时候,要先把要插的行全读出来,不然扫描会读到刚追加的页,永远扫不完
+  size_t batch_size = ScansTable(*plan_->GetChildPlan(), table_info_->oid_) ? SIZE_MAX : BULK_INSERT_BATCH_SIZE;
+  // 每个索引的索引项攒到最后,排好序一起插
+  std::vector<std::vector<std::pair<Tuple, RID>>> index_entries(index_info_.size());
+  std::vector<Tuple> batch;
+  batch.reserve(std::min<size_t>(batch_size, BULK_INSERT_BATCH_SIZE));
+  int sum = 0;
+  Tuple child_tuple;
+  RID child_rid;
+  bool child_done = false;
+  while (!child_done) {
+    batch.clear();
+    while (batch.size() < batch_size) {
+      if (!child_executor_->Next(&child_tuple, &child_rid)) {
+        child_done = true;
+        break;
+      }
+      batch.push_back(std::move(child_tuple));
+    }
+    if (batch.empty()) {
+      break;
+    }
+    // 表的X锁已经拿着,新页整页写满再接到表上,不拿行锁
+    auto rids = table_info_->table_->BulkInsertTuples(tuple_meta, batch);
+    for (size_t i = 0; i < batch.size(); i++) {
+      auto table_write_record = TableWriteRecord{table_info_->oid_, rids[i], table_info_->table_.get()};
+      table_write_record.wtype_ = WType::INSERT;
+      txn->GetWriteSet()->push_back(table_write_record);
+      // 插进去的就是子算子给的tuple,不用再从表里读一遍
+      for (size_t j = 0; j < index_info_.size(); j++) {
+        const auto *index = index_info_[j]->index_.get();
+        index_entries[j].emplace_back(
+            batch[i].KeyFromTuple(table_info_->schema_, *index->GetEntrySchema(), index->GetEntryAttrs()), rids[i]);
+      }
+    }
+    sum += static_cast<int>(batch.size());
+  }
+  for (size_t j = 0; j < index_info_.size(); j++) {
+    InsertEntriesInKeyOrder(index_info_[j]->index_.get(), std::move(index_entries[j]), txn);
+  }
+  return sum;
+}
+
 }  // namespace bustub
@@ -22,11 +22,12 @@ auto ProjectionExecutor::Next(Tuple *tuple, RID *rid) -> bool {
     return false;
   }
 
-  // Compute expressions
+  // Compute expressions on a view of child_tuple, a VARCHAR value points into it until the output tuple copies it
+  TupleView child_view(child_tuple);
   std::vector<Value> values{};
   values.reserve(GetOutputSchema().GetColumnCount());
   for (const auto &expr : plan_->GetExpressions()) {
-    values.push_back(expr->Evaluate(&child_tuple, child_executor_->GetOutputSchema()));
+    values.push_back(expr->EvaluateView(child_view, child_executor_->GetOutputSchema()));
   }
 
   *tuple = Tuple{values, &GetOutputSchema()};
@@ -1,202 +1,373 @@
-//===----------------------------------------------------------------------===//
-//
-//                         BusTub
-//
-// seq_scan_executor.cpp
-//
-// Identification: src/execution/seq_scan_executor.cpp
-//
-// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
-//
-//===----------------------------------------------------------------------===//
-
-#include "execution/executors/seq_scan_executor.h"
-#include "common/exception.h"
-#include "type/value_factory.h"
-
-namespace bustub {
-
-SeqScanExecutor::SeqScanExecutor(ExecutorContext *exec_ctx, const SeqScanPlanNode *plan)
-    : AbstractExecutor(exec_ctx), plan_(plan) {
-  // this->plan_ = plan;
-  // this->Init();
-}
-
-SeqScanExecutor::~SeqScanExecutor() {
-  if (this->it_ != nullptr) {
-    delete this->it_;
-    this->it_ = nullptr;
-  }
-}
-
-void SeqScanExecutor::Init() {
-  auto oid = plan_->GetTableOid();
-  if (exec_ctx_->IsDelete()) {
-    AcquireTableLock(LockManager::LockMode::INTENTION_EXCLUSIVE, oid);
-  } else {
-    auto now_txn = exec_ctx_->GetTransaction();
-    if (!(now_txn->GetIsolationLevel() == IsolationLevel::READ_UNCOMMITTED)) {
-      if (!(now_txn->GetExclusiveTableLockSet()->count(oid) > 0)) {
-        if (!(now_txn->GetIntentionExclusiveTableLockSet()->count(oid) > 0)) {
-          AcquireTableLock(LockManager::LockMode::INTENTION_SHARED, oid);
-        }
-      }
-    }
-  }
-
-  auto cata_log = exec_ctx_->GetCatalog();
-  auto table_info = cata_log->GetTable(plan_->GetTableOid());
-  auto get_table = table_info->table_.get();
-
-  this->it_ = new TableIterator(get_table->MakeEagerIterator());
-}
-
-void SeqScanExecutor::AcquireTableLock(const LockManager::LockMode &request_lock_mode, const table_oid_t &oid) {
-  try {
-    bool res = exec_ctx_->GetLockManager()->LockTable(exec_ctx_->GetTransaction(), request_lock_mode, oid);
-    if (!res) {
-      switch (request_lock_mode) {
-        case LockManager::LockMode::EXCLUSIVE: {
-          throw ExecutionException("seq_scan_executor acquire X Table lock fail");
-          break;
-        }
-        case LockManager::LockMode::INTENTION_EXCLUSIVE: {
-          throw ExecutionException("seq_scan_executor acquire IX Table lock fail");
-          break;
-        }
-        case LockManager::LockMode::SHARED: {
-          throw ExecutionException("seq_scan_executor acquire S Table lock fail");
-          break;
-        }
-        case LockManager::LockMode::INTENTION_SHARED: {
-          throw ExecutionException("seq_scan_executor acquire IS Table lock fail");
-          break;
-        }
-        case LockManager::LockMode::SHARED_INTENTION_EXCLUSIVE: {
-          throw ExecutionException("seq_scan_executor acquire SIX Table lock fail");
-          break;
-        }
-      }
-    }
-  } catch (TransactionAbortException &e) {
-    throw ExecutionException(e.GetInfo());
-    // std::cout<<e.GetInfo()<<std::endl;
-  }
-}
-
-void SeqScanExecutor::ReleaseTableLock(const table_oid_t &oid) {
-  try {
-    bool res = exec_ctx_->GetLockManager()->UnlockTable(exec_ctx_->GetTransaction(), oid);
-    if (!res) {
-      throw ExecutionException("seq_scan_executor unlock fail");
-    }
-  } catch (TransactionAbortException &e) {
-    throw ExecutionException(e.GetInfo());
-  }
-}
-
-void SeqScanExecutor::AcquireRowLock(const LockManager::LockMode &request_lock_mode, const table_oid_t &oid,
-                                     const RID &rid) {
-  try {
-    bool res = exec_ctx_->GetLockManager()->LockRow(exec_ctx_->GetTransaction(), request_lock_mode, oid, rid);
-    if (!res) {
-      switch (request_lock_mode) {
-        case LockManager::LockMode::EXCLUSIVE: {
-          throw ExecutionException("seq_scan_executor acquire X ROW lock fail");
-          break;
-        }
-        case LockManager::LockMode::SHARED: {
-          throw ExecutionException("seq_scan_executor acquire S ROW lock fail");
-          break;
-        }
-        case LockManager::LockMode::INTENTION_SHARED:
-        case LockManager::LockMode::INTENTION_EXCLUSIVE:
-        case LockManager::LockMode::SHARED_INTENTION_EXCLUSIVE:
-          break;
-      }
-    }
-  } catch (TransactionAbortException &e) {
-    throw ExecutionException(e.GetInfo());
-    // std::cout<<e.GetInfo()<<std::endl;
-  }
-}
-
-void SeqScanExecutor::ReleaseRowLock(const table_oid_t &oid, const RID &rid, bool force) {
-  try {
-    bool res = exec_ctx_->GetLockManager()->UnlockRow(exec_ctx_->GetTransaction(), oid, rid, force);
-    if (!res) {
-      throw ExecutionException("seq_scan_executor unlock Row fail");
-    }
-  } catch (TransactionAbortException &e) {
-    throw ExecutionException(e.GetInfo());
-  }
-}
-
-auto SeqScanExecutor::Next(Tuple *tuple, RID *rid) -> bool {
-  if (this->it_ == nullptr) {
-    return false;
-  }
-  while (true) {
-    if (this->it_->IsEnd()) {
-      auto now_txn = exec_ctx_->GetTransaction();
-      if (now_txn->GetIsolationLevel() == IsolationLevel::READ_COMMITTED && !exec_ctx_->IsDelete()) {
-        if (now_txn->GetIntentionExclusiveTableLockSet()->count(plan_->GetTableOid()) == 0) {
-          ReleaseTableLock(plan_->GetTableOid());
-        }
-      }
-      delete this->it_;
-      this->it_ = nullptr;
-      return false;
-    }
-    *tuple = this->it_->GetTuple().second;
-    *rid = tuple->GetRid();
-
-    if (exec_ctx_->IsDelete()) {
-      AcquireRowLock(LockManager::LockMode::EXCLUSIVE, plan_->GetTableOid(), tuple->GetRid());
-    } else {
-      auto now_txn = exec_ctx_->GetTransaction();
-      if (!(now_txn->GetIsolationLevel() == IsolationLevel::READ_UNCOMMITTED)) {
-        if (now_txn->GetExclusiveRowLockSet()->count(plan_->GetTableOid()) == 0 ||
-            now_txn->GetExclusiveRowLockSet()->at(plan_->GetTableOid()).count(tuple->GetRid()) == 0) {
-          AcquireRowLock(LockManager::LockMode::SHARED, plan_->GetTableOid(), tuple->GetRid());
-        }
-      }
-    }
-
-    auto tuple_meta = this->it_->GetTuple().first;
-    // 检查两个点,如果其中某个点没有满足,就要强制unlock(或的关系)
-    //     1. 这个tuple已经被标记删除
-    //     2. 假如上层结点是一个filter过滤结点,而这个tuple不满足过滤的条件
-    if (tuple_meta.is_deleted_ ||
-        (plan_->filter_predicate_ != nullptr &&
-         plan_->filter_predicate_->Evaluate(tuple, exec_ctx_->GetCatalog()->GetTable(plan_->GetTableOid())->schema_)
-                 .CompareEquals(bustub::ValueFactory::GetBooleanValue(false)) == CmpBool::CmpTrue)) {
-      // 必须判断是否为RUC,因为RUC不能拿读锁,而这个地方如果要解读锁,且事务隔离级别是RUC,那么解的话
-      // 由于之前没有拿过读锁,故会在LOCKROW中将事务状态置为ABORTED,但是根据提交来看这是一种需要特判
-      // 的情况,因为BUSTUB认为如果一个事务如果是RUC的话,在拿完读锁后状态变为ABORTED是非法的
-      if (exec_ctx_->GetTransaction()->GetIsolationLevel() != IsolationLevel::READ_UNCOMMITTED) {
-        if (exec_ctx_->GetTransaction()->GetExclusiveRowLockSet()->count(plan_->GetTableOid()) == 0 ||
-            exec_ctx_->GetTransaction()->GetExclusiveRowLockSet()->at(plan_->GetTableOid()).count(tuple->GetRid()) ==
-                0) {
-          ReleaseRowLock(plan_->GetTableOid(), tuple->GetRid(), true);
-        }
-      }
-      ++(*(this->it_));
-      continue;
-    }
-    *tuple = this->it_->GetTuple().second;
-    *rid = tuple->GetRid();
-    auto txn = exec_ctx_->GetTransaction();
-    if (txn->GetIsolationLevel() == IsolationLevel::READ_COMMITTED) {
-      if (exec_ctx_->GetTransaction()->GetExclusiveRowLockSet()->count(plan_->GetTableOid()) == 0 ||
-          exec_ctx_->GetTransaction()->GetExclusiveRowLockSet()->at(plan_->GetTableOid()).count(tuple->GetRid()) == 0) {
-        ReleaseRowLock(plan_->GetTableOid(), tuple->GetRid(), false);
-      }
-    }
-
-    ++(*(this->it_));
-    return true;
-  }
-}
-
-}  // namespace bustub
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// seq_scan_executor.cpp
+//
+// Identification: src/execution/seq_scan_executor.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/executors/seq_scan_executor.h"
+
+#include <tuple>
+
+#include "common/exception.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+/**
+ * Rewrite a filter to run on the stored tuples of a dictionary-encoded table: an encoded column compared for
+ * (in)equality with another encoded column or a string constant compares codes instead. Codes of one table never
+ * change, equal strings have equal codes.
+ * @return nullptr if an encoded column is used any other way, or a constant has no code yet and a row holding it may
+ * still be written while scanning; the filter then runs on decoded tuples
+ */
+auto RewriteForCodes(const AbstractExpressionRef &expr, TableDictionary *dictionary) -> AbstractExpressionRef {
+  if (const auto *column = dynamic_cast<const ColumnValueExpression *>(expr.get()); column != nullptr) {
+    return dictionary->IsEncoded(column->GetColIdx()) ? nullptr : expr;
+  }
+  const auto *comparison = dynamic_cast<const ComparisonExpression *>(expr.get());
+  if (comparison != nullptr &&
+      (comparison->comp_type_ == ComparisonType::Equal || comparison->comp_type_ == ComparisonType::NotEqual)) {
+    bool has_encoded_column = false;
+    std::vector<AbstractExpressionRef> sides;
+    for (const auto &side : comparison->GetChildren()) {
+      if (const auto *column = dynamic_cast<const ColumnValueExpression *>(side.get());
+          column != nullptr && dictionary->IsEncoded(column->GetColIdx())) {
+        has_encoded_column = true;
+        sides.push_back(std::make_shared<ColumnValueExpression>(0, column->GetColIdx(), TypeId::INTEGER));
+        continue;
+      }
+      const auto *constant = dynamic_cast<const ConstantValueExpression *>(side.get());
+      if (constant == nullptr || constant->val_.GetTypeId() != TypeId::VARCHAR) {
+        break;
+      }
+      if (constant->val_.IsNull()) {
+        sides.push_back(std::make_shared<ConstantValueExpression>(ValueFactory::GetNullValueByType(TypeId::INTEGER)));
+        continue;
+      }
+      auto code = dictionary->Lookup(constant->val_);
+      if (code == std::nullopt) {
+        return nullptr;
+      }
+      sides.push_back(std::make_shared<ConstantValueExpression>(ValueFactory::GetIntegerValue(*code)));
+    }
+    if (has_encoded_column && sides.size() == 2) {
+      return comparison->CloneWithChildren(std::move(sides));
+    }
+  }
+  if (expr->GetChildren().empty()) {
+    return expr;
+  }
+  std::vector<AbstractExpressionRef> children;
+  for (const auto &child : expr->GetChildren()) {
+    auto rewritten = RewriteForCodes(child, dictionary);
+    if (rewritten == nullptr) {
+      return nullptr;
+    }
+    children.push_back(std::move(rewritten));
+  }
+  return expr->CloneWithChildren(std::move(children));
+}
+
+}  // namespace
+
+auto SeqScanExecutor::GetCodeUse(const AbstractExpressionRef &expr, const TableDictionary &dictionary) -> CodeUse {
+  if (const auto *column = dynamic_cast<const ColumnValueExpression *>(expr.get()); column != nullptr) {
+    return dictionary.IsEncoded(column->GetColIdx()) ? CodeUse::Column : CodeUse::None;
+  }
+  for (const auto &child : expr->GetChildren()) {
+    if (GetCodeUse(child, dictionary) != CodeUse::None) {
+      return CodeUse::Other;
+    }
+  }
+  return CodeUse::None;
+}
+
+auto SeqScanExecutor::GetDictionary() const -> TableDictionary * {
+  return exec_ctx_->GetCatalog()->GetTable(plan_->GetTableOid())->table_->GetDictionary();
+}
+
+SeqScanExecutor::SeqScanExecutor(ExecutorContext *exec_ctx, const SeqScanPlanNode *plan)
+    : AbstractExecutor(exec_ctx), plan_(plan) {
+  // this->plan_ = plan;
+  // this->Init();
+}
+
+SeqScanExecutor::~SeqScanExecutor() {
+  if (this->it_ != nullptr) {
+    delete this->it_;
+    this->it_ = nullptr;
+  }
+}
+
+void SeqScanExecutor::Init() {
+  auto oid = plan_->GetTableOid();
+  if (exec_ctx_->IsDelete()) {
+    AcquireTableLock(LockManager::LockMode::INTENTION_EXCLUSIVE, oid);
+  } else {
+    auto now_txn = exec_ctx_->GetTransaction();
+    if (!(now_txn->GetIsolationLevel() == IsolationLevel::READ_UNCOMMITTED)) {
+      if (!(now_txn->GetExclusiveTableLockSet()->count(oid) > 0)) {
+        if (!(now_txn->GetIntentionExclusiveTableLockSet()->count(oid) > 0)) {
+          AcquireTableLock(LockManager::LockMode::INTENTION_SHARED, oid);
+        }
+      }
+    }
+  }
+
+  auto cata_log = exec_ctx_->GetCatalog();
+  auto table_info = cata_log->GetTable(plan_->GetTableOid());
+  auto get_table = table_info->table_.get();
+  table_schema_ = &table_info->schema_;
+
+  // 重新Init(比如作为join的内表)的时候,上一轮没走完的迭代器还pin着页
+  delete this->it_;
+  this->it_ = new TableIterator(get_table->MakeEagerIterator());
+
+  zone_map_ = get_table->GetZoneMap();
+  zone_bounds_.clear();
+  checked_page_id_ = INVALID_PAGE_ID;
+  if (zone_map_ != nullptr && plan_->filter_predicate_ != nullptr) {
+    CollectColumnBounds(plan_->filter_predicate_, zone_bounds_);
+  }
+
+  dictionary_ = get_table->GetDictionary();
+  code_filter_ = nullptr;
+  if (dictionary_ != nullptr && plan_->filter_predicate_ != nullptr) {
+    code_filter_ = RewriteForCodes(plan_->filter_predicate_, dictionary_);
+  }
+}
+
+auto SeqScanExecutor::PageMayMatch(page_id_t page_id) -> bool {
+  for (const auto &bound : zone_bounds_) {
+    const Value *low = nullptr;
+    const Value *high = nullptr;
+    bool inclusive = true;
+    switch (bound.comp_type_) {
+      case ComparisonType::Equal:
+        low = high = &bound.value_;
+        break;
+      case ComparisonType::LessThan:
+        inclusive = false;
+        high = &bound.value_;
+        break;
+      case ComparisonType::LessThanOrEqual:
+        high = &bound.value_;
+        break;
+      case ComparisonType::GreaterThan:
+        inclusive = false;
+        low = &bound.value_;
+        break;
+      case ComparisonType::GreaterThanOrEqual:
+        low = &bound.value_;
+        break;
+      default:
+        continue;
+    }
+    if (!zone_map_->MayContain(page_id, bound.col_idx_, low, inclusive, high, inclusive)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void SeqScanExecutor::AcquireTableLock(const LockManager::LockMode &request_lock_mode, const table_oid_t &oid) {
+  try {
+    bool res = exec_ctx_->GetLockManager()->LockTable(exec_ctx_->GetTransaction(), request_lock_mode, oid);
+    if (!res) {
+      switch (request_lock_mode) {
+        case LockManager::LockMode::EXCLUSIVE: {
+          throw ExecutionException("seq_scan_executor acquire X Table lock fail");
+          break;
+        }
+        case LockManager::LockMode::INTENTION_EXCLUSIVE: {
+          throw ExecutionException("seq_scan_executor acquire IX Table lock fail");
+          break;
+        }
+        case LockManager::LockMode::SHARED: {
+          throw ExecutionException("seq_scan_executor acquire S Table lock fail");
+          break;
+        }
+        case LockManager::LockMode::INTENTION_SHARED: {
+          throw ExecutionException("seq_scan_executor acquire IS Table lock fail");
+          break;
+        }
+        case LockManager::LockMode::SHARED_INTENTION_EXCLUSIVE: {
+          throw ExecutionException("seq_scan_executor acquire SIX Table lock fail");
+          break;
+        }
+      }
+    }
+  } catch (TransactionAbortException &e) {
+    throw ExecutionException(e.GetInfo());
+    // std::cout<<e.GetInfo()<<std::endl;
+  }
+}
+
+void SeqScanExecutor::ReleaseTableLock(const table_oid_t &oid) {
+  try {
+    bool res = exec_ctx_->GetLockManager()->UnlockTable(exec_ctx_->GetTransaction(), oid);
+    if (!res) {
+      throw ExecutionException("seq_scan_executor unlock fail");
+    }
+  } catch (TransactionAbortException &e) {
+    throw ExecutionException(e.GetInfo());
+  }
+}
+
+void SeqScanExecutor::AcquireRowLock(const LockManager::LockMode &request_lock_mode, const table_oid_t &oid,
+                                     const RID &rid) {
+  try {
+    bool res = exec_ctx_->GetLockManager()->LockRow(exec_ctx_->GetTransaction(), request_lock_mode, oid, rid);
+    if (!res) {
+      switch (request_lock_mode) {
+        case LockManager::LockMode::EXCLUSIVE: {
+          throw ExecutionException("seq_scan_executor acquire X ROW lock fail");
+          break;
+        }
+        case LockManager::LockMode::SHARED: {
+          throw ExecutionException("seq_scan_executor acquire S ROW lock fail");
+          break;
+        }
+        case LockManager::LockMode::INTENTION_SHARED:
+        case LockManager::LockMode::INTENTION_EXCLUSIVE:
+        case LockManager::LockMode::SHARED_INTENTION_EXCLUSIVE:
+          break;
+      }
+    }
+  } catch (TransactionAbortException &e) {
+    throw ExecutionException(e.GetInfo());
+    // std::cout<<e.GetInfo()<<std::endl;
+  }
+}
+
+void SeqScanExecutor::ReleaseRowLock(const table_oid_t &oid, const RID &rid, bool force) {
+  try {
+    bool res = exec_ctx_->GetLockManager()->UnlockRow(exec_ctx_->GetTransaction(), oid, rid, force);
+    if (!res) {
+      throw ExecutionException("seq_scan_executor unlock Row fail");
+    }
+  } catch (TransactionAbortException &e) {
+    throw ExecutionException(e.GetInfo());
+  }
+}
+
+auto SeqScanExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  if (this->it_ == nullptr) {
+    return false;
+  }
+  while (true) {
+    if (this->it_->IsEnd()) {
+      auto now_txn = exec_ctx_->GetTransaction();
+      if (now_txn->GetIsolationLevel() == IsolationLevel::READ_COMMITTED && !exec_ctx_->IsDelete()) {
+        // INSERT ... SELECT拿着同一张表的X锁,不能在这里放掉
+        if (now_txn->GetIntentionExclusiveTableLockSet()->count(plan_->GetTableOid()) == 0 &&
+            now_txn->GetExclusiveTableLockSet()->count(plan_->GetTableOid()) == 0) {
+          ReleaseTableLock(plan_->GetTableOid());
+        }
+      }
+      delete this->it_;
+      this->it_ = nullptr;
+      return false;
+    }
+    // 每进一页先看zone map,filter在这一页上不可能成立就整页跳过,连行锁都不用拿
+    if (!zone_bounds_.empty() && this->it_->GetRID().GetPageId() != checked_page_id_) {
+      checked_page_id_ = this->it_->GetRID().GetPageId();
+      bool may_match;
+      {
+        // zone map里一页的范围由这一页的锁保护,插入的线程拿着写锁改它
+        auto page_guard = this->it_->LatchPage();
+        may_match = PageMayMatch(checked_page_id_);
+      }
+      if (!may_match) {
+        this->it_->NextPage();
+        continue;
+      }
+    }
+    // 行锁只要rid,先拿锁再读,读到的就是拿到锁以后的样子
+    *rid = this->it_->GetRID();
+
+    if (exec_ctx_->IsDelete()) {
+      AcquireRowLock(LockManager::LockMode::EXCLUSIVE, plan_->GetTableOid(), *rid);
+    } else {
+      auto now_txn = exec_ctx_->GetTransaction();
+      if (!(now_txn->GetIsolationLevel() == IsolationLevel::READ_UNCOMMITTED)) {
+        if (now_txn->GetExclusiveRowLockSet()->count(plan_->GetTableOid()) == 0 ||
+            now_txn->GetExclusiveRowLockSet()->at(plan_->GetTableOid()).count(*rid) == 0) {
+          AcquireRowLock(LockManager::LockMode::SHARED, plan_->GetTableOid(), *rid);
+        }
+      }
+    }
+
+    // 迭代器pin着当前页,读一行只拿页的读锁,不经过缓冲池。PAX表只读上层用到的那几列
+    // 持着页的读锁直接在页上算filter,只有满足条件的行才拷贝出来
+    // 检查两个点,如果其中某个点没有满足,就要强制unlock(或的关系)
+    //     1. 这个tuple已经被标记删除
+    //     2. 假如上层结点是一个filter过滤结点,而这个tuple不满足过滤的条件(结果是NULL也算不满足,和filter结点一致)
+    const auto *read_columns = plan_->read_columns_.has_value() ? &*plan_->read_columns_ : nullptr;
+    bool matched;
+    if (code_filter_ != nullptr || (emit_stored_ && dictionary_ != nullptr)) {
+      // 在编码的行上比code,满足条件才解码;上层要编码的行就原样拷出去
+      auto page_guard = this->it_->LatchPage();
+      auto [tuple_meta, view] = this->it_->GetStoredTupleView(page_guard, read_columns);
+      matched = !tuple_meta.is_deleted_;
+      if (matched && code_filter_ != nullptr) {
+        matched = code_filter_->EvaluateView(view, dictionary_->GetStoredSchema())
+                      .CompareEquals(bustub::ValueFactory::GetBooleanValue(true)) == CmpBool::CmpTrue;
+      } else if (matched && plan_->filter_predicate_ != nullptr) {
+        // filter换不成比code,只能解码了再算
+        auto decoded = dictionary_->Decode(view);
+        matched = plan_->filter_predicate_->Evaluate(&decoded, *table_schema_)
+                      .CompareEquals(bustub::ValueFactory::GetBooleanValue(true)) == CmpBool::CmpTrue;
+      }
+      if (matched) {
+        *tuple = emit_stored_ ? view.Materialize() : dictionary_->Decode(view);
+      }
+    } else {
+      auto page_guard = this->it_->LatchPage();
+      auto [tuple_meta, view] = this->it_->GetTupleView(page_guard, read_columns);
+      matched = !tuple_meta.is_deleted_ &&
+                (plan_->filter_predicate_ == nullptr ||
+                 plan_->filter_predicate_->EvaluateView(view, *table_schema_)
+                         .CompareEquals(bustub::ValueFactory::GetBooleanValue(true)) == CmpBool::CmpTrue);
+      if (matched) {
+        *tuple = view.Materialize();
+      }
+    }
+    if (!matched) {
+      // 必须判断是否为RUC,因为RUC不能拿读锁,而这个地方如果要解读锁,且事务隔离级别是RUC,那么解的话
+      // 由于之前没有拿过读锁,故会在LOCKROW中将事务状态置为ABORTED,但是根据提交来看这是一种需要特判
+      // 的情况,因为BUSTUB认为如果一个事务如果是RUC的话,在拿完读锁后状态变为ABORTED是非法的
+      if (exec_ctx_->GetTransaction()->GetIsolationLevel() != IsolationLevel::READ_UNCOMMITTED) {
+        if (exec_ctx_->GetTransaction()->GetExclusiveRowLockSet()->count(plan_->GetTableOid()) == 0 ||
+            exec_ctx_->GetTransaction()->GetExclusiveRowLockSet()->at(plan_->GetTableOid()).count(*rid) == 0) {
+          ReleaseRowLock(plan_->GetTableOid(), *rid, true);
+        }
+      }
+      ++(*(this->it_));
+      continue;
+    }
+    auto txn = exec_ctx_->GetTransaction();
+    if (txn->GetIsolationLevel() == IsolationLevel::READ_COMMITTED) {
+      if (exec_ctx_->GetTransaction()->GetExclusiveRowLockSet()->count(plan_->GetTableOid()) == 0 ||
+          exec_ctx_->GetTransaction()->GetExclusiveRowLockSet()->at(plan_->GetTableOid()).count(*rid) == 0) {
+        ReleaseRowLock(plan_->GetTableOid(), *rid, false);
+      }
+    }
+
+    ++(*(this->it_));
+    return true;
+  }
+}
+
+}  // namespace bustub
@@ -9,7 +9,10 @@
 // Copyright (c) 2015-2021, Carnegie Mellon University Database Group
 //
 //===----------------------------------------------------------------------===//
+#include <cstring>
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include "execution/executors/update_executor.h"
 
@@ -25,6 +28,17 @@ UpdateExecutor::UpdateExecutor(ExecutorContext *exec_ctx, const UpdatePlanNode *
 void UpdateExecutor::Init() {
   auto catalog = exec_ctx_->GetCatalog();
   auto table_oid = plan_->TableOid();
+  // 先拿表的IX锁再读索引列表:排在CREATE INDEX的S锁后面的语句,等到锁的时候新索引已经发布了,要一起维护
+  try {
+    bool success =
+        exec_ctx_->GetLockManager()->LockTable(exec_ctx_->GetTransaction(), LockManager::LockMode::INTENTION_EXCLUSIVE,
+                                               table_oid);
+    if (!success) {
+      throw ExecutionException("update_executor acquire Table IX Lock Fail");
+    }
+  } catch (TransactionAbortException &e) {
+    throw ExecutionException(e.GetInfo());
+  }
   this->table_info_ = catalog->GetTable(table_oid);
   auto table_name = this->table_info_->name_;
   this->index_info_ = catalog->GetTableIndexes(table_name);
@@ -36,40 +50,55 @@ auto UpdateExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) -> bool {
   // 准备tuple和rid接收子算子的tuple
   Tuple temp_tuple;
   RID temp_rid;
-  // 1.遍历子算子的每一个tuple,这个地方可以写循环也可以一次Next就拿一个tuple
-  int update_num = 0;
+  // 1.先把子算子要改的tuple全读出来再动表,不然挪到表尾的新版本会又被扫描读到,改了又改
+  std::vector<std::pair<Tuple, RID>> old_tuples;
   while (this->child_executor_->Next(&temp_tuple, &temp_rid)) {
-    // 2.根据子算子的tuple找到对应要修改的tuple，修改其meta为删除的状态
-    TupleMeta delete_meta{};
-    delete_meta.delete_txn_id_ = delete_meta.insert_txn_id_ = INVALID_TXN_ID;
-    delete_meta.is_deleted_ = true;
-    table_info_->table_->UpdateTupleMeta(delete_meta, temp_rid);  // 修改table的meta
-
-    // 3.插入新的tuple,新的tuple需要从plan中拿
-    delete_meta.is_deleted_ = false;
+    old_tuples.emplace_back(std::move(temp_tuple), temp_rid);
+  }
+  int update_num = 0;
+  for (const auto &[old_tuple, old_rid] : old_tuples) {
+    // 2.新的tuple需要从plan中拿
     std::vector<bustub::Value> value_insert;
     for (const auto &expr : plan_->target_expressions_) {
-      value_insert.emplace_back(expr->Evaluate(&temp_tuple, table_info_->schema_));
+      value_insert.emplace_back(expr->Evaluate(&old_tuple, table_info_->schema_));
     }
     Tuple inserted_tuple{value_insert, &table_info_->schema_};
-    auto inserted_rid = table_info_->table_->InsertTuple(delete_meta, inserted_tuple);  // 复用meta
-    if (inserted_rid == std::nullopt) {
-      std::cout << "插入过于巨大,可能出错了" << std::endl;
-      continue;
+
+    // 3.新tuple放得回原来的位置就原地改,rid不变;放不下才把旧的标记删除,再插入新的
+    TupleMeta tuple_meta{INVALID_TXN_ID, INVALID_TXN_ID, false};
+    RID inserted_rid = old_rid;
+    if (!table_info_->table_->UpdateTupleInPlace(tuple_meta, inserted_tuple, old_rid)) {
+      tuple_meta.is_deleted_ = true;
+      table_info_->table_->UpdateTupleMeta(tuple_meta, old_rid);
+      tuple_meta.is_deleted_ = false;
+      auto new_rid = table_info_->table_->InsertTuple(tuple_meta, inserted_tuple);
+      // 旧的已经标记删除了,跳过这一行就等于悄悄删掉它,只能报错
+      if (new_rid == std::nullopt) {
+        throw ExecutionException("updated tuple is too large to insert");
+      }
+      inserted_rid = *new_rid;
     }
+
     // 4.更新索引
     for (auto &index_info : this->index_info_) {
-      // 这里理论上应该只能获取到B_PLUS_TREE的index,其他都没有实现
-      // auto index = dynamic_cast<BPlusTreeIndexForTwoIntegerColumn *>(index_info->index_.get());
+      auto *index = index_info->index_.get();
       // 首先拿到插入的这条tuple的key,可以看到在tuple.h中有一个KeyFromTuple的方法专门用于计算并获取一个tuple的key
-      auto insert_tuple_key = inserted_tuple.KeyFromTuple(
-          this->table_info_->schema_, *(index_info->index_->GetKeySchema()), index_info->index_->GetKeyAttrs());
+      auto insert_tuple_key =
+          inserted_tuple.KeyFromTuple(this->table_info_->schema_, *(index->GetEntrySchema()), index->GetEntryAttrs());
+      // rid没变,键列和include列也都没变的索引,里面的索引项还是对的,不用动
+      if (inserted_rid == old_rid) {
+        auto old_entry =
+            old_tuple.KeyFromTuple(this->table_info_->schema_, *(index->GetEntrySchema()), index->GetEntryAttrs());
+        if (old_entry.GetLength() == insert_tuple_key.GetLength() &&
+            memcmp(old_entry.GetData(), insert_tuple_key.GetData(), old_entry.GetLength()) == 0) {
+          continue;
+        }
+      }
       // 更新索引,包括删除原来的tuple的索引和插入新tuple的索引
-      auto delete_tuple = this->table_info_->table_->GetTuple(temp_rid).second;
-      auto delete_tuple_key = delete_tuple.KeyFromTuple(
-          this->table_info_->schema_, *(index_info->index_->GetKeySchema()), index_info->index_->GetKeyAttrs());
-      index_info->index_->DeleteEntry(delete_tuple_key, temp_rid, exec_ctx_->GetTransaction());
-      index_info->index_->InsertEntry(insert_tuple_key, *inserted_rid, exec_ctx_->GetTransaction());
+      auto delete_tuple_key =
+          old_tuple.KeyFromTuple(this->table_info_->schema_, *(index->GetKeySchema()), index->GetKeyAttrs());
+      index->DeleteEntry(delete_tuple_key, old_rid, exec_ctx_->GetTransaction());
+      index->InsertEntry(insert_tuple_key, inserted_rid, exec_ctx_->GetTransaction());
     }
     update_num++;
   }
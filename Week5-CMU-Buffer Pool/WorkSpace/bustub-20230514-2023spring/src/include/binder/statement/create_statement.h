@@ -11,6 +11,7 @@
 #include <vector>
 
 #include "binder/bound_statement.h"
+#include "catalog/catalog.h"
 #include "catalog/column.h"
 
 namespace duckdb_libpgquery {
@@ -21,11 +22,18 @@ namespace bustub {
 
 class CreateStatement : public BoundStatement {
  public:
-  explicit CreateStatement(std::string table, std::vector<Column> columns);
+  explicit CreateStatement(std::string table, std::vector<Column> columns, TableLayout layout = TableLayout::Row,
+                           TableEncoding encoding = TableEncoding::Plain);
 
   std::string table_;
   std::vector<Column> columns_;
 
+  /** How the table heap lays out its pages, WITH (layout = 'pax') stores each column in its own mini-page */
+  TableLayout layout_;
+
+  /** How the table heap stores VARCHAR values, WITH (encoding = 'dictionary') stores codes of a table dictionary */
+  TableEncoding encoding_;
+
   auto ToString() const -> std::string override;
 };
 
@@ -14,6 +14,7 @@
 #include "binder/bound_statement.h"
 #include "binder/expressions/bound_column_ref.h"
 #include "binder/table_ref/bound_base_table_ref.h"
+#include "catalog/catalog.h"
 #include "catalog/column.h"
 
 namespace bustub {
@@ -21,7 +22,9 @@ namespace bustub {
 class IndexStatement : public BoundStatement {
  public:
   explicit IndexStatement(std::string index_name, std::unique_ptr<BoundBaseTableRef> table,
-                          std::vector<std::unique_ptr<BoundColumnRef>> cols);
+                          std::vector<std::unique_ptr<BoundColumnRef>> cols, bool unique = false,
+                          std::vector<std::unique_ptr<BoundColumnRef>> include_cols = {},
+                          IndexType index_type = IndexType::BPlusTreeIndex);
 
   /** Name of the index */
   std::string index_name_;
@@ -32,6 +35,15 @@ class IndexStatement : public BoundStatement {
   /** Name of the columns */
   std::vector<std::unique_ptr<BoundColumnRef>> cols_;
 
+  /** Whether the index rejects duplicate keys (CREATE UNIQUE INDEX) */
+  bool unique_;
+
+  /** Non-key columns stored in the index entries, WITH (include = 'col, ...') */
+  std::vector<std::unique_ptr<BoundColumnRef>> include_cols_;
+
+  /** The data structure backing the index, CREATE INDEX ... USING HASH picks the hash table */
+  IndexType index_type_;
+
   auto ToString() const -> std::string override;
 };
 
@@ -12,9 +12,11 @@
 
 #pragma once
 
+#include <atomic>
 #include <list>
 #include <memory>
 #include <mutex>  // NOLINT
+#include <optional>
 #include <unordered_map>
 
 #include "buffer/lru_k_replacer.h"
@@ -121,6 +123,17 @@ class BufferPoolManager {
   auto FetchPageRead(page_id_t page_id) -> ReadPageGuard;
   auto FetchPageWrite(page_id_t page_id) -> WritePageGuard;
 
+  /**
+   * @brief Like FetchPageWrite, but never waits for the page latch.
+   *
+   * Background work that must not stall behind foreground latches (or deadlock with them) uses this and skips pages
+   * that are busy.
+   *
+   * @param page_id, the id of the page to fetch
+   * @return a write guard, or nullopt if the page cannot be fetched or its latch is held by someone else
+   */
+  auto TryFetchPageWrite(page_id_t page_id) -> std::optional<WritePageGuard>;
+
   /**
    * TODO(P1): Add implementation
    *
@@ -172,6 +185,19 @@ class BufferPoolManager {
    */
   auto DeletePage(page_id_t page_id) -> bool;
 
+  /**
+   * @brief Reserve frames for pages an index keeps pinned for as long as it lives. Every index shares one budget of
+   * 1/RESIDENT_FRAMES_DIVISOR of the pool, so that resident pages can never pin the whole pool however many indexes
+   * there are.
+   *
+   * @param num_frames the number of pages the caller is about to pin
+   * @return false, reserving nothing, if fewer frames are left in the budget
+   */
+  auto ReserveResidentFrames(size_t num_frames) -> bool;
+
+  /** @brief Give back frames reserved with ReserveResidentFrames once their pages are unpinned. */
+  void ReleaseResidentFrames(size_t num_frames);
+
  private:
   /** Number of pages in the buffer pool. */
   const size_t pool_size_;
@@ -180,6 +206,9 @@ class BufferPoolManager {
 
   /** Array of buffer pool pages. */
   Page *pages_;
+  /** Frames resident index pages may pin in total, and how many of them are reserved. */
+  const size_t resident_budget_;
+  std::atomic<size_t> resident_frames_{0};
   /** Pointer to the disk manager. */
   DiskManager *disk_manager_ __attribute__((__unused__));
   /** Pointer to the log manager. Please ignore this for P1. */
@@ -21,8 +21,11 @@
 #include "buffer/buffer_pool_manager.h"
 #include "catalog/schema.h"
 #include "container/hash/hash_function.h"
+#include "storage/index/art_index.h"
 #include "storage/index/b_plus_tree_index.h"
+#include "storage/index/buffered_b_plus_tree_index.h"
 #include "storage/index/extendible_hash_table_index.h"
+#include "storage/index/index_builder.h"
 #include "storage/index/index.h"
 #include "storage/table/table_heap.h"
 
@@ -35,6 +38,9 @@ using table_oid_t = uint32_t;
 using column_oid_t = uint32_t;
 using index_oid_t = uint32_t;
 
+/** The data structure backing an index */
+enum class IndexType { BPlusTreeIndex, HashTableIndex, BufferedBPlusTreeIndex, ARTIndex };
+
 /**
  * The TableInfo class maintains metadata about a table.
  */
@@ -70,15 +76,17 @@ struct IndexInfo {
    * @param index_oid The unique OID for the index
    * @param table_name The name of the table on which the index is created
    * @param key_size The size of the index key, in bytes
+   * @param index_type The data structure backing the index
    */
   IndexInfo(Schema key_schema, std::string name, std::unique_ptr<Index> &&index, index_oid_t index_oid,
-            std::string table_name, size_t key_size)
+            std::string table_name, size_t key_size, IndexType index_type = IndexType::BPlusTreeIndex)
       : key_schema_{std::move(key_schema)},
         name_{std::move(name)},
         index_{std::move(index)},
         index_oid_{index_oid},
         table_name_{std::move(table_name)},
-        key_size_{key_size} {}
+        key_size_{key_size},
+        index_type_{index_type} {}
   /** The schema for the index key */
   Schema key_schema_;
   /** The name of the index */
@@ -91,6 +99,11 @@ struct IndexInfo {
   std::string table_name_;
   /** The size of the index key, in bytes */
   const size_t key_size_;
+  /**
+   * The data structure backing the index; hash indexes only answer equality lookups on the full key, ART indexes
+   * equality lookups on a key prefix
+   */
+  const IndexType index_type_;
 };
 
 /**
@@ -121,9 +134,12 @@ class Catalog {
    * @param table_name The name of the new table, note that all tables beginning with `__` are reserved for the system.
    * @param schema The schema of the new table
    * @param create_table_heap whether to create a table heap for the new table
+   * @param layout how the table heap lays tuples out in its pages
+   * @param encoding how the table heap stores VARCHAR values
    * @return A (non-owning) pointer to the metadata for the table
    */
-  auto CreateTable(Transaction *txn, const std::string &table_name, const Schema &schema, bool create_table_heap = true)
+  auto CreateTable(Transaction *txn, const std::string &table_name, const Schema &schema, bool create_table_heap = true,
+                   TableLayout layout = TableLayout::Row, TableEncoding encoding = TableEncoding::Plain)
       -> TableInfo * {
     if (table_names_.count(table_name) != 0) {
       return NULL_TABLE_INFO;
@@ -136,7 +152,7 @@ class Catalog {
     // When create_table_heap == false, it means that we're running binder tests (where no txn will be provided) or
     // we are running shell without buffer pool. We don't need to create TableHeap in this case.
     if (create_table_heap) {
-      table = std::make_unique<TableHeap>(bpm_);
+      table = std::make_unique<TableHeap>(bpm_, &schema, layout, encoding);
     }
 
     // Fetch the table OID for the new table
@@ -196,12 +212,17 @@ class Catalog {
    * @param key_attrs Key attributes
    * @param keysize Size of the key
    * @param hash_function The hash function for the index
+   * @param is_unique Whether the index rejects duplicate keys
+   * @param include_attrs Non-key columns stored in the index entries
+   * @param index_type The data structure backing the index
    * @return A (non-owning) pointer to the metadata of the new table
    */
   template <class KeyType, class ValueType, class KeyComparator>
   auto CreateIndex(Transaction *txn, const std::string &index_name, const std::string &table_name, const Schema &schema,
                    const Schema &key_schema, const std::vector<uint32_t> &key_attrs, std::size_t keysize,
-                   HashFunction<KeyType> hash_function) -> IndexInfo * {
+                   HashFunction<KeyType> hash_function, bool is_unique = true,
+                   const std::vector<uint32_t> &include_attrs = {},
+                   IndexType index_type = IndexType::BPlusTreeIndex) -> IndexInfo * {
     // Reject the creation request for nonexistent table
     if (table_names_.find(table_name) == table_names_.end()) {
       return NULL_INDEX_INFO;
@@ -211,41 +232,77 @@ class Catalog {
     BUSTUB_ASSERT((index_names_.find(table_name) != index_names_.end()), "Broken Invariant");
 
     // Determine if the requested index already exists for this table
-    auto &table_indexes = index_names_.find(table_name)->second;
-    if (table_indexes.find(index_name) != table_indexes.end()) {
+    if (GetIndex(index_name, table_name) != NULL_INDEX_INFO) {
       // The requested index already exists for this table
       return NULL_INDEX_INFO;
     }
 
+    return PublishIndex(BuildIndex<KeyType, ValueType, KeyComparator>(txn, index_name, GetTable(table_name), schema,
+                                                                       key_schema, key_attrs, keysize, hash_function,
+                                                                       is_unique, include_attrs, index_type));
+  }
+
+  /**
+   * Construct a new index and populate it with the existing data of the table, without registering it in the catalog.
+   * Only the table is read, so the build can run without holding the catalog; the caller must keep the table from
+   * being modified until the index is published. The parameters are the same as CreateIndex.
+   * @return The metadata of the new index, its OID is assigned by PublishIndex
+   */
+  template <class KeyType, class ValueType, class KeyComparator>
+  auto BuildIndex(Transaction *txn, const std::string &index_name, TableInfo *table_info, const Schema &schema,
+                  const Schema &key_schema, const std::vector<uint32_t> &key_attrs, std::size_t keysize,
+                  HashFunction<KeyType> hash_function, bool is_unique = true,
+                  const std::vector<uint32_t> &include_attrs = {},
+                  IndexType index_type = IndexType::BPlusTreeIndex) -> std::unique_ptr<IndexInfo> {
     // Construct index metdata
-    auto meta = std::make_unique<IndexMetadata>(index_name, table_name, &schema, key_attrs);
+    auto meta =
+        std::make_unique<IndexMetadata>(index_name, table_info->name_, &schema, key_attrs, is_unique, include_attrs);
 
     // Construct the index, take ownership of metadata
-    // TODO(Kyle): We should update the API for CreateIndex
-    // to allow specification of the index type itself, not
-    // just the key, value, and comparator types
-
-    // TODO(chi): support both hash index and btree index
-    auto index = std::make_unique<BPlusTreeIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_);
+    std::unique_ptr<Index> index;
+    if (index_type == IndexType::HashTableIndex) {
+      index = std::make_unique<ExtendibleHashTableIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_,
+                                                                                             hash_function);
+    } else if (index_type == IndexType::ARTIndex) {
+      index = std::make_unique<ARTIndex>(std::move(meta));
+    } else if (index_type == IndexType::BufferedBPlusTreeIndex) {
+      index = std::make_unique<BufferedBPlusTreeIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_);
+    } else {
+      index = std::make_unique<BPlusTreeIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_);
+    }
 
     // Populate the index with all tuples in table heap
-    auto *table_meta = GetTable(table_name);
-    for (auto iter = table_meta->table_->MakeIterator(); !iter.IsEnd(); ++iter) {
-      auto [meta, tuple] = iter.GetTuple();
-      index->InsertEntry(tuple.KeyFromTuple(schema, key_schema, key_attrs), tuple.GetRid(), txn);
+    BuildIndexFromHeap(index.get(), table_info->table_.get(), schema, txn);
+    // the index starts out with statistics of the rows it was built from, including the key histogram
+    index->RefreshStatistics();
+
+    // Construct index information; IndexInfo takes ownership of the Index itself
+    return std::make_unique<IndexInfo>(key_schema, index_name, std::move(index), 0, table_info->name_, keysize,
+                                       index_type);
+  }
+
+  /**
+   * Register an index built by BuildIndex and assign its OID.
+   * @param index_info The index to register
+   * @return A (non-owning) pointer to the metadata of the index, NULL_INDEX_INFO if the table already has an index of
+   * the same name
+   */
+  auto PublishIndex(std::unique_ptr<IndexInfo> &&index_info) -> IndexInfo * {
+    auto table_indexes = index_names_.find(index_info->table_name_);
+    BUSTUB_ASSERT((table_indexes != index_names_.end()), "Broken Invariant");
+    if (table_indexes->second.find(index_info->name_) != table_indexes->second.end()) {
+      // Another index of the same name was published while this one was built
+      return NULL_INDEX_INFO;
     }
 
     // Get the next OID for the new index
     const auto index_oid = next_index_oid_.fetch_add(1);
-
-    // Construct index information; IndexInfo takes ownership of the Index itself
-    auto index_info =
-        std::make_unique<IndexInfo>(key_schema, index_name, std::move(index), index_oid, table_name, keysize);
+    index_info->index_oid_ = index_oid;
     auto *tmp = index_info.get();
 
     // Update internal tracking
+    table_indexes->second.emplace(index_info->name_, index_oid);
     indexes_.emplace(index_oid, std::move(index_info));
-    table_indexes.emplace(index_name, index_oid);
 
     return tmp;
   }
@@ -298,7 +355,7 @@ class Catalog {
    * @param index_oid The OID of the index for which to query
    * @return A (non-owning) pointer to the metadata for the index
    */
-  auto GetIndex(index_oid_t index_oid) -> IndexInfo * {
+  auto GetIndex(index_oid_t index_oid) const -> IndexInfo * {
     auto index = indexes_.find(index_oid);
     if (index == indexes_.end()) {
       return NULL_INDEX_INFO;
@@ -116,8 +116,8 @@ class Column {
       case TypeId::TIMESTAMP:
         return 8;
       case TypeId::VARCHAR:
-        // TODO(Amadou): Confirm this.
-        return 12;
+        // the 2-byte offset of the value in the tuple, see tuple_offset_t
+        return 2;
       default: {
         UNREACHABLE("Cannot get size of invalid type");
       }
@@ -130,7 +130,7 @@ class Column {
   /** Column value's type. */
   TypeId column_type_;
 
-  /** For a non-inlined column, this is the size of a pointer. Otherwise, the size of the fixed length column. */
+  /** For a non-inlined column, this is the size of its offset in the tuple. Otherwise, the size of the column. */
   uint32_t fixed_length_;
 
   /** For an inlined column, 0. Otherwise, the length of the variable length column. */
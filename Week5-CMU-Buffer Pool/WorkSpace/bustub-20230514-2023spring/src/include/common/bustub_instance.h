@@ -47,6 +47,8 @@ class IndexStatement;
 class VariableSetStatement;
 class VariableShowStatement;
 class ExplainStatement;
+class AnalyzeStatement;
+class VacuumStatement;
 
 class ResultWriter {
  public:
@@ -286,6 +288,8 @@ class BustubInstance {
   void HandleExplainStatement(Transaction *txn, const ExplainStatement &stmt, ResultWriter &writer);
   void HandleVariableShowStatement(Transaction *txn, const VariableShowStatement &stmt, ResultWriter &writer);
   void HandleVariableSetStatement(Transaction *txn, const VariableSetStatement &stmt, ResultWriter &writer);
+  void HandleAnalyzeStatement(Transaction *txn, const AnalyzeStatement &stmt, ResultWriter &writer);
+  void HandleVacuumStatement(Transaction *txn, const VacuumStatement &stmt, ResultWriter &writer);
 
   std::unordered_map<std::string, std::string> session_variables_;
 };
@@ -36,6 +36,15 @@ static constexpr int BUFFER_POOL_SIZE = 10;
 static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * BUSTUB_PAGE_SIZE);  // size of a log buffer in byte
 static constexpr int BUCKET_SIZE = 50;                                               // size of extendible hash bucket
 static constexpr int LRUK_REPLACER_K = 10;  // lookback window for lru-k replacer
+static constexpr int BPLUSTREE_RESIDENT_LEVELS = 2;  // inner levels of a B+ tree index kept pinned for point lookups
+static constexpr int RESIDENT_FRAMES_DIVISOR = 8;  // all resident index pages together pin at most 1/N of the pool
+static constexpr bool BPLUSTREE_LAZY_DELETE = true;  // B+ tree indexes leave underfull leaves to the compactor
+static constexpr int BPLUSTREE_COMPACT_TRIGGER = 8;  // leaves turning sparse before the compactor is woken up
+static constexpr int BUFFERED_INDEX_CAPACITY = 256;  // messages a buffer of a buffered index holds before flushing
+static constexpr int BLOOM_FILTER_BITS_PER_KEY = 10;  // bits of an index's Bloom filter per key, ~1% false positives
+static constexpr int INDEX_HISTOGRAM_BUCKETS = 32;  // buckets of the equi-depth key histogram in index statistics
+static constexpr int TABLE_HEAP_INSERT_PAGES = 8;  // pages of a table heap that concurrent inserts fill in parallel
+static constexpr int BULK_INSERT_BATCH_SIZE = 4096;  // tuples INSERT ... SELECT appends to fresh pages at a time
 
 using frame_id_t = int32_t;    // frame id type
 using page_id_t = int32_t;     // page id type
@@ -34,6 +34,12 @@ class ReaderWriterLatch {
    */
   void WUnlock() { mutex_.unlock(); }
 
+  /**
+   * Try to acquire a write latch without blocking.
+   * @return true if the write latch is now held
+   */
+  auto TryWLock() -> bool { return mutex_.try_lock(); }
+
   /**
    * Acquire a read latch.
    */
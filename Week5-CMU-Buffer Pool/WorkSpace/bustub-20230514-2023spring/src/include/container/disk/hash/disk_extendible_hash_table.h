@@ -30,6 +30,10 @@ namespace bustub {
  * Implementation of extendible hash table that is backed by a buffer pool
  * manager. Non-unique keys are supported. Supports insert and delete. The
  * table grows/shrinks dynamically as buckets become full/empty.
+ *
+ * A full bucket that a split cannot help, because the directory is as large as
+ * one page allows or because all its entries share one hash value, grows an
+ * overflow chain of bucket pages instead.
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class DiskExtendibleHashTable {
@@ -74,6 +78,14 @@ class DiskExtendibleHashTable {
    */
   auto GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) -> bool;
 
+  /**
+   * Collects the keys of all entries, a key stored with several values is returned once per value.
+   *
+   * @param transaction the current transaction
+   * @param[out] result the keys, in no particular order
+   */
+  void GetAllKeys(Transaction *transaction, std::vector<KeyType> *result);
+
   /**
    * Returns the global depth
    */
@@ -136,6 +148,45 @@ class DiskExtendibleHashTable {
    */
   auto FetchBucketPage(page_id_t bucket_page_id) -> HASH_TABLE_BUCKET_TYPE *;
 
+  /**
+   * Collects the values associated with key from every page of a bucket. Needs the latch of the first page.
+   *
+   * @param bucket_page the first page of the bucket
+   * @param key the key to look up
+   * @param[out] result the values associated with key
+   * @return true if at least one value is found
+   */
+  auto ChainGetValue(HASH_TABLE_BUCKET_TYPE *bucket_page, const KeyType &key, std::vector<ValueType> *result) -> bool;
+
+  /**
+   * Puts a pair the bucket does not hold yet into the first page of the bucket with a free slot. Needs the write
+   * latch of the first page.
+   *
+   * @param bucket_page the first page of the bucket
+   * @param key the key to insert
+   * @param value the value to insert
+   * @param grow whether to chain a new overflow page when every page of the bucket is full
+   * @return false if the bucket is full, or a new overflow page cannot be allocated
+   */
+  auto ChainAppend(HASH_TABLE_BUCKET_TYPE *bucket_page, const KeyType &key, const ValueType &value, bool grow)
+      -> bool;
+
+  /**
+   * Removes a pair from whichever page of the bucket holds it, an overflow page left empty is unchained and deleted.
+   * Needs the write latch of the first page.
+   *
+   * @param bucket_page the first page of the bucket
+   * @param key the key to remove
+   * @param value the value to remove
+   * @return true if the pair is removed
+   */
+  auto ChainRemove(HASH_TABLE_BUCKET_TYPE *bucket_page, const KeyType &key, const ValueType &value) -> bool;
+
+  /**
+   * @return true if some entry of the bucket hashes differently from key, so that a split can separate them
+   */
+  auto ChainCanSplit(HASH_TABLE_BUCKET_TYPE *bucket_page, const KeyType &key) -> bool;
+
   /**
    * Performs insertion with an optional bucket splitting.
    *
@@ -0,0 +1,34 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// column_bound.h
+//
+// Identification: src/include/execution/column_bound.h
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "execution/expressions/abstract_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/** 形如 `column op constant` 的一个合取项 */
+struct ColumnBound {
+  uint32_t col_idx_;
+  ComparisonType comp_type_;
+  Value value_;
+};
+
+/**
+ * 把 `a AND b AND ...` 拆成若干个 `column op constant`,其余形式的合取项直接忽略(它们仍然留在filter里)。
+ * 索引扫描用它找键的范围,顺序扫描用它跳过zone map对不上的页
+ */
+void CollectColumnBounds(const AbstractExpressionRef &expr, std::vector<ColumnBound> &bounds);
+
+}  // namespace bustub
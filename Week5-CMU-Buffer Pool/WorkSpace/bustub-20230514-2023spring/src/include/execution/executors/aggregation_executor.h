@@ -21,8 +21,10 @@
 #include "container/hash/hash_function.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
+#include "execution/executors/seq_scan_executor.h"
 #include "execution/expressions/abstract_expression.h"
 #include "execution/plans/aggregation_plan.h"
+#include "storage/table/table_dictionary.h"
 #include "storage/table/tuple.h"
 #include "type/type_id.h"
 #include "type/value.h"
@@ -220,11 +222,22 @@ class AggregationExecutor : public AbstractExecutor {
   auto GetChildExecutor() const -> const AbstractExecutor *;
 
  private:
+  /**
+   * Aggregate the stored tuples of a dictionary-encoded table if the child scans one and no expression needs the
+   * strings: the group-by columns that are encoded group by their codes, and COUNT only tells NULL codes apart.
+   */
+  void AggregateCodesIfPossible();
+
+  /** @return the schema the child tuples are read with, the stored schema if they are encoded */
+  auto GetChildSchema() const -> const Schema & {
+    return dictionary_ != nullptr ? dictionary_->GetStoredSchema() : child_->GetOutputSchema();
+  }
+
   /** @return The tuple as an AggregateKey */
   auto MakeAggregateKey(const Tuple *tuple) -> AggregateKey {
     std::vector<Value> keys;
     for (const auto &expr : plan_->GetGroupBys()) {
-      keys.emplace_back(expr->Evaluate(tuple, child_->GetOutputSchema()));
+      keys.emplace_back(expr->Evaluate(tuple, GetChildSchema()));
     }
     return {keys};
   }
@@ -233,7 +246,7 @@ class AggregationExecutor : public AbstractExecutor {
   auto MakeAggregateValue(const Tuple *tuple) -> AggregateValue {
     std::vector<Value> vals;
     for (const auto &expr : plan_->GetAggregates()) {
-      vals.emplace_back(expr->Evaluate(tuple, child_->GetOutputSchema()));
+      vals.emplace_back(expr->Evaluate(tuple, GetChildSchema()));
     }
     return {vals};
   }
@@ -249,5 +262,8 @@ class AggregationExecutor : public AbstractExecutor {
   SimpleAggregationHashTable::Iterator aht_iterator_;
   /** 查看一下是否已经将tuple取完*/
   bool has_out_{false};
+  // 子节点给的是字典编码的行时,group by的编码列存的是code,输出时才解码
+  TableDictionary *dictionary_{nullptr};
+  std::vector<bool> decoded_group_bys_;
 };
 }  // namespace bustub
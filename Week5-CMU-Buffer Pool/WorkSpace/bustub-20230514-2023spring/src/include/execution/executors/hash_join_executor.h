@@ -21,7 +21,9 @@
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
 #include "execution/executors/aggregation_executor.h"
+#include "execution/executors/seq_scan_executor.h"
 #include "execution/plans/hash_join_plan.h"
+#include "storage/table/table_dictionary.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
@@ -121,10 +123,30 @@ class HashJoinExecutor : public AbstractExecutor {
   };
 
  private:
+  /**
+   * Join on codes if a side scans a dictionary-encoded table and its keys read the encoded columns only as whole
+   * columns. That side yields its stored tuples. The string keys of the other side are looked up in the same
+   * dictionary, unless both sides scan the same table and compare codes anyway.
+   */
+  void JoinCodesIfPossible();
+
+  /** @return the schema the tuples of a side are read with, the stored schema if they are encoded */
+  auto GetChildSchema(const AbstractExecutor &child, TableDictionary *dictionary) const -> const Schema & {
+    return dictionary != nullptr ? dictionary->GetStoredSchema() : child.GetOutputSchema();
+  }
+
+  /** Append the columns of a tuple of one side to an output row, decoding the tuple if that side is encoded */
+  void AppendColumns(const Tuple &tuple, const AbstractExecutor &child, TableDictionary *dictionary,
+                     std::vector<Value> *values);
+
+  /**
+   * @param lookup_keys the keys replaced by their code in lookup_dictionary, empty if none
+   */
   void AddTupleToHashTable(const Tuple &tuple,
                            std::unordered_map<AggregateKey, std::list<std::unique_ptr<Tuple> > > &hash_table,
                            const std::vector<bustub::AbstractExpressionRef> &join_key_expressions,
-                           const Schema &son_schema);
+                           const Schema &son_schema, const std::vector<bool> &lookup_keys,
+                           TableDictionary *lookup_dictionary);
   /** The NestedLoopJoin plan node to be executed. */
   const HashJoinPlanNode *plan_;
   std::unique_ptr<AbstractExecutor> left_executor_;
@@ -137,6 +159,12 @@ class HashJoinExecutor : public AbstractExecutor {
   // HashJoinTableIterator right_ht_it_;
 
   bool is_left_has_right_{false};
+  // 按code连接时,给编码的行的那一边记下它的字典,另一边的字符串键要查成这个字典里的code
+  TableDictionary *left_dictionary_{nullptr};
+  TableDictionary *right_dictionary_{nullptr};
+  std::vector<bool> left_lookup_keys_;
+  std::vector<bool> right_lookup_keys_;
+  bool codes_prepared_{false};
   // HashJoinTableIterator left_ht_end_;
   // HashJoinTableIterator right_ht_end_;
   // std::list<std::unique_ptr<Tuple> >::iterator left_ht_it_;
@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <memory>
 #include <vector>
 
 #include "common/rid.h"
@@ -42,14 +43,20 @@ class IndexScanExecutor : public AbstractExecutor {
   auto Next(Tuple *tuple, RID *rid) -> bool override;
 
  private:
+  /** 用plan中给出的前缀值构造索引键,没给出的列填NULL(比较时和任何值都相等) */
+  auto MakeBoundKey(const std::vector<Value> &prefix) const -> Tuple;
+
+  /** 只扫描索引时,用索引项里存的列拼出一个表的tuple,索引里没有的列填NULL */
+  auto MakeTupleFromEntry(const Tuple &entry) const -> Tuple;
+
   /** The index scan plan node to be executed. */
   const IndexScanPlanNode *plan_;
   /** 遍历索引信息*/
   const IndexInfo *index_info_;
   /** Metadata identifying the table that should be updated */
   const TableInfo *table_info_;
-  /** 迭代器*/
-  bustub::BPlusTreeIndexIteratorForTwoIntegerColumn iter_;
+  /** 迭代器,不依赖索引键的具体类型*/
+  std::unique_ptr<IndexScanIterator> iter_;
   /** 是否将子执行算子的每个tuple更新完*/
   // bool has_out_{false};
 };
@@ -56,6 +56,12 @@ class InsertExecutor : public AbstractExecutor {
   auto GetOutputSchema() const -> const Schema & override { return plan_->OutputSchema(); };
 
  private:
+  /**
+   * Append all tuples of the child to fresh pages in batches, then insert their index entries sorted by key.
+   * @return the number of rows inserted
+   */
+  auto BulkInsert() -> int;
+
   /** The insert plan node to be executed*/
   const InsertPlanNode *plan_;
   std::unique_ptr<AbstractExecutor> child_executor_;
@@ -64,6 +70,8 @@ class InsertExecutor : public AbstractExecutor {
   std::vector<IndexInfo *> index_info_;
   /** 防止反复插入空的元组数组*/
   bool has_out_{false};
+  /** 子算子不是VALUES的时候整批追加 */
+  bool bulk_{false};
 };
 
 }  // namespace bustub
@@ -15,10 +15,13 @@
 #include <vector>
 
 #include "concurrency/lock_manager.h"
+#include "execution/column_bound.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
 #include "execution/plans/seq_scan_plan.h"
+#include "storage/table/table_dictionary.h"
 #include "storage/table/tuple.h"
+#include "storage/table/zone_map.h"
 
 namespace bustub {
 
@@ -52,6 +55,24 @@ class SeqScanExecutor : public AbstractExecutor {
   /** @return The output schema for the sequential scan */
   auto GetOutputSchema() const -> const Schema & override { return plan_->OutputSchema(); }
 
+  /** How an expression over the tuples of a dictionary-encoded table reads the encoded columns */
+  enum class CodeUse { None, Column, Other };
+
+  /**
+   * @return None if expr reads no encoded column and evaluates the same on the stored tuples, Column if expr is an
+   * encoded column and evaluates to its code on them, Other if expr needs the decoded strings
+   */
+  static auto GetCodeUse(const AbstractExpressionRef &expr, const TableDictionary &dictionary) -> CodeUse;
+
+  /** @return the dictionary of the scanned table, nullptr if it stores its VARCHAR values inline */
+  auto GetDictionary() const -> TableDictionary *;
+
+  /**
+   * Yield the tuples of a dictionary-encoded table as stored, to be read with the stored schema of its dictionary,
+   * so that the parent compares codes and decodes only the rows it outputs. Call before Init.
+   */
+  void EmitStoredTuples() { emit_stored_ = true; }
+
   void AcquireTableLock(const LockManager::LockMode &request_lock_mode, const table_oid_t &oid);
   void ReleaseTableLock(const table_oid_t &oid);
 
@@ -59,10 +80,25 @@ class SeqScanExecutor : public AbstractExecutor {
   void ReleaseRowLock(const table_oid_t &oid, const RID &rid, bool force);
 
  private:
+  /** @return false if the zone map shows no tuple in the page can satisfy the filter */
+  auto PageMayMatch(page_id_t page_id) -> bool;
+
   /** The sequential scan plan node to be executed */
   const SeqScanPlanNode *plan_;
   /* 存储table的源信息,在init的时候存储下来,方便Next使用 */
   // TableHeap * table_;  // table本身
-  TableIterator *it_;
+  TableIterator *it_{nullptr};
+  const Schema *table_schema_{nullptr};
+
+  // filter里 `column op constant` 的合取项,每进一页先拿zone map对一下,对不上整页跳过
+  ZoneMap *zone_map_{nullptr};
+  std::vector<ColumnBound> zone_bounds_;
+  page_id_t checked_page_id_{INVALID_PAGE_ID};
+
+  // 字典编码的表,filter里编码列上的等值比较换成比code,直接在没解码的行上算,只有满足条件的行才解码
+  TableDictionary *dictionary_{nullptr};
+  AbstractExpressionRef code_filter_;
+  // 上层按code做group by或者连接,要的是没解码的行
+  bool emit_stored_{false};
 };
 }  // namespace bustub
@@ -54,6 +54,16 @@ class AbstractExpression {
   /** @return The value obtained by evaluating the tuple with the given schema */
   virtual auto Evaluate(const Tuple *tuple, const Schema &schema) const -> Value = 0;
 
+  /**
+   * Evaluate the expression on a tuple that is only viewed, e.g. while it still lies in a pinned page. Expressions that
+   * don't override this evaluate a materialized copy.
+   * @return The value obtained by evaluating the viewed tuple with the given schema
+   */
+  virtual auto EvaluateView(const TupleView &tuple, const Schema &schema) const -> Value {
+    auto materialized = tuple.Materialize();
+    return Evaluate(&materialized, schema);
+  }
+
   /**
    * Returns the value obtained by evaluating a JOIN.
    * @param left_tuple The left tuple
@@ -14,6 +14,7 @@
 
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "catalog/catalog.h"
 #include "execution/expressions/abstract_expression.h"
@@ -29,9 +30,26 @@ class IndexScanPlanNode : public AbstractPlanNode {
    * Creates a new index scan plan node.
    * @param output the output format of this scan plan node
    * @param table_oid the identifier of table to be scanned
+   * @param filter_predicate the predicate every emitted tuple must satisfy, or nullptr
+   * @param low_key values of a prefix of the index key columns bounding the scan from below, empty means unbounded
+   * @param low_inclusive whether keys equal to low_key are scanned
+   * @param high_key values of a prefix of the index key columns bounding the scan from above, empty means unbounded
+   * @param high_inclusive whether keys equal to high_key are scanned
+   * @param reverse whether the keys are produced in descending order
+   * @param index_only whether the tuples are built from the index entries without touching the table heap
    */
-  IndexScanPlanNode(SchemaRef output, index_oid_t index_oid)
-      : AbstractPlanNode(std::move(output), {}), index_oid_(index_oid) {}
+  IndexScanPlanNode(SchemaRef output, index_oid_t index_oid, AbstractExpressionRef filter_predicate = nullptr,
+                    std::vector<Value> low_key = {}, bool low_inclusive = true, std::vector<Value> high_key = {},
+                    bool high_inclusive = true, bool reverse = false, bool index_only = false)
+      : AbstractPlanNode(std::move(output), {}),
+        index_oid_(index_oid),
+        filter_predicate_(std::move(filter_predicate)),
+        low_key_(std::move(low_key)),
+        low_inclusive_(low_inclusive),
+        high_key_(std::move(high_key)),
+        high_inclusive_(high_inclusive),
+        reverse_(reverse),
+        index_only_(index_only) {}
 
   auto GetType() const -> PlanType override { return PlanType::IndexScan; }
 
@@ -45,9 +63,54 @@ class IndexScanPlanNode : public AbstractPlanNode {
 
   // Add anything you want here for index lookup
 
+  /** The predicate to filter the tuples fetched from the index, nullptr means no filter */
+  AbstractExpressionRef filter_predicate_;
+
+  /** Range of the scan. Bounds only cover a prefix of the key columns, the remaining columns are left unconstrained */
+  std::vector<Value> low_key_;
+  bool low_inclusive_;
+  std::vector<Value> high_key_;
+  bool high_inclusive_;
+
+  /** Scan the index from the largest key to the smallest one */
+  bool reverse_;
+
+  /**
+   * Every column read above the scan is stored in the index entries, so the table heap is never fetched. Columns of
+   * the output schema that are not in the index are NULL.
+   */
+  bool index_only_;
+
  protected:
   auto PlanNodeToString() const -> std::string override {
-    return fmt::format("IndexScan {{ index_oid={} }}", index_oid_);
+    std::string range;
+    if (!low_key_.empty() || !high_key_.empty()) {
+      range = fmt::format(", range={}{}, {}{}", low_inclusive_ ? "[" : "(", KeyToString(low_key_),
+                          KeyToString(high_key_), high_inclusive_ ? "]" : ")");
+    }
+    if (reverse_) {
+      range += ", reverse";
+    }
+    if (index_only_) {
+      range += ", index_only";
+    }
+    if (filter_predicate_) {
+      return fmt::format("IndexScan {{ index_oid={}{}, filter={} }}", index_oid_, range, filter_predicate_);
+    }
+    return fmt::format("IndexScan {{ index_oid={}{} }}", index_oid_, range);
+  }
+
+ private:
+  static auto KeyToString(const std::vector<Value> &key) -> std::string {
+    if (key.empty()) {
+      return "-";
+    }
+    std::vector<std::string> values;
+    values.reserve(key.size());
+    for (const auto &value : key) {
+      values.push_back(value.ToString());
+    }
+    return fmt::format("({})", fmt::join(values, ", "));
   }
 };
 
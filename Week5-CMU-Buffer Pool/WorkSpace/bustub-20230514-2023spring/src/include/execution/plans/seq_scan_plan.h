@@ -13,8 +13,10 @@
 #pragma once
 
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "binder/table_ref/bound_base_table_ref.h"
 #include "catalog/catalog.h"
@@ -62,12 +64,22 @@ class SeqScanPlanNode : public AbstractPlanNode {
   */
   AbstractExpressionRef filter_predicate_;
 
+  /**
+   * The only columns read above the scan and by its filter, set on PAX tables so that just their column mini-pages
+   * are read. The other columns of the output schema are NULL. nullopt reads whole tuples.
+   */
+  std::optional<std::vector<uint32_t>> read_columns_;
+
  protected:
   auto PlanNodeToString() const -> std::string override {
+    std::string columns;
+    if (read_columns_.has_value()) {
+      columns = fmt::format(", columns=[{}]", fmt::join(*read_columns_, ", "));
+    }
     if (filter_predicate_) {
-      return fmt::format("SeqScan {{ table={}, filter={} }}", table_name_, filter_predicate_);
+      return fmt::format("SeqScan {{ table={}{}, filter={} }}", table_name_, columns, filter_predicate_);
     }
-    return fmt::format("SeqScan {{ table={} }}", table_name_);
+    return fmt::format("SeqScan {{ table={}{} }}", table_name_, columns);
   }
 };
 
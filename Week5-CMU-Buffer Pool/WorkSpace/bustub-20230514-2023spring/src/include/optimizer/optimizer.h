@@ -79,6 +79,19 @@ class Optimizer {
    */
   auto OptimizeMergeFilterScan(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
 
+  /**
+   * @brief turn a seq scan whose filter bounds a prefix of an index key (e.g. `x = 1 AND y >= 10` on an index over
+   * (x, y)) into a range index scan, so that only the qualifying leaves are read
+   */
+  auto OptimizeSeqScanAsIndexScan(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
+
+  /**
+   * @brief mark index scans as index-only when every column read above them is stored in the index entries (the key
+   * columns plus the included columns of a covering index), so that the table heap is never fetched. Seq scans over
+   * PAX tables are told the same set of columns and read only their column mini-pages.
+   */
+  auto OptimizeIndexOnlyScan(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
+
   /**
    * @brief rewrite expression to be used in nested loop joins. e.g., if we have `SELECT * FROM a, b WHERE a.x = b.y`,
    * we will have `#0.x = #0.y` in the filter plan node. We will need to figure out where does `0.x` and `0.y` belong
@@ -109,8 +122,9 @@ class Optimizer {
   auto OptimizeSortLimitAsTopN(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
 
   /**
-   * @brief get the estimated cardinality for a table based on the table name. Useful when join reordering. BusTub
-   * doesn't support statistics for now, so it's the only way for you to get the table size :(
+   * @brief get the estimated cardinality for a table. Useful when join reordering. The entry count of the table's
+   * B+ tree indexes is used when there is one, otherwise the size is guessed from the table name suffix (`_1m`,
+   * `_100k`, ...) as for the mock tables.
    *
    * @param table_name
    * @return std::optional<size_t>
@@ -0,0 +1,82 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// art_index.h
+//
+// Identification: src/include/storage/index/art_index.h
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <utility>
+#include <vector>
+
+#include "storage/index/index.h"
+
+namespace bustub {
+
+struct ArtNode;
+
+/** Walks the entries found by an ART lookup, which are collected all at once in key order */
+class ARTIndexScanIterator : public IndexScanIterator {
+ public:
+  explicit ARTIndexScanIterator(std::vector<std::pair<RID, Tuple>> &&entries) : entries_(std::move(entries)) {}
+
+  auto IsEnd() -> bool override { return pos_ == entries_.size(); }
+
+  auto GetRID() -> RID override { return entries_[pos_].first; }
+
+  auto GetEntry() -> Tuple override { return entries_[pos_].second; }
+
+  void Next() override { pos_++; }
+
+ private:
+  std::vector<std::pair<RID, Tuple>> entries_;
+  size_t pos_{0};
+};
+
+/**
+ * An adaptive radix tree kept entirely in memory, it never touches the buffer pool. Keys are the memcmp-comparable
+ * encoding of the key columns, inner nodes grow and shrink between Node4, Node16, Node48 and Node256 with the number
+ * of children, and chains of single-child nodes are compressed into a prefix. Nothing is written to disk, the catalog
+ * rebuilds the tree from the table heap when the index is created.
+ *
+ * Lookups find the full key or a prefix of its columns; ranges over a column are not supported.
+ */
+class ARTIndex : public Index {
+ public:
+  explicit ARTIndex(std::unique_ptr<IndexMetadata> &&metadata);
+
+  ~ARTIndex() override;
+
+  auto InsertEntry(const Tuple &key, RID rid, Transaction *transaction) -> bool override;
+
+  void DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) override;
+
+  void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
+
+  /**
+   * Only equality on a prefix of the key columns is supported: both bounds must be inclusive and hold the same values
+   * on their leading columns, the remaining columns are NULL. `reverse` is ignored.
+   */
+  auto MakeScanIterator(const Tuple *low_key, bool low_inclusive, const Tuple *high_key, bool high_inclusive,
+                        bool reverse) -> std::unique_ptr<IndexScanIterator> override;
+
+ private:
+  /** Encode the first column_count key columns of key, read with schema, so that memcmp orders them like Value does */
+  static auto EncodeKey(const Tuple &key, const Schema *schema, uint32_t column_count) -> std::vector<uint8_t>;
+
+  /** Collect the entries of every key that starts with prefix, in key order */
+  void Lookup(const std::vector<uint8_t> &prefix, std::vector<std::pair<RID, Tuple>> *entries);
+
+  // writers hold it exclusively, lookups shared
+  std::shared_mutex latch_;
+  std::unique_ptr<ArtNode> root_;
+};
+
+}  // namespace bustub
@@ -11,14 +11,19 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>  // NOLINT
 #include <deque>
+#include <functional>
 #include <iostream>
+#include <mutex>  // NOLINT
 #include <optional>
 #include <queue>
 #include <shared_mutex>
 #include <stack>
 #include <string>
-// #include <thread>
+#include <thread>  // NOLINT
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -63,6 +68,14 @@ class Context {
   auto IsRootPage(page_id_t page_id) -> bool { return page_id == root_page_id_; }
 };
 
+/** The shape of a B+ tree, see BPlusTree::GetShape */
+struct BPlusTreeShape {
+  // levels from the root down to the leaves, 0 for an empty tree
+  int height_{0};
+  int internal_pages_{0};
+  int leaf_pages_{0};
+};
+
 #define BPLUSTREE_TYPE BPlusTree<KeyType, ValueType, KeyComparator>
 
 // Main class providing the API for the Interactive B+ Tree.
@@ -74,7 +87,11 @@ class BPlusTree {
  public:
   explicit BPlusTree(std::string name, page_id_t header_page_id, BufferPoolManager *buffer_pool_manager,
                      const KeyComparator &comparator, int leaf_max_size = LEAF_PAGE_SIZE,
-                     int internal_max_size = INTERNAL_PAGE_SIZE);
+                     int internal_max_size = INTERNAL_PAGE_SIZE, int resident_levels = 0, bool lazy_delete = false);
+
+  // Stop the compactor and unpin the pages kept resident for point lookups, must run before the buffer pool is
+  // destroyed
+  ~BPlusTree();
 
   // Returns true if this B+ tree has no keys and values.
   auto IsEmpty() const -> bool;
@@ -82,15 +99,50 @@ class BPlusTree {
   // Insert a key-value pair into this B+ tree.
   auto Insert(const KeyType &key, const ValueType &value, Transaction *txn = nullptr) -> bool;
 
-  // Remove a key and its value from this B+ tree.
-  void Remove(const KeyType &key, Transaction *txn);
+  // Build an empty tree bottom-up from the pairs next produces in strictly ascending key order, next returns false
+  // when there are no more. Returns false, without calling next, if the tree is not empty.
+  auto BulkLoad(const std::function<bool(KeyType *key, ValueType *value)> &next) -> bool;
+
+  // Remove a key and its value from this B+ tree. In lazy-delete mode the leaf is left underfull and sparse leaves
+  // are merged later by Compact. Returns false if the key was not in the tree.
+  auto Remove(const KeyType &key, Transaction *txn) -> bool;
+
+  // Apply a batch sorted by key in ascending order, a pair with a value puts it under its key (replacing an entry
+  // with an equal key), one without removes the key. The pairs that fall into the same leaf share one leaf latch,
+  // neighbouring leaves share the descent down to their lowest common ancestor. The pairs that would split a leaf, or
+  // rebalance it when deletes are not lazy, go through Insert and Remove afterwards.
+  void ApplyBatch(const std::vector<std::pair<KeyType, std::optional<ValueType>>> &batch);
+
+  // Route keys sorted in ascending order one level down from the internal page node_id, INVALID_PAGE_ID meaning the
+  // root. node_id is looked for on the path from the root to the first key. (*children)[i] receives the child that
+  // sorted_keys[i] descends to, *leaf_children whether the children are leaves. Returns false if node_id is no longer
+  // on that path, or is a leaf.
+  auto RouteBatch(page_id_t node_id, const std::vector<KeyType> &sorted_keys, std::vector<page_id_t> *children,
+                  bool *leaf_children) -> bool;
+
+  // Merge the leaves that lazy deletes left sparse with their siblings, and the parents this leaves underfull, then
+  // shrink the height and free the merged pages. Busy nodes are kept for the next call rather than waited for.
+  // Returns false if some were kept. The background compactor of a lazy-delete tree calls this, tests may call it
+  // directly.
+  auto Compact() -> bool;
 
   // Return the value associated with a given key
   auto GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *txn = nullptr) -> bool;
 
+  // Look up a batch of keys sorted in ascending order, (*result)[i] receives the values of sorted_keys[i].
+  // Returns the number of keys found.
+  auto GetValues(const std::vector<KeyType> &sorted_keys, std::vector<std::vector<ValueType>> *result,
+                 Transaction *txn = nullptr) -> size_t;
+
   // Return the page id of the root node
   auto GetRootPageId() -> page_id_t;
 
+  // Count the levels and pages of the tree. Only internal pages are read, the leaf count is the number of children of
+  // the lowest internal level. Writers may run concurrently, the result is then approximate.
+  auto GetShape() -> BPlusTreeShape;
+
+  auto GetLeafMaxSize() const -> int { return leaf_max_size_; }
+
   // Index iterator
   auto Begin() -> INDEXITERATOR_TYPE;
 
@@ -98,6 +150,15 @@ class BPlusTree {
 
   auto Begin(const KeyType &key) -> INDEXITERATOR_TYPE;
 
+  // Iterate over [key, stop_key] (or [key, stop_key) when stop_inclusive is false)
+  auto Begin(const KeyType &key, const KeyType &stop_key, bool stop_inclusive) -> INDEXITERATOR_TYPE;
+
+  // Reverse index iterator, walks from the largest key towards the smallest one and ends at End()
+  auto RBegin() -> INDEXITERATOR_TYPE;
+
+  // Reverse index iterator starting at the last key not greater than key
+  auto RBegin(const KeyType &key) -> INDEXITERATOR_TYPE;
+
   // Print the B+ tree
   void Print(BufferPoolManager *bpm);
 
@@ -136,26 +197,22 @@ class BPlusTree {
 
   /*
     插入一个value值在pos位置上，数组从原先的pos开始向右移动一格
+    压缩后的键放不下时返回false,page不变
   */
-  void InsertLeafAValue(LeafPage *pages, const MappingType &value, int pos);
+  auto InsertLeafAValue(LeafPage *pages, const MappingType &value, int pos) -> bool;
 
   /*
     插入一个value值在pos位置上，数组从原先的pos开始向右移动一格
+    压缩后的键放不下时返回false,page不变
   */
-  void InsertInternalAValue(InternalPage *pages, const std::pair<KeyType, page_id_t> &value, int pos);
+  auto InsertInternalAValue(InternalPage *pages, const std::pair<KeyType, page_id_t> &value, int pos) -> bool;
 
   /*
-    处理内部结点的分裂
+    处理内部结点的分裂,append_split为true时表示在最右边追加,左边结点尽量保持满的
   */
   void DealWithInternalSplit(InternalPage *pages, int key_index, const KeyType &key,
                              const std::pair<page_id_t, page_id_t> &left_right_son, KeyType &key_to_push,
-                             std::pair<page_id_t, page_id_t> &left_right_son_to_push);
-  /*
-    处理叶子结点的分裂
-  */
-  void DealWithLeafSplit(LeafPage *pages, int key_index, const KeyType &key, const ValueType &value,
-                         KeyType &key_to_push, std::pair<page_id_t, page_id_t> &left_right_son_to_push);
-
+                             std::pair<page_id_t, page_id_t> &left_right_son_to_push, bool append_split = false);
   /*
     处理根节点分裂
   */
@@ -168,6 +225,29 @@ class BPlusTree {
   */
   void BuildNewPage(page_id_t *page_id, IndexPageType page_type);
 
+  /**
+   * 常驻结点
+   *
+   */
+
+  /*
+    给点查询取一个结点的读锁:常驻的结点直接用记下来的frame,不经过缓冲池的页表、pin和replacer,
+    其余的照常走缓冲池。调用方要持有resident_latch_的读锁,保证frame在用完之前不会被换出去
+  */
+  auto FetchNodeRead(page_id_t page_id) -> ReadPageGuard;
+
+  /*
+    内部结点分裂、合并或者换根之后,重新挑选常驻的结点:header加上从根往下resident_levels_层的内部结点,
+    所有索引的常驻结点共用缓冲池里的一份预算(见BufferPoolManager::ReserveResidentFrames),预算不够就少放几层。
+    调用时不能持有任何结点的锁
+  */
+  void RefreshResidentPages();
+
+  /*
+    把常驻的结点全部unpin掉,把占的预算还给缓冲池,调用方要持有resident_latch_的写锁
+  */
+  void ReleaseResidentPages();
+
   /**
    * 删除
    *
@@ -188,6 +268,44 @@ class BPlusTree {
   auto BorrowOrCoalesceInternalPage(InternalPage *page, page_id_t page_id, std::pair<BPlusTreePage *, int> parent)
       -> bool;
 
+  /**
+   * 惰性删除
+   *
+   */
+
+  /*
+    惰性删除:header的读锁全程拿着,内部结点一路读锁往下走,只对叶子拿写锁,删完不借值也不合并。
+    插入和压缩都要header的写锁,所以这期间树的结构不会变。没找到key返回false
+  */
+  auto RemoveLazily(const KeyType &key) -> bool;
+
+  /*
+    压缩沿key往下第level层(叶子是第0层)的结点:拿着header的读锁找到它的父亲,父亲拿到写锁就放掉header,
+    在父亲下面把它和相邻的兄弟合并。父亲因此变稀疏时把上一层记进nodes。拿不到孩子的锁时返回false
+  */
+  auto CompactNode(const KeyType &key, int level, std::deque<std::pair<KeyType, int>> *nodes) -> bool;
+
+  /*
+    根只剩一个孩子时换根,树被删空时把根释放掉,只有这里拿header的写锁。
+    根是内部结点时调用方要持有resident_latch_的写锁
+  */
+  auto CollapseRoot() -> bool;
+
+  /*
+    把右兄弟合并进左兄弟,两个都不少于最小值或者合起来放不下时不合并。index是left在parent里的下标
+  */
+  auto MergeSiblings(InternalPage *parent, int index, WritePageGuard *left_guard, WritePageGuard *right_guard) -> bool;
+
+  /*
+    叫醒压缩线程,第一次调用时才启动它
+  */
+  void RequestCompaction();
+
+  /*
+    压缩线程:等到有人叫醒就压缩一遍,树忙的时候隔一会儿再试
+  */
+  void CompactorLoop();
+
   // auto DeleteBegin(page_id_t root_page_id_)-> INDEXITERATOR_TYPE;
   // void DeleteAValueFrom
 
@@ -207,6 +325,26 @@ class BPlusTree {
   int leaf_max_size_;
   int internal_max_size_;
   page_id_t header_page_id_;
+  // 从根往下常驻多少层内部结点,0表示不开启
+  int resident_levels_;
+  // 保护resident_pages_,点查询全程持有读锁,重新挑选常驻结点时持有写锁
+  std::shared_mutex resident_latch_;
+  // 常驻结点的page_id到frame的映射,这些frame由树自己pin着,不会被换出
+  std::unordered_map<page_id_t, Page *> resident_pages_;
+  // 上层结构变过,写操作结束时要重新挑选常驻结点
+  std::atomic<bool> resident_stale_{false};
+  // 删除时不借值也不合并,交给压缩线程
+  bool lazy_delete_;
+  // 保证同时只有一个线程在压缩,树的结构在header读锁下只会被它改
+  std::mutex compact_latch_;
+  // 保护下面压缩线程的状态
+  std::mutex compactor_latch_;
+  // 等着压缩的结点:结点里的一个key和它的层数,叶子是第0层
+  std::deque<std::pair<KeyType, int>> sparse_nodes_;
+  std::condition_variable compactor_cv_;
+  bool compact_requested_{false};
+  bool stop_compactor_{false};
+  std::thread compactor_;
 };
 
 /**
@@ -18,34 +18,115 @@
 
 #include "container/hash/hash_function.h"
 #include "storage/index/b_plus_tree.h"
+#include "storage/index/bloom_filter.h"
 #include "storage/index/index.h"
+#include "storage/index/index_statistics.h"
 
 namespace bustub {
 
 #define BPLUSTREE_INDEX_TYPE BPlusTreeIndex<KeyType, ValueType, KeyComparator>
 
+INDEX_TEMPLATE_ARGUMENTS
+class BPlusTreeIndex;
+
+/** Adapts a B+ tree iterator to the key-type agnostic IndexScanIterator */
+INDEX_TEMPLATE_ARGUMENTS
+class BPlusTreeIndexScanIterator : public IndexScanIterator {
+ public:
+  BPlusTreeIndexScanIterator(const BPLUSTREE_INDEX_TYPE *index, INDEXITERATOR_TYPE &&iter)
+      : index_(index), iter_(std::move(iter)) {}
+
+  auto IsEnd() -> bool override { return iter_.IsEnd(); }
+
+  auto GetRID() -> RID override { return (*iter_).second; }
+
+  auto GetEntry() -> Tuple override { return index_->EntryFromTreeKey((*iter_).first); }
+
+  void Next() override { ++iter_; }
+
+ private:
+  const BPLUSTREE_INDEX_TYPE *index_;
+  INDEXITERATOR_TYPE iter_;
+};
+
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeIndex : public Index {
  public:
-  BPlusTreeIndex(std::unique_ptr<IndexMetadata> &&metadata, BufferPoolManager *buffer_pool_manager);
+  /**
+   * @param use_key_filter whether point lookups check a Bloom filter over the keys before descending the tree
+   */
+  BPlusTreeIndex(std::unique_ptr<IndexMetadata> &&metadata, BufferPoolManager *buffer_pool_manager,
+                 bool use_key_filter = true);
 
   auto InsertEntry(const Tuple &key, RID rid, Transaction *transaction) -> bool override;
 
+  /** Builds the tree bottom-up from the sorted entries, falls back to InsertEntry if the tree is not empty */
+  void BulkLoad(const std::function<bool(Tuple *key, RID *rid)> &next, Transaction *transaction) override;
+
   void DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) override;
 
   void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
 
+  void ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *result,
+                Transaction *transaction) override;
+
+  void ScanRange(const Tuple *low_key, bool low_inclusive, const Tuple *high_key, bool high_inclusive,
+                 std::vector<RID> *result, Transaction *transaction) override;
+
   auto GetBeginIterator() -> INDEXITERATOR_TYPE;
 
   auto GetBeginIterator(const KeyType &key) -> INDEXITERATOR_TYPE;
 
+  /**
+   * @return an iterator over the keys within the given bounds, nullptr means unbounded. The iterator turns into
+   * GetEndIterator() as soon as it passes the far bound, so leaves beyond the range are never fetched. A reverse
+   * iterator starts at high_key and walks down to low_key.
+   */
+  auto GetRangeIterator(const Tuple *low_key, bool low_inclusive, const Tuple *high_key, bool high_inclusive,
+                        bool reverse = false) -> INDEXITERATOR_TYPE;
+
+  auto MakeScanIterator(const Tuple *low_key, bool low_inclusive, const Tuple *high_key, bool high_inclusive,
+                        bool reverse) -> std::unique_ptr<IndexScanIterator> override;
+
   auto GetEndIterator() -> INDEXITERATOR_TYPE;
 
+  /** @return the index entry (key columns followed by included columns) stored in a tree key */
+  auto EntryFromTreeKey(const KeyType &index_key) const -> Tuple;
+
+  auto GetStatistics(bool with_shape) -> std::optional<IndexStatistics> override;
+
+  void RefreshStatistics() override;
+
  protected:
+  /**
+   * Build the key stored in the tree. A non-unique index appends the RID as a hidden column so that every entry
+   * stays unique inside the tree and all RIDs of one key are stored next to each other in RID order. Pass nullptr as
+   * rid to get a search key, whose NULL columns (the RID, key columns left NULL) match any value. Included columns are
+   * stored after the key and the RID, they are never compared. key is an index entry carrying the included columns
+   * if is_entry is true, otherwise it only has the key columns and the included columns are left NULL.
+   */
+  auto MakeTreeKey(const Tuple &key, const RID *rid, bool is_entry = false) const -> KeyType;
+
+  /** Copy the key tuple into index_key, throws if the tuple does not fit into KeyType. */
+  void SetTreeKey(KeyType *index_key, const Tuple &key) const;
+
+  // schema of the keys stored in the tree: the index key, the hidden RID column of a non-unique index, the included
+  // columns of a covering index
+  std::unique_ptr<Schema> tree_key_schema_;
+  // the part of tree_key_schema_ the comparator looks at, the included columns are left out
+  std::unique_ptr<Schema> compare_key_schema_;
   // comparator for key
   KeyComparator comparator_;
   // container
   std::shared_ptr<BPlusTree<KeyType, ValueType, KeyComparator>> container_;
+  // lookups of absent keys return before the tree is descended, nullptr if the index keeps no filter
+  std::unique_ptr<IndexKeyFilter> key_filter_;
+  // entry count, distinct keys and key histogram
+  IndexStatisticsCollector stats_;
+
+ private:
+  /** Enumerate the entries stored in the tree in key order */
+  void ScanEntries(const std::function<void(const Tuple &entry, const Schema *schema)> &callback);
 };
 
 /** We only support index table with one integer key for now in BusTub. Hardcode everything here. */
@@ -59,4 +140,28 @@ using BPlusTreeIndexIteratorForTwoIntegerColumn =
     IndexIterator<IntegerKeyType, IntegerValueType, IntegerComparatorType>;
 using IntegerHashFunctionType = HashFunction<IntegerKeyType>;
 
+/**
+ * B+ tree indexes are instantiated for GenericKey<4/8/16/32/64>, CREATE INDEX picks the smallest key type that can
+ * hold the longest possible key, see GetMaxIndexKeySize.
+ */
+constexpr static const uint32_t MAX_INDEX_KEY_SIZE = 64;
+
+/**
+ * @return the size of the longest key an index on key_schema can store: the inlined part of the key tuple, plus the
+ * length prefix, the declared maximum length and the trailing '\0' of every VARCHAR column, plus the hidden RID column
+ * of a non-unique index, plus the null bitmap over all of these columns.
+ */
+inline auto GetMaxIndexKeySize(const Schema &key_schema, bool is_unique) -> uint32_t {
+  uint32_t key_size = key_schema.GetLength();
+  for (auto col_idx : key_schema.GetUnlinedColumns()) {
+    key_size += sizeof(tuple_offset_t) + key_schema.GetColumn(col_idx).GetLength() + 1;
+  }
+  uint32_t column_count = key_schema.GetColumnCount();
+  if (!is_unique) {
+    key_size += sizeof(int64_t);
+    column_count++;
+  }
+  return key_size + (column_count + 7) / 8;
+}
+
 }  // namespace bustub
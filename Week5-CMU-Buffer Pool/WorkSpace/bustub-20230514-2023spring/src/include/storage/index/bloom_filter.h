@@ -0,0 +1,127 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// bloom_filter.h
+//
+// Identification: src/include/storage/index/bloom_filter.h
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "common/config.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/** Calls its argument with every entry stored in an index, the key columns come first in the entry schema */
+using IndexEntryScanner = std::function<void(const std::function<void(const Tuple &entry, const Schema *schema)> &)>;
+
+/**
+ * Serialize the leading key columns of a tuple one after another, so that equal keys give equal bytes whether they
+ * come from an index entry or a search key. Stops at the first NULL column.
+ * @param column_ends if not nullptr, receives the end offset in bytes of every serialized column
+ * @return the number of columns serialized
+ */
+auto SerializeIndexKey(const Tuple &key, const Schema *schema, uint32_t column_count, std::string *bytes,
+                       std::vector<size_t> *column_ends = nullptr) -> uint32_t;
+
+/** @return the 64-bit hash of the first length bytes of a serialized key */
+auto HashIndexKeyBytes(const std::string &bytes, size_t length) -> uint64_t;
+
+/**
+ * A blocked Bloom filter. Every key hashes to one cache-line sized block and sets PROBES bits inside it, so a lookup
+ * touches a single cache line. Bits are set with atomic ORs, inserts and lookups may run concurrently.
+ */
+class BloomFilter {
+ public:
+  static constexpr uint32_t PROBES = 6;
+
+  /** Size the filter for num_keys keys at BLOOM_FILTER_BITS_PER_KEY bits per key */
+  explicit BloomFilter(size_t num_keys);
+
+  void Insert(uint64_t hash);
+
+  /** @return false if the hash was definitely never inserted */
+  auto MayContain(uint64_t hash) const -> bool;
+
+  /** @return the number of keys the filter was sized for */
+  auto GetCapacity() const -> size_t { return capacity_; }
+
+ private:
+  static constexpr size_t WORDS_PER_BLOCK = 8;
+
+  struct alignas(64) Block {
+    std::atomic<uint64_t> words_[WORDS_PER_BLOCK];
+  };
+
+  auto BlockOf(uint64_t hash) const -> size_t { return hash % blocks_.size(); }
+
+  size_t capacity_;
+  std::vector<Block> blocks_;
+};
+
+/**
+ * The Bloom filter over the keys of an index, so that lookups of absent keys return without descending the index.
+ *
+ * Deleted keys cannot be taken out of a Bloom filter and inserts beyond its capacity raise the false positive rate.
+ * Either way the filter is rebuilt from the keys in the index, lazily: the next lookup that finds the filter stale
+ * rebuilds it before checking.
+ */
+class IndexKeyFilter {
+ public:
+  using EntryScanner = IndexEntryScanner;
+
+  /**
+   * @param key_column_count the number of key columns, the leading columns of every tuple passed in
+   * @param scan_entries enumerates the entries of the index when the filter is rebuilt
+   */
+  IndexKeyFilter(uint32_t key_column_count, EntryScanner scan_entries);
+
+  /**
+   * Add the key of an entry to the filter and run insert, which puts the entry into the index. A rebuild waits until
+   * insert has returned, so it never misses the key.
+   * @return the result of insert
+   */
+  auto Insert(const Tuple &entry, const Schema *schema, const std::function<bool()> &insert) -> bool;
+
+  /** Note that an entry was deleted from the index */
+  void Delete();
+
+  /**
+   * @return false if no entry with this key is in the index. Keys with a NULL column are never filtered, NULL bounds
+   * stand for any value in a prefix lookup.
+   */
+  auto MayContain(const Tuple &key, const Schema *schema) -> bool;
+
+  /** @return the number of keys the current filter was sized for */
+  auto GetCapacity() -> size_t;
+
+ private:
+  /** @return whether the key has a NULL column, otherwise *hash is set to the hash of the key columns */
+  auto HashKey(const Tuple &key, const Schema *schema, uint64_t *hash) const -> bool;
+
+  /** Replace the filter with one built from the current entries of the index, latch_ must be held exclusively */
+  void Rebuild();
+
+  uint32_t key_column_count_;
+  EntryScanner scan_entries_;
+  // 插入和查找拿读锁,重建拿写锁,重建期间不会有插入漏掉
+  std::shared_mutex latch_;
+  std::unique_ptr<BloomFilter> filter_;
+  // 当前filter里的键数和之后删掉的项数,用来判断filter是不是该重建了
+  std::atomic<size_t> num_keys_{0};
+  std::atomic<size_t> num_deletes_{0};
+};
+
+}  // namespace bustub
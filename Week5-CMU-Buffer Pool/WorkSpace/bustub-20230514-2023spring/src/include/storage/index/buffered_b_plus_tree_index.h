@@ -0,0 +1,193 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffered_b_plus_tree_index.h
+//
+// Identification: src/include/storage/index/buffered_b_plus_tree_index.h
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "storage/index/b_plus_tree_index.h"
+
+namespace bustub {
+
+#define BUFFERED_BPLUSTREE_INDEX_TYPE BufferedBPlusTreeIndex<KeyType, ValueType, KeyComparator>
+
+/**
+ * Merges the pending messages within the bounds of a scan into a scan of the tree. The messages are a snapshot taken
+ * in scan order when the scan starts, the message of a key overrides the tree entry of the key.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+class BufferedBPlusTreeIndexScanIterator : public IndexScanIterator {
+ public:
+  BufferedBPlusTreeIndexScanIterator(const BPLUSTREE_INDEX_TYPE *index, INDEXITERATOR_TYPE &&iter,
+                                     std::vector<std::pair<KeyType, std::optional<RID>>> &&messages,
+                                     const KeyComparator &comparator, bool reverse)
+      : index_(index),
+        iter_(std::move(iter)),
+        messages_(std::move(messages)),
+        comparator_(comparator),
+        reverse_(reverse) {
+    Settle();
+  }
+
+  auto IsEnd() -> bool override { return iter_.IsEnd() && next_message_ == messages_.size(); }
+
+  auto GetRID() -> RID override { return on_message_ ? *messages_[next_message_].second : (*iter_).second; }
+
+  auto GetEntry() -> Tuple override {
+    return index_->EntryFromTreeKey(on_message_ ? messages_[next_message_].first : (*iter_).first);
+  }
+
+  void Next() override {
+    if (on_message_) {
+      next_message_++;
+    } else {
+      ++iter_;
+    }
+    Settle();
+  }
+
+ private:
+  /** Move to the next entry that is not removed by a message, and tell whether it comes from a message or the tree */
+  void Settle() {
+    while (next_message_ < messages_.size()) {
+      int cmp = -1;
+      if (!iter_.IsEnd()) {
+        cmp = comparator_(messages_[next_message_].first, (*iter_).first);
+        cmp = reverse_ ? -cmp : cmp;
+      }
+      if (cmp > 0) {
+        break;
+      }
+      if (cmp == 0) {
+        // 消息比树里的项新,树里这一项跳过
+        ++iter_;
+      }
+      if (messages_[next_message_].second.has_value()) {
+        on_message_ = true;
+        return;
+      }
+      next_message_++;
+    }
+    on_message_ = false;
+  }
+
+  const BPLUSTREE_INDEX_TYPE *index_;
+  INDEXITERATOR_TYPE iter_;
+  // 扫描范围内还没写进树的消息,按扫描的顺序排好,没有RID的是删除
+  std::vector<std::pair<KeyType, std::optional<RID>>> messages_;
+  size_t next_message_{0};
+  // 当前这一项是消息还是树里的项
+  bool on_message_{false};
+  KeyComparator comparator_;
+  bool reverse_;
+};
+
+/**
+ * A write-optimized B+ tree index in the style of a B-epsilon tree. Inserts and deletes do not walk the tree, they are
+ * recorded as messages in the buffer above the root. Every internal page of the tree has a message buffer of its own,
+ * kept in a side area keyed by the page id. Once a buffer holds buffer_capacity messages, the batch bound for its
+ * fullest child moves one level down into the buffer of that child, then the batch of the next fullest one, until
+ * the buffer is half empty. Batches bound for leaves are applied to the tree instead, one descent per leaf. A key has
+ * at most one pending message, so lookups and range scans merge the pending messages with what the tree returns and
+ * never have to flush.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+class BufferedBPlusTreeIndex : public BPlusTreeIndex<KeyType, ValueType, KeyComparator> {
+ public:
+  BufferedBPlusTreeIndex(std::unique_ptr<IndexMetadata> &&metadata, BufferPoolManager *buffer_pool_manager,
+                         size_t buffer_capacity = BUFFERED_INDEX_CAPACITY);
+
+  auto InsertEntry(const Tuple &key, RID rid, Transaction *transaction) -> bool override;
+
+  /** Goes through the buffer like InsertEntry */
+  void BulkLoad(const std::function<bool(Tuple *key, RID *rid)> &next, Transaction *transaction) override {
+    Index::BulkLoad(next, transaction);
+  }
+
+  void DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) override;
+
+  void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
+
+  void ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *result,
+                Transaction *transaction) override;
+
+  void ScanRange(const Tuple *low_key, bool low_inclusive, const Tuple *high_key, bool high_inclusive,
+                 std::vector<RID> *result, Transaction *transaction) override;
+
+  auto MakeScanIterator(const Tuple *low_key, bool low_inclusive, const Tuple *high_key, bool high_inclusive,
+                        bool reverse) -> std::unique_ptr<IndexScanIterator> override;
+
+  /** Flushes first when asked for the shape, so that the fill factor describes the tree with every entry in it */
+  auto GetStatistics(bool with_shape) -> std::optional<IndexStatistics> override;
+
+  void RefreshStatistics() override;
+
+  /** Apply every pending message to the tree, whichever buffer it waits in */
+  void Flush();
+
+  /** @return the number of messages waiting in all buffers */
+  auto GetPendingCount() -> size_t;
+
+ private:
+  /** Orders tree keys with the index's three-way comparator. A key with a NULL RID column equals every RID of it. */
+  struct KeyLess {
+    KeyComparator comparator_;
+    auto operator()(const KeyType &a, const KeyType &b) const -> bool { return comparator_(a, b) < 0; }
+  };
+
+  /**
+   * The net effect of the inserts and deletes of each tree key since it was last applied: the RID to put under the
+   * key, replacing any entry of an equal key in the tree, or std::nullopt to remove the key.
+   */
+  using MessageBuffer = std::map<KeyType, std::optional<RID>, KeyLess>;
+
+  /** @return the pending message of index_key, nullptr if there is none */
+  auto FindMessage(const KeyType &index_key) const -> const std::optional<RID> *;
+
+  /**
+   * Replace the message of index_key, wherever it waits, by a new one in the buffer above the root. The new key is
+   * kept as it may carry different included columns. Flushes the root buffer once it is full.
+   */
+  void PutMessage(const KeyType &index_key, const std::optional<RID> &message);
+
+  /** @return the buffer of node_id, created empty if it has none, INVALID_PAGE_ID is the buffer above the root */
+  auto GetBuffer(page_id_t node_id) -> MessageBuffer &;
+
+  /**
+   * Move the messages of node_id's buffer one level down, a child's batch at a time starting with the fullest child,
+   * until the buffer is half empty. A child's buffer that fills up is flushed in turn. The caller holds buffer_latch_
+   * exclusively.
+   */
+  void FlushNode(page_id_t node_id);
+
+  /** Apply the messages [begin, end) of a buffer to the tree and forget them, the caller erases them from the buffer */
+  void ApplyMessages(typename MessageBuffer::const_iterator begin, typename MessageBuffer::const_iterator end);
+
+  /** @return the pending messages within the bounds in ascending key order, nullptr means unbounded */
+  auto CollectMessages(const Tuple *low_key, bool low_inclusive, const Tuple *high_key, bool high_inclusive) const
+      -> std::vector<std::pair<KeyType, std::optional<RID>>>;
+
+  size_t buffer_capacity_;
+  // protects the buffers; readers hold it shared across the tree lookup, so a flush cannot move a message under them
+  std::shared_mutex buffer_latch_;
+  // 每个内部结点的消息缓冲区,INVALID_PAGE_ID是根上面的那个。结点被压缩线程合并掉以后它的缓冲区还留着,
+  // 下次刷它的时候在树里找不到这个结点,就整个写进树里
+  std::unordered_map<page_id_t, MessageBuffer> buffers_;
+  // 每个有消息的键在哪个缓冲区里,查找时不用一层层去找
+  std::map<KeyType, page_id_t, KeyLess> owners_;
+};
+
+}  // namespace bustub
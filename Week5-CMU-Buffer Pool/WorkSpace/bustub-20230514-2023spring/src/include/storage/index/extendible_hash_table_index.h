@@ -19,12 +19,33 @@
 
 #include "container/disk/hash/disk_extendible_hash_table.h"
 #include "container/hash/hash_function.h"
+#include "storage/index/bloom_filter.h"
 #include "storage/index/index.h"
 
 namespace bustub {
 
 #define HASH_TABLE_INDEX_TYPE ExtendibleHashTableIndex<KeyType, ValueType, KeyComparator>
 
+/** Walks the RIDs of one key, which a hash index looks up all at once */
+class HashTableIndexScanIterator : public IndexScanIterator {
+ public:
+  HashTableIndexScanIterator(Tuple key, std::vector<RID> &&rids) : key_(std::move(key)), rids_(std::move(rids)) {}
+
+  auto IsEnd() -> bool override { return pos_ == rids_.size(); }
+
+  auto GetRID() -> RID override { return rids_[pos_]; }
+
+  /** Hash indexes store no included columns, every entry found is the lookup key itself */
+  auto GetEntry() -> Tuple override { return key_; }
+
+  void Next() override { pos_++; }
+
+ private:
+  Tuple key_;
+  std::vector<RID> rids_;
+  size_t pos_{0};
+};
+
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class ExtendibleHashTableIndex : public Index {
  public:
@@ -39,11 +60,26 @@ class ExtendibleHashTableIndex : public Index {
 
   void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
 
+  /**
+   * Only point lookups are supported: both bounds must be the same key, inclusive, with every key column given.
+   * The RIDs come back in no particular order and `reverse` is ignored.
+   */
+  auto MakeScanIterator(const Tuple *low_key, bool low_inclusive, const Tuple *high_key, bool high_inclusive,
+                        bool reverse) -> std::unique_ptr<IndexScanIterator> override;
+
  protected:
+  /** Build the fixed-size hash key, throws if the tuple does not fit in KeyType */
+  auto MakeHashKey(const Tuple &key) const -> KeyType;
+
+  /** @return the key tuple stored in a hash key */
+  auto KeyFromHashKey(const KeyType &index_key) const -> Tuple;
+
   // comparator for key
   KeyComparator comparator_;
   // container
   DiskExtendibleHashTable<KeyType, ValueType, KeyComparator> container_;
+  // lookups of absent keys return before the directory and the bucket page are fetched
+  IndexKeyFilter key_filter_;
 };
 
 }  // namespace bustub
@@ -12,10 +12,12 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstring>
 
 #include "storage/table/tuple.h"
 #include "type/value.h"
+#include "type/value_factory.h"
 
 namespace bustub {
 
@@ -25,6 +27,9 @@ namespace bustub {
  * This key type uses an fixed length array to hold data for indexing
  * purposes, the actual size of which is specified and instantiated
  * with a template argument.
+ *
+ * The key holds the whole key tuple, its null bitmap included, so that every NULL column carries an explicit null
+ * flag. A search bound clears the flags of the columns it leaves open, see SetNullsAsWildcards.
  */
 template <size_t KeySize>
 class GenericKey {
@@ -32,7 +37,7 @@ class GenericKey {
   inline void SetFromKey(const Tuple &tuple) {
     // intialize to 0
     memset(data_, 0, KeySize);
-    memcpy(data_, tuple.GetData(), tuple.GetLength());
+    memcpy(data_, tuple.GetData(), std::min<size_t>(tuple.GetLength(), KeySize));
   }
 
   // NOTE: for test purpose only
@@ -41,18 +46,41 @@ class GenericKey {
     memcpy(data_, &key, sizeof(int64_t));
   }
 
+  /**
+   * Turns the NULL columns of a search bound into wildcards that compare equal to any value, by clearing their null
+   * flags. The padded columns of a bound (key columns left open, the RID of a non-unique index, included columns)
+   * are NULL, a stored key keeps the flag of every NULL so that NULLs sort first.
+   */
+  inline void SetNullsAsWildcards(const Schema &schema) {
+    uint32_t bitmap_offset = schema.GetLength();
+    uint32_t bitmap_end = std::min<uint32_t>(KeySize, bitmap_offset + Tuple::GetNullBitmapSize(&schema));
+    if (bitmap_offset < bitmap_end) {
+      memset(data_ + bitmap_offset, 0, bitmap_end - bitmap_offset);
+    }
+  }
+
+  /** @return true if the null flag of a column is set in the null bitmap starting at bitmap_offset */
+  inline auto HasNullFlag(uint32_t bitmap_offset, uint32_t column_idx) const -> bool {
+    uint32_t byte_idx = bitmap_offset + column_idx / 8;
+    return byte_idx < KeySize && (data_[byte_idx] & (1 << (column_idx % 8))) != 0;
+  }
+
   inline auto ToValue(Schema *schema, uint32_t column_idx) const -> Value {
-    const char *data_ptr;
+    // A NULL is readable without the null bitmap: an inlined one is stored as the null value of its type and a NULL
+    // VARCHAR has offset 0. Whether it is a stored NULL or a wildcard is told by its null flag, see HasNullFlag.
     const auto &col = schema->GetColumn(column_idx);
     const TypeId column_type = col.GetType();
-    const bool is_inlined = col.IsInlined();
-    if (is_inlined) {
-      data_ptr = (data_ + col.GetOffset());
-    } else {
-      int32_t offset = *reinterpret_cast<int32_t *>(const_cast<char *>(data_ + col.GetOffset()));
-      data_ptr = (data_ + offset);
+    if (col.IsInlined()) {
+      return Value::DeserializeFrom(data_ + col.GetOffset(), column_type);
     }
-    return Value::DeserializeFrom(data_ptr, column_type);
+    tuple_offset_t offset;
+    memcpy(&offset, data_ + col.GetOffset(), sizeof(tuple_offset_t));
+    if (offset == 0) {
+      return ValueFactory::GetNullValueByType(column_type);
+    }
+    tuple_offset_t len;
+    memcpy(&len, data_ + offset, sizeof(tuple_offset_t));
+    return {column_type, data_ + offset + sizeof(tuple_offset_t), len, true};
   }
 
   // NOTE: for test purpose only
@@ -72,6 +100,9 @@ class GenericKey {
 
 /**
  * Function object returns true if lhs < rhs, used for trees
+ *
+ * A NULL with its null flag set sorts before every value and equals another NULL. A NULL without its flag is a
+ * wildcard column of a search bound and equals anything, see GenericKey::SetNullsAsWildcards.
  */
 template <size_t KeySize>
 class GenericComparator {
@@ -80,27 +111,137 @@ class GenericComparator {
     uint32_t column_count = key_schema_->GetColumnCount();
 
     for (uint32_t i = 0; i < column_count; i++) {
-      Value lhs_value = (lhs.ToValue(key_schema_, i));
-      Value rhs_value = (rhs.ToValue(key_schema_, i));
-
-      if (lhs_value.CompareLessThan(rhs_value) == CmpBool::CmpTrue) {
-        return -1;
-      }
-      if (lhs_value.CompareGreaterThan(rhs_value) == CmpBool::CmpTrue) {
-        return 1;
+      int cmp = CompareColumn(lhs, rhs, i);
+      if (cmp != 0) {
+        return cmp;
       }
     }
     // equals
     return 0;
   }
 
-  GenericComparator(const GenericComparator &other) : key_schema_{other.key_schema_} {}
+  /**
+   * Suffix truncation for the separators of internal pages.
+   * @return a key k with lhs < k <= rhs, as short as the key layout allows: the columns after the first one where lhs
+   * and rhs differ become NULL, and a VARCHAR in that column is cut to its shortest prefix still greater than lhs.
+   * Short separators differ from each other in fewer bytes, which keeps the compressed slots of a page narrow.
+   */
+  inline auto ShortestSeparator(const GenericKey<KeySize> &lhs, const GenericKey<KeySize> &rhs) const
+      -> GenericKey<KeySize> {
+    uint32_t column_count = key_schema_->GetColumnCount();
+    uint32_t column = 0;
+    while (column < column_count && CompareColumn(lhs, rhs, column) == 0) {
+      column++;
+    }
+    if (column == column_count) {
+      return rhs;
+    }
+    GenericKey<KeySize> separator = rhs;
+    // 分隔键还用得到的字节到哪里为止,后面的全部清零
+    uint32_t used_end = std::min<uint32_t>(KeySize, null_bitmap_offset_ + (column_count + 7) / 8);
+    for (uint32_t i = column + 1; i < column_count; i++) {
+      const auto &col = key_schema_->GetColumn(i);
+      if (col.IsInlined()) {
+        ValueFactory::GetNullValueByType(col.GetType()).SerializeTo(separator.data_ + col.GetOffset());
+      } else {
+        memset(separator.data_ + col.GetOffset(), 0, sizeof(tuple_offset_t));
+      }
+      if (null_bitmap_offset_ + i / 8 < KeySize) {
+        separator.data_[null_bitmap_offset_ + i / 8] |= static_cast<char>(1 << (i % 8));
+      }
+    }
+    const auto &col = key_schema_->GetColumn(column);
+    Value rhs_value = rhs.ToValue(key_schema_, column);
+    if (!col.IsInlined() && !rhs_value.IsNull()) {
+      tuple_offset_t offset;
+      memcpy(&offset, rhs.data_ + col.GetOffset(), sizeof(tuple_offset_t));
+      // 字符串的长度里带着结尾的'\0',比较时不算它
+      uint32_t rhs_len = rhs_value.GetLength() - 1;
+      Value lhs_value = lhs.ToValue(key_schema_, column);
+      uint32_t keep = 1;
+      if (!lhs_value.IsNull()) {
+        // 第一个和lhs不一样的字符留下,后面的都不要
+        uint32_t lhs_len = lhs_value.GetLength() - 1;
+        uint32_t same = 0;
+        while (same < lhs_len && same < rhs_len && lhs_value.GetData()[same] == rhs_value.GetData()[same]) {
+          same++;
+        }
+        keep = same + 1;
+      }
+      if (keep < rhs_len) {
+        tuple_offset_t len = keep + 1;
+        memcpy(separator.data_ + offset, &len, sizeof(tuple_offset_t));
+        separator.data_[offset + sizeof(tuple_offset_t) + keep] = '\0';
+        rhs_len = keep;
+      }
+      used_end = std::max<uint32_t>(used_end, offset + sizeof(tuple_offset_t) + rhs_len + 1);
+    } else {
+      // 前面的列里最后一个非空字符串的结尾
+      for (uint32_t i = 0; i <= column; i++) {
+        const auto &prev = key_schema_->GetColumn(i);
+        Value value = rhs.ToValue(key_schema_, i);
+        if (!prev.IsInlined() && !value.IsNull()) {
+          tuple_offset_t offset;
+          memcpy(&offset, rhs.data_ + prev.GetOffset(), sizeof(tuple_offset_t));
+          used_end = std::max<uint32_t>(used_end, offset + sizeof(tuple_offset_t) + value.GetLength());
+        }
+      }
+    }
+    // include列不参与比较,和后面用不到的字符串一起清零
+    uint32_t include_end = std::min<uint32_t>(KeySize, null_bitmap_offset_);
+    if (key_schema_->GetLength() < include_end) {
+      memset(separator.data_ + key_schema_->GetLength(), 0, include_end - key_schema_->GetLength());
+    }
+    if (used_end < KeySize) {
+      memset(separator.data_ + used_end, 0, KeySize - used_end);
+    }
+    if ((*this)(lhs, separator) < 0 && (*this)(separator, rhs) <= 0) {
+      return separator;
+    }
+    return rhs;
+  }
+
+  GenericComparator(const GenericComparator &other)
+      : key_schema_{other.key_schema_}, null_bitmap_offset_{other.null_bitmap_offset_} {}
 
-  // constructor
-  explicit GenericComparator(Schema *key_schema) : key_schema_(key_schema) {}
+  /**
+   * @param key_schema the columns to compare
+   * @param key_layout the schema the keys are stored with, if key_schema only compares its leading columns
+   */
+  explicit GenericComparator(Schema *key_schema, const Schema *key_layout = nullptr)
+      : key_schema_(key_schema), null_bitmap_offset_((key_layout == nullptr ? key_schema : key_layout)->GetLength()) {}
 
  private:
+  /** @return how the column compares in lhs and rhs, see operator() */
+  inline auto CompareColumn(const GenericKey<KeySize> &lhs, const GenericKey<KeySize> &rhs, uint32_t column) const
+      -> int {
+    Value lhs_value = (lhs.ToValue(key_schema_, column));
+    Value rhs_value = (rhs.ToValue(key_schema_, column));
+
+    bool lhs_null = lhs_value.IsNull();
+    bool rhs_null = rhs_value.IsNull();
+    if (lhs_null || rhs_null) {
+      if ((lhs_null && !lhs.HasNullFlag(null_bitmap_offset_, column)) ||
+          (rhs_null && !rhs.HasNullFlag(null_bitmap_offset_, column))) {
+        return 0;
+      }
+      if (lhs_null != rhs_null) {
+        return lhs_null ? -1 : 1;
+      }
+      return 0;
+    }
+    if (lhs_value.CompareLessThan(rhs_value) == CmpBool::CmpTrue) {
+      return -1;
+    }
+    if (lhs_value.CompareGreaterThan(rhs_value) == CmpBool::CmpTrue) {
+      return 1;
+    }
+    return 0;
+  }
+
   Schema *key_schema_;
+  /** where the null bitmap of the stored key tuple starts */
+  uint32_t null_bitmap_offset_;
 };
 
 }  // namespace bustub
@@ -12,12 +12,16 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "catalog/schema.h"
+#include "common/exception.h"
+#include "storage/index/index_statistics.h"
 #include "storage/table/tuple.h"
 #include "type/value.h"
 
@@ -43,11 +47,20 @@ class IndexMetadata {
    * @param table_name The name of the table on which the index is created
    * @param tuple_schema The schema of the indexed key
    * @param key_attrs The mapping from indexed columns to base table columns
+   * @param is_unique Whether the index rejects duplicate keys
+   * @param include_attrs The base table columns stored in the index entries besides the key
    */
   IndexMetadata(std::string index_name, std::string table_name, const Schema *tuple_schema,
-                std::vector<uint32_t> key_attrs)
-      : name_(std::move(index_name)), table_name_(std::move(table_name)), key_attrs_(std::move(key_attrs)) {
+                std::vector<uint32_t> key_attrs, bool is_unique = true, std::vector<uint32_t> include_attrs = {})
+      : name_(std::move(index_name)),
+        table_name_(std::move(table_name)),
+        key_attrs_(std::move(key_attrs)),
+        is_unique_(is_unique),
+        include_attrs_(std::move(include_attrs)) {
     key_schema_ = std::make_shared<Schema>(Schema::CopySchema(tuple_schema, key_attrs_));
+    entry_attrs_ = key_attrs_;
+    entry_attrs_.insert(entry_attrs_.end(), include_attrs_.begin(), include_attrs_.end());
+    entry_schema_ = std::make_shared<Schema>(Schema::CopySchema(tuple_schema, entry_attrs_));
   }
 
   ~IndexMetadata() = default;
@@ -72,6 +85,18 @@ class IndexMetadata {
   /** @return The mapping relation between indexed columns and base table columns */
   inline auto GetKeyAttrs() const -> const std::vector<uint32_t> & { return key_attrs_; }
 
+  /** @return Whether the index rejects duplicate keys */
+  inline auto IsUnique() const -> bool { return is_unique_; }
+
+  /** @return The base table columns stored in the index entries besides the key */
+  inline auto GetIncludeAttrs() const -> const std::vector<uint32_t> & { return include_attrs_; }
+
+  /** @return The base table columns of an index entry, the key columns followed by the included columns */
+  inline auto GetEntryAttrs() const -> const std::vector<uint32_t> & { return entry_attrs_; }
+
+  /** @return The schema of an index entry, the key columns followed by the included columns */
+  inline auto GetEntrySchema() const -> Schema * { return entry_schema_.get(); }
+
   /** @return A string representation for debugging */
   auto ToString() const -> std::string {
     std::stringstream os;
@@ -79,8 +104,12 @@ class IndexMetadata {
     os << "IndexMetadata["
        << "Name = " << name_ << ", "
        << "Type = B+Tree, "
+       << "Unique = " << (is_unique_ ? "true" : "false") << ", "
        << "Table name = " << table_name_ << "] :: ";
     os << key_schema_->ToString();
+    if (!include_attrs_.empty()) {
+      os << " include " << entry_schema_->ToString();
+    }
 
     return os.str();
   }
@@ -94,6 +123,40 @@ class IndexMetadata {
   const std::vector<uint32_t> key_attrs_;
   /** The schema of the indexed key */
   std::shared_ptr<Schema> key_schema_;
+  /** Whether the index rejects duplicate keys */
+  bool is_unique_;
+  /** The mapping relation between the included columns and tuple schema */
+  const std::vector<uint32_t> include_attrs_;
+  /** key_attrs_ followed by include_attrs_ */
+  std::vector<uint32_t> entry_attrs_;
+  /** The schema of an index entry */
+  std::shared_ptr<Schema> entry_schema_;
+};
+
+/**
+ * class IndexScanIterator - A cursor over the RIDs produced by an index scan.
+ *
+ * It hides the concrete key type of the underlying index, so that executors
+ * can scan any index without knowing how it was instantiated.
+ */
+class IndexScanIterator {
+ public:
+  virtual ~IndexScanIterator() = default;
+
+  /** @return Whether the scan is exhausted */
+  virtual auto IsEnd() -> bool = 0;
+
+  /** @return The RID at the current position */
+  virtual auto GetRID() -> RID = 0;
+
+  /**
+   * @return The index entry at the current position, in the layout of IndexMetadata::GetEntrySchema. Together with
+   * the included columns it lets a scan answer a query without fetching the tuple from the table heap.
+   */
+  virtual auto GetEntry() -> Tuple = 0;
+
+  /** Move to the next entry of the scan */
+  virtual void Next() = 0;
 };
 
 /////////////////////////////////////////////////////////////////////
@@ -139,6 +202,15 @@ class Index {
   /** @return The index key attributes */
   auto GetKeyAttrs() const -> const std::vector<uint32_t> & { return metadata_->GetKeyAttrs(); }
 
+  /** @return Whether the index rejects duplicate keys */
+  auto IsUnique() const -> bool { return metadata_->IsUnique(); }
+
+  /** @return The schema of an index entry, the key columns followed by the included columns */
+  auto GetEntrySchema() const -> Schema * { return metadata_->GetEntrySchema(); }
+
+  /** @return The base table columns of an index entry */
+  auto GetEntryAttrs() const -> const std::vector<uint32_t> & { return metadata_->GetEntryAttrs(); }
+
   /** @return A string representation for debugging */
   auto ToString() const -> std::string {
     std::stringstream os;
@@ -153,7 +225,7 @@ class Index {
 
   /**
    * Insert an entry into the index.
-   * @param key The index key
+   * @param key The index entry, the key columns followed by the included columns (see GetEntrySchema)
    * @param rid The RID associated with the key
    * @param transaction The transaction context
    * @returns whether insertion is successful
@@ -168,6 +240,20 @@ class Index {
    */
   virtual void DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) = 0;
 
+  /**
+   * Fill an empty index with entries produced in ascending order of key and RID. The default inserts them one by
+   * one, an index that can build itself from sorted input overrides it.
+   * @param next Sets the next entry and its RID, returns false when there are no more
+   * @param transaction The transaction context
+   */
+  virtual void BulkLoad(const std::function<bool(Tuple *key, RID *rid)> &next, Transaction *transaction) {
+    Tuple key;
+    RID rid;
+    while (next(&key, &rid)) {
+      InsertEntry(key, rid, transaction);
+    }
+  }
+
   /**
    * Search the index for the provided key.
    * @param key The index key
@@ -176,6 +262,76 @@ class Index {
    */
   virtual void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) = 0;
 
+  /**
+   * Search the index for a batch of keys.
+   * @param keys The index keys, in any order
+   * @param result (*result)[i] is populated with the RIDs of keys[i]
+   * @param transaction The transaction context
+   */
+  virtual void ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *result,
+                        Transaction *transaction) {
+    result->assign(keys.size(), {});
+    for (size_t i = 0; i < keys.size(); i++) {
+      ScanKey(keys[i], &(*result)[i], transaction);
+    }
+  }
+
+  /**
+   * Search the index for all keys within [low_key, high_key]. Either bound may be nullptr, meaning the range is
+   * unbounded on that side. Trailing key columns set to NULL match any value, so a bound may constrain only a prefix
+   * of a composite key.
+   * @param low_key The lower bound of the range, or nullptr
+   * @param low_inclusive Whether keys equal to low_key are part of the range
+   * @param high_key The upper bound of the range, or nullptr
+   * @param high_inclusive Whether keys equal to high_key are part of the range
+   * @param result The collection of RIDs that is populated with results of the search, in key order
+   * @param transaction The transaction context
+   */
+  virtual void ScanRange(const Tuple *low_key, bool low_inclusive, const Tuple *high_key, bool high_inclusive,
+                         std::vector<RID> *result, Transaction *transaction) {
+    throw NotImplementedException("range scan is not supported by index " + GetName());
+  }
+
+  /**
+   * Open a cursor over the keys within [low_key, high_key], with the same bound semantics as ScanRange.
+   * @param reverse Whether the keys are produced in descending order
+   * @return A cursor positioned at the first qualifying entry
+   */
+  virtual auto MakeScanIterator(const Tuple *low_key, bool low_inclusive, const Tuple *high_key, bool high_inclusive,
+                                bool reverse) -> std::unique_ptr<IndexScanIterator> {
+    throw NotImplementedException("index scan is not supported by index " + GetName());
+  }
+
+  ///////////////////////////////////////////////////////////////////
+  // Statistics
+  ///////////////////////////////////////////////////////////////////
+
+  /**
+   * @param with_shape Whether to fill in the height and page counts as well, which reads the upper levels of the index
+   * @return The current statistics of the index, or std::nullopt if the index keeps none
+   */
+  virtual auto GetStatistics(bool with_shape) -> std::optional<IndexStatistics> { return std::nullopt; }
+
+  /** Recompute the statistics from the entries of the index, dropping what deletes left behind */
+  virtual void RefreshStatistics() {}
+
+ protected:
+  /** @return whether the bounds select a single key with every key column given, i.e. an equality lookup */
+  auto IsPointLookup(const Tuple *low_key, bool low_inclusive, const Tuple *high_key, bool high_inclusive) const
+      -> bool {
+    if (low_key == nullptr || high_key == nullptr || !low_inclusive || !high_inclusive) {
+      return false;
+    }
+    for (uint32_t i = 0; i < GetKeySchema()->GetColumnCount(); i++) {
+      Value low = low_key->GetValue(GetKeySchema(), i);
+      Value high = high_key->GetValue(GetKeySchema(), i);
+      if (low.IsNull() || high.IsNull() || low.CompareEquals(high) != CmpBool::CmpTrue) {
+        return false;
+      }
+    }
+    return true;
+  }
+
  private:
   /** The Index structure owns its metadata */
   std::unique_ptr<IndexMetadata> metadata_;
@@ -0,0 +1,51 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// index_builder.h
+//
+// Identification: src/include/storage/index/index_builder.h
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "concurrency/transaction.h"
+#include "storage/index/index.h"
+#include "storage/table/table_heap.h"
+
+namespace bustub {
+
+/**
+ * Fill a new index with the entries of every live tuple in a table heap.
+ *
+ * The pages of the heap are split into contiguous ranges, one per worker thread. Every worker extracts the index
+ * entries of its pages and sorts them by key and RID. The sorted runs are then merged and handed to Index::BulkLoad in
+ * key order, which lets a B+ tree build its leaves and internal levels bottom-up instead of inserting every entry.
+ *
+ * The caller must keep the table from being modified while the index is built.
+ *
+ * @param index the index to fill, no other thread may use it yet
+ * @param table_heap the table the index is created on
+ * @param schema the schema of the table
+ * @param txn the transaction creating the index
+ * @param num_workers the number of threads that scan the heap, 0 picks one per hardware thread
+ */
+void BuildIndexFromHeap(Index *index, TableHeap *table_heap, const Schema &schema, Transaction *txn,
+                        size_t num_workers = 0);
+
+/**
+ * Insert a batch of entries into an index, sorted by key and RID first, so that a B+ tree sees keys in order as it
+ * does when it is built from a heap.
+ *
+ * @param index the index to insert into
+ * @param entries index entries, in the format of the entry schema of the index, and the RIDs they point to
+ * @param txn the transaction inserting the entries
+ */
+void InsertEntriesInKeyOrder(Index *index, std::vector<std::pair<Tuple, RID>> entries, Transaction *txn);
+
+}  // namespace bustub
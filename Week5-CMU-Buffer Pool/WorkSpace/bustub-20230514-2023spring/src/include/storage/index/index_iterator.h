@@ -13,6 +13,8 @@
  * For range scan of b+ tree
  */
 #pragma once
+#include <optional>
+
 #include "storage/page/b_plus_tree_leaf_page.h"
 
 namespace bustub {
@@ -26,6 +28,15 @@ class IndexIterator {
   // IndexIterator(BufferPoolManager *bpm, ReadPageGuard &&page_guard_, ReadPageGuard &&head_guard_, int index = -233);
   IndexIterator(BufferPoolManager *bpm, ReadPageGuard &&page_guard_, int index = -233);
 
+  /**
+   * Construct a reverse iterator positioned at the last key not greater than key, or at the last key of the tree when
+   * key is nullopt. operator++ then moves towards smaller keys.
+   */
+  IndexIterator(BufferPoolManager *bpm, page_id_t header_page_id, const KeyComparator *comparator,
+                const std::optional<KeyType> &key);
+
+  IndexIterator(IndexIterator &&that) noexcept;
+
   auto operator=(IndexIterator &&that) noexcept -> IndexIterator &;
 
   ~IndexIterator();  // NOLINT
@@ -36,6 +47,13 @@ class IndexIterator {
 
   auto operator++() -> IndexIterator &;
 
+  /**
+   * Bound the iterator from above (from below for a reverse iterator): once the current key passes stop_key (or reaches
+   * it when stop_inclusive is false), the iterator turns into End() and releases its leaf. Used for range scans so that
+   * we never touch leaves beyond the bound.
+   */
+  void SetStopKey(const KeyType &stop_key, bool stop_inclusive, const KeyComparator *comparator);
+
   auto operator==(const IndexIterator &itr) const -> bool {
     if (this->page_id_ == INVALID_PAGE_ID) {
       // 说明是一个不合法的page，则如果对方也是不合法的,则相等
@@ -61,6 +79,27 @@ class IndexIterator {
   int index_;
   // 当前的page_id,当为End时会体现出作用
   page_id_t page_id_;
+  // 范围扫描的终止键,为空代表一直扫描到最后一个叶子
+  std::optional<KeyType> stop_key_{std::nullopt};
+  bool stop_inclusive_{true};
+  const KeyComparator *comparator_{nullptr};
+  // 反向迭代器:叶子之间没有向前的指针,走到叶子开头时从根重新往下找前一个叶子
+  bool reverse_{false};
+  page_id_t header_page_id_{INVALID_PAGE_ID};
+  // operator*返回的键值对
+  MappingType current_;
+
+  // 越过终止键时把迭代器置为End
+  void CheckStopKey();
+
+  // 定位到最后一个小于key(inclusive时为不大于key)的键,key为空时定位到整棵树的最后一个键
+  void SeekBackward(const std::optional<KeyType> &key, bool inclusive);
+
+  // 当前叶子读完了就往后面的叶子走,惰性删除会留下空的叶子,一直走到有键的叶子或者末尾
+  void SkipExhaustedLeaves();
+
+  // 置为End并释放叶子
+  void SetEnd();
 };
 
 }  // namespace bustub
@@ -0,0 +1,113 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// index_statistics.h
+//
+// Identification: src/include/storage/index/index_statistics.h
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "common/config.h"
+#include "storage/index/bloom_filter.h"
+#include "storage/table/tuple.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/**
+ * A HyperLogLog sketch counting the distinct hashes added to it, with a standard error of about 3%. Registers are
+ * updated with atomic compare-and-swap, adds may run concurrently.
+ */
+class HyperLogLog {
+ public:
+  static constexpr uint32_t PRECISION = 10;
+
+  void Add(uint64_t hash);
+
+  /** @return the estimated number of distinct hashes added */
+  auto Estimate() const -> double;
+
+ private:
+  static constexpr size_t NUM_REGISTERS = 1 << PRECISION;
+
+  std::array<std::atomic<uint8_t>, NUM_REGISTERS> registers_{};
+};
+
+/** A snapshot of the statistics of an index */
+struct IndexStatistics {
+  size_t num_entries_{0};
+  // distinct_prefixes_[i] is the estimated number of distinct values of the first i + 1 key columns
+  std::vector<size_t> distinct_prefixes_;
+  // the shape of the tree, only filled in when asked for
+  int height_{0};
+  int internal_pages_{0};
+  int leaf_pages_{0};
+  // entries per leaf page relative to the leaf capacity
+  double leaf_fill_{0};
+  // equi-depth histogram on the first key column: bucket i holds histogram_counts_[i] entries with values in
+  // (histogram_bounds_[i], histogram_bounds_[i + 1]], the first bucket also holds histogram_bounds_[0]. Empty until
+  // the statistics are refreshed.
+  std::vector<Value> histogram_bounds_;
+  std::vector<size_t> histogram_counts_;
+
+  /** @return the estimated number of distinct keys */
+  auto GetDistinctKeys() const -> size_t { return distinct_prefixes_.empty() ? 0 : distinct_prefixes_.back(); }
+
+  /**
+   * Estimate how many entries an index scan with these bounds returns. The bounds are built like an index scan's:
+   * leading columns with equal low and high values are equality conditions, a trailing column may carry a range.
+   */
+  auto EstimateRows(const std::vector<Value> &low_key, bool low_inclusive, const std::vector<Value> &high_key,
+                    bool high_inclusive) const -> double;
+};
+
+/**
+ * Keeps the statistics of one index up to date. Inserts and deletes adjust the entry count and the histogram, inserts
+ * feed the distinct-key sketches; deleted keys stay in the sketches and the histogram bounds stay put until Refresh
+ * recomputes everything from the entries of the index.
+ */
+class IndexStatisticsCollector {
+ public:
+  explicit IndexStatisticsCollector(uint32_t key_column_count);
+
+  /** Count an entry added to the index, the key columns lead the tuple */
+  void Insert(const Tuple &key, const Schema *schema);
+
+  /** Count an entry removed from the index, the key columns lead the tuple */
+  void Delete(const Tuple &key, const Schema *schema);
+
+  /** Recompute the statistics from scratch, the scanner enumerates the entries in key order */
+  void Refresh(const IndexEntryScanner &scan_entries);
+
+  /** Fill in the entry count, the distinct keys and the histogram */
+  void Snapshot(IndexStatistics *stats);
+
+ private:
+  /** Feed the prefixes of a key to the sketches */
+  void AddToSketches(const Tuple &key, const Schema *schema);
+
+  /** @return the bucket a first key column value falls into, latch_ must be held */
+  auto BucketOf(const Value &value) const -> size_t;
+
+  uint32_t key_column_count_;
+  std::atomic<size_t> num_entries_{0};
+  // 插入和删除拿读锁,Refresh换掉sketch和直方图时拿写锁
+  std::shared_mutex latch_;
+  // 每个键前缀一个sketch
+  std::vector<std::unique_ptr<HyperLogLog>> sketches_;
+  std::vector<Value> histogram_bounds_;
+  std::unique_ptr<std::atomic<size_t>[]> histogram_counts_;
+};
+
+}  // namespace bustub
@@ -13,14 +13,20 @@
 #include <queue>
 #include <string>
 #include <utility>
+#include <vector>
 
+#include "storage/page/b_plus_tree_key_array.h"
 #include "storage/page/b_plus_tree_page.h"
 
 namespace bustub {
 
 #define B_PLUS_TREE_INTERNAL_PAGE_TYPE BPlusTreeInternalPage<KeyType, ValueType, KeyComparator>
-#define INTERNAL_PAGE_HEADER_SIZE 12
-#define INTERNAL_PAGE_SIZE ((BUSTUB_PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / (sizeof(MappingType)))
+#define INTERNAL_PAGE_HEADER_SIZE (12 + BPlusTreeKeyArray<KeyType, ValueType>::HEADER_SIZE)
+#define INTERNAL_PAGE_SPACE (BUSTUB_PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE)
+// 不压缩时一页能放下的孩子数
+#define INTERNAL_PAGE_SLOT_COUNT (INTERNAL_PAGE_SPACE / (sizeof(MappingType)))
+// 压缩以后最多放两倍,满了再插一个分裂出来的两半就算不压缩也放得下
+#define INTERNAL_PAGE_SIZE (2 * INTERNAL_PAGE_SLOT_COUNT - 1)
 /**
  * Store n indexed keys and n+1 child pointers (page_id) within internal page.
  * Pointer PAGE_ID(i) points to a subtree in which all keys K satisfy:
@@ -29,10 +35,16 @@ namespace bustub {
  * the first key always remains invalid. That is to say, any search/lookup
  * should ignore the first key.
  *
- * Internal page format (keys are stored in increasing order):
+ * Internal page format (keys are stored in increasing order, compressed
+ * against a template key, see BPlusTreeKeyArray):
  *  --------------------------------------------------------------------------
  * | HEADER | KEY(1)+PAGE_ID(1) | KEY(2)+PAGE_ID(2) | ... | KEY(n)+PAGE_ID(n) |
  *  --------------------------------------------------------------------------
+ *
+ * The keys are separators picked by the comparator as short as it can (see
+ * GenericComparator::ShortestSeparator), which keeps the compressed range of
+ * the page narrow. MaxSize only bounds the number of children, writing a key
+ * may also fail because the compressed entries no longer fit in the page.
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeInternalPage : public BPlusTreePage {
@@ -58,8 +70,9 @@ class BPlusTreeInternalPage : public BPlusTreePage {
    *
    * @param index The index of the key to set. Index must be non-zero.
    * @param key The new value for key
+   * @return false, leaving the page untouched, if the entries no longer fit
    */
-  void SetKeyAt(int index, const KeyType &key);
+  auto SetKeyAt(int index, const KeyType &key) -> bool;
 
   /**
    *
@@ -76,11 +89,32 @@ class BPlusTreeInternalPage : public BPlusTreePage {
 
   void SetValueAt(int index, const page_id_t &value);
 
-  void SetArrayAt(int index, std::pair<KeyType, page_id_t> value);
+  /**
+   * Uncompressed pages split when they are full in bytes, long before MaxSize,
+   * so the min size follows what an uncompressed page holds.
+   */
+  auto GetMinSize() const -> int;
+
+  /** @return the index of the first key not less than key, in [1, GetSize()] */
+  auto LowerBound(const KeyType &key, const KeyComparator &comparator) const -> int;
 
-  auto GetArray() const -> const MappingType *;
+  /** @return the index of the first key greater than key, in [1, GetSize()] */
+  auto UpperBound(const KeyType &key, const KeyComparator &comparator) const -> int;
 
-  auto GetMinSize() const -> int;
+  /**
+   * Insert a key and the child right of it in front of index, index must be non-zero.
+   * @return false, leaving the page untouched, if the entries no longer fit
+   */
+  auto InsertAt(int index, const KeyType &key, const ValueType &value) -> bool;
+
+  /** @return all keys and children of the page, the first key is invalid */
+  auto GetEntries() const -> std::vector<MappingType>;
+
+  /**
+   * Replace all keys and children of the page, the first key is ignored.
+   * @return false, leaving the page untouched, if they do not fit
+   */
+  auto SetEntries(const std::vector<MappingType> &entries) -> bool;
 
   void DeleteAValue(int pos);
 
@@ -111,7 +145,7 @@ class BPlusTreeInternalPage : public BPlusTreePage {
   }
 
  private:
-  // Flexible array member for page data.
-  MappingType array_[0];
+  // Compressed key/child slots, extends to the end of the page.
+  BPlusTreeKeyArray<KeyType, ValueType> array_;
 };
 }  // namespace bustub
@@ -0,0 +1,196 @@
+//===----------------------------------------------------------------------===//
+//
+//                         CMU-DB Project (15-445/645)
+//                         ***DO NO SHARE PUBLICLY***
+//
+// Identification: src/include/page/b_plus_tree_key_array.h
+//
+// Copyright (c) 2018, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace bustub {
+
+/**
+ * The key/value slots of a B+ tree page, with prefix and suffix compression.
+ *
+ * All keys of a page are stored against one template key kept in the header of the array. A slot only holds the
+ * bytes [DiffBegin, DiffEnd) of its key, the range where the keys of the page differ from the template: the common
+ * prefix before the range and the common suffix after it (mostly the zero padding of a short key) are read from the
+ * template. The range only widens while slots are written, it is recomputed when the page is rebuilt by Assign.
+ *
+ * The array does not know how many slots it holds, the page passes its size in. The keys in front of first_key are
+ * not real keys (the first key of an internal page), they never widen the range and read back as garbage.
+ *
+ * Format (size in byte):
+ *  --------------------------------------------------------------------------------------------------
+ * | DiffBegin (2) | DiffEnd (2) | Template (sizeof(KeyType)) | KEY(1) + VALUE(1) | KEY(2) + VALUE(2) | ...
+ *  --------------------------------------------------------------------------------------------------
+ */
+template <typename KeyType, typename ValueType>
+class BPlusTreeKeyArray {
+ public:
+  static constexpr size_t HEADER_SIZE = 2 * sizeof(uint16_t) + sizeof(KeyType);
+
+  BPlusTreeKeyArray() = delete;
+  BPlusTreeKeyArray(const BPlusTreeKeyArray &other) = delete;
+
+  void Init() {
+    diff_begin_ = 0;
+    diff_end_ = 0;
+    memset(template_, 0, sizeof(KeyType));
+  }
+
+  /** @return the bytes a slot takes with the current range */
+  auto SlotSize() const -> size_t { return diff_end_ - diff_begin_ + sizeof(ValueType); }
+
+  auto KeyAt(int index) const -> KeyType {
+    KeyType key;
+    memcpy(&key, template_, sizeof(KeyType));
+    memcpy(reinterpret_cast<char *>(&key) + diff_begin_, Slot(index), diff_end_ - diff_begin_);
+    return key;
+  }
+
+  auto ValueAt(int index) const -> ValueType {
+    ValueType value;
+    memcpy(&value, Slot(index) + diff_end_ - diff_begin_, sizeof(ValueType));
+    return value;
+  }
+
+  void SetValueAt(int index, const ValueType &value) {
+    memcpy(Slot(index) + diff_end_ - diff_begin_, &value, sizeof(ValueType));
+  }
+
+  /** @return all size slots decoded */
+  auto Entries(int size) const -> std::vector<std::pair<KeyType, ValueType>> {
+    std::vector<std::pair<KeyType, ValueType>> entries;
+    entries.reserve(size);
+    for (int i = 0; i < size; i++) {
+      entries.emplace_back(KeyAt(i), ValueAt(i));
+    }
+    return entries;
+  }
+
+  /**
+   * Rewrite the slots to hold entries, with the narrowest range for their keys.
+   * @return false, leaving the slots untouched, if they do not fit in space bytes
+   */
+  auto Assign(const std::vector<std::pair<KeyType, ValueType>> &entries, int first_key, size_t space) -> bool {
+    const char *base = nullptr;
+    size_t begin = 0;
+    size_t end = 0;
+    for (size_t i = first_key; i < entries.size(); i++) {
+      auto key = reinterpret_cast<const char *>(&entries[i].first);
+      if (base == nullptr) {
+        base = key;
+        continue;
+      }
+      Widen(base, key, &begin, &end);
+    }
+    if (entries.size() * (end - begin + sizeof(ValueType)) > space) {
+      return false;
+    }
+    if (base != nullptr) {
+      memcpy(template_, base, sizeof(KeyType));
+    }
+    diff_begin_ = begin;
+    diff_end_ = end;
+    for (size_t i = 0; i < entries.size(); i++) {
+      WriteSlot(i, entries[i].first, entries[i].second);
+    }
+    return true;
+  }
+
+  /**
+   * Insert an entry in front of slot index, the size slots after it move right by one.
+   * @return false, leaving the slots untouched, if they do not fit in space bytes any more
+   */
+  auto Insert(int size, int first_key, int index, const KeyType &key, const ValueType &value, size_t space) -> bool {
+    if (!Covers(size, first_key, key)) {
+      auto entries = Entries(size);
+      entries.insert(entries.begin() + index, std::make_pair(key, value));
+      return Assign(entries, first_key, space);
+    }
+    if ((size + 1) * SlotSize() > space) {
+      return false;
+    }
+    memmove(Slot(index + 1), Slot(index), (size - index) * SlotSize());
+    WriteSlot(index, key, value);
+    return true;
+  }
+
+  /**
+   * Replace the key of slot index.
+   * @return false, leaving the slots untouched, if they do not fit in space bytes any more
+   */
+  auto SetKeyAt(int size, int first_key, int index, const KeyType &key, size_t space) -> bool {
+    if (!Covers(size, first_key, key)) {
+      auto entries = Entries(size);
+      entries[index].first = key;
+      return Assign(entries, first_key, space);
+    }
+    WriteSlot(index, key, ValueAt(index));
+    return true;
+  }
+
+  /** Remove slot index, the slots after it move left by one */
+  void Erase(int size, int index) { memmove(Slot(index), Slot(index + 1), (size - index - 1) * SlotSize()); }
+
+ private:
+  /** Widen [*begin, *end) to cover the bytes where key differs from base */
+  static void Widen(const char *base, const char *key, size_t *begin, size_t *end) {
+    size_t first = 0;
+    while (first < sizeof(KeyType) && base[first] == key[first]) {
+      first++;
+    }
+    if (first == sizeof(KeyType)) {
+      return;
+    }
+    size_t last = sizeof(KeyType);
+    while (base[last - 1] == key[last - 1]) {
+      last--;
+    }
+    if (*begin == *end) {
+      *begin = first;
+      *end = last;
+    } else {
+      *begin = std::min(*begin, first);
+      *end = std::max(*end, last);
+    }
+  }
+
+  /** @return true if key only differs from the template inside the current range */
+  auto Covers(int size, int first_key, const KeyType &key) const -> bool {
+    if (size <= first_key) {
+      // 还没有真正的键,模板是旧的,重新选一个
+      return false;
+    }
+    size_t begin = diff_begin_;
+    size_t end = diff_end_;
+    Widen(template_, reinterpret_cast<const char *>(&key), &begin, &end);
+    return begin == diff_begin_ && end == diff_end_;
+  }
+
+  auto Slot(int index) -> char * { return data_ + index * SlotSize(); }
+  auto Slot(int index) const -> const char * { return data_ + index * SlotSize(); }
+
+  void WriteSlot(int index, const KeyType &key, const ValueType &value) {
+    memcpy(Slot(index), reinterpret_cast<const char *>(&key) + diff_begin_, diff_end_ - diff_begin_);
+    memcpy(Slot(index) + diff_end_ - diff_begin_, &value, sizeof(ValueType));
+  }
+
+  uint16_t diff_begin_;
+  uint16_t diff_end_;
+  char template_[sizeof(KeyType)];
+  // Flexible array member for the slots.
+  char data_[0];
+};
+
+}  // namespace bustub
@@ -14,31 +14,40 @@
 #include <utility>
 #include <vector>
 
+#include "storage/page/b_plus_tree_key_array.h"
 #include "storage/page/b_plus_tree_page.h"
 
 namespace bustub {
 
 #define B_PLUS_TREE_LEAF_PAGE_TYPE BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>
-#define LEAF_PAGE_HEADER_SIZE 16
-#define LEAF_PAGE_SIZE ((BUSTUB_PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / sizeof(MappingType))
+#define LEAF_PAGE_HEADER_SIZE (16 + BPlusTreeKeyArray<KeyType, ValueType>::HEADER_SIZE)
+#define LEAF_PAGE_SPACE (BUSTUB_PAGE_SIZE - LEAF_PAGE_HEADER_SIZE)
+// 不压缩时一页能放下的键值对数
+#define LEAF_PAGE_SLOT_COUNT (LEAF_PAGE_SPACE / sizeof(MappingType))
+// 压缩以后最多放两倍,分裂出来的两半就算不压缩也放得下
+#define LEAF_PAGE_SIZE (2 * LEAF_PAGE_SLOT_COUNT)
 
 /**
  * Store indexed key and record id(record id = page id combined with slot id,
  * see include/common/rid.h for detailed implementation) together within leaf
  * page. Only support unique key.
  *
- * Leaf page format (keys are stored in order):
+ * Leaf page format (keys are stored in order, compressed against a template
+ * key, see BPlusTreeKeyArray):
  *  ----------------------------------------------------------------------
  * | HEADER | KEY(1) + RID(1) | KEY(2) + RID(2) | ... | KEY(n) + RID(n)
  *  ----------------------------------------------------------------------
  *
- *  Header format (size in byte, 16 bytes in total):
+ *  Header format (size in byte, 20 + sizeof(KeyType) bytes in total):
  *  ---------------------------------------------------------------------
  * | PageType (4) | CurrentSize (4) | MaxSize (4) |
  *  ---------------------------------------------------------------------
- *  -----------------------------------------------
- * |  NextPageId (4)
- *  -----------------------------------------------
+ *  -----------------------------------------------------------------------
+ * |  NextPageId (4) | DiffBegin (2) | DiffEnd (2) | Template (KeySize)
+ *  -----------------------------------------------------------------------
+ *
+ * MaxSize only bounds the number of entries, an insert may also fail because
+ * the compressed entries no longer fit in the page.
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeLeafPage : public BPlusTreePage {
@@ -58,15 +67,33 @@ class BPlusTreeLeafPage : public BPlusTreePage {
   auto GetNextPageId() const -> page_id_t;
   void SetNextPageId(page_id_t next_page_id);
 
-  void SetKeyAt(int index, const KeyType &key);
-
   auto KeyAt(int index) const -> KeyType;
   auto ValueAt(int index) const -> ValueType;
-  auto KeyValueAt(int index) const -> const MappingType &;
+  auto KeyValueAt(int index) const -> MappingType;
+
+  /**
+   * Uncompressed pages split when they are full in bytes, long before MaxSize,
+   * so the min size follows what an uncompressed page holds.
+   */
+  auto GetMinSize() const -> int;
 
-  void SetArrayAt(int index, MappingType value);
+  /** @return the index of the first key not less than key, GetSize() if there is none */
+  auto LowerBound(const KeyType &key, const KeyComparator &comparator) const -> int;
 
-  auto GetArray() const -> const MappingType *;
+  /**
+   * Insert a key/value pair in front of index.
+   * @return false, leaving the page untouched, if the entries no longer fit
+   */
+  auto InsertAt(int index, const KeyType &key, const ValueType &value) -> bool;
+
+  /** @return all entries of the page */
+  auto GetEntries() const -> std::vector<MappingType>;
+
+  /**
+   * Replace all entries of the page.
+   * @return false, leaving the page untouched, if they do not fit
+   */
+  auto SetEntries(const std::vector<MappingType> &entries) -> bool;
 
   void DeleteAValue(int pos);
 
@@ -97,7 +124,7 @@ class BPlusTreeLeafPage : public BPlusTreePage {
 
  private:
   page_id_t next_page_id_;
-  // Flexible array member for page data.
-  MappingType array_[0];
+  // Compressed key/value slots, extends to the end of the page.
+  BPlusTreeKeyArray<KeyType, ValueType> array_;
 };
 }  // namespace bustub
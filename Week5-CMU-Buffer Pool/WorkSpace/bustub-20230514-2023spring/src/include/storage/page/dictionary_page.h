@@ -0,0 +1,66 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// dictionary_page.h
+//
+// Identification: src/include/storage/page/dictionary_page.h
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <optional>
+#include <string_view>
+
+#include "common/config.h"
+
+namespace bustub {
+
+static constexpr uint64_t DICTIONARY_PAGE_HEADER_SIZE = 8;
+
+/**
+ * A page of the dictionary of a table, holding the strings of consecutive codes back to back:
+ *  ---------------------------------------------------------------
+ *  | HEADER | STRING_0 | STRING_1 | ... | STRING_n | FREE SPACE |
+ *  ---------------------------------------------------------------
+ *
+ *  Header format (size in bytes):
+ *  --------------------------------------------------
+ *  | NextPageId (4) | NumStrings (2) | DataEnd (2) |
+ *  --------------------------------------------------
+ *
+ * A string is stored as its length (2) followed by its bytes. Strings are only ever appended, the offset of a string
+ * in its page never changes.
+ */
+class DictionaryPage {
+ public:
+  void Init();
+
+  auto GetNextPageId() const -> page_id_t { return next_page_id_; }
+
+  void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+  auto GetNumStrings() const -> uint32_t { return num_strings_; }
+
+  /** @return the largest string a page can hold */
+  static constexpr auto MaxStringLength() -> size_t {
+    return BUSTUB_PAGE_SIZE - DICTIONARY_PAGE_HEADER_SIZE - sizeof(uint16_t);
+  }
+
+  /** Append a string, return its offset in the page or nullopt if it does not fit */
+  auto AppendString(std::string_view str) -> std::optional<uint16_t>;
+
+  /** @return the string stored at offset, valid while the page is latched */
+  auto GetString(uint16_t offset) const -> std::string_view;
+
+ private:
+  char page_start_[0];
+  page_id_t next_page_id_;
+  uint16_t num_strings_;
+  uint16_t data_end_;
+};
+
+static_assert(sizeof(DictionaryPage) == DICTIONARY_PAGE_HEADER_SIZE);
+
+}  // namespace bustub
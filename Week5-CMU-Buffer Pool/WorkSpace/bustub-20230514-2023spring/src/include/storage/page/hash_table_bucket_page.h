@@ -30,8 +30,11 @@ namespace bustub {
  *  ----------------------------------------------------------------
  *
  *  Here '+' means concatenation.
- *  The above format omits the space required for the occupied_ and
- *  readable_ arrays. More information is in storage/page/hash_table_page_defs.h.
+ *  The above format omits the space required for the overflow page id and the
+ *  occupied_ and readable_ arrays. More information is in storage/page/hash_table_page_defs.h.
+ *
+ *  A bucket that can no longer be split chains further bucket pages after its first one
+ *  through the overflow page id, the page latch of the first page guards the whole chain.
  *
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
@@ -40,6 +43,23 @@ class HashTableBucketPage {
   // Delete all constructor / destructor to ensure memory safety
   HashTableBucketPage() = delete;
 
+  /**
+   * Empties the bucket and cuts it off any overflow chain. A bucket page must be initialized before it is chained.
+   */
+  void Init();
+
+  /**
+   * @return the page id of the next bucket page in the overflow chain, INVALID_PAGE_ID if this is the last one
+   */
+  auto GetOverflowPageId() const -> page_id_t;
+
+  /**
+   * Chains a bucket page after this one.
+   *
+   * @param overflow_page_id the page id of the next bucket page, INVALID_PAGE_ID to end the chain here
+   */
+  void SetOverflowPageId(page_id_t overflow_page_id);
+
   /**
    * Scan the bucket and collect values that have the matching key
    *
@@ -138,6 +158,7 @@ class HashTableBucketPage {
   void PrintBucket();
 
  private:
+  page_id_t overflow_page_id_;
   //  For more on BUCKET_ARRAY_SIZE see storage/page/hash_table_page_defs.h
   char occupied_[(BUCKET_ARRAY_SIZE - 1) / 8 + 1];
   // 0 if tombstone/brand new (never occupied), 1 otherwise.
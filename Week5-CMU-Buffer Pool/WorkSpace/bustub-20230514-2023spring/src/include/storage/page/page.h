@@ -57,6 +57,9 @@ class Page {
   /** Release the page write latch. */
   inline void WUnlatch() { rwlatch_.WUnlock(); }
 
+  /** Acquire the page write latch if nobody holds the latch. @return true on success */
+  inline auto TryWLatch() -> bool { return rwlatch_.TryWLock(); }
+
   /** Acquire the page read latch. */
   inline void RLatch() { rwlatch_.RLock(); }
 
@@ -0,0 +1,184 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// pax_page.h
+//
+// Identification: src/include/storage/page/pax_page.h
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "common/config.h"
+#include "common/rid.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+static constexpr uint64_t PAX_PAGE_HEADER_SIZE = 12;
+
+/**
+ * Where the column mini-pages of a PAX table start in each of its pages. Every page of a table holds the same number
+ * of slots, picked so that the fixed-width area leaves room for VARCHAR values that fill half their declared length.
+ */
+class PaxLayout {
+  friend class PaxPage;
+
+ public:
+  explicit PaxLayout(const Schema &schema);
+
+  /** @return the number of tuples a page can hold at most */
+  auto GetCapacity() const -> uint32_t { return capacity_; }
+
+ private:
+  /** @return the length of a VARCHAR value in a tuple of this layout, BUSTUB_VALUE_NULL for NULL */
+  auto VarlenLength(const Tuple &tuple, uint32_t col_idx) const -> uint32_t;
+
+  struct ColumnInfo {
+    /** where the value, or the offset of a VARCHAR value, is stored in a tuple */
+    uint32_t tuple_offset_;
+    /** bytes per slot in the mini-page: the value size, or offset and length of a VARCHAR value */
+    uint32_t width_;
+    bool inlined_;
+    /** where the mini-page starts in a page */
+    uint32_t page_offset_;
+  };
+
+  Schema schema_;
+  std::vector<ColumnInfo> columns_;
+  /** the null bitmap of a tuple, stored in a mini-page of its own after the columns */
+  ColumnInfo bitmap_;
+  /** the VARCHAR columns in schema order, which is also the order of their data in a tuple */
+  std::vector<uint32_t> varlen_columns_;
+  uint32_t capacity_;
+  /** bytes of the fixed-width area used by one slot, its meta and flag included */
+  uint32_t slot_size_;
+  /** where the fixed-width area ends and the VARCHAR area may begin */
+  uint32_t fixed_end_;
+  /**
+   * the inlined part and the null bitmap of a tuple whose columns are all NULL, copied before the columns read are
+   * filled in
+   */
+  std::vector<char> null_tuple_;
+};
+
+/**
+ * PAX (partition attributes across) page format, a table page storing each column in its own mini-page:
+ *  ------------------------------------------------------------------------------------------------------------
+ *  | HEADER | META[cap] | RECLAIMED[cap] | COLUMN_0[cap] | ... | NULL_BITMAP[cap] | FREE SPACE | VARCHAR DATA |
+ *  ------------------------------------------------------------------------------------------------------------
+ *
+ *  Header format (size in bytes):
+ *  ----------------------------------------------------------------------------------------
+ *  | NextPageId (4)| NumTuples(2) | NumDeletedTuples(2) | VarlenOffset(2) | Reserved(2) |
+ *  ----------------------------------------------------------------------------------------
+ *
+ * A fixed-width column stores its values back to back exactly as a tuple does, so reading one column of many tuples
+ * walks one contiguous array. A VARCHAR column stores the offset and length (2 + 2) of each value, the value itself
+ * grows down from the end of the page; a NULL has length 0xFFFF. The header starts like the one of TablePage, so
+ * code walking a chain of pages may read the next page id and the tuple count through either class.
+ */
+class PaxPage {
+ public:
+  void Init();
+
+  auto GetNumTuples() const -> uint32_t { return num_tuples_; }
+
+  auto GetNumDeletedTuples() const -> uint32_t { return num_deleted_tuples_; }
+
+  auto GetNextPageId() const -> page_id_t { return next_page_id_; }
+
+  void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+  /**
+   * @return the bytes the next tuple may take, a tuple needing more than that does not fit. Every slot reserves its
+   * fixed-width part, so once the slots run out the page is full whatever VARCHAR space is left.
+   */
+  auto GetFreeSpace(const PaxLayout &layout) const -> size_t;
+
+  /** @return the bytes a tuple takes in a page of this layout, its fixed-width slot included */
+  static auto GetSpaceNeeded(const PaxLayout &layout, const Tuple &tuple) -> size_t;
+
+  /** Split a tuple into the column mini-pages, return nullopt if it does not fit */
+  auto InsertTuple(const PaxLayout &layout, const TupleMeta &meta, const Tuple &tuple) -> std::optional<uint16_t>;
+
+  void UpdateTupleMeta(const TupleMeta &meta, const RID &rid);
+
+  /**
+   * Rebuild a tuple from the column mini-pages.
+   * @param columns if not nullptr, only these columns are read, the others are NULL in the returned tuple
+   * @return the meta and tuple, the tuple is empty for a deleted tuple whose data a vacuum dropped
+   */
+  auto GetTuple(const PaxLayout &layout, const RID &rid, const std::vector<uint32_t> *columns = nullptr) const
+      -> std::pair<TupleMeta, Tuple>;
+
+  /**
+   * Same as GetTuple, but rebuild the tuple into buffer, whose memory is reused from one call to the next.
+   * @return the meta and a view of buffer, valid until buffer is written again
+   */
+  auto GetTupleView(const PaxLayout &layout, const RID &rid, const std::vector<uint32_t> *columns,
+                    std::vector<char> *buffer) const -> std::pair<TupleMeta, TupleView>;
+
+  auto GetTupleMeta(const RID &rid) const -> TupleMeta;
+
+  /** @return true if tuple can overwrite the tuple in the slot of rid, no VARCHAR value growing past its old one */
+  auto CanUpdateInPlace(const PaxLayout &layout, const Tuple &tuple, const RID &rid) const -> bool;
+
+  /** Overwrite a tuple in place, a VARCHAR value may not grow past the space its old value took */
+  void UpdateTupleInPlaceUnsafe(const PaxLayout &layout, const TupleMeta &meta, const Tuple &tuple, RID rid);
+
+  /**
+   * Same as TablePage::Compact: drop the VARCHAR data of deleted tuples, give the trailing deleted slots up and pack
+   * the VARCHAR area at the end of the page.
+   * @return the number of bytes reclaimed
+   */
+  auto Compact(const PaxLayout &layout) -> size_t;
+
+ private:
+  struct VarlenEntry {
+    uint16_t offset_;
+    uint16_t len_;
+  };
+  static constexpr uint16_t VARLEN_NULL = 0xFFFF;
+
+  static_assert(BUSTUB_PAGE_SIZE < VARLEN_NULL);
+
+  auto CheckSlot(const RID &rid) const -> uint16_t;
+
+  /** Offsets in the page of the meta, reclaimed flag and null bitmap of a slot, and of a value in a column mini-page */
+  static auto MetaOffset(uint16_t slot) -> size_t { return PAX_PAGE_HEADER_SIZE + TUPLE_META_SIZE * slot; }
+  static auto ReclaimedOffset(const PaxLayout &layout, uint16_t slot) -> size_t {
+    return PAX_PAGE_HEADER_SIZE + TUPLE_META_SIZE * layout.capacity_ + slot;
+  }
+  static auto ValueOffset(const PaxLayout &layout, uint32_t col_idx, uint16_t slot) -> size_t {
+    const auto &column = layout.columns_[col_idx];
+    return column.page_offset_ + column.width_ * slot;
+  }
+  static auto BitmapOffset(const PaxLayout &layout, uint16_t slot) -> size_t {
+    return layout.bitmap_.page_offset_ + layout.bitmap_.width_ * slot;
+  }
+
+  /** Write the bytes of a tuple, in the format of Tuple, rebuilt from the mini-pages into out */
+  void ReadTupleData(const PaxLayout &layout, uint16_t slot, const std::vector<uint32_t> *columns,
+                     std::vector<char> *out) const;
+
+  /** @return the free bytes in the VARCHAR area plus the fixed-width space of the unused slots */
+  auto GetUnusedSpace(const PaxLayout &layout) const -> size_t;
+
+  char page_start_[0];
+  page_id_t next_page_id_;
+  uint16_t num_tuples_;
+  uint16_t num_deleted_tuples_;
+  uint16_t varlen_offset_;
+  uint16_t reserved_;
+};
+
+static_assert(sizeof(PaxPage) == PAX_PAGE_HEADER_SIZE);
+
+}  // namespace bustub
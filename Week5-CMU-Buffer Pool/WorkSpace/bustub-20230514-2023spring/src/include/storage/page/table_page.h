@@ -59,12 +59,21 @@ class TablePage {
   /** @return number of tuples in this page */
   auto GetNumTuples() const -> uint32_t { return num_tuples_; }
 
+  /** @return number of tuples marked deleted in this page, still holding their slots */
+  auto GetNumDeletedTuples() const -> uint32_t { return num_deleted_tuples_; }
+
   /** @return the page ID of the next table page */
   auto GetNextPageId() const -> page_id_t { return next_page_id_; }
 
   /** Set the page id of the next page in the table. */
   void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
 
+  /** @return the bytes left between the slot array and the tuple data, for new tuples and their slots */
+  auto GetFreeSpace() const -> size_t;
+
+  /** @return the bytes a tuple takes in a page, including its slot */
+  static auto GetSpaceNeeded(const Tuple &tuple) -> size_t { return tuple.GetLength() + TUPLE_INFO_SIZE; }
+
   /** Get the next offset to insert, return nullopt if this tuple cannot fit in this page */
   auto GetNextTupleOffset(const TupleMeta &meta, const Tuple &tuple) const -> std::optional<uint16_t>;
 
@@ -85,16 +94,34 @@ class TablePage {
    */
   auto GetTuple(const RID &rid) const -> std::pair<TupleMeta, Tuple>;
 
+  /**
+   * Read a tuple from a table without copying it, the view is valid as long as the page is latched.
+   */
+  auto GetTupleView(const RID &rid) const -> std::pair<TupleMeta, TupleView>;
+
   /**
    * Read a tuple meta from a table.
    */
   auto GetTupleMeta(const RID &rid) const -> TupleMeta;
 
+  /**
+   * @return true if the tuple in the slot of rid can be overwritten by tuple in place, which needs the same size
+   */
+  auto CanUpdateInPlace(const Tuple &tuple, const RID &rid) const -> bool;
+
   /**
    * Update a tuple in place.
    */
   void UpdateTupleInPlaceUnsafe(const TupleMeta &meta, const Tuple &tuple, RID rid);
 
+  /**
+   * Drop the data of deleted tuples and pack the rest at the end of the page. Live tuples keep their slots, deleted
+   * tuples at the end of the slot array give their slots up for new tuples, the others stay as empty deleted slots.
+   * Only safe once no transaction can undo the deletes.
+   * @return the number of bytes reclaimed
+   */
+  auto Compact() -> size_t;
+
   static_assert(sizeof(page_id_t) == 4);
 
  private:
@@ -0,0 +1,66 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map.h
+//
+// Identification: src/include/storage/table/free_space_map.h
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * The free-space map of a table heap. Every page is summarized by a 4-bit category, the free space of the page in
+ * units of BUSTUB_PAGE_SIZE / 16 rounded down, so a page is never reported roomier than it is. A max-tree over the
+ * categories finds the first page with enough room in O(log n).
+ *
+ * A page handed out by TakePage is recorded as full until its user gives it back with Update, so that two inserting
+ * threads are never sent to the same page. Pages are only handed out once at least REUSE_CATEGORY units are free:
+ * a page left behind because one tuple did not fit is not refilled with smaller tuples, which keeps single-threaded
+ * inserts in insertion order.
+ */
+class FreeSpaceMap {
+ public:
+  static constexpr size_t CATEGORY_BYTES = BUSTUB_PAGE_SIZE / 16;
+  static constexpr uint8_t MAX_CATEGORY = 15;
+  static constexpr uint8_t REUSE_CATEGORY = 2;
+
+  /** Track a new page of the heap, with free_space bytes available */
+  void AddPage(page_id_t page_id, size_t free_space);
+
+  /** Record the free space of a tracked page, giving the page back if it was taken */
+  void Update(page_id_t page_id, size_t free_space);
+
+  /**
+   * Find the first page with at least free_space bytes available and mark it as full.
+   * @return the page id, or INVALID_PAGE_ID if no page has enough room
+   */
+  auto TakePage(size_t free_space) -> page_id_t;
+
+  /** @return a lower bound of the free space of a tracked page, 0 while it is taken */
+  auto GetFreeSpace(page_id_t page_id) -> size_t;
+
+ private:
+  static auto CategoryOf(size_t free_space) -> uint8_t;
+
+  void SetCategory(size_t index, uint8_t category);
+
+  std::mutex latch_;
+  /** leaves of the max-tree start at capacity_, node i has children 2i and 2i + 1 */
+  std::vector<uint8_t> tree_;
+  size_t capacity_{0};
+  std::vector<page_id_t> page_ids_;
+  std::unordered_map<page_id_t, size_t> index_of_;
+};
+
+}  // namespace bustub
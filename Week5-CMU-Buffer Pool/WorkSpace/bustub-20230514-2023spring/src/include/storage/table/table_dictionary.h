@@ -0,0 +1,86 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// table_dictionary.h
+//
+// Identification: src/include/storage/table/table_dictionary.h
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "catalog/schema.h"
+#include "common/config.h"
+#include "storage/table/tuple.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/**
+ * The dictionary of a dictionary-encoded table: every VARCHAR column stores a 4-byte INTEGER code in its tuples, and
+ * the string of each code is kept once in DictionaryPages fetched through the buffer pool. One dictionary is shared by
+ * all VARCHAR columns of the table, so two encoded columns holding the same string hold the same code.
+ *
+ * Codes are handed out in order and never reused or dropped, a string stays in the dictionary after its last tuple is
+ * deleted. A NULL string is stored as a NULL code.
+ */
+class TableDictionary {
+ public:
+  /** Encode the VARCHAR columns of schema, the dictionary pages are only allocated once a string is added */
+  TableDictionary(BufferPoolManager *bpm, const Schema &schema);
+
+  /** @return true if schema has a column a dictionary can encode */
+  static auto HasEncodableColumns(const Schema &schema) -> bool;
+
+  /** @return the schema the tuples are stored with, every encoded column an INTEGER */
+  auto GetStoredSchema() const -> const Schema & { return stored_schema_; }
+
+  /** @return true if the column stores codes */
+  auto IsEncoded(uint32_t col_idx) const -> bool { return encoded_[col_idx]; }
+
+  /** Replace the strings of a tuple by their codes, adding the strings not in the dictionary yet */
+  auto Encode(const Tuple &tuple) -> Tuple;
+
+  /** Replace the codes of a stored tuple by their strings, the returned tuple keeps the rid of the view */
+  auto Decode(const TupleView &view) -> Tuple;
+
+  /** @return the string of a code read from a stored tuple, a NULL VARCHAR for a NULL code */
+  auto DecodeValue(const Value &code) -> Value;
+
+  /** @return the code of a VARCHAR value, nullopt if no tuple ever stored it */
+  auto Lookup(const Value &value) -> std::optional<int32_t>;
+
+  /** @return the number of distinct strings in the dictionary */
+  auto GetNumCodes() -> size_t;
+
+ private:
+  /** Where the string of a code is stored */
+  struct Entry {
+    page_id_t page_id_;
+    uint16_t offset_;
+  };
+
+  /** @return the code of a string, appending it to the last dictionary page if it is new. Needs the write latch. */
+  auto AddString(const std::string &str) -> int32_t;
+
+  BufferPoolManager *bpm_;
+  Schema schema_;
+  Schema stored_schema_;
+  std::vector<bool> encoded_;
+
+  std::shared_mutex latch_;
+  /** the string of every code, its trailing '\0' included as in a VARCHAR value */
+  std::unordered_map<std::string, int32_t> codes_;
+  std::vector<Entry> entries_;
+  page_id_t last_page_id_{INVALID_PAGE_ID};
+};
+
+}  // namespace bustub
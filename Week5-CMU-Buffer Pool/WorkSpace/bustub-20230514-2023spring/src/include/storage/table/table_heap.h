@@ -12,9 +12,14 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
 #include <mutex>  // NOLINT
 #include <optional>
 #include <utility>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "common/config.h"
@@ -22,30 +27,63 @@
 #include "concurrency/transaction.h"
 #include "recovery/log_manager.h"
 #include "storage/page/table_page.h"
+#include "storage/table/free_space_map.h"
+#include "storage/table/table_dictionary.h"
 #include "storage/table/table_iterator.h"
 #include "storage/table/tuple.h"
+#include "storage/table/zone_map.h"
 
 namespace bustub {
 
+class PaxLayout;
+
+/** How a table heap lays tuples out in its pages: whole rows in slotted pages, or one mini-page per column */
+enum class TableLayout { Row, PAX };
+
+/** How a table heap stores its VARCHAR values: inline in the tuples, or as codes of a dictionary of the table */
+enum class TableEncoding { Plain, Dictionary };
+
+/** What a vacuum pass over a table heap reclaimed */
+struct VacuumResult {
+  size_t tuples_{0};
+  size_t bytes_{0};
+  size_t pages_emptied_{0};
+};
+
 /**
  * TableHeap represents a physical table on disk.
  * This is just a doubly-linked list of pages.
+ *
+ * Inserting threads are spread over TABLE_HEAP_INSERT_PAGES insertion pages by thread id and only latch the page they
+ * fill, so concurrent inserts do not serialize. A page that is left behind goes back to the free-space map, which
+ * hands it out again once enough of it is free; the heap-wide latch is only taken to append a page to the chain.
+ * Only the thread that clears a page from its insertion slot gives it back, so a page is never handed out twice.
+ *
+ * The pages of a PAX table are PaxPages instead of TablePages. Both start with the same header, so walking the chain
+ * reads every page as a TablePage; only reading and writing tuples depends on the layout.
+ *
+ * A dictionary-encoded table stores the tuples encoded by its TableDictionary, whatever the layout. Tuples are encoded
+ * on their way into a page and decoded on their way out, so only a scan that asks for the stored tuples sees codes.
  */
 class TableHeap {
   friend class TableIterator;
 
  public:
-  ~TableHeap() = default;
+  ~TableHeap();
 
   /**
    * Create a table heap without a transaction. (open table)
    * @param buffer_pool_manager the buffer pool manager
-   * @param first_page_id the id of the first page
+   * @param schema if not nullptr, keep a zone map over the numeric columns of this schema
+   * @param layout the page layout, a PAX table needs its schema
+   * @param encoding how VARCHAR values are stored, a dictionary-encoded table needs its schema
    */
-  explicit TableHeap(BufferPoolManager *bpm);
+  explicit TableHeap(BufferPoolManager *bpm, const Schema *schema = nullptr, TableLayout layout = TableLayout::Row,
+                     TableEncoding encoding = TableEncoding::Plain);
 
   /**
    * Insert a tuple into the table. If the tuple is too large (>= page_size), return std::nullopt.
+   * Tuples inserted concurrently may land on different pages, not necessarily the last one.
    * @param meta tuple meta
    * @param tuple tuple to insert
    * @return rid of the inserted tuple
@@ -53,6 +91,17 @@ class TableHeap {
   auto InsertTuple(const TupleMeta &meta, const Tuple &tuple, LockManager *lock_mgr = nullptr,
                    Transaction *txn = nullptr, table_oid_t oid = 0) -> std::optional<RID>;
 
+  /**
+   * Insert many tuples at once. They fill fresh pages that are linked to the end of the heap one by one, each page is
+   * written before any other thread can see it, so no page latch is taken per tuple and the heap latch only once per
+   * page. The empty page of a new table is filled first. No row locks are taken, the caller should hold an exclusive
+   * lock on the table.
+   * @param meta tuple meta of every tuple
+   * @param tuples tuples to insert
+   * @return rids of the inserted tuples, in the order of tuples
+   */
+  auto BulkInsertTuples(const TupleMeta &meta, const std::vector<Tuple> &tuples) -> std::vector<RID>;
+
   /**
    * Insert a tuple into the table. If the tuple is too large (>= page_size), return false.
    * @param meta new tuple meta
@@ -75,15 +124,57 @@ class TableHeap {
    */
   auto GetTupleMeta(RID rid) -> TupleMeta;
 
-  /** @return the iterator of this table, use this for project 3 */
+  /**
+   * @return the iterator of this table, use this for project 3. It stops at the tuples the last page had when it was
+   * made, tuples inserted later into an earlier page that still had room may or may not be seen.
+   */
   auto MakeIterator() -> TableIterator;
 
   /** @return the iterator of this table, use this for project 4 except updates */
   auto MakeEagerIterator() -> TableIterator;
 
+  /** @return the ids of the pages of this table in chain order, so that a scan can split them between threads */
+  auto GetPageIds() -> std::vector<page_id_t>;
+
+  /**
+   * Read every tuple stored in one page of this table, including deleted ones, under a single page latch.
+   * @param page_id a page of this table
+   * @return the meta and tuple of each slot, in slot order
+   */
+  auto GetPageTuples(page_id_t page_id) -> std::vector<std::pair<TupleMeta, Tuple>>;
+
+  /** @return the page layout of this table */
+  auto GetLayout() const -> TableLayout { return pax_layout_ != nullptr ? TableLayout::PAX : TableLayout::Row; }
+
+  /** @return the dictionary of the VARCHAR columns, nullptr if the table stores them inline */
+  auto GetDictionary() -> TableDictionary * { return dictionary_.get(); }
+
+  /** @return the per-page min and max of the numeric columns, nullptr if the table keeps none */
+  auto GetZoneMap() -> ZoneMap * { return zone_map_.get(); }
+
   /** @return the id of the first page of this table */
   inline auto GetFirstPageId() const -> page_id_t { return first_page_id_; }
 
+  /**
+   * Compact every page holding deleted tuples, rebuild its zone map ranges and hand the reclaimed space to the
+   * free-space map. Live tuples keep their rids; pages left empty stay in the chain and are filled again before the
+   * heap grows.
+   * The caller must make sure no running transaction can still undo a delete, e.g. by holding an exclusive table lock.
+   * @param on_reclaim called under the page latch with every deleted tuple before its data is dropped, so that index
+   * entries still pointing at it can be removed before its slot is reused
+   */
+  auto Vacuum(const std::function<void(const Tuple &tuple, RID rid)> &on_reclaim) -> VacuumResult;
+
+  /**
+   * Update a tuple in place if the new tuple fits where the old one is: a row page needs the same size, a PAX page
+   * VARCHAR values no longer than the old ones. The rid of the tuple stays the same.
+   * @param meta new tuple meta
+   * @param tuple new tuple
+   * @param rid the rid of the tuple to be updated
+   * @return false if the tuple does not fit, the old tuple is left untouched then
+   */
+  auto UpdateTupleInPlace(const TupleMeta &meta, const Tuple &tuple, RID rid) -> bool;
+
   /**
    * Update a tuple in place. SHOULD NOT BE USED UNLESS YOU WANT TO OPTIMIZE FOR PROJECT 4.
    * @param meta new tuple meta
@@ -96,8 +187,51 @@ class TableHeap {
   BufferPoolManager *bpm_;
   page_id_t first_page_id_{INVALID_PAGE_ID};
 
+  /** Allocate a page, link it at the end of the chain and track it in the free-space map as taken */
+  auto AppendPage() -> page_id_t;
+
   std::mutex latch_;
   page_id_t last_page_id_{INVALID_PAGE_ID}; /* protected by latch_ */
+
+  FreeSpaceMap free_space_map_;
+  /** the page each group of inserting threads is filling, INVALID_PAGE_ID until one is found */
+  std::array<std::atomic<page_id_t>, TABLE_HEAP_INSERT_PAGES> insert_pages_;
+
+  std::unique_ptr<ZoneMap> zone_map_;
+
+  /** the codes of the VARCHAR values of a dictionary-encoded table, nullptr for a plain table */
+  std::unique_ptr<TableDictionary> dictionary_;
+
+  /** @return the tuple as it is stored in a page: tuple itself, or its encoding written to encoded */
+  auto StoredTuple(const Tuple &tuple, Tuple *encoded) -> const Tuple &;
+
+  /** where the columns are in every page of a PAX table, nullptr for a row table */
+  std::unique_ptr<PaxLayout> pax_layout_;
+
+  /*
+   * The tuple operations on the data of one page, done by TablePage or PaxPage depending on the layout. The header
+   * (next page id, tuple counts) is read through TablePage for both.
+   */
+  auto PageInit(char *page) -> size_t;
+  auto PageGetFreeSpace(const char *page) const -> size_t;
+  auto PageGetSpaceNeeded(const Tuple &tuple) const -> size_t;
+  auto PageInsertTuple(char *page, const TupleMeta &meta, const Tuple &tuple) -> std::optional<uint16_t>;
+  /** fill an empty page with the tuples that have no rid in rids yet, as many as fit, and append their rids */
+  void PageInsertTuples(char *page, page_id_t page_id, const TupleMeta &meta, const std::vector<Tuple> &tuples,
+                        std::vector<RID> *rids);
+  auto PageGetTuple(const char *page, RID rid, const std::vector<uint32_t> *columns = nullptr) const
+      -> std::pair<TupleMeta, Tuple>;
+  /**
+   * a row page hands out a view of the page, a PAX page rebuilds the tuple into buffer and views that. A decoded tuple
+   * of a dictionary-encoded table is moved into buffer as well, unless decode is false and the view shows the codes.
+   */
+  auto PageGetTupleView(const char *page, RID rid, const std::vector<uint32_t> *columns, std::vector<char> *buffer,
+                        bool decode = true) const -> std::pair<TupleMeta, TupleView>;
+  auto PageGetTupleMeta(const char *page, RID rid) const -> TupleMeta;
+  void PageUpdateTupleMeta(char *page, const TupleMeta &meta, RID rid);
+  auto PageCanUpdateInPlace(const char *page, const Tuple &tuple, RID rid) const -> bool;
+  void PageUpdateTupleInPlace(char *page, const TupleMeta &meta, const Tuple &tuple, RID rid);
+  auto PageCompact(char *page) -> size_t;
 };
 
 }  // namespace bustub
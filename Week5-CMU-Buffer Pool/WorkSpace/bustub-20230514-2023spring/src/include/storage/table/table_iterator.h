@@ -15,10 +15,13 @@
 #include <cassert>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "common/macros.h"
 #include "common/rid.h"
 #include "concurrency/transaction.h"
+#include "storage/page/page.h"
+#include "storage/page/page_guard.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
@@ -26,7 +29,9 @@ namespace bustub {
 class TableHeap;
 
 /**
- * TableIterator enables the sequential scan of a TableHeap.
+ * TableIterator enables the sequential scan of a TableHeap. The page under the cursor stays pinned until the iterator
+ * leaves it, so stepping through the tuples of a page only takes the page latch and never goes through the buffer
+ * pool. No latch is held between calls, the caller may modify the table while scanning it.
  */
 class TableIterator {
   friend class Cursor;
@@ -35,11 +40,38 @@ class TableIterator {
   DISALLOW_COPY(TableIterator);
 
   TableIterator(TableHeap *table_heap, RID rid, RID stop_at_rid);
-  TableIterator(TableIterator &&) = default;
-
-  ~TableIterator() = default;
-
-  auto GetTuple() -> std::pair<TupleMeta, Tuple>;
+  TableIterator(TableIterator &&that) noexcept;
+
+  ~TableIterator();
+
+  /**
+   * @param columns if not nullptr, only these columns are needed. A PAX table reads just their column mini-pages and
+   * leaves the other columns NULL, a row table always reads the whole tuple.
+   */
+  auto GetTuple(const std::vector<uint32_t> *columns = nullptr) -> std::pair<TupleMeta, Tuple>;
+
+  /**
+   * Read the current tuple without copying it into a Tuple. The view points into the pinned page, or for a PAX table
+   * into a buffer of the iterator rebuilt for every tuple, so it is only valid while guard latches the page and the
+   * iterator does not move. Call TupleView::Materialize to keep the tuple.
+   * @param guard the latch of the page under the cursor, taken with LatchPage
+   * @param columns the columns needed, as for GetTuple
+   */
+  auto GetTupleView(ReadPageGuard &guard, const std::vector<uint32_t> *columns = nullptr)
+      -> std::pair<TupleMeta, TupleView>;
+
+  /**
+   * Same as GetTupleView, but a dictionary-encoded table leaves the tuple encoded: the view holds the codes of the
+   * VARCHAR columns and is read with the stored schema of the dictionary. Other tables read as with GetTupleView.
+   */
+  auto GetStoredTupleView(ReadPageGuard &guard, const std::vector<uint32_t> *columns = nullptr)
+      -> std::pair<TupleMeta, TupleView>;
+
+  /** Read latch the pinned page, the guard only releases the latch and leaves the pin alone */
+  auto LatchPage() -> ReadPageGuard;
+
+  /** @return the meta of the current tuple, cheaper than GetTuple when the data is not needed */
+  auto GetTupleMeta() -> TupleMeta;
 
   auto GetRID() -> RID;
 
@@ -47,7 +79,16 @@ class TableIterator {
 
   auto operator++() -> TableIterator &;
 
+  /** Skip the rest of the current page and move to the first tuple of a later page, or to the end */
+  void NextPage();
+
  private:
+  /** Move rid_ forward to the first tuple at or after it, skipping pages without tuples, or to the end */
+  void SkipToTuple();
+
+  /** Unpin the current page and pin page_id instead, INVALID_PAGE_ID only unpins */
+  void MoveToPage(page_id_t page_id);
+
   TableHeap *table_heap_;
   RID rid_;
 
@@ -55,6 +96,12 @@ class TableIterator {
   // Otherwise we will have dead loops when updating while scanning. (In project 4, update should be implemented as
   // deletion + insertion.)
   RID stop_at_rid_;
+
+  // rid_所在的页,一直pin着直到走到下一页,读的时候只拿页的读锁
+  Page *page_{nullptr};
+
+  // PAX表的行要从各列的小页拼出来,GetTupleView拼在这里,不用每行分配一次
+  std::vector<char> buffer_;
 };
 
 }  // namespace bustub
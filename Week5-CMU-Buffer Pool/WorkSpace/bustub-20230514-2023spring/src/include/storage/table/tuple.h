@@ -16,6 +16,7 @@
 #include <vector>
 
 #include "catalog/schema.h"
+#include "common/config.h"
 #include "common/rid.h"
 #include "type/value.h"
 
@@ -42,16 +43,77 @@ struct TupleMeta {
 
 static_assert(sizeof(TupleMeta) == TUPLE_META_SIZE);
 
+/** The offset and the length of a VARCHAR value in a tuple. A tuple has to fit in a page, so two bytes are enough. */
+using tuple_offset_t = uint16_t;
+
+static_assert(BUSTUB_PAGE_SIZE <= UINT16_MAX);
+
+class Tuple;
+
+/**
+ * A read-only view of tuple data owned by someone else: a pinned page, a buffer of an executor or a Tuple. Reading a
+ * tuple through a view copies nothing, and a VARCHAR value read from it points into the viewed bytes as well. The
+ * view is only valid while the bytes it points to are, an operator that keeps the tuple calls Materialize.
+ */
+class TupleView {
+  friend class Tuple;
+
+ public:
+  TupleView() = default;
+
+  TupleView(const char *data, uint32_t size, RID rid) : data_(data), size_(size), rid_(rid) {}
+
+  // view over a tuple the caller owns
+  explicit TupleView(const Tuple &tuple);
+
+  inline auto GetRid() const -> RID { return rid_; }
+
+  inline auto GetData() const -> const char * { return data_; }
+
+  inline auto GetLength() const -> uint32_t { return size_; }
+
+  // Get the value of a specified column, a VARCHAR value does not own its data
+  auto GetValue(const Schema *schema, uint32_t column_idx) const -> Value;
+
+  // Same as GetValue, but a VARCHAR value owns a copy of its data
+  auto CopyValue(const Schema *schema, uint32_t column_idx) const -> Value;
+
+  // Is the column value null? Only tests a bit of the null bitmap.
+  inline auto IsNull(const Schema *schema, uint32_t column_idx) const -> bool {
+    auto bitmap = data_ + schema->GetLength();
+    return ((bitmap[column_idx / 8] >> (column_idx % 8)) & 1) != 0;
+  }
+
+  // Copy the viewed bytes into a tuple of its own
+  auto Materialize() const -> Tuple;
+
+ private:
+  // Get the starting storage address of specific column
+  auto GetDataPtr(const Schema *schema, uint32_t column_idx) const -> const char *;
+
+  // Read a column that is not NULL
+  auto ReadValue(const Schema *schema, uint32_t column_idx, bool copy_varlen) const -> Value;
+
+  const char *data_{nullptr};
+  uint32_t size_{0};
+  RID rid_{};
+};
+
 /**
  * Tuple format:
- * ---------------------------------------------------------------------
- * | FIXED-SIZE or VARIED-SIZED OFFSET | PAYLOAD OF VARIED-SIZED FIELD |
- * ---------------------------------------------------------------------
+ * ---------------------------------------------------------------------------------------------------
+ * | FIXED-SIZE or VARIED-SIZED OFFSET (2) | NULL BITMAP | PAYLOAD OF VARIED-SIZED FIELD (2 + length) |
+ * ---------------------------------------------------------------------------------------------------
+ *
+ * Bit i of the null bitmap is set if column i is NULL. A NULL fixed-size column keeps its slot so that every column
+ * stays at the offset the schema gives it, a NULL VARCHAR takes no payload.
  */
 class Tuple {
   friend class TablePage;
+  friend class PaxPage;
   friend class TableHeap;
   friend class TableIterator;
+  friend class TupleView;
 
  public:
   // Default constructor (to create a dummy tuple)
@@ -83,6 +145,9 @@ class Tuple {
   // return RID of current tuple
   inline auto GetRid() const -> RID { return rid_; }
 
+  // set RID of a tuple that was not read from the table heap
+  inline void SetRid(RID rid) { rid_ = rid; }
+
   // Get the address of this tuple in the table's backing store
   inline auto GetData() const -> const char * { return data_.data(); }
 
@@ -94,20 +159,20 @@ class Tuple {
   auto GetValue(const Schema *schema, uint32_t column_idx) const -> Value;
 
   // Generates a key tuple given schemas and attributes
-  auto KeyFromTuple(const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs) -> Tuple;
+  auto KeyFromTuple(const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs) const
+      -> Tuple;
 
-  // Is the column value null ?
+  // Is the column value null ? Only tests a bit of the null bitmap.
   inline auto IsNull(const Schema *schema, uint32_t column_idx) const -> bool {
-    Value value = GetValue(schema, column_idx);
-    return value.IsNull();
+    return TupleView(*this).IsNull(schema, column_idx);
   }
 
+  // the size of the null bitmap of a tuple with this schema
+  static auto GetNullBitmapSize(const Schema *schema) -> uint32_t { return (schema->GetColumnCount() + 7) / 8; }
+
   auto ToString(const Schema *schema) const -> std::string;
 
  private:
-  // Get the starting storage address of specific column
-  auto GetDataPtr(const Schema *schema, uint32_t column_idx) const -> const char *;
-
   RID rid_{};  // if pointing to the table heap, the rid is valid
   std::vector<char> data_;
 };
@@ -0,0 +1,77 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// zone_map.h
+//
+// Identification: src/include/storage/table/zone_map.h
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "common/config.h"
+#include "storage/table/tuple.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/**
+ * The zone map of a table heap: the min and max of every numeric column in every page, so that a scan can skip pages
+ * whose values cannot satisfy a range predicate.
+ *
+ * A range only widens when tuples are inserted or updated in place, deleted tuples stay covered until the page is
+ * vacuumed and its ranges are rebuilt. NULLs are left out, a comparison with NULL is never true.
+ *
+ * The ranges of a page are guarded by the latch of the page itself: Add and Reset are called with the page write
+ * latched, MayContain with the page read latched. Inserts into different pages therefore never wait for each other.
+ */
+class ZoneMap {
+ public:
+  /** Track the numeric columns of schema, tables without any don't need a zone map */
+  explicit ZoneMap(const Schema &schema);
+
+  /** @return true if schema has a column a zone map can track */
+  static auto HasTrackedColumns(const Schema &schema) -> bool;
+
+  /** Widen the ranges of a page to cover a tuple stored in it, the caller holds the write latch of the page */
+  void Add(page_id_t page_id, const Tuple &tuple);
+
+  /** Forget the ranges of a page, the tuples still in it are added back one by one. Needs the page write latch. */
+  void Reset(page_id_t page_id);
+
+  /**
+   * @return false if no value of the column in the page can lie between low and high, true if it may or the column
+   * is not tracked. Either bound may be nullptr for an open end. The caller holds the read latch of the page.
+   */
+  auto MayContain(page_id_t page_id, uint32_t col_idx, const Value *low, bool low_inclusive, const Value *high,
+                  bool high_inclusive) -> bool;
+
+ private:
+  struct ColumnRange {
+    bool empty_{true};
+    Value min_;
+    Value max_;
+  };
+
+  static auto IsTracked(TypeId type) -> bool;
+
+  /** @return the ranges of a page, created empty the first time the page is seen */
+  auto GetPageRanges(page_id_t page_id) -> std::vector<ColumnRange> &;
+
+  Schema schema_;
+  /** the tracked columns, and for every column its index into the ranges of a page or -1 */
+  std::vector<uint32_t> columns_;
+  std::vector<int> range_of_column_;
+
+  /** only guards the map itself, an entry is never moved or resized once created */
+  std::shared_mutex latch_;
+  std::unordered_map<page_id_t, std::vector<ColumnRange>> ranges_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <unordered_set>
+#include <vector>
+
+#include "catalog/catalog.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/plans/abstract_plan.h"
+#include "execution/plans/aggregation_plan.h"
+#include "execution/plans/filter_plan.h"
+#include "execution/plans/index_scan_plan.h"
+#include "execution/plans/projection_plan.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "execution/plans/sort_plan.h"
+#include "execution/plans/topn_plan.h"
+#include "optimizer/optimizer.h"
+
+namespace bustub {
+
+namespace {
+
+/** 收集表达式里读到的子结点输出的列 */
+void CollectColumns(const AbstractExpressionRef &expr, std::unordered_set<uint32_t> &columns) {
+  if (expr == nullptr) {
+    return;
+  }
+  if (const auto *column_expr = dynamic_cast<const ColumnValueExpression *>(expr.get()); column_expr != nullptr) {
+    columns.insert(column_expr->GetColIdx());
+    return;
+  }
+  for (const auto &child : expr->GetChildren()) {
+    CollectColumns(child, columns);
+  }
+}
+
+/**
+ * needed是父结点会读到的plan输出的列,nullopt表示不知道,只能认为所有列都会被读到。
+ * Projection和Aggregation只读它们表达式里的列;Sort/TopN/Limit/Filter原样输出子结点的tuple,
+ * 所以要把父结点需要的列和自己表达式里的列一起往下传。
+ * PAX表上的SeqScan也用同样的信息,只读这些列的小页。
+ */
+auto RewriteIndexOnlyScan(const Catalog &catalog, const AbstractPlanNodeRef &plan,
+                          std::optional<std::unordered_set<uint32_t>> needed) -> AbstractPlanNodeRef {
+  if (plan->GetType() == PlanType::IndexScan) {
+    const auto &index_scan = dynamic_cast<const IndexScanPlanNode &>(*plan);
+    if (!needed.has_value()) {
+      return plan;
+    }
+    CollectColumns(index_scan.filter_predicate_, *needed);
+    const auto &entry_attrs = catalog.GetIndex(index_scan.index_oid_)->index_->GetEntryAttrs();
+    std::unordered_set<uint32_t> covered(entry_attrs.begin(), entry_attrs.end());
+    for (auto col_idx : *needed) {
+      if (covered.count(col_idx) == 0) {
+        return plan;
+      }
+    }
+    auto index_only_scan = std::make_shared<IndexScanPlanNode>(index_scan);
+    index_only_scan->index_only_ = true;
+    return index_only_scan;
+  }
+  if (plan->GetType() == PlanType::SeqScan) {
+    const auto &seq_scan = dynamic_cast<const SeqScanPlanNode &>(*plan);
+    const auto *table_info = catalog.GetTable(seq_scan.table_oid_);
+    if (!needed.has_value() || table_info == Catalog::NULL_TABLE_INFO || table_info->table_ == nullptr ||
+        table_info->table_->GetLayout() != TableLayout::PAX) {
+      return plan;
+    }
+    CollectColumns(seq_scan.filter_predicate_, *needed);
+    std::vector<uint32_t> columns(needed->begin(), needed->end());
+    std::sort(columns.begin(), columns.end());
+    auto pruned_scan = std::make_shared<SeqScanPlanNode>(seq_scan);
+    pruned_scan->read_columns_ = std::move(columns);
+    return pruned_scan;
+  }
+
+  std::optional<std::unordered_set<uint32_t>> child_needed = std::nullopt;
+  switch (plan->GetType()) {
+    case PlanType::Projection: {
+      child_needed.emplace();
+      for (const auto &expr : dynamic_cast<const ProjectionPlanNode &>(*plan).GetExpressions()) {
+        CollectColumns(expr, *child_needed);
+      }
+      break;
+    }
+    case PlanType::Aggregation: {
+      const auto &agg = dynamic_cast<const AggregationPlanNode &>(*plan);
+      child_needed.emplace();
+      for (const auto &expr : agg.GetGroupBys()) {
+        CollectColumns(expr, *child_needed);
+      }
+      for (const auto &expr : agg.GetAggregates()) {
+        CollectColumns(expr, *child_needed);
+      }
+      break;
+    }
+    case PlanType::Sort:
+    case PlanType::TopN: {
+      child_needed = needed;
+      if (child_needed.has_value()) {
+        const auto &order_bys = plan->GetType() == PlanType::Sort
+                                    ? dynamic_cast<const SortPlanNode &>(*plan).GetOrderBy()
+                                    : dynamic_cast<const TopNPlanNode &>(*plan).GetOrderBy();
+        for (const auto &[order_type, expr] : order_bys) {
+          CollectColumns(expr, *child_needed);
+        }
+      }
+      break;
+    }
+    case PlanType::Filter: {
+      child_needed = needed;
+      if (child_needed.has_value()) {
+        CollectColumns(dynamic_cast<const FilterPlanNode &>(*plan).GetPredicate(), *child_needed);
+      }
+      break;
+    }
+    case PlanType::Limit:
+      child_needed = needed;
+      break;
+    default:
+      // join等其他结点:不知道它们会读哪些列,保守处理
+      break;
+  }
+
+  std::vector<AbstractPlanNodeRef> children;
+  for (const auto &child : plan->GetChildren()) {
+    children.emplace_back(RewriteIndexOnlyScan(catalog, child, child_needed));
+  }
+  return plan->CloneWithChildren(std::move(children));
+}
+
+}  // namespace
+
+auto Optimizer::OptimizeIndexOnlyScan(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef {
+  // 根结点的输出全部都要返回给用户
+  return RewriteIndexOnlyScan(catalog_, plan, std::nullopt);
+}
+
+}  // namespace bustub
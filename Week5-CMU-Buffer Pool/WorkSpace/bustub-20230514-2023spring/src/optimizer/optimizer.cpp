@@ -1,5 +1,7 @@
 #include "optimizer/optimizer.h"
+#include <algorithm>
 #include <optional>
+#include "catalog/catalog.h"
 #include "common/util/string_util.h"
 #include "execution/plans/abstract_plan.h"
 
@@ -20,6 +22,19 @@ auto Optimizer::Optimize(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef
 }
 
 auto Optimizer::EstimatedCardinality(const std::string &table_name) -> std::optional<size_t> {
+  // 表上任何一个带统计信息的索引都能给出行数;索引可能不收录某些行,取最大的那个
+  std::optional<size_t> indexed_rows;
+  if (catalog_.GetTable(table_name) != Catalog::NULL_TABLE_INFO) {
+    for (const auto *index_info : catalog_.GetTableIndexes(table_name)) {
+      if (auto stats = index_info->index_->GetStatistics(false); stats.has_value()) {
+        indexed_rows = std::max(indexed_rows.value_or(0), stats->num_entries_);
+      }
+    }
+  }
+  if (indexed_rows.has_value()) {
+    return indexed_rows;
+  }
+  // 没有索引统计信息的表(比如mock表)只能按表名的后缀猜
   if (StringUtil::EndsWith(table_name, "_1m")) {
     return std::make_optional(1000000);
   }
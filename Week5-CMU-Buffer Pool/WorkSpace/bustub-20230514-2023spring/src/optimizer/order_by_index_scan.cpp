@@ -33,9 +33,10 @@ auto Optimizer::OptimizeOrderByAsIndexScan(const AbstractPlanNodeRef &plan) -> A
     const auto &order_bys = sort_plan.GetOrderBy();
 
     std::vector<uint32_t> order_by_column_ids;
+    // All order types are asc (or default), or all of them are desc, which is a reverse index scan
+    bool reverse = !order_bys.empty() && order_bys[0].first == OrderByType::DESC;
     for (const auto &[order_type, expr] : order_bys) {
-      // Order type is asc or default
-      if (!(order_type == OrderByType::ASC || order_type == OrderByType::DEFAULT)) {
+      if (order_type == OrderByType::INVALID || reverse != (order_type == OrderByType::DESC)) {
         return optimized_plan;
       }
 
@@ -58,6 +59,10 @@ auto Optimizer::OptimizeOrderByAsIndexScan(const AbstractPlanNodeRef &plan) -> A
       const auto indices = catalog_.GetTableIndexes(table_info->name_);
 
       for (const auto *index : indices) {
+        if (index->index_type_ == IndexType::HashTableIndex || index->index_type_ == IndexType::ARTIndex) {
+          // 哈希索引的项是无序的,ART只支持前缀查找
+          continue;
+        }
         const auto &columns = index->key_schema_.GetColumns();
         // check index key schema == order by columns
         bool valid = true;
@@ -69,7 +74,8 @@ auto Optimizer::OptimizeOrderByAsIndexScan(const AbstractPlanNodeRef &plan) -> A
             }
           }
           if (valid) {
-            return std::make_shared<IndexScanPlanNode>(optimized_plan->output_schema_, index->index_oid_);
+            return std::make_shared<IndexScanPlanNode>(optimized_plan->output_schema_, index->index_oid_, nullptr,
+                                                       std::vector<Value>{}, true, std::vector<Value>{}, true, reverse);
           }
         }
       }
@@ -0,0 +1,141 @@
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "catalog/catalog.h"
+#include "execution/column_bound.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/plans/abstract_plan.h"
+#include "execution/plans/index_scan_plan.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "optimizer/optimizer.h"
+
+namespace bustub {
+
+namespace {
+
+auto FindBound(const std::vector<ColumnBound> &bounds, uint32_t col_idx, const Column &column,
+               std::initializer_list<ComparisonType> comp_types) -> const ColumnBound * {
+  for (const auto &bound : bounds) {
+    if (bound.col_idx_ != col_idx || bound.value_.IsNull() || bound.value_.GetTypeId() != column.GetType()) {
+      continue;
+    }
+    // 比声明长度还长的VARCHAR常量放不进索引键里,不能拿来当边界
+    if (!column.IsInlined() && bound.value_.GetLength() > column.GetLength() + 1) {
+      continue;
+    }
+    for (auto comp_type : comp_types) {
+      if (bound.comp_type_ == comp_type) {
+        return &bound;
+      }
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+auto Optimizer::OptimizeSeqScanAsIndexScan(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef {
+  if (plan->GetType() == PlanType::Delete || plan->GetType() == PlanType::Update) {
+    // 删除和更新会修改正在扫描的索引,而且行锁是在SeqScan里加的,这里保持顺序扫描
+    return plan;
+  }
+  std::vector<AbstractPlanNodeRef> children;
+  for (const auto &child : plan->GetChildren()) {
+    children.emplace_back(OptimizeSeqScanAsIndexScan(child));
+  }
+  auto optimized_plan = plan->CloneWithChildren(std::move(children));
+
+  if (optimized_plan->GetType() != PlanType::SeqScan) {
+    return optimized_plan;
+  }
+  const auto &seq_scan = dynamic_cast<const SeqScanPlanNode &>(*optimized_plan);
+  if (seq_scan.filter_predicate_ == nullptr) {
+    return optimized_plan;
+  }
+  std::vector<ColumnBound> bounds;
+  CollectColumnBounds(seq_scan.filter_predicate_, bounds);
+  if (bounds.empty()) {
+    return optimized_plan;
+  }
+
+  const auto *table_info = catalog_.GetTable(seq_scan.GetTableOid());
+  std::shared_ptr<IndexScanPlanNode> best_plan = nullptr;
+  size_t best_matched = 0;
+  int best_rank = 0;
+  std::optional<double> best_estimate;
+  for (const auto *index : catalog_.GetTableIndexes(table_info->name_)) {
+    // 键的前缀能用等值条件匹配多少列就匹配多少列,第一个不是等值条件的列最多再贡献一个范围
+    const auto &key_attrs = index->index_->GetKeyAttrs();
+    std::vector<Value> low_key;
+    std::vector<Value> high_key;
+    bool low_inclusive = true;
+    bool high_inclusive = true;
+    size_t matched = 0;
+    // 哈希索引只能做完整键的等值查找,任何一列没有等值条件都用不上;ART只能做键前缀的等值查找,不能带范围
+    bool is_hash = index->index_type_ == IndexType::HashTableIndex;
+    bool is_art = index->index_type_ == IndexType::ARTIndex;
+    for (auto col_idx : key_attrs) {
+      const auto &column = table_info->schema_.GetColumn(col_idx);
+      if (const auto *eq = FindBound(bounds, col_idx, column, {ComparisonType::Equal}); eq != nullptr) {
+        low_key.push_back(eq->value_);
+        high_key.push_back(eq->value_);
+        matched++;
+        continue;
+      }
+      if (is_hash) {
+        matched = 0;
+        break;
+      }
+      if (is_art) {
+        break;
+      }
+      const auto *lower =
+          FindBound(bounds, col_idx, column, {ComparisonType::GreaterThan, ComparisonType::GreaterThanOrEqual});
+      const auto *upper = FindBound(bounds, col_idx, column, {ComparisonType::LessThan, ComparisonType::LessThanOrEqual});
+      if (lower != nullptr) {
+        low_key.push_back(lower->value_);
+        low_inclusive = lower->comp_type_ == ComparisonType::GreaterThanOrEqual;
+      }
+      if (upper != nullptr) {
+        high_key.push_back(upper->value_);
+        high_inclusive = upper->comp_type_ == ComparisonType::LessThanOrEqual;
+      }
+      if (lower != nullptr || upper != nullptr) {
+        matched++;
+      }
+      break;
+    }
+    if (matched == 0) {
+      continue;
+    }
+    // 两个候选都有统计信息时选估计返回行数少的;否则匹配的列数多的优先,
+    // 匹配的列数相同时优先用不经过缓冲池的ART,其次是一次查找就能定位到桶的哈希索引
+    int rank = is_art ? 2 : is_hash ? 1 : 0;
+    std::optional<double> estimate;
+    if (auto stats = index->index_->GetStatistics(false); stats.has_value()) {
+      estimate = stats->EstimateRows(low_key, low_inclusive, high_key, high_inclusive);
+    }
+    bool better;
+    if (best_plan != nullptr && estimate.has_value() && best_estimate.has_value()) {
+      better = *estimate < *best_estimate;
+    } else {
+      better = matched > best_matched || (matched == best_matched && rank > best_rank);
+    }
+    if (better) {
+      best_rank = rank;
+      best_matched = matched;
+      best_estimate = estimate;
+      // 范围只是为了少访问叶子,完整的谓词依然作为filter保留,保证结果正确
+      best_plan = std::make_shared<IndexScanPlanNode>(seq_scan.output_schema_, index->index_oid_,
+                                                      seq_scan.filter_predicate_, std::move(low_key), low_inclusive,
+                                                      std::move(high_key), high_inclusive);
+    }
+  }
+  if (best_plan != nullptr) {
+    return best_plan;
+  }
+  return optimized_plan;
+}
+
+}  // namespace bustub
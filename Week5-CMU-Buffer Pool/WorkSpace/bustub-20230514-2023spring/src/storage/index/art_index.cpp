@@ -0,0 +1,529 @@
+#include <algorithm>
+#include <cstring>
+#include <mutex>  // NOLINT
+#include <type_traits>
+
+#include "storage/index/art_index.h"
+
+namespace bustub {
+
+enum class ArtNodeType : uint8_t { LEAF, NODE4, NODE16, NODE48, NODE256 };
+
+struct ArtNode {
+  explicit ArtNode(ArtNodeType type) : type_(type) {}
+  virtual ~ArtNode() = default;
+  ArtNodeType type_;
+};
+
+/** 叶子存完整的键,所以内部结点的前缀只是为了少走几层,匹配到叶子时再整个比一遍 */
+struct ArtLeaf : public ArtNode {
+  explicit ArtLeaf(std::vector<uint8_t> key) : ArtNode(ArtNodeType::LEAF), key_(std::move(key)) {}
+  std::vector<uint8_t> key_;
+  // 非唯一索引同一个键有多个RID,每个RID带着自己的索引项(键列加include列)
+  std::vector<std::pair<RID, Tuple>> entries_;
+};
+
+struct ArtInnerNode : public ArtNode {
+  using ArtNode::ArtNode;
+  // 压缩掉的单孩子路径上的字节
+  std::vector<uint8_t> prefix_;
+  uint16_t count_{0};
+};
+
+/** Node4和Node16: 键字节有序存放,孩子和键一一对应 */
+template <size_t Capacity, ArtNodeType Type>
+struct ArtSortedNode : public ArtInnerNode {
+  ArtSortedNode() : ArtInnerNode(Type) {}
+  uint8_t keys_[Capacity]{};
+  std::unique_ptr<ArtNode> children_[Capacity];
+};
+
+using ArtNode4 = ArtSortedNode<4, ArtNodeType::NODE4>;
+using ArtNode16 = ArtSortedNode<16, ArtNodeType::NODE16>;
+
+/** Node48: 按键字节索引的256个槽位,存孩子在children_里的下标加一,0表示没有孩子 */
+struct ArtNode48 : public ArtInnerNode {
+  ArtNode48() : ArtInnerNode(ArtNodeType::NODE48) {}
+  uint8_t child_index_[256]{};
+  std::unique_ptr<ArtNode> children_[48];
+};
+
+/** Node256: 直接按键字节寻址 */
+struct ArtNode256 : public ArtInnerNode {
+  ArtNode256() : ArtInnerNode(ArtNodeType::NODE256) {}
+  std::unique_ptr<ArtNode> children_[256];
+};
+
+namespace {
+
+auto FindChild(ArtInnerNode *node, uint8_t byte) -> std::unique_ptr<ArtNode> * {
+  switch (node->type_) {
+    case ArtNodeType::NODE4: {
+      auto *n = static_cast<ArtNode4 *>(node);
+      for (uint16_t i = 0; i < n->count_; i++) {
+        if (n->keys_[i] == byte) {
+          return &n->children_[i];
+        }
+      }
+      return nullptr;
+    }
+    case ArtNodeType::NODE16: {
+      auto *n = static_cast<ArtNode16 *>(node);
+      auto *it = std::lower_bound(n->keys_, n->keys_ + n->count_, byte);
+      if (it != n->keys_ + n->count_ && *it == byte) {
+        return &n->children_[it - n->keys_];
+      }
+      return nullptr;
+    }
+    case ArtNodeType::NODE48: {
+      auto *n = static_cast<ArtNode48 *>(node);
+      return n->child_index_[byte] == 0 ? nullptr : &n->children_[n->child_index_[byte] - 1];
+    }
+    case ArtNodeType::NODE256: {
+      auto *n = static_cast<ArtNode256 *>(node);
+      return n->children_[byte] == nullptr ? nullptr : &n->children_[byte];
+    }
+    default:
+      return nullptr;
+  }
+}
+
+/** Call f(byte, child) for every child in byte order */
+template <typename F>
+void ForEachChild(ArtInnerNode *node, F &&f) {
+  switch (node->type_) {
+    case ArtNodeType::NODE4: {
+      auto *n = static_cast<ArtNode4 *>(node);
+      for (uint16_t i = 0; i < n->count_; i++) {
+        f(n->keys_[i], n->children_[i]);
+      }
+      break;
+    }
+    case ArtNodeType::NODE16: {
+      auto *n = static_cast<ArtNode16 *>(node);
+      for (uint16_t i = 0; i < n->count_; i++) {
+        f(n->keys_[i], n->children_[i]);
+      }
+      break;
+    }
+    case ArtNodeType::NODE48: {
+      auto *n = static_cast<ArtNode48 *>(node);
+      for (int byte = 0; byte < 256; byte++) {
+        if (n->child_index_[byte] != 0) {
+          f(static_cast<uint8_t>(byte), n->children_[n->child_index_[byte] - 1]);
+        }
+      }
+      break;
+    }
+    case ArtNodeType::NODE256: {
+      auto *n = static_cast<ArtNode256 *>(node);
+      for (int byte = 0; byte < 256; byte++) {
+        if (n->children_[byte] != nullptr) {
+          f(static_cast<uint8_t>(byte), n->children_[byte]);
+        }
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+template <typename From, typename To>
+auto MoveChildren(std::unique_ptr<ArtNode> &ref) -> To * {
+  auto *from = static_cast<From *>(ref.get());
+  auto to = std::make_unique<To>();
+  to->prefix_ = std::move(from->prefix_);
+  ForEachChild(from, [&](uint8_t byte, std::unique_ptr<ArtNode> &child) {
+    if constexpr (std::is_same_v<To, ArtNode48>) {
+      to->children_[to->count_] = std::move(child);
+      to->child_index_[byte] = ++to->count_;
+    } else if constexpr (std::is_same_v<To, ArtNode256>) {
+      to->children_[byte] = std::move(child);
+      to->count_++;
+    } else {
+      // 按字节顺序遍历,直接追加就是有序的
+      to->keys_[to->count_] = byte;
+      to->children_[to->count_++] = std::move(child);
+    }
+  });
+  auto *result = to.get();
+  ref = std::move(to);
+  return result;
+}
+
+template <typename Node>
+void InsertSorted(Node *n, uint8_t byte, std::unique_ptr<ArtNode> child) {
+  uint16_t pos = std::lower_bound(n->keys_, n->keys_ + n->count_, byte) - n->keys_;
+  for (uint16_t i = n->count_; i > pos; i--) {
+    n->keys_[i] = n->keys_[i - 1];
+    n->children_[i] = std::move(n->children_[i - 1]);
+  }
+  n->keys_[pos] = byte;
+  n->children_[pos] = std::move(child);
+  n->count_++;
+}
+
+/** Add a child under byte, growing the node into the next larger type if it is full */
+void AddChild(std::unique_ptr<ArtNode> &ref, uint8_t byte, std::unique_ptr<ArtNode> child) {
+  switch (ref->type_) {
+    case ArtNodeType::NODE4: {
+      auto *n = static_cast<ArtNode4 *>(ref.get());
+      if (n->count_ < 4) {
+        InsertSorted(n, byte, std::move(child));
+        return;
+      }
+      InsertSorted(MoveChildren<ArtNode4, ArtNode16>(ref), byte, std::move(child));
+      return;
+    }
+    case ArtNodeType::NODE16: {
+      auto *n = static_cast<ArtNode16 *>(ref.get());
+      if (n->count_ < 16) {
+        InsertSorted(n, byte, std::move(child));
+        return;
+      }
+      MoveChildren<ArtNode16, ArtNode48>(ref);
+      AddChild(ref, byte, std::move(child));
+      return;
+    }
+    case ArtNodeType::NODE48: {
+      auto *n = static_cast<ArtNode48 *>(ref.get());
+      if (n->count_ < 48) {
+        uint8_t slot = 0;
+        while (n->children_[slot] != nullptr) {
+          slot++;
+        }
+        n->children_[slot] = std::move(child);
+        n->child_index_[byte] = slot + 1;
+        n->count_++;
+        return;
+      }
+      MoveChildren<ArtNode48, ArtNode256>(ref);
+      AddChild(ref, byte, std::move(child));
+      return;
+    }
+    case ArtNodeType::NODE256: {
+      auto *n = static_cast<ArtNode256 *>(ref.get());
+      n->children_[byte] = std::move(child);
+      n->count_++;
+      return;
+    }
+    default:
+      return;
+  }
+}
+
+/** Remove the child under byte, then shrink the node, or replace a Node4 left with one child by that child */
+void RemoveChild(std::unique_ptr<ArtNode> &ref, uint8_t byte) {
+  auto *inner = static_cast<ArtInnerNode *>(ref.get());
+  switch (inner->type_) {
+    case ArtNodeType::NODE4:
+    case ArtNodeType::NODE16: {
+      // Node4和Node16只差容量,删掉一个槽位后把后面的往前挪
+      uint8_t *keys = inner->type_ == ArtNodeType::NODE4 ? static_cast<ArtNode4 *>(inner)->keys_
+                                                         : static_cast<ArtNode16 *>(inner)->keys_;
+      std::unique_ptr<ArtNode> *children = inner->type_ == ArtNodeType::NODE4
+                                               ? static_cast<ArtNode4 *>(inner)->children_
+                                               : static_cast<ArtNode16 *>(inner)->children_;
+      uint16_t pos = std::find(keys, keys + inner->count_, byte) - keys;
+      for (uint16_t i = pos; i + 1 < inner->count_; i++) {
+        keys[i] = keys[i + 1];
+        children[i] = std::move(children[i + 1]);
+      }
+      children[--inner->count_].reset();
+      break;
+    }
+    case ArtNodeType::NODE48: {
+      auto *n = static_cast<ArtNode48 *>(inner);
+      n->children_[n->child_index_[byte] - 1].reset();
+      n->child_index_[byte] = 0;
+      n->count_--;
+      break;
+    }
+    case ArtNodeType::NODE256: {
+      static_cast<ArtNode256 *>(inner)->children_[byte].reset();
+      inner->count_--;
+      break;
+    }
+    default:
+      return;
+  }
+
+  // 缩小的阈值比放大的低一些,避免在边界上反复增删时来回转换
+  if (inner->type_ == ArtNodeType::NODE256 && inner->count_ <= 37) {
+    MoveChildren<ArtNode256, ArtNode48>(ref);
+  } else if (inner->type_ == ArtNodeType::NODE48 && inner->count_ <= 12) {
+    MoveChildren<ArtNode48, ArtNode16>(ref);
+  } else if (inner->type_ == ArtNodeType::NODE16 && inner->count_ <= 3) {
+    MoveChildren<ArtNode16, ArtNode4>(ref);
+  } else if (inner->type_ == ArtNodeType::NODE4 && inner->count_ == 1) {
+    // 只剩一个孩子,把本结点的前缀和孩子的键字节并进孩子的前缀里,路径压缩
+    auto *n = static_cast<ArtNode4 *>(inner);
+    auto child = std::move(n->children_[0]);
+    if (child->type_ != ArtNodeType::LEAF) {
+      auto *child_inner = static_cast<ArtInnerNode *>(child.get());
+      std::vector<uint8_t> prefix = std::move(n->prefix_);
+      prefix.push_back(n->keys_[0]);
+      prefix.insert(prefix.end(), child_inner->prefix_.begin(), child_inner->prefix_.end());
+      child_inner->prefix_ = std::move(prefix);
+    }
+    ref = std::move(child);
+  }
+}
+
+auto MakeLeaf(const std::vector<uint8_t> &key, RID rid, const Tuple &entry) -> std::unique_ptr<ArtNode> {
+  auto leaf = std::make_unique<ArtLeaf>(key);
+  leaf->entries_.emplace_back(rid, entry);
+  return leaf;
+}
+
+auto Insert(std::unique_ptr<ArtNode> &ref, const std::vector<uint8_t> &key, size_t depth, RID rid, const Tuple &entry,
+            bool unique) -> bool {
+  if (ref == nullptr) {
+    ref = MakeLeaf(key, rid, entry);
+    return true;
+  }
+  if (ref->type_ == ArtNodeType::LEAF) {
+    auto *leaf = static_cast<ArtLeaf *>(ref.get());
+    if (leaf->key_ == key) {
+      if (unique) {
+        return false;
+      }
+      leaf->entries_.emplace_back(rid, entry);
+      return true;
+    }
+    // 编码后的键互相不是前缀,两个键一定会在某个字节上分开,分叉点之前的部分成为新结点的前缀
+    size_t p = 0;
+    while (leaf->key_[depth + p] == key[depth + p]) {
+      p++;
+    }
+    auto node = std::make_unique<ArtNode4>();
+    node->prefix_.assign(key.begin() + depth, key.begin() + depth + p);
+    uint8_t old_byte = leaf->key_[depth + p];
+    InsertSorted(node.get(), old_byte, std::move(ref));
+    InsertSorted(node.get(), key[depth + p], MakeLeaf(key, rid, entry));
+    ref = std::move(node);
+    return true;
+  }
+
+  auto *inner = static_cast<ArtInnerNode *>(ref.get());
+  size_t p = 0;
+  while (p < inner->prefix_.size() && inner->prefix_[p] == key[depth + p]) {
+    p++;
+  }
+  if (p < inner->prefix_.size()) {
+    // 前缀中间分叉: 新结点接管匹配的那一段,旧结点留下分叉字节之后的部分
+    auto node = std::make_unique<ArtNode4>();
+    node->prefix_.assign(inner->prefix_.begin(), inner->prefix_.begin() + p);
+    uint8_t old_byte = inner->prefix_[p];
+    inner->prefix_.erase(inner->prefix_.begin(), inner->prefix_.begin() + p + 1);
+    InsertSorted(node.get(), old_byte, std::move(ref));
+    InsertSorted(node.get(), key[depth + p], MakeLeaf(key, rid, entry));
+    ref = std::move(node);
+    return true;
+  }
+  depth += inner->prefix_.size();
+  if (auto *child = FindChild(inner, key[depth]); child != nullptr) {
+    return Insert(*child, key, depth + 1, rid, entry, unique);
+  }
+  AddChild(ref, key[depth], MakeLeaf(key, rid, entry));
+  return true;
+}
+
+void Remove(std::unique_ptr<ArtNode> &ref, const std::vector<uint8_t> &key, size_t depth, RID rid) {
+  if (ref == nullptr) {
+    return;
+  }
+  if (ref->type_ == ArtNodeType::LEAF) {
+    auto *leaf = static_cast<ArtLeaf *>(ref.get());
+    if (leaf->key_ != key) {
+      return;
+    }
+    auto &entries = leaf->entries_;
+    entries.erase(std::remove_if(entries.begin(), entries.end(), [&](const auto &e) { return e.first == rid; }),
+                  entries.end());
+    if (entries.empty()) {
+      ref.reset();
+    }
+    return;
+  }
+  auto *inner = static_cast<ArtInnerNode *>(ref.get());
+  if (key.size() < depth + inner->prefix_.size() + 1 ||
+      !std::equal(inner->prefix_.begin(), inner->prefix_.end(), key.begin() + depth)) {
+    return;
+  }
+  depth += inner->prefix_.size();
+  auto *child = FindChild(inner, key[depth]);
+  if (child == nullptr) {
+    return;
+  }
+  Remove(*child, key, depth + 1, rid);
+  if (*child == nullptr) {
+    RemoveChild(ref, key[depth]);
+  }
+}
+
+void CollectEntries(ArtNode *node, std::vector<std::pair<RID, Tuple>> *entries) {
+  if (node->type_ == ArtNodeType::LEAF) {
+    const auto &leaf_entries = static_cast<ArtLeaf *>(node)->entries_;
+    entries->insert(entries->end(), leaf_entries.begin(), leaf_entries.end());
+    return;
+  }
+  ForEachChild(static_cast<ArtInnerNode *>(node),
+               [&](uint8_t, std::unique_ptr<ArtNode> &child) { CollectEntries(child.get(), entries); });
+}
+
+/** Append the big-endian bytes of an unsigned integer */
+template <typename T>
+void AppendBigEndian(std::vector<uint8_t> *out, T value) {
+  for (int shift = (sizeof(T) - 1) * 8; shift >= 0; shift -= 8) {
+    out->push_back(static_cast<uint8_t>(value >> shift));
+  }
+}
+
+/** Signed integers with the sign bit flipped compare like unsigned ones */
+template <typename Signed, typename Unsigned>
+void AppendSigned(std::vector<uint8_t> *out, Signed value) {
+  AppendBigEndian<Unsigned>(out, static_cast<Unsigned>(value) ^ (Unsigned{1} << (sizeof(Unsigned) * 8 - 1)));
+}
+
+}  // namespace
+
+ARTIndex::ARTIndex(std::unique_ptr<IndexMetadata> &&metadata) : Index(std::move(metadata)) {}
+
+ARTIndex::~ARTIndex() = default;
+
+auto ARTIndex::EncodeKey(const Tuple &key, const Schema *schema, uint32_t column_count) -> std::vector<uint8_t> {
+  std::vector<uint8_t> out;
+  for (uint32_t i = 0; i < column_count; i++) {
+    Value value = key.GetValue(schema, i);
+    // 每列先放一个字节区分NULL,NULL排在所有值前面
+    if (value.IsNull()) {
+      out.push_back(0);
+      continue;
+    }
+    out.push_back(1);
+    switch (value.GetTypeId()) {
+      case TypeId::BOOLEAN:
+      case TypeId::TINYINT:
+        AppendSigned<int8_t, uint8_t>(&out, value.GetAs<int8_t>());
+        break;
+      case TypeId::SMALLINT:
+        AppendSigned<int16_t, uint16_t>(&out, value.GetAs<int16_t>());
+        break;
+      case TypeId::INTEGER:
+        AppendSigned<int32_t, uint32_t>(&out, value.GetAs<int32_t>());
+        break;
+      case TypeId::BIGINT:
+        AppendSigned<int64_t, uint64_t>(&out, value.GetAs<int64_t>());
+        break;
+      case TypeId::TIMESTAMP:
+        AppendBigEndian<uint64_t>(&out, value.GetAs<uint64_t>());
+        break;
+      case TypeId::DECIMAL: {
+        // 正数翻转符号位,负数翻转所有位;-0.0和0.0相等,先统一成0.0
+        double d = value.GetAs<double>();
+        if (d == 0) {
+          d = 0;
+        }
+        uint64_t bits;
+        std::memcpy(&bits, &d, sizeof(bits));
+        bits = (bits >> 63) != 0 ? ~bits : bits | (uint64_t{1} << 63);
+        AppendBigEndian<uint64_t>(&out, bits);
+        break;
+      }
+      case TypeId::VARCHAR: {
+        // 0x00转义成0x00 0xFF,再以0x00 0x00结尾,这样短的字符串排在以它开头的长字符串前面,且任何键都不是别的键的前缀
+        const char *data = value.GetData();
+        size_t len = strnlen(data, value.GetLength());
+        for (size_t j = 0; j < len; j++) {
+          out.push_back(static_cast<uint8_t>(data[j]));
+          if (data[j] == '\0') {
+            out.push_back(0xFF);
+          }
+        }
+        out.push_back(0);
+        out.push_back(0);
+        break;
+      }
+      default:
+        throw NotImplementedException("ART index does not support the key type");
+    }
+  }
+  return out;
+}
+
+auto ARTIndex::InsertEntry(const Tuple &key, RID rid, Transaction *transaction) -> bool {
+  auto art_key = EncodeKey(key, GetEntrySchema(), GetIndexColumnCount());
+  std::unique_lock lock(latch_);
+  return Insert(root_, art_key, 0, rid, key, IsUnique());
+}
+
+void ARTIndex::DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) {
+  auto art_key = EncodeKey(key, GetKeySchema(), GetIndexColumnCount());
+  std::unique_lock lock(latch_);
+  Remove(root_, art_key, 0, rid);
+}
+
+void ARTIndex::ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) {
+  std::vector<std::pair<RID, Tuple>> entries;
+  Lookup(EncodeKey(key, GetKeySchema(), GetIndexColumnCount()), &entries);
+  for (const auto &entry : entries) {
+    result->push_back(entry.first);
+  }
+}
+
+auto ARTIndex::MakeScanIterator(const Tuple *low_key, bool low_inclusive, const Tuple *high_key, bool high_inclusive,
+                                bool reverse) -> std::unique_ptr<IndexScanIterator> {
+  // 前面若干列两端相等,其余的列两端都是NULL,才是一次前缀查找
+  uint32_t prefix_columns = 0;
+  bool prefix_lookup = low_key != nullptr && high_key != nullptr && low_inclusive && high_inclusive;
+  for (uint32_t i = 0; prefix_lookup && i < GetIndexColumnCount(); i++) {
+    Value low = low_key->GetValue(GetKeySchema(), i);
+    Value high = high_key->GetValue(GetKeySchema(), i);
+    if (low.IsNull() && high.IsNull()) {
+      continue;
+    }
+    prefix_lookup = prefix_columns == i && !low.IsNull() && !high.IsNull() && low.CompareEquals(high) == CmpBool::CmpTrue;
+    prefix_columns++;
+  }
+  if (!prefix_lookup || prefix_columns == 0) {
+    throw NotImplementedException("ART index " + GetName() + " only supports equality lookups on a key prefix");
+  }
+  std::vector<std::pair<RID, Tuple>> entries;
+  Lookup(EncodeKey(*low_key, GetKeySchema(), prefix_columns), &entries);
+  return std::make_unique<ARTIndexScanIterator>(std::move(entries));
+}
+
+void ARTIndex::Lookup(const std::vector<uint8_t> &prefix, std::vector<std::pair<RID, Tuple>> *entries) {
+  std::shared_lock lock(latch_);
+  ArtNode *node = root_.get();
+  size_t depth = 0;
+  while (node != nullptr) {
+    if (node->type_ == ArtNodeType::LEAF) {
+      const auto &leaf_key = static_cast<ArtLeaf *>(node)->key_;
+      if (leaf_key.size() >= prefix.size() && std::equal(prefix.begin(), prefix.end(), leaf_key.begin())) {
+        CollectEntries(node, entries);
+      }
+      return;
+    }
+    auto *inner = static_cast<ArtInnerNode *>(node);
+    for (auto byte : inner->prefix_) {
+      if (depth == prefix.size()) {
+        break;
+      }
+      if (byte != prefix[depth++]) {
+        return;
+      }
+    }
+    // 查找的键在这个结点上用完了,下面所有的键都以它开头
+    if (depth == prefix.size()) {
+      CollectEntries(node, entries);
+      return;
+    }
+    auto *child = FindChild(inner, prefix[depth++]);
+    node = child == nullptr ? nullptr : child->get();
+  }
+}
+
+}  // namespace bustub
@@ -11,18 +11,39 @@ namespace bustub {
 
 INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_TYPE::BPlusTree(std::string name, page_id_t header_page_id, BufferPoolManager *buffer_pool_manager,
-                          const KeyComparator &comparator, int leaf_max_size, int internal_max_size)
+                          const KeyComparator &comparator, int leaf_max_size, int internal_max_size,
+                          int resident_levels, bool lazy_delete)
     : index_name_(std::move(name)),
       bpm_(buffer_pool_manager),
       comparator_(std::move(comparator)),
       leaf_max_size_(leaf_max_size),
       internal_max_size_(internal_max_size),
-      header_page_id_(header_page_id) {
+      header_page_id_(header_page_id),
+      resident_levels_(resident_levels),
+      lazy_delete_(lazy_delete) {
   WritePageGuard guard = bpm_->FetchPageWrite(header_page_id_);
   auto root_page = guard.AsMut<BPlusTreeHeaderPage>();
   root_page->root_page_id_ = INVALID_PAGE_ID;
+  guard.Drop();
 
   // std::cout << leaf_max_size << " " << internal_max_size << std::endl;
+  if (resident_levels_ > 0) {
+    RefreshResidentPages();
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+BPLUSTREE_TYPE::~BPlusTree() {
+  {
+    std::lock_guard<std::mutex> lock(compactor_latch_);
+    stop_compactor_ = true;
+  }
+  compactor_cv_.notify_one();
+  if (compactor_.joinable()) {
+    compactor_.join();
+  }
+  std::unique_lock<std::shared_mutex> lock(resident_latch_);
+  ReleaseResidentPages();
 }
 
 /*
@@ -51,21 +72,18 @@ INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *txn) -> bool {
   // Declaration of context instance.
   if (!this->IsEmpty()) {
-    ReadPageGuard header_guard = this->bpm_->FetchPageRead(this->header_page_id_);
+    std::shared_lock<std::shared_mutex> resident_lock(resident_latch_);
+    ReadPageGuard header_guard = this->FetchNodeRead(this->header_page_id_);
     auto header_page = header_guard.As<BPlusTreeHeaderPage>();
-    ReadPageGuard root_page_guard = this->bpm_->FetchPageRead(header_page->root_page_id_);
+    if (header_page->root_page_id_ == INVALID_PAGE_ID) {
+      return false;
+    }
+    ReadPageGuard root_page_guard = this->FetchNodeRead(header_page->root_page_id_);
     header_guard.Drop();
     Context ctx;
     ctx.read_set_.push_back(std::move(root_page_guard));
     // 自此,拿到了root page(结点),将其存储在read_set_中
     bool ret_flag = false;
-    auto leaf_cmp_func = [&](const MappingType &a, const MappingType &b) -> bool {
-      return static_cast<bool>(this->comparator_(a.first, b.first) == -1);
-    };
-    auto internal_cmp_func = [&](const std::pair<KeyType, page_id_t> &a,
-                                 const std::pair<KeyType, page_id_t> &b) -> bool {
-      return static_cast<bool>(this->comparator_(a.first, b.first) == -1);
-    };
 
     while (!ctx.read_set_.empty()) {
       auto now_page = ctx.read_set_.back().As<BPlusTreePage>();
@@ -73,14 +91,11 @@ auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result
         auto now_leaf_page = reinterpret_cast<const LeafPage *>(now_page);
         // 这时候找一下有没有关键字就可以了
         // 这个地方不知道leafpage的数组下标是不是从0开始的。
-        auto now_leaf_page_array = now_leaf_page->GetArray();
-        auto key_itr = std::lower_bound(now_leaf_page_array, now_leaf_page_array + now_leaf_page->GetSize(),
-                                        std::make_pair(key, now_leaf_page_array[0].second), leaf_cmp_func);
-        int key_index = key_itr - now_leaf_page_array;
+        int key_index = now_leaf_page->LowerBound(key, this->comparator_);
         if (key_index < now_leaf_page->GetSize()) {
-          if (this->comparator_(now_leaf_page_array[key_index].first, key) == 0) {
+          if (this->comparator_(now_leaf_page->KeyAt(key_index), key) == 0) {
             ret_flag = true;
-            auto now_rid = now_leaf_page_array[key_index].second;
+            auto now_rid = now_leaf_page->ValueAt(key_index);
             result->push_back(now_rid);
           }
         }
@@ -92,14 +107,9 @@ auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result
         continue;
       }
       auto now_internal_page = reinterpret_cast<const InternalPage *>(now_page);
-      auto now_internal_page_array = now_internal_page->GetArray();
       // 这时候需要接着寻找,压入read_set_
-      auto key_pos =
-          std::upper_bound(now_internal_page_array + 1, now_internal_page_array + now_internal_page->GetSize(),
-                           std::make_pair(key, now_internal_page_array[0].second), internal_cmp_func) -
-          1;
-      int key_index = key_pos - now_internal_page_array;
-      ReadPageGuard son_page_guard = this->bpm_->FetchPageRead(now_internal_page_array[key_index].second);
+      int key_index = now_internal_page->UpperBound(key, this->comparator_) - 1;
+      ReadPageGuard son_page_guard = this->FetchNodeRead(now_internal_page->ValueAt(key_index));
       ctx.read_set_.push_back(std::move(son_page_guard));
       ctx.read_set_.pop_front();
     }
@@ -108,6 +118,64 @@ auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result
   return false;
 }
 
+/*
+ * Batched point query. The keys must be sorted in ascending order, so the
+ * path from the root to the current leaf is kept latched and the next key only
+ * climbs up to the lowest ancestor whose subtree still covers it, instead of
+ * paying a header latch and a full root-to-leaf descent per key. Keys landing
+ * in the same leaf are answered without any new latch, keys in a neighbouring
+ * leaf only re-latch the shared parent.
+ * @return : the number of keys found
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::GetValues(const std::vector<KeyType> &sorted_keys, std::vector<std::vector<ValueType>> *result,
+                               Transaction *txn) -> size_t {
+  result->assign(sorted_keys.size(), {});
+  if (sorted_keys.empty()) {
+    return 0;
+  }
+  std::shared_lock<std::shared_mutex> resident_lock(resident_latch_);
+  ReadPageGuard header_guard = this->FetchNodeRead(this->header_page_id_);
+  auto header_page = header_guard.As<BPlusTreeHeaderPage>();
+  if (header_page->root_page_id_ == INVALID_PAGE_ID) {
+    return 0;
+  }
+  Context ctx;
+  ctx.read_set_.push_back(this->FetchNodeRead(header_page->root_page_id_));
+  header_guard.Drop();
+  // fences[i]是read_set_[i]这棵子树的上界(不包含),为空代表正无穷
+  std::vector<std::optional<KeyType>> fences{std::nullopt};
+
+  size_t found = 0;
+  for (size_t i = 0; i < sorted_keys.size(); i++) {
+    const KeyType &key = sorted_keys[i];
+    // 往上退到仍然覆盖key的最低祖先,根结点覆盖所有键
+    while (fences.back().has_value() && this->comparator_(key, *fences.back()) >= 0) {
+      ctx.read_set_.pop_back();
+      fences.pop_back();
+    }
+    // 从这个祖先往下走到叶子,沿途的读锁一直保留给后面的键使用
+    auto now_page = ctx.read_set_.back().As<BPlusTreePage>();
+    while (!now_page->IsLeafPage()) {
+      auto now_internal_page = reinterpret_cast<const InternalPage *>(now_page);
+      int size = now_internal_page->GetSize();
+      int key_index = now_internal_page->UpperBound(key, this->comparator_) - 1;
+      std::optional<KeyType> fence =
+          key_index + 1 < size ? std::optional<KeyType>(now_internal_page->KeyAt(key_index + 1)) : fences.back();
+      ctx.read_set_.push_back(this->FetchNodeRead(now_internal_page->ValueAt(key_index)));
+      fences.push_back(fence);
+      now_page = ctx.read_set_.back().As<BPlusTreePage>();
+    }
+    auto now_leaf_page = reinterpret_cast<const LeafPage *>(now_page);
+    int key_index = now_leaf_page->LowerBound(key, this->comparator_);
+    if (key_index < now_leaf_page->GetSize() && this->comparator_(now_leaf_page->KeyAt(key_index), key) == 0) {
+      (*result)[i].push_back(now_leaf_page->ValueAt(key_index));
+      found++;
+    }
+  }
+  return found;
+}
+
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
@@ -140,21 +208,19 @@ auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transact
   bool reach_leaf = false;
   std::optional<KeyType> last_split = std::nullopt;
   std::optional<std::pair<page_id_t, page_id_t>> left_right_id = std::nullopt;
+  // 是否是在整棵树的最右边追加(顺序插入),此时分裂让左边结点保持满的,只把新键分到右边。
+  // 这样顺序插入建出来的树几乎是满的,而不是一半空的,扇出更大,树也更矮
+  bool append_split = false;
   while (!ctx.write_set_.empty()) {
     auto now_page = ctx.write_set_.back().AsMut<BPlusTreePage>();
     auto now_page_id = ctx.write_set_.back().PageId();
-    auto cmp_func = [&](const MappingType &a, const MappingType &b) -> bool {
-      return static_cast<bool>(this->comparator_(a.first, b.first) == -1);
-    };
     if (now_page->IsLeafPage()) {
       reach_leaf = true;
       auto now_leaf_page = reinterpret_cast<LeafPage *>(now_page);
-      auto now_leaf_page_array = now_leaf_page->GetArray();
-      auto lower = std::lower_bound(now_leaf_page_array, now_leaf_page_array + now_leaf_page->GetSize(),
-                                    std::make_pair(key, value), cmp_func);
-      if (lower - now_leaf_page_array < now_leaf_page->GetSize()) {
+      int right_node_index_num = now_leaf_page->LowerBound(key, this->comparator_);
+      if (right_node_index_num < now_leaf_page->GetSize()) {
         // 保证找到的位置是有效的
-        if (this->comparator_(lower->first, key) == 0) {
+        if (this->comparator_(now_leaf_page->KeyAt(right_node_index_num), key) == 0) {
           // 说明有重复的键值,返回false;
           ret_flag = false;
           (*ctx.header_page_).Drop();
@@ -165,33 +231,37 @@ auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transact
         }
       }
       ret_flag = true;
-      int right_node_index_num = lower - now_leaf_page_array;
-      // 此时应该先插入,再看一下有没有超过上界
-      this->InsertLeafAValue(now_leaf_page, std::make_pair(key, value), right_node_index_num);
-      if (now_leaf_page->GetSize() == now_leaf_page->GetMaxSize()) {
+      // 此时应该先插入,再看一下有没有超过上界;压缩后的键放不下时也要分裂
+      bool inserted = this->InsertLeafAValue(now_leaf_page, std::make_pair(key, value), right_node_index_num);
+      if (!inserted || now_leaf_page->GetSize() == now_leaf_page->GetMaxSize()) {
         // 由于达到上限,此时应该要分裂
         page_id_t new_right_page_id = -233;
         this->BuildNewPage(&new_right_page_id, IndexPageType::LEAF_PAGE);
         WritePageGuard new_right_page_guard = this->bpm_->FetchPageWrite(new_right_page_id);
         auto new_right_page = new_right_page_guard.AsMut<LeafPage>();
 
-        // 将结点右半部分移到新结点中,并将原先的结点Size调整为原先的一半。
-        int half_index = now_leaf_page->GetSize() / 2;
-
-        // 将右半部分移动到新的右子树
-        now_leaf_page_array = now_leaf_page->GetArray();  // 重新获取一次插入后的数组
-        std::vector<MappingType> move_to_right;
-        for (int i = half_index; i < now_leaf_page->GetSize(); i++) {
-          move_to_right.push_back(now_leaf_page_array[i]);
+        std::vector<MappingType> prime_leaf_page = now_leaf_page->GetEntries();
+        if (!inserted) {
+          prime_leaf_page.insert(prime_leaf_page.begin() + right_node_index_num, std::make_pair(key, value));
         }
-        now_leaf_page->SetSize(half_index);
-        int siz = move_to_right.size();
-        new_right_page->SetSize(siz);
-        for (int i = 0; i < siz; i++) {
-          new_right_page->SetArrayAt(i, move_to_right[i]);
+        int siz = prime_leaf_page.size();
+        // 将结点右半部分移到新结点中,并将原先的结点Size调整为原先的一半。
+        int half_index = siz / 2;
+        append_split =
+            right_node_index_num == siz - 1 && now_leaf_page->GetNextPageId() == INVALID_PAGE_ID && siz > 2;
+        if (append_split) {
+          // 最右边的叶子追加,只把新插入的键移到右边
+          half_index = siz - 1;
         }
-        // 存储需要传给上层的MappingType以及新的左右孩子的page_id
-        last_split = std::make_optional(now_leaf_page->KeyAt(half_index));
+
+        // 将右半部分移动到新的右子树,两半都不超过不压缩时一页的容量,一定放得下
+        std::vector<MappingType> move_to_right(prime_leaf_page.begin() + half_index, prime_leaf_page.end());
+        prime_leaf_page.resize(half_index);
+        BUSTUB_ENSURE(now_leaf_page->SetEntries(prime_leaf_page), "left half of a leaf split does not fit");
+        BUSTUB_ENSURE(new_right_page->SetEntries(move_to_right), "right half of a leaf split does not fit");
+        // 存储需要传给上层的MappingType以及新的左右孩子的page_id,分隔键截到刚好能分开左右两边
+        last_split = std::make_optional(this->comparator_.ShortestSeparator(prime_leaf_page.back().first,
+                                                                            move_to_right.front().first));
         left_right_id = std::make_optional(std::make_pair(now_page_id, new_right_page_id));
         new_right_page->SetNextPageId(now_leaf_page->GetNextPageId());
         now_leaf_page->SetNextPageId(new_right_page_id);
@@ -201,11 +271,9 @@ auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transact
           this->BuildNewPage(&new_root_id, IndexPageType::INTERNAL_PAGE);
           WritePageGuard new_root_page_guard = this->bpm_->FetchPageWrite(new_root_id);
           auto new_root_page = new_root_page_guard.AsMut<InternalPage>();
-          new_root_page->SetKeyAt(1, *last_split);
           // 左子树肯定是原root本身,右子树是新建的结点
-          new_root_page->SetValueAt(0, (*left_right_id).first);
-          new_root_page->SetValueAt(1, (*left_right_id).second);
-          new_root_page->SetSize(2);
+          new_root_page->SetEntries({std::make_pair(*last_split, (*left_right_id).first),
+                                     std::make_pair(*last_split, (*left_right_id).second)});
           // 更新header
           header_page->root_page_id_ = new_root_id;
         }
@@ -225,28 +293,23 @@ auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transact
       // 但是我想pop_back完了之后,在析构的时候应该会自动调用drop的,应该不用手动drop?这里尝试把手动drop的注释掉看看对不对
       ctx.write_set_.pop_back();
     } else {
-      auto internal_cmp_func = [&](const std::pair<KeyType, page_id_t> &a,
-                                   const std::pair<KeyType, page_id_t> &b) -> bool {
-        return static_cast<bool>(this->comparator_(a.first, b.first) == -1);
-      };
       // 说明此时是Internal page
       auto now_internal_page = reinterpret_cast<InternalPage *>(now_page);
-      auto now_internal_page_array = now_internal_page->GetArray();
       if (reach_leaf) {
         // 此时已经到达过叶子结点,故需要处理有没有传上来的需要插入的结点
         if (last_split != std::nullopt && left_right_id != std::nullopt) {
           // 这个地方我选择重新二分查找要插入last_split的index,但是实际上应该可以自己写个栈保留一下当前这个internalPage
           // 找到的孩子结点的键值对的索引,可以减少一个对数复杂度,但是我懒得写.如果因此TLE寄了就寄了吧,工作量过大
-          auto key_pos =
-              std::upper_bound(now_internal_page_array + 1, now_internal_page_array + now_internal_page->GetSize(),
-                               std::make_pair((*last_split), (*left_right_id).second), internal_cmp_func);
-          int key_index = key_pos - now_internal_page_array;
-          if (now_internal_page->GetSize() == now_internal_page->GetMaxSize()) {
-            // 在插入前Size就已经是Max了,则必须分裂
+          int key_index = now_internal_page->UpperBound(*last_split, this->comparator_);
+          if (now_internal_page->GetSize() == now_internal_page->GetMaxSize() ||
+              !this->InsertInternalAValue(now_internal_page, std::make_pair(*last_split, (*left_right_id).second),
+                                          key_index)) {
+            // 在插入前Size就已经是Max了,或者压缩后的键放不下了,则必须分裂
             KeyType key_to_push;
             std::pair<page_id_t, page_id_t> left_right_son_to_push;
+            append_split = append_split && key_index == now_internal_page->GetSize();
             this->DealWithInternalSplit(now_internal_page, key_index, (*last_split), (*left_right_id), key_to_push,
-                                        left_right_son_to_push);
+                                        left_right_son_to_push, append_split);
             left_right_son_to_push.first = now_page_id;
             // 存储需要传给上层的MappingType以及新的左右孩子的page_id
             last_split = std::make_optional(key_to_push);
@@ -256,20 +319,16 @@ auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transact
               this->BuildNewPage(&new_root_id, IndexPageType::INTERNAL_PAGE);
               WritePageGuard new_root_page_guard = this->bpm_->FetchPageWrite(new_root_id);
               auto new_root_page = new_root_page_guard.AsMut<InternalPage>();
-              new_root_page->SetKeyAt(1, *last_split);
               // 左子树肯定是原root本身
-              new_root_page->SetValueAt(0, (*left_right_id).first);
-              new_root_page->SetValueAt(1, (*left_right_id).second);
-              new_root_page->SetSize(2);
+              new_root_page->SetEntries({std::make_pair(*last_split, (*left_right_id).first),
+                                         std::make_pair(*last_split, (*left_right_id).second)});
               // 更新header
               header_page->root_page_id_ = new_root_id;
               last_split = std::nullopt;
               left_right_id = std::nullopt;
             }
           } else {
-            // 否则直接插入
-            this->InsertInternalAValue(now_internal_page, std::make_pair(*last_split, (*left_right_id).second),
-                                       key_index);
+            // 否则上面已经直接插入了
             last_split = std::nullopt;
             left_right_id = std::nullopt;
           }
@@ -286,12 +345,8 @@ auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transact
         ctx.write_set_.pop_back();
       } else {
         // 注意这里需要从1号位置开始二分,因为1号不符合要求,key_pos对应的位置就是
-        auto key_pos =
-            std::upper_bound(now_internal_page_array + 1, now_internal_page_array + now_internal_page->GetSize(),
-                             std::make_pair(key, -233), internal_cmp_func) -
-            1;
-        int key_index = key_pos - now_internal_page_array;
-        auto son_page_id = now_internal_page_array[key_index].second;
+        int key_index = now_internal_page->UpperBound(key, this->comparator_) - 1;
+        auto son_page_id = now_internal_page->ValueAt(key_index);
         WritePageGuard son_page_guard = this->bpm_->FetchPageWrite(son_page_id);
         ctx.write_set_.push_back(std::move(son_page_guard));
       }
@@ -301,9 +356,124 @@ auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transact
   while (!ctx.write_set_.empty()) {
     ctx.write_set_.pop_front();
   }
+  if (resident_levels_ > 0 && resident_stale_) {
+    this->RefreshResidentPages();
+  }
   return ret_flag;
 }
 
+/*
+ * Build an empty tree bottom-up from keys in strictly ascending order. Leaves
+ * are filled left to right and linked, then every internal level is built from
+ * the first keys of the level below, so no key ever descends from the root.
+ * The last node of a level is evened out with its left neighbour when it is
+ * underfull. The header write latch is held for the whole load.
+ * @return : false, without calling next, if the tree is not empty
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::BulkLoad(const std::function<bool(KeyType *key, ValueType *value)> &next) -> bool {
+  WritePageGuard header_guard = this->bpm_->FetchPageWrite(this->header_page_id_);
+  auto header_page = header_guard.AsMut<BPlusTreeHeaderPage>();
+  if (header_page->root_page_id_ != INVALID_PAGE_ID) {
+    return false;
+  }
+  // 当前这一层的结点,每个结点带着它和左边结点之间的分隔键,第一个结点的分隔键不用
+  std::vector<std::pair<KeyType, page_id_t>> level;
+  std::optional<WritePageGuard> leaf_guard;
+  KeyType key;
+  ValueType value;
+  std::optional<KeyType> last_key;
+  while (next(&key, &value)) {
+    BUSTUB_ENSURE(!last_key.has_value() || this->comparator_(*last_key, key) < 0,
+                  "bulk loaded keys must be strictly ascending");
+    // 和顺序插入一样,叶子最多放到MaxSize - 1个,压缩后放不下了也换下一个叶子
+    bool appended = false;
+    if (leaf_guard.has_value()) {
+      auto leaf_page = leaf_guard->AsMut<LeafPage>();
+      appended = leaf_page->GetSize() + 1 < leaf_page->GetMaxSize() &&
+                 this->InsertLeafAValue(leaf_page, std::make_pair(key, value), leaf_page->GetSize());
+    }
+    if (!appended) {
+      page_id_t new_page_id = -233;
+      this->BuildNewPage(&new_page_id, IndexPageType::LEAF_PAGE);
+      WritePageGuard new_leaf_guard = this->bpm_->FetchPageWrite(new_page_id);
+      BUSTUB_ENSURE(this->InsertLeafAValue(new_leaf_guard.AsMut<LeafPage>(), std::make_pair(key, value), 0),
+                    "key does not fit into an empty leaf");
+      if (leaf_guard.has_value()) {
+        leaf_guard->AsMut<LeafPage>()->SetNextPageId(new_page_id);
+        level.emplace_back(this->comparator_.ShortestSeparator(*last_key, key), new_page_id);
+      } else {
+        level.emplace_back(key, new_page_id);
+      }
+      leaf_guard = std::move(new_leaf_guard);
+    }
+    last_key = key;
+  }
+  if (level.empty()) {
+    return true;
+  }
+  // 最后一个叶子太空的话和左边的叶子平分,分隔键跟着改
+  auto last_leaf = leaf_guard->AsMut<LeafPage>();
+  if (level.size() > 1 && last_leaf->GetSize() < last_leaf->GetMinSize()) {
+    WritePageGuard prev_guard = this->bpm_->FetchPageWrite(level[level.size() - 2].second);
+    auto prev_leaf = prev_guard.AsMut<LeafPage>();
+    std::vector<MappingType> entries = prev_leaf->GetEntries();
+    std::vector<MappingType> last_entries = last_leaf->GetEntries();
+    entries.insert(entries.end(), last_entries.begin(), last_entries.end());
+    std::vector<MappingType> move_to_right(entries.begin() + entries.size() / 2, entries.end());
+    entries.resize(entries.size() / 2);
+    BUSTUB_ENSURE(prev_leaf->SetEntries(entries), "left half of the last leaves does not fit");
+    BUSTUB_ENSURE(last_leaf->SetEntries(move_to_right), "right half of the last leaves does not fit");
+    level.back().first = this->comparator_.ShortestSeparator(entries.back().first, move_to_right.front().first);
+  }
+  leaf_guard.reset();
+
+  // 逐层往上建内部结点,一个结点的第一个分隔键就是它自己和左边结点之间的分隔键
+  while (level.size() > 1) {
+    std::vector<std::pair<KeyType, page_id_t>> upper_level;
+    std::optional<WritePageGuard> internal_guard;
+    for (const auto &[separator, child_page_id] : level) {
+      bool appended = false;
+      if (internal_guard.has_value()) {
+        auto internal_page = internal_guard->AsMut<InternalPage>();
+        appended = internal_page->GetSize() < internal_page->GetMaxSize() &&
+                   this->InsertInternalAValue(internal_page, std::make_pair(separator, child_page_id),
+                                              internal_page->GetSize());
+      }
+      if (!appended) {
+        page_id_t new_page_id = -233;
+        this->BuildNewPage(&new_page_id, IndexPageType::INTERNAL_PAGE);
+        internal_guard = this->bpm_->FetchPageWrite(new_page_id);
+        BUSTUB_ENSURE(internal_guard->AsMut<InternalPage>()->SetEntries({std::make_pair(separator, child_page_id)}),
+                      "child does not fit into an empty internal page");
+        upper_level.emplace_back(separator, new_page_id);
+      }
+    }
+    auto last_internal = internal_guard->AsMut<InternalPage>();
+    if (upper_level.size() > 1 && last_internal->GetSize() < last_internal->GetMinSize()) {
+      WritePageGuard prev_guard = this->bpm_->FetchPageWrite(upper_level[upper_level.size() - 2].second);
+      auto prev_internal = prev_guard.AsMut<InternalPage>();
+      std::vector<std::pair<KeyType, page_id_t>> entries = prev_internal->GetEntries();
+      std::vector<std::pair<KeyType, page_id_t>> last_entries = last_internal->GetEntries();
+      // 最后一个结点的第0个键换成它真正的分隔键,合在一起之后就是一个普通的键
+      last_entries.front().first = upper_level.back().first;
+      entries.insert(entries.end(), last_entries.begin(), last_entries.end());
+      std::vector<std::pair<KeyType, page_id_t>> move_to_right(entries.begin() + entries.size() / 2, entries.end());
+      entries.resize(entries.size() / 2);
+      BUSTUB_ENSURE(prev_internal->SetEntries(entries), "left half of the last internal pages does not fit");
+      BUSTUB_ENSURE(last_internal->SetEntries(move_to_right), "right half of the last internal pages does not fit");
+      upper_level.back().first = move_to_right.front().first;
+    }
+    level = std::move(upper_level);
+  }
+  header_page->root_page_id_ = level.front().second;
+  header_guard.Drop();
+  if (resident_levels_ > 0 && resident_stale_) {
+    this->RefreshResidentPages();
+  }
+  return true;
+}
+
 /*****************************************************************************
  * REMOVE
  *****************************************************************************/
@@ -313,9 +483,13 @@ auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transact
  * If not, User needs to first find the right leaf page as deletion target, then
  * delete entry from leaf page. Remember to deal with redistribute or merge if
  * necessary.
+ * @return : false if the key was not in the tree
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *txn) {
+auto BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *txn) -> bool {
+  if (lazy_delete_) {
+    return this->RemoveLazily(key);
+  }
   // Declaration of context instance.
   Context ctx;
   WritePageGuard header_guard = this->bpm_->FetchPageWrite(this->header_page_id_);
@@ -323,7 +497,7 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *txn) {
   auto header_page = ctx.header_page_->AsMut<BPlusTreeHeaderPage>();
   if (header_page->root_page_id_ == INVALID_PAGE_ID) {
     // 立即返回
-    return;
+    return false;
   }
   WritePageGuard root_page_guard = this->bpm_->FetchPageWrite(header_page->root_page_id_);
   ctx.root_page_id_ = header_page->root_page_id_;
@@ -331,25 +505,16 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *txn) {
   // reach_leaf用来判断是否到达过leaf点,last_split存储栈信息中如果上一次是否有要添加的值
   // 如果在返回的过程中,有需要加入当前结点的key值,则将上一次循环的新生成的两个叶子page的page_id存储起来
   bool reach_leaf = false;
+  // 有没有真的删掉一个键,没找到key时统计信息不能跟着减
+  bool removed = false;
   while (!ctx.write_set_.empty()) {
     auto now_page = ctx.write_set_.back().AsMut<BPlusTreePage>();
     auto now_page_id = ctx.write_set_.back().PageId();
-    auto cmp_func = [&](const MappingType &a, const MappingType &b) -> bool {
-      return static_cast<bool>(this->comparator_(a.first, b.first) == -1);
-    };
-    auto internal_cmp_func = [&](const std::pair<KeyType, page_id_t> &a,
-                                 const std::pair<KeyType, page_id_t> &b) -> bool {
-      return static_cast<bool>(this->comparator_(a.first, b.first) == -1);
-    };
     if (now_page->IsLeafPage()) {
       // 如果是叶子结点
       reach_leaf = true;
       auto now_leaf_page = reinterpret_cast<LeafPage *>(now_page);
-      auto now_leaf_page_array = now_leaf_page->GetArray();
-      // 这里的now_leaf_page_array[0].first没有意义
-      auto delete_itr = std::lower_bound(now_leaf_page_array, now_leaf_page_array + now_leaf_page->GetSize(),
-                                         std::make_pair(key, now_leaf_page_array[0].second), cmp_func);
-      int delete_index = delete_itr - now_leaf_page_array;
+      int delete_index = now_leaf_page->LowerBound(key, this->comparator_);
       if (delete_index >= now_leaf_page->GetSize()) {
         // 判定delete_index超过了上限,直接退出循环
         (*ctx.header_page_).Drop();
@@ -358,7 +523,7 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *txn) {
         }
         continue;
       }
-      if (this->comparator_(key, delete_itr->first) == -1) {
+      if (this->comparator_(key, now_leaf_page->KeyAt(delete_index)) == -1) {
         // 说明找到的值比key大,直接退出循环
         (*ctx.header_page_).Drop();
         while (!ctx.write_set_.empty()) {
@@ -368,6 +533,7 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *txn) {
       }
       // 否则说明找到了要删除的值在delete_index
       // 叶子结点先删完,再判断是否小于ceil(MaxSize / 2)
+      removed = true;
       bool is_coalesce = false;
       if (now_page_id == ctx.root_page_id_) {
         // 说明要删除值的叶子结点是根节点,特殊处理一下
@@ -400,7 +566,6 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *txn) {
       ctx.parent_.pop();
     } else {
       auto now_internal_page = reinterpret_cast<InternalPage *>(now_page);
-      auto now_internal_page_array = now_internal_page->GetArray();
       if (reach_leaf) {
         // 说明到达过叶子结点
         bool is_coalesce = false;
@@ -410,6 +575,7 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *txn) {
             header_page->root_page_id_ = now_internal_page->ValueAt(0);
             // 并且考虑这个地方考虑一下调不调用this->bpm_->DeletePage()?
             this->bpm_->DeletePage(now_page_id);
+            resident_stale_ = true;
           }
         } else {
           // 否则这个地方首先看一下需不需要合并或者借值操作
@@ -424,6 +590,7 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *txn) {
           // 说明有合并操作
           // 这个地方考虑一下调不调用this->bpm_->DeletePage()?
           this->bpm_->DeletePage(now_page_id);
+          resident_stale_ = true;
         } else {
           // 这时候说明没有合并操作使得父亲结点发生变化，可以提前把锁放掉了
           (*ctx.header_page_).Drop();
@@ -435,13 +602,8 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *txn) {
         }
       } else {
         // 说明还未到达过叶子结点
-        auto delete_itr =
-            std::upper_bound(now_internal_page_array + 1, now_internal_page_array + now_internal_page->GetSize(),
-                             std::make_pair(key, now_internal_page_array[0].second), internal_cmp_func) -
-            1;
-
-        int key_index = delete_itr - now_internal_page_array;
-        auto son_page_id = now_internal_page_array[key_index].second;
+        int key_index = now_internal_page->UpperBound(key, this->comparator_) - 1;
+        auto son_page_id = now_internal_page->ValueAt(key_index);
         WritePageGuard son_page_guard = this->bpm_->FetchPageWrite(son_page_id);
         ctx.write_set_.push_back(std::move(son_page_guard));
 
@@ -450,6 +612,175 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *txn) {
       }
     }
   }
+  (*ctx.header_page_).Drop();
+  if (resident_levels_ > 0 && resident_stale_) {
+    this->RefreshResidentPages();
+  }
+  return removed;
+}
+
+/*****************************************************************************
+ * BATCHED UPDATES
+ *****************************************************************************/
+/*
+ * Apply a sorted batch of puts and removes leaf by leaf. Like GetValues, the
+ * path of internal pages down to the current leaf stays read latched, the
+ * next leaf is reached by climbing up to the lowest ancestor still covering
+ * the next key, so the pairs of neighbouring leaves share one descent. Every
+ * leaf is write latched exactly as RemoveLazily latches it and the pairs below
+ * its fence are applied there. A put into a full leaf (or a remove that would
+ * underflow it when deletes are not lazy) is put aside and goes through Insert
+ * (Remove) once no latch is held.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ApplyBatch(const std::vector<std::pair<KeyType, std::optional<ValueType>>> &batch) {
+  std::vector<size_t> deferred;
+  std::vector<KeyType> sparse_keys;
+  size_t i = 0;
+  while (i < batch.size()) {
+    ReadPageGuard header_guard = this->bpm_->FetchPageRead(this->header_page_id_);
+    page_id_t root_page_id = header_guard.As<BPlusTreeHeaderPage>()->root_page_id_;
+    if (root_page_id == INVALID_PAGE_ID) {
+      // 空树,第一个插入走Insert把根建出来,后面的接着按叶子批量做
+      header_guard.Drop();
+      if (batch[i].second.has_value()) {
+        this->Insert(batch[i].first, *batch[i].second);
+      }
+      i++;
+      continue;
+    }
+    // path[j]是读锁着的内部结点,fences[j]是它这棵子树的上界(不包含),为空代表正无穷。根是叶子时path为空
+    std::vector<ReadPageGuard> path;
+    std::vector<std::optional<KeyType>> fences;
+    ReadPageGuard root_guard = this->bpm_->FetchPageRead(root_page_id);
+    if (!root_guard.As<BPlusTreePage>()->IsLeafPage()) {
+      path.push_back(std::move(root_guard));
+      fences.push_back(std::nullopt);
+    }
+    root_guard.Drop();
+    while (i < batch.size()) {
+      page_id_t page_id = root_page_id;
+      std::optional<KeyType> fence = std::nullopt;
+      if (!path.empty()) {
+        // 往上退到仍然覆盖这个键的最低祖先,再从它往下走到叶子的父亲
+        while (fences.back().has_value() && this->comparator_(batch[i].first, *fences.back()) >= 0) {
+          path.pop_back();
+          fences.pop_back();
+        }
+        while (true) {
+          auto now_internal_page = path.back().As<InternalPage>();
+          int key_index = now_internal_page->UpperBound(batch[i].first, this->comparator_) - 1;
+          fence = key_index + 1 < now_internal_page->GetSize()
+                      ? std::optional<KeyType>(now_internal_page->KeyAt(key_index + 1))
+                      : fences.back();
+          page_id = now_internal_page->ValueAt(key_index);
+          ReadPageGuard son_page_guard = this->bpm_->FetchPageRead(page_id);
+          if (son_page_guard.As<BPlusTreePage>()->IsLeafPage()) {
+            break;
+          }
+          path.push_back(std::move(son_page_guard));
+          fences.push_back(fence);
+        }
+      }
+      // 和RemoveLazily一样,拿着父亲的读锁把叶子的读锁换成写锁
+      WritePageGuard leaf_guard = this->bpm_->FetchPageWrite(page_id);
+      auto leaf_page = leaf_guard.AsMut<LeafPage>();
+      int sparse_size = std::max(leaf_page->GetMinSize() / 2, 1);
+      bool was_sparse = leaf_page->GetSize() < sparse_size;
+      const KeyType &leaf_key = batch[i].first;
+      for (; i < batch.size() && (!fence.has_value() || this->comparator_(batch[i].first, *fence) < 0); i++) {
+        const auto &[key, value] = batch[i];
+        int index = leaf_page->LowerBound(key, this->comparator_);
+        bool found = index < leaf_page->GetSize() && this->comparator_(leaf_page->KeyAt(index), key) == 0;
+        if (!value.has_value()) {
+          if (found && !lazy_delete_ && leaf_page->GetSize() <= leaf_page->GetMinSize()) {
+            deferred.push_back(i);
+          } else if (found) {
+            leaf_page->DeleteAValue(index);
+          }
+          continue;
+        }
+        if (found) {
+          // 相等的键换成新的,include列可能不一样
+          leaf_page->DeleteAValue(index);
+        } else if (leaf_page->GetSize() + 1 >= leaf_page->GetMaxSize()) {
+          // 插进去就要分裂了
+          deferred.push_back(i);
+          continue;
+        }
+        if (!this->InsertLeafAValue(leaf_page, std::make_pair(key, *value), index)) {
+          deferred.push_back(i);
+        }
+      }
+      if (lazy_delete_ && !was_sparse && leaf_page->GetSize() < sparse_size) {
+        sparse_keys.push_back(leaf_key);
+      }
+    }
+  }
+  for (auto index : deferred) {
+    const auto &[key, value] = batch[index];
+    if (!value.has_value()) {
+      this->Remove(key, nullptr);
+    } else if (!this->Insert(key, *value)) {
+      this->Remove(key, nullptr);
+      this->Insert(key, *value);
+    }
+  }
+  if (sparse_keys.empty()) {
+    return;
+  }
+  bool wake_compactor;
+  {
+    std::lock_guard<std::mutex> lock(compactor_latch_);
+    for (const auto &key : sparse_keys) {
+      sparse_nodes_.emplace_back(key, 0);
+    }
+    wake_compactor = sparse_nodes_.size() >= BPLUSTREE_COMPACT_TRIGGER;
+  }
+  if (wake_compactor) {
+    this->RequestCompaction();
+  }
+}
+
+/*
+ * Look for node_id on the path of the first key, then route every key by the
+ * separators of node_id under its read latch. Pages that the compactor merged
+ * away are never fetched by id, they simply are not found on the path.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::RouteBatch(page_id_t node_id, const std::vector<KeyType> &sorted_keys,
+                                std::vector<page_id_t> *children, bool *leaf_children) -> bool {
+  if (sorted_keys.empty()) {
+    return false;
+  }
+  ReadPageGuard header_guard = this->bpm_->FetchPageRead(this->header_page_id_);
+  page_id_t page_id = header_guard.As<BPlusTreeHeaderPage>()->root_page_id_;
+  if (page_id == INVALID_PAGE_ID) {
+    return false;
+  }
+  ReadPageGuard now_page_guard = this->bpm_->FetchPageRead(page_id);
+  while (node_id != INVALID_PAGE_ID && page_id != node_id) {
+    if (now_page_guard.As<BPlusTreePage>()->IsLeafPage()) {
+      return false;
+    }
+    auto now_internal_page = now_page_guard.As<InternalPage>();
+    page_id = now_internal_page->ValueAt(now_internal_page->UpperBound(sorted_keys.front(), this->comparator_) - 1);
+    now_page_guard = this->bpm_->FetchPageRead(page_id);
+  }
+  if (now_page_guard.As<BPlusTreePage>()->IsLeafPage()) {
+    return false;
+  }
+  header_guard.Drop();
+  auto node_page = now_page_guard.As<InternalPage>();
+  children->clear();
+  children->reserve(sorted_keys.size());
+  for (const auto &key : sorted_keys) {
+    children->push_back(node_page->ValueAt(node_page->UpperBound(key, this->comparator_) - 1));
+  }
+  // 同一个内部结点的孩子都在同一层,看第一个就知道是不是叶子
+  ReadPageGuard child_guard = this->bpm_->FetchPageRead(node_page->ValueAt(0));
+  *leaf_children = child_guard.As<BPlusTreePage>()->IsLeafPage();
+  return true;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -459,6 +790,10 @@ auto BPLUSTREE_TYPE::BorrowOrCoalesceLeafPage(LeafPage *page, page_id_t page_id,
     throw("有个父亲节点是叶子结点");
   }
   auto parent_internal_page = reinterpret_cast<InternalPage *>(parent.first);
+  if (parent_internal_page->GetSize() < 2) {
+    // 父亲的分隔键放不下时借值合并会被跳过,父亲可能只剩这一个孩子,没有兄弟可找,就让它先不满着
+    return false;
+  }
   // 添加屎山代码中
   // 将可以给予键值对的兄弟结点装入
   bool is_left_sibing_ok = false;
@@ -495,12 +830,12 @@ auto BPLUSTREE_TYPE::BorrowOrCoalesceLeafPage(LeafPage *page, page_id_t page_id,
       auto left_right_page_id = parent_internal_page->ValueAt(parent.second - 1);
       WritePageGuard left__right_page_guard = this->bpm_->FetchPageWrite(left_right_page_id);
       auto left_right_page = left__right_page_guard.AsMut<LeafPage>();
-      int siz = page->GetSize();
+      // 两边都不到半满,合起来不压缩也放得下
+      auto merged = left_right_page->GetEntries();
+      auto entries = page->GetEntries();
+      merged.insert(merged.end(), entries.begin(), entries.end());
+      BUSTUB_ENSURE(left_right_page->SetEntries(merged), "coalesced leaf does not fit");
       left_right_page->SetNextPageId(page->GetNextPageId());
-      for (int i = 0; i < siz; i++) {
-        this->InsertLeafAValue(left_right_page, std::make_pair(page->KeyAt(i), page->ValueAt(i)),
-                               left_right_page->GetSize());
-      }
       parent_internal_page->DeleteAValue(parent.second);
       this->bpm_->DeletePage(page_id);
     } else {
@@ -508,35 +843,37 @@ auto BPLUSTREE_TYPE::BorrowOrCoalesceLeafPage(LeafPage *page, page_id_t page_id,
       auto left_right_page_id = parent_internal_page->ValueAt(parent.second + 1);
       WritePageGuard left__right_page_guard = this->bpm_->FetchPageWrite(left_right_page_id);
       auto left_right_page = left__right_page_guard.AsMut<LeafPage>();
-      int siz = left_right_page->GetSize();
+      auto merged = page->GetEntries();
+      auto entries = left_right_page->GetEntries();
+      merged.insert(merged.end(), entries.begin(), entries.end());
+      BUSTUB_ENSURE(page->SetEntries(merged), "coalesced leaf does not fit");
       page->SetNextPageId(left_right_page->GetNextPageId());
-      for (int i = 0; i < siz; i++) {
-        this->InsertLeafAValue(page, std::make_pair(left_right_page->KeyAt(i), left_right_page->ValueAt(i)),
-                               page->GetSize());
-      }
       parent_internal_page->DeleteAValue(parent.second + 1);
       this->bpm_->DeletePage(left_right_page_id);
     }
     return true;
   }
   // 说明这时候可以借一个数
+  // page不到半满,借来的一个键值对一定放得下;新的分隔键可能让父亲放不下,这时就不借了,让page先不满着
   auto left_right_page = sibing_that_can_give_key[0].AsMut<LeafPage>();
   if (is_left_sibing_ok) {
-    // 首先覆盖父亲原先分界点的值:
-    parent_internal_page->SetKeyAt(parent.second, left_right_page->KeyAt(left_right_page->GetSize() - 1));
-    // 接下来将左兄弟的最后一个值替代父亲原先的键值,并且将key-value插入到原结点中
-    this->InsertLeafAValue(page,
-                           std::make_pair(left_right_page->KeyAt(left_right_page->GetSize() - 1),
-                                          left_right_page->ValueAt(left_right_page->GetSize() - 1)),
-                           0);
-    left_right_page->DeleteAValue(left_right_page->GetSize() - 1);
+    int last = left_right_page->GetSize() - 1;
+    // 左兄弟的最后一个值移到原结点,父亲原先分界点的值换成能分开左兄弟和它的分隔键
+    KeyType separator =
+        this->comparator_.ShortestSeparator(left_right_page->KeyAt(last - 1), left_right_page->KeyAt(last));
+    if (!parent_internal_page->SetKeyAt(parent.second, separator)) {
+      return false;
+    }
+    this->InsertLeafAValue(page, left_right_page->KeyValueAt(last), 0);
+    left_right_page->DeleteAValue(last);
   } else {
-    this->InsertLeafAValue(page, std::make_pair(left_right_page->KeyAt(0), left_right_page->ValueAt(0)),
-                           page->GetSize());
+    KeyType separator = this->comparator_.ShortestSeparator(left_right_page->KeyAt(0), left_right_page->KeyAt(1));
+    if (!parent_internal_page->SetKeyAt(parent.second + 1, separator)) {
+      return false;
+    }
+    this->InsertLeafAValue(page, left_right_page->KeyValueAt(0), page->GetSize());
 
     left_right_page->DeleteAValue(0);
-
-    parent_internal_page->SetKeyAt(parent.second + 1, left_right_page->KeyAt(0));
   }
   // 最后记得让左或右兄弟的大小减一
   return false;
@@ -549,6 +886,9 @@ auto BPLUSTREE_TYPE::BorrowOrCoalesceInternalPage(InternalPage *page, page_id_t
     throw("有个父亲节点是叶子结点");
   }
   auto parent_internal_page = reinterpret_cast<InternalPage *>(parent.first);
+  if (parent_internal_page->GetSize() < 2) {
+    return false;
+  }
   // 添加屎山代码中
   // 将可以给予键值对的兄弟结点装入
   bool is_left_sibing_ok = false;
@@ -582,26 +922,21 @@ auto BPLUSTREE_TYPE::BorrowOrCoalesceInternalPage(InternalPage *page, page_id_t
         parent_internal_page->ValueAt(is_left_sibing_coalesce ? parent.second - 1 : parent.second + 1);
     WritePageGuard left__right_page_guard = this->bpm_->FetchPageWrite(left_right_page_id);
     auto left_right_page = left__right_page_guard.AsMut<InternalPage>();
-    int siz = page->GetSize();
+    // 两边都不到半满,合起来不压缩也放得下
     if (is_left_sibing_coalesce) {
-      // 合并到左子树
-      for (int i = 0; i < siz; i++) {
-        // int pos = i;
-        if (i == 0) {
-          this->InsertInternalAValue(left_right_page,
-                                     std::make_pair(parent_internal_page->KeyAt(parent.second), page->ValueAt(i)),
-                                     left_right_page->GetSize());
-        } else {
-          this->InsertInternalAValue(left_right_page, std::make_pair(page->KeyAt(i), page->ValueAt(i)),
-                                     left_right_page->GetSize());
-        }
-      }
+      // 合并到左子树,page的第0个孩子用父亲里的分隔键
+      auto merged = left_right_page->GetEntries();
+      auto entries = page->GetEntries();
+      entries[0].first = parent_internal_page->KeyAt(parent.second);
+      merged.insert(merged.end(), entries.begin(), entries.end());
+      BUSTUB_ENSURE(left_right_page->SetEntries(merged), "coalesced internal page does not fit");
     } else {
       // 合并到右子树
-      left_right_page->SetKeyAt(0, parent_internal_page->KeyAt(parent.second + 1));
-      for (int i = siz - 1; i >= 0; i--) {
-        this->InsertInternalAValue(left_right_page, std::make_pair(page->KeyAt(i), page->ValueAt(i)), 0);
-      }
+      auto merged = page->GetEntries();
+      auto entries = left_right_page->GetEntries();
+      entries[0].first = parent_internal_page->KeyAt(parent.second + 1);
+      merged.insert(merged.end(), entries.begin(), entries.end());
+      BUSTUB_ENSURE(left_right_page->SetEntries(merged), "coalesced internal page does not fit");
     }
     // 将父亲结点对应位置的值删除
     // 这里需不需要调用this->bpm_->DeletePage()清除孩子结点占用的page?不过这里应该清除不了,得去外面清除需要考虑一下
@@ -609,31 +944,320 @@ auto BPLUSTREE_TYPE::BorrowOrCoalesceInternalPage(InternalPage *page, page_id_t
     return true;
   }
   // 说明这时候可以借一个数
+  // page不到半满,借来的一个孩子一定放得下;上移的分隔键让父亲放不下时就不借了,让page先不满着
   auto left_right_page = sibing_that_can_give_key[0].AsMut<InternalPage>();
   if (is_left_sibing_ok) {
-    // 首先将父亲的Key值传给page的首元素
-    page->SetKeyAt(0, parent_internal_page->KeyAt(parent.second));
-    // 再将左兄弟的最后一个Key值覆盖到父亲结点
-    parent_internal_page->SetKeyAt(parent.second, left_right_page->KeyAt(left_right_page->GetSize() - 1));
-    // 最后再插入
-    this->InsertInternalAValue(page,
-                               std::make_pair(left_right_page->KeyAt(left_right_page->GetSize() - 1),
-                                              left_right_page->ValueAt(left_right_page->GetSize() - 1)),
-                               0);
-
-    left_right_page->DeleteAValue(left_right_page->GetSize() - 1);
+    int last = left_right_page->GetSize() - 1;
+    // 左兄弟的最后一个Key值覆盖到父亲结点
+    KeyType separator = parent_internal_page->KeyAt(parent.second);
+    if (!parent_internal_page->SetKeyAt(parent.second, left_right_page->KeyAt(last))) {
+      return false;
+    }
+    // 父亲原来的Key值跟着page原来的首元素,左兄弟的最后一个孩子成为新的首元素
+    auto entries = page->GetEntries();
+    entries[0].first = separator;
+    entries.insert(entries.begin(), std::make_pair(left_right_page->KeyAt(last), left_right_page->ValueAt(last)));
+    BUSTUB_ENSURE(page->SetEntries(entries), "borrowing internal page does not fit");
+
+    left_right_page->DeleteAValue(last);
   } else {
-    this->InsertInternalAValue(
-        page, std::make_pair(parent_internal_page->KeyAt(parent.second + 1), left_right_page->ValueAt(0)),
-        page->GetSize());
+    KeyType separator = parent_internal_page->KeyAt(parent.second + 1);
+    if (!parent_internal_page->SetKeyAt(parent.second + 1, left_right_page->KeyAt(1))) {
+      return false;
+    }
+    this->InsertInternalAValue(page, std::make_pair(separator, left_right_page->ValueAt(0)), page->GetSize());
 
     left_right_page->DeleteAValue(0);
-
-    parent_internal_page->SetKeyAt(parent.second + 1, left_right_page->KeyAt(0));
   }
   return false;
 }
 
+/*****************************************************************************
+ * LAZY DELETE AND COMPACTION
+ *****************************************************************************/
+/*
+ * Remove without rebalancing. Internal pages are only read latched and the
+ * siblings of the leaf are never touched, an underfull or even empty leaf
+ * stays in the tree. Leaves that drop below a quarter of their capacity are
+ * counted, and every BPLUSTREE_COMPACT_TRIGGER of them wake up the compactor.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::RemoveLazily(const KeyType &key) -> bool {
+  ReadPageGuard header_guard = this->bpm_->FetchPageRead(this->header_page_id_);
+  page_id_t page_id = header_guard.As<BPlusTreeHeaderPage>()->root_page_id_;
+  if (page_id == INVALID_PAGE_ID) {
+    return false;
+  }
+  ReadPageGuard parent_guard;
+  ReadPageGuard now_page_guard = this->bpm_->FetchPageRead(page_id);
+  while (!now_page_guard.As<BPlusTreePage>()->IsLeafPage()) {
+    auto now_internal_page = now_page_guard.As<InternalPage>();
+    int key_index = now_internal_page->UpperBound(key, this->comparator_) - 1;
+    page_id = now_internal_page->ValueAt(key_index);
+    parent_guard = std::move(now_page_guard);
+    now_page_guard = this->bpm_->FetchPageRead(page_id);
+  }
+  // 读锁换成写锁,中间放掉的这一下叶子不会被分裂或者合并掉:header的读锁挡住插入,
+  // 父亲的读锁挡住压缩线程,它要拿着父亲的写锁才能把这个叶子合并掉
+  now_page_guard.Drop();
+  WritePageGuard leaf_guard = this->bpm_->FetchPageWrite(page_id);
+  auto leaf_page = leaf_guard.AsMut<LeafPage>();
+  int delete_index = leaf_page->LowerBound(key, this->comparator_);
+  if (delete_index == leaf_page->GetSize() || this->comparator_(leaf_page->KeyAt(delete_index), key) != 0) {
+    return false;
+  }
+  leaf_page->DeleteAValue(delete_index);
+  // 刚好掉到稀疏线以下时把删掉的key记下来,压缩线程顺着它找回这个叶子;同一个叶子继续删不会重复记
+  int sparse_size = std::max(leaf_page->GetMinSize() / 2, 1);
+  if (leaf_page->GetSize() != sparse_size - 1) {
+    return true;
+  }
+  leaf_guard.Drop();
+  header_guard.Drop();
+  bool wake_compactor;
+  {
+    std::lock_guard<std::mutex> lock(compactor_latch_);
+    sparse_nodes_.emplace_back(key, 0);
+    wake_compactor = sparse_nodes_.size() >= BPLUSTREE_COMPACT_TRIGGER;
+  }
+  if (wake_compactor) {
+    this->RequestCompaction();
+  }
+  return true;
+}
+
+/*
+ * Merge the nodes recorded as sparse with their siblings and shrink the height.
+ * Every node is merged locally under its write-latched parent, see
+ * CompactNode, the header is only write-latched to collapse the root. Nodes
+ * that are busy go back to the list for the next call.
+ * @return : false if some recorded node was left for later
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::Compact() -> bool {
+  std::unique_lock<std::mutex> compact_lock(compact_latch_, std::try_to_lock);
+  if (!compact_lock.owns_lock()) {
+    return false;
+  }
+  std::deque<std::pair<KeyType, int>> nodes;
+  {
+    std::lock_guard<std::mutex> lock(compactor_latch_);
+    nodes.swap(sparse_nodes_);
+  }
+  std::deque<std::pair<KeyType, int>> busy_nodes;
+  while (!nodes.empty()) {
+    auto [key, level] = nodes.front();
+    nodes.pop_front();
+    if (!this->CompactNode(key, level, &nodes)) {
+      busy_nodes.emplace_back(key, level);
+    }
+  }
+  if (!busy_nodes.empty()) {
+    std::lock_guard<std::mutex> lock(compactor_latch_);
+    sparse_nodes_.insert(sparse_nodes_.begin(), busy_nodes.begin(), busy_nodes.end());
+  }
+  if (resident_levels_ > 0 && resident_stale_) {
+    this->RefreshResidentPages();
+  }
+  return busy_nodes.empty();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::CompactNode(const KeyType &key, int level, std::deque<std::pair<KeyType, int>> *nodes) -> bool {
+  // 合并内部结点要删页,常驻的内部结点都pin着,先放掉。点查询全程拿着resident_latch_的读锁,这里只试一下
+  std::unique_lock<std::shared_mutex> resident_lock(resident_latch_, std::defer_lock);
+  if (level > 0) {
+    if (!resident_lock.try_lock()) {
+      return false;
+    }
+    this->ReleaseResidentPages();
+    resident_stale_ = true;
+  }
+  // header的读锁挡住插入,树的结构只有压缩线程会改,所以沿着key记下的路径在放掉读锁以后也还是对的
+  ReadPageGuard header_guard = this->bpm_->FetchPageRead(this->header_page_id_);
+  page_id_t root_page_id = header_guard.As<BPlusTreeHeaderPage>()->root_page_id_;
+  if (root_page_id == INVALID_PAGE_ID) {
+    return true;
+  }
+  std::vector<page_id_t> path{root_page_id};
+  {
+    ReadPageGuard now_page_guard = this->bpm_->FetchPageRead(root_page_id);
+    while (!now_page_guard.As<BPlusTreePage>()->IsLeafPage()) {
+      auto now_internal_page = now_page_guard.As<InternalPage>();
+      path.push_back(now_internal_page->ValueAt(now_internal_page->UpperBound(key, this->comparator_) - 1));
+      now_page_guard = this->bpm_->FetchPageRead(path.back());
+    }
+  }
+  int depth = static_cast<int>(path.size()) - 1 - level;
+  if (depth <= 0) {
+    // 要处理的是根,只有换根才拿header的写锁
+    header_guard.Drop();
+    return this->CollapseRoot();
+  }
+  // 父亲拿到写锁以后就放掉header,插入走到这个父亲时会等着,树的其余部分照常读写
+  page_id_t node_page_id = path[depth];
+  WritePageGuard parent_guard = this->bpm_->FetchPageWrite(path[depth - 1]);
+  header_guard.Drop();
+  auto parent_page = parent_guard.AsMut<InternalPage>();
+  int index = parent_page->UpperBound(key, this->comparator_) - 1;
+  if (parent_page->ValueAt(index) != node_page_id) {
+    return true;
+  }
+
+  // 先和左兄弟合并,合并后的结点再接着吞掉右边的兄弟。孩子的锁只试一下,
+  // 迭代器拿着叶子的读锁时可能还会去读这个父亲
+  int left = std::max(index - 1, 0);
+  std::optional<WritePageGuard> left_guard = this->bpm_->TryFetchPageWrite(parent_page->ValueAt(left));
+  if (!left_guard.has_value()) {
+    return false;
+  }
+  bool busy = false;
+  while (left + 1 < parent_page->GetSize()) {
+    std::optional<WritePageGuard> right_guard = this->bpm_->TryFetchPageWrite(parent_page->ValueAt(left + 1));
+    if (!right_guard.has_value()) {
+      busy = true;
+      break;
+    }
+    KeyType separator = parent_page->KeyAt(left + 1);
+    if (this->MergeSiblings(parent_page, left, &*left_guard, &*right_guard)) {
+      page_id_t right_page_id = right_guard->PageId();
+      right_guard.reset();
+      this->bpm_->DeletePage(right_page_id);
+      if (level > 0) {
+        // 两个内部结点合并以后,原来隔着的两个孩子成了兄弟,接缝处的孩子也查一遍
+        nodes->emplace_back(separator, level - 1);
+      }
+      continue;
+    }
+    if (left >= index) {
+      break;
+    }
+    left_guard = std::move(right_guard);
+    left++;
+  }
+  left_guard.reset();
+  // 父亲变稀疏了就接着往上处理,根只剩一个孩子时树矮一层
+  bool parent_is_root = depth == 1;
+  if (parent_is_root ? parent_page->GetSize() == 1 : parent_page->GetSize() < parent_page->GetMinSize()) {
+    nodes->emplace_back(key, level + 1);
+  }
+  return !busy;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::CollapseRoot() -> bool {
+  std::optional<WritePageGuard> header_guard = this->bpm_->TryFetchPageWrite(this->header_page_id_);
+  if (!header_guard.has_value()) {
+    return false;
+  }
+  auto header_page = header_guard->AsMut<BPlusTreeHeaderPage>();
+  while (header_page->root_page_id_ != INVALID_PAGE_ID) {
+    page_id_t root_page_id = header_page->root_page_id_;
+    std::optional<WritePageGuard> root_guard = this->bpm_->TryFetchPageWrite(root_page_id);
+    if (!root_guard.has_value()) {
+      return false;
+    }
+    auto root_page = root_guard->AsMut<BPlusTreePage>();
+    if (root_page->IsLeafPage()) {
+      if (root_page->GetSize() == 0) {
+        // 树被删空了
+        header_page->root_page_id_ = INVALID_PAGE_ID;
+        root_guard.reset();
+        this->bpm_->DeletePage(root_page_id);
+      }
+      break;
+    }
+    auto root_internal_page = reinterpret_cast<InternalPage *>(root_page);
+    if (root_internal_page->GetSize() != 1) {
+      break;
+    }
+    // 根只剩一个孩子,树矮一层
+    header_page->root_page_id_ = root_internal_page->ValueAt(0);
+    root_guard.reset();
+    this->bpm_->DeletePage(root_page_id);
+    resident_stale_ = true;
+  }
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::MergeSiblings(InternalPage *parent, int index, WritePageGuard *left_guard,
+                                   WritePageGuard *right_guard) -> bool {
+  if (left_guard->As<BPlusTreePage>()->IsLeafPage()) {
+    auto left_leaf_page = left_guard->AsMut<LeafPage>();
+    auto right_leaf_page = right_guard->AsMut<LeafPage>();
+    if (left_leaf_page->GetSize() >= left_leaf_page->GetMinSize() &&
+        right_leaf_page->GetSize() >= right_leaf_page->GetMinSize()) {
+      return false;
+    }
+    // 叶子插入后等于最大值就会分裂,合并后要严格小于最大值
+    if (left_leaf_page->GetSize() + right_leaf_page->GetSize() >= leaf_max_size_) {
+      return false;
+    }
+    auto merged = left_leaf_page->GetEntries();
+    auto entries = right_leaf_page->GetEntries();
+    merged.insert(merged.end(), entries.begin(), entries.end());
+    // 压缩后的键放不下也不合并
+    if (!left_leaf_page->SetEntries(merged)) {
+      return false;
+    }
+    left_leaf_page->SetNextPageId(right_leaf_page->GetNextPageId());
+  } else {
+    auto left_internal_page = left_guard->AsMut<InternalPage>();
+    auto right_internal_page = right_guard->AsMut<InternalPage>();
+    if (left_internal_page->GetSize() >= left_internal_page->GetMinSize() &&
+        right_internal_page->GetSize() >= right_internal_page->GetMinSize()) {
+      return false;
+    }
+    if (left_internal_page->GetSize() + right_internal_page->GetSize() > internal_max_size_) {
+      return false;
+    }
+    auto merged = left_internal_page->GetEntries();
+    auto entries = right_internal_page->GetEntries();
+    // 右兄弟的第0个孩子没有键,用父亲里的分隔键
+    entries[0].first = parent->KeyAt(index + 1);
+    merged.insert(merged.end(), entries.begin(), entries.end());
+    if (!left_internal_page->SetEntries(merged)) {
+      return false;
+    }
+  }
+  parent->DeleteAValue(index + 1);
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::RequestCompaction() {
+  std::lock_guard<std::mutex> lock(compactor_latch_);
+  if (stop_compactor_) {
+    return;
+  }
+  compact_requested_ = true;
+  if (!compactor_.joinable()) {
+    compactor_ = std::thread([this] { this->CompactorLoop(); });
+  }
+  compactor_cv_.notify_one();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::CompactorLoop() {
+  std::unique_lock<std::mutex> lock(compactor_latch_);
+  while (true) {
+    compactor_cv_.wait(lock, [this] { return stop_compactor_ || compact_requested_; });
+    if (stop_compactor_) {
+      return;
+    }
+    compact_requested_ = false;
+    lock.unlock();
+    bool done = this->Compact();
+    lock.lock();
+    if (!done && !stop_compactor_) {
+      // 树正忙,过一会儿再试
+      compact_requested_ = true;
+      compactor_cv_.wait_for(lock, std::chrono::milliseconds(10), [this] { return stop_compactor_; });
+    }
+  }
+}
+
 /*****************************************************************************
  * INDEX ITERATOR
  *****************************************************************************/
@@ -665,18 +1289,12 @@ auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE {
 }
 
 /*
- * Input parameter is low key, find the leaf page that contains the input key
- * first, then construct index iterator
+ * Input parameter is low key, find the leaf page that contains the first key
+ * which is not less than the input key, then construct index iterator
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE {
-  auto cmp_func = [&](const MappingType &a, const MappingType &b) -> bool {
-    return static_cast<bool>(this->comparator_(a.first, b.first) == -1);
-  };
-  auto internal_cmp_func = [&](const std::pair<KeyType, page_id_t> &a, const std::pair<KeyType, page_id_t> &b) -> bool {
-    return static_cast<bool>(this->comparator_(a.first, b.first) == -1);
-  };
   ReadPageGuard root_guard = bpm_->FetchPageRead(header_page_id_);
   auto root_page = root_guard.As<BPlusTreeHeaderPage>();
   if (root_page->root_page_id_ == INVALID_PAGE_ID) {
@@ -690,29 +1308,59 @@ auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE {
   while (!now_page->IsLeafPage()) {
     auto now_internal_page = now_page_guard.As<BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator>>();
 
-    auto now_internal_page_array = now_internal_page->GetArray();
-    auto key_pos = std::upper_bound(now_internal_page_array + 1, now_internal_page_array + now_internal_page->GetSize(),
-                                    std::make_pair(key, now_internal_page_array[0].second), internal_cmp_func) -
-                   1;
-    int key_index = key_pos - now_internal_page_array;
+    // 这里用lower_bound而不是upper_bound:key可能是只给出前缀的复合键(后面的列为NULL,和任何值比较都相等),
+    // 和它"相等"的键可能落在分隔键左边的子树里,所以要走到最后一个严格小于key的分隔键对应的孩子
+    int key_index = now_internal_page->LowerBound(key, comparator_) - 1;
     page_id = now_internal_page->ValueAt(key_index);
     now_page_guard = bpm_->FetchPageRead(page_id);
     now_page = now_page_guard.As<BPlusTreePage>();
   }
 
   auto now_leaf_page = now_page_guard.As<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>();
-  auto now_leaf_page_array = now_leaf_page->GetArray();
-  auto key_itr = std::lower_bound(now_leaf_page_array, now_leaf_page_array + now_leaf_page->GetSize(),
-                                  std::make_pair(key, now_leaf_page_array[0].second), cmp_func);
-  int key_index = key_itr - now_leaf_page_array;
+  int key_index = now_leaf_page->LowerBound(key, comparator_);
   if (key_index >= now_leaf_page->GetSize()) {
-    return End();
-  }
-  if (this->comparator_(now_leaf_page_array[key_index].first, key) == 0) {
-    // return INDEXITERATOR_TYPE(bpm_, std::move(now_page_guard), std::move(root_guard), key_index);
-    return INDEXITERATOR_TYPE(bpm_, std::move(now_page_guard), key_index);
+    // 当前叶子里的键都比key小,第一个不小于key的键就是下一个叶子的第一个键
+    page_id_t next_page_id = now_leaf_page->GetNextPageId();
+    if (next_page_id == INVALID_PAGE_ID) {
+      return End();
+    }
+    now_page_guard = bpm_->FetchPageRead(next_page_id);
+    key_index = 0;
   }
-  return End();
+  // return INDEXITERATOR_TYPE(bpm_, std::move(now_page_guard), std::move(root_guard), key_index);
+  return INDEXITERATOR_TYPE(bpm_, std::move(now_page_guard), key_index);
+}
+
+/*
+ * Input parameter is low key and high key, the returned iterator starts at the
+ * first key not less than key and becomes End() once it passes stop_key
+ * @return : index iterator
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::Begin(const KeyType &key, const KeyType &stop_key, bool stop_inclusive) -> INDEXITERATOR_TYPE {
+  auto iter = Begin(key);
+  iter.SetStopKey(stop_key, stop_inclusive, &comparator_);
+  return iter;
+}
+
+/*
+ * Input parameter is void, find the rightmost leaf page first, then construct
+ * a reverse index iterator
+ * @return : index iterator
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::RBegin() -> INDEXITERATOR_TYPE {
+  return INDEXITERATOR_TYPE(bpm_, header_page_id_, &comparator_, std::nullopt);
+}
+
+/*
+ * Input parameter is high key, find the leaf page that contains the last key
+ * not greater than the input key, then construct a reverse index iterator
+ * @return : index iterator
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::RBegin(const KeyType &key) -> INDEXITERATOR_TYPE {
+  return INDEXITERATOR_TYPE(bpm_, header_page_id_, &comparator_, key);
 }
 
 /*
@@ -932,107 +1580,37 @@ auto BPLUSTREE_TYPE::DrawBPlusTree() -> std::string {
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::InsertLeafAValue(LeafPage *pages, const MappingType &value, int pos) {
-  std::vector<MappingType> move_to_right;
-  auto page_array = pages->GetArray();
-  for (int i = pos; i < pages->GetSize(); i++) {
-    move_to_right.push_back(page_array[i]);
-  }
-  pages->SetArrayAt(pos, std::move(std::make_pair(value.first, value.second)));
-  pages->IncreaseSize(1);
-  int new_start_index = pos + 1;
-  for (int i = new_start_index; i < pages->GetSize(); i++) {
-    pages->SetArrayAt(i, std::move(move_to_right[i - new_start_index]));
-  }
+auto BPLUSTREE_TYPE::InsertLeafAValue(LeafPage *pages, const MappingType &value, int pos) -> bool {
+  return pages->InsertAt(pos, value.first, value.second);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::InsertInternalAValue(InternalPage *pages, const std::pair<KeyType, page_id_t> &value, int pos) {
-  std::vector<std::pair<KeyType, page_id_t>> move_to_right;
-  // std::vector <MappingType> move_to_right;
-  auto page_array = pages->GetArray();
-  for (int i = pos; i < pages->GetSize(); i++) {
-    move_to_right.push_back(page_array[i]);
-  }
-  pages->SetArrayAt(pos, std::move(std::make_pair(value.first, value.second)));
-  pages->IncreaseSize(1);
-  int new_start_index = pos + 1;
-  for (int i = new_start_index; i < pages->GetSize(); i++) {
-    pages->SetArrayAt(i, std::move(move_to_right[i - new_start_index]));
-  }
+auto BPLUSTREE_TYPE::InsertInternalAValue(InternalPage *pages, const std::pair<KeyType, page_id_t> &value, int pos)
+    -> bool {
+  return pages->InsertAt(pos, value.first, value.second);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::DealWithInternalSplit(InternalPage *pages, int key_index, const KeyType &key,
                                            const std::pair<page_id_t, page_id_t> &left_right_son, KeyType &key_to_push,
-                                           std::pair<page_id_t, page_id_t> &left_right_son_to_push) {
-  std::vector<std::pair<KeyType, page_id_t>> prime_internal_page;
-  auto pages_array = pages->GetArray();
+                                           std::pair<page_id_t, page_id_t> &left_right_son_to_push,
+                                           bool append_split) {
+  std::vector<std::pair<KeyType, page_id_t>> prime_internal_page = pages->GetEntries();
   page_id_t new_right_page_id = -233;
   this->BuildNewPage(&new_right_page_id, IndexPageType::INTERNAL_PAGE);
   WritePageGuard new_right_page_guard = this->bpm_->FetchPageWrite(new_right_page_id);
   auto new_right_page = new_right_page_guard.AsMut<InternalPage>();
-  for (int i = 0; i < pages->GetSize(); i++) {
-    if (i == key_index) {
-      prime_internal_page.push_back(std::make_pair(key, left_right_son.second));
-    }
-    prime_internal_page.push_back(pages_array[i]);
-  }
-  if (key_index == pages->GetSize()) {
-    // 这种情况要插入到最后面
-    prime_internal_page.push_back(std::make_pair(key, left_right_son.second));
-  }
+  prime_internal_page.insert(prime_internal_page.begin() + key_index, std::make_pair(key, left_right_son.second));
   int siz = prime_internal_page.size();
-  key_to_push = prime_internal_page[siz / 2].first;
-  pages->SetSize(siz / 2);
-  for (int i = 0; i < pages->GetSize(); i++) {
-    pages->SetArrayAt(i, prime_internal_page[i]);
-  }
-  int new_start_index = siz / 2;
-  // 这里new_right_page的第一个key应该要设个非法值
-  // new_right_page->SetKeyAt(0,0);  //但是不知道怎么设置
-  new_right_page->SetValueAt(0, prime_internal_page[new_start_index].second);
-  for (int i = new_start_index + 1; i < siz; i++) {
-    new_right_page->SetArrayAt(i - new_start_index, prime_internal_page[i]);
-  }
-  new_right_page->SetSize(siz - pages->GetSize());
-  // left_right_son_to_push.first =  //这个地方还拿不到,只有在函数外面拿,我写的锅
-  left_right_son_to_push.second = new_right_page_id;
-}
-
-INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::DealWithLeafSplit(LeafPage *pages, int key_index, const KeyType &key, const ValueType &value,
-                                       KeyType &key_to_push, std::pair<page_id_t, page_id_t> &left_right_son_to_push) {
-  std::vector<MappingType> prime_internal_page;
-  auto pages_array = pages->GetArray();
-  page_id_t new_right_page_id = -233;
-  this->BuildNewPage(&new_right_page_id, IndexPageType::LEAF_PAGE);
-  WritePageGuard new_right_page_guard = this->bpm_->FetchPageWrite(new_right_page_id);
-  auto new_right_page = new_right_page_guard.AsMut<LeafPage>();
-  for (int i = 0; i < pages->GetSize(); i++) {
-    if (i == key_index) {
-      prime_internal_page.push_back(std::make_pair(key, value));
-    }
-    prime_internal_page.push_back(pages_array[i]);
-  }
-  if (key_index == pages->GetSize()) {
-    // 这种情况要插入到最后面
-    prime_internal_page.push_back(std::make_pair(key, value));
-  }
-  int siz = prime_internal_page.size();
-  key_to_push = prime_internal_page[siz / 2].first;
-  pages->SetSize(siz / 2);
-  for (int i = 0; i < pages->GetSize(); i++) {
-    pages->SetArrayAt(i, prime_internal_page[i]);
-  }
-  int new_start_index = siz / 2;
-
-  // new_right_page->SetKeyAt(0,0);  //但是不知道怎么设置
-  // new_right_page->SetValueAt(0, prime_internal_page[new_start_index].second);
-  for (int i = new_start_index; i < siz; i++) {
-    new_right_page->SetArrayAt(i - new_start_index, prime_internal_page[i]);
-  }
-  new_right_page->SetSize(siz - pages->GetSize());
+  // 最右边追加时右边只留两个孩子,其余都留在左边
+  int new_start_index = append_split ? std::max(siz / 2, siz - 2) : siz / 2;
+  key_to_push = prime_internal_page[new_start_index].first;
+  // 右边的第一个key是非法值,SetEntries不会用它;两半都放得下,要么不超过不压缩时一页的容量,要么是原来的一部分
+  std::vector<std::pair<KeyType, page_id_t>> move_to_right(prime_internal_page.begin() + new_start_index,
+                                                           prime_internal_page.end());
+  prime_internal_page.resize(new_start_index);
+  BUSTUB_ENSURE(pages->SetEntries(prime_internal_page), "left half of an internal split does not fit");
+  BUSTUB_ENSURE(new_right_page->SetEntries(move_to_right), "right half of an internal split does not fit");
   // left_right_son_to_push.first =  //这个地方还拿不到,只有在函数外面拿,我写的锅
   left_right_son_to_push.second = new_right_page_id;
 }
@@ -1048,8 +1626,145 @@ void BPLUSTREE_TYPE::BuildNewPage(page_id_t *page_id, IndexPageType page_type) {
     if (page_type == IndexPageType::INTERNAL_PAGE) {
       auto *new_page = new_page_guard.AsMut<InternalPage>();
       new_page->Init(this->internal_max_size_);
+      // 新的内部结点可能落在常驻的那几层里
+      resident_stale_ = true;
+    }
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FetchNodeRead(page_id_t page_id) -> ReadPageGuard {
+  auto itr = this->resident_pages_.find(page_id);
+  if (itr == this->resident_pages_.end()) {
+    return this->bpm_->FetchPageRead(page_id);
+  }
+  // 不经过缓冲池,guard里不带bpm_,Drop的时候只放锁不unpin
+  itr->second->RLatch();
+  return {nullptr, itr->second};
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::RefreshResidentPages() {
+  std::unique_lock<std::shared_mutex> lock(resident_latch_);
+  this->ReleaseResidentPages();
+  resident_stale_ = false;
+
+  // 每个索引各自只看缓冲池大小的话,索引一多就能把整个缓冲池pin满,所以先从缓冲池共用的预算里申请
+  if (!this->bpm_->ReserveResidentFrames(1)) {
+    return;
+  }
+  Page *header_frame = this->bpm_->FetchPage(this->header_page_id_);
+  if (header_frame == nullptr) {
+    this->bpm_->ReleaseResidentFrames(1);
+    return;
+  }
+  this->resident_pages_.emplace(this->header_page_id_, header_frame);
+  header_frame->RLatch();
+  page_id_t root_page_id = reinterpret_cast<const BPlusTreeHeaderPage *>(header_frame->GetData())->root_page_id_;
+  header_frame->RUnlatch();
+
+  // 一层一层往下放,某一层放不下了就整层都不放;叶子结点变化太频繁,不常驻
+  std::vector<page_id_t> level;
+  if (root_page_id != INVALID_PAGE_ID) {
+    level.push_back(root_page_id);
+  }
+  for (int depth = 0; depth < this->resident_levels_ && !level.empty(); depth++) {
+    if (!this->bpm_->ReserveResidentFrames(level.size())) {
+      break;
+    }
+    // 没能常驻的结点把预算退回去
+    size_t unused = 0;
+    std::vector<page_id_t> next_level;
+    for (auto page_id : level) {
+      Page *frame = this->bpm_->FetchPage(page_id);
+      if (frame == nullptr) {
+        unused++;
+        continue;
+      }
+      frame->RLatch();
+      auto node = reinterpret_cast<const BPlusTreePage *>(frame->GetData());
+      if (node->IsLeafPage()) {
+        frame->RUnlatch();
+        this->bpm_->UnpinPage(page_id, false);
+        unused++;
+        continue;
+      }
+      auto internal_node = reinterpret_cast<const InternalPage *>(node);
+      for (int i = 0; i < internal_node->GetSize(); i++) {
+        next_level.push_back(internal_node->ValueAt(i));
+      }
+      frame->RUnlatch();
+      this->resident_pages_.emplace(page_id, frame);
     }
+    this->bpm_->ReleaseResidentFrames(unused);
+    level = std::move(next_level);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::GetShape() -> BPlusTreeShape {
+  BPlusTreeShape shape;
+  page_id_t root_page_id;
+  {
+    ReadPageGuard header_guard = this->bpm_->FetchPageRead(this->header_page_id_);
+    root_page_id = header_guard.As<BPlusTreeHeaderPage>()->root_page_id_;
+  }
+  if (root_page_id == INVALID_PAGE_ID) {
+    return shape;
+  }
+
+  // 一层一层往下数内部结点,数到最后一层内部结点时,它们的孩子数加起来就是叶子数,叶子本身不用读
+  std::vector<page_id_t> level{root_page_id};
+  while (!level.empty()) {
+    shape.height_++;
+    std::vector<page_id_t> next_level;
+    bool children_are_leaves = false;
+    for (auto page_id : level) {
+      ReadPageGuard guard = this->bpm_->FetchPageRead(page_id);
+      auto node = guard.As<BPlusTreePage>();
+      if (node->IsLeafPage()) {
+        // 只有根是叶子的时候才会走到这里
+        shape.leaf_pages_++;
+        continue;
+      }
+      shape.internal_pages_++;
+      auto internal_node = guard.As<InternalPage>();
+      if (internal_node->GetSize() == 0) {
+        continue;
+      }
+      if (!children_are_leaves && next_level.empty()) {
+        // 同一层的结点深度相同,看第一个孩子是不是叶子就知道下一层是不是叶子层
+        ReadPageGuard child_guard = this->bpm_->FetchPageRead(internal_node->ValueAt(0));
+        children_are_leaves = child_guard.As<BPlusTreePage>()->IsLeafPage();
+      }
+      if (children_are_leaves) {
+        shape.leaf_pages_ += internal_node->GetSize();
+        continue;
+      }
+      for (int i = 0; i < internal_node->GetSize(); i++) {
+        next_level.push_back(internal_node->ValueAt(i));
+      }
+    }
+    if (children_are_leaves) {
+      shape.height_++;
+      break;
+    }
+    level = std::move(next_level);
+  }
+  return shape;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ReleaseResidentPages() {
+  // 没有常驻页就不碰bpm,树可能比bpm活得久
+  if (this->resident_pages_.empty()) {
+    return;
+  }
+  for (const auto &resident_page : this->resident_pages_) {
+    this->bpm_->UnpinPage(resident_page.first, false);
   }
+  this->bpm_->ReleaseResidentFrames(this->resident_pages_.size());
+  this->resident_pages_.clear();
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -10,47 +10,271 @@
 //===----------------------------------------------------------------------===//
 
 #include "storage/index/b_plus_tree_index.h"
+#include "fmt/format.h"
+#include "type/value_factory.h"
 
 namespace bustub {
+
+static auto MakeTreeKeySchema(const IndexMetadata &metadata, bool with_include) -> std::unique_ptr<Schema> {
+  std::vector<Column> columns = metadata.GetKeySchema()->GetColumns();
+  if (!metadata.IsUnique()) {
+    columns.emplace_back("__rid", TypeId::BIGINT);
+  }
+  if (with_include) {
+    const auto &entry_columns = metadata.GetEntrySchema()->GetColumns();
+    columns.insert(columns.end(), entry_columns.begin() + metadata.GetIndexColumnCount(), entry_columns.end());
+  }
+  return std::make_unique<Schema>(columns);
+}
+
 /*
  * Constructor
  */
 INDEX_TEMPLATE_ARGUMENTS
-BPLUSTREE_INDEX_TYPE::BPlusTreeIndex(std::unique_ptr<IndexMetadata> &&metadata, BufferPoolManager *buffer_pool_manager)
-    : Index(std::move(metadata)), comparator_(GetMetadata()->GetKeySchema()) {
+BPLUSTREE_INDEX_TYPE::BPlusTreeIndex(std::unique_ptr<IndexMetadata> &&metadata, BufferPoolManager *buffer_pool_manager,
+                                     bool use_key_filter)
+    : Index(std::move(metadata)),
+      tree_key_schema_(MakeTreeKeySchema(*GetMetadata(), true)),
+      compare_key_schema_(MakeTreeKeySchema(*GetMetadata(), false)),
+      comparator_(compare_key_schema_.get(), tree_key_schema_.get()),
+      stats_(GetIndexColumnCount()) {
   page_id_t header_page_id;
   buffer_pool_manager->NewPage(&header_page_id);
-  container_ = std::make_shared<BPlusTree<KeyType, ValueType, KeyComparator>>(GetMetadata()->GetName(), header_page_id,
-                                                                              buffer_pool_manager, comparator_);
+  buffer_pool_manager->UnpinPage(header_page_id, true);
+  container_ = std::make_shared<BPlusTree<KeyType, ValueType, KeyComparator>>(
+      GetMetadata()->GetName(), header_page_id, buffer_pool_manager, comparator_, LEAF_PAGE_SIZE, INTERNAL_PAGE_SIZE,
+      BPLUSTREE_RESIDENT_LEVELS, BPLUSTREE_LAZY_DELETE);
+  if (use_key_filter) {
+    key_filter_ = std::make_unique<IndexKeyFilter>(GetIndexColumnCount(),
+                                                   [this](const auto &callback) { ScanEntries(callback); });
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::MakeTreeKey(const Tuple &key, const RID *rid, bool is_entry) const -> KeyType {
+  KeyType index_key;
+  const Schema *entry_schema = GetEntrySchema();
+  uint32_t key_column_count = GetIndexColumnCount();
+  if (IsUnique() && entry_schema->GetColumnCount() == key_column_count) {
+    SetTreeKey(&index_key, key);
+    if (rid == nullptr) {
+      index_key.SetNullsAsWildcards(*tree_key_schema_);
+    }
+    return index_key;
+  }
+  // 除了唯一索引,树里存的key都要按tree_key_schema_重新排列: 键列,RID列,include列
+  const Schema *key_schema = is_entry ? entry_schema : GetKeySchema();
+  std::vector<Value> values;
+  values.reserve(tree_key_schema_->GetColumnCount());
+  for (uint32_t i = 0; i < key_column_count; i++) {
+    values.push_back(key.GetValue(key_schema, i));
+  }
+  if (!IsUnique()) {
+    values.push_back(rid == nullptr ? ValueFactory::GetNullValueByType(TypeId::BIGINT)
+                                    : ValueFactory::GetBigIntValue(rid->Get()));
+  }
+  for (uint32_t i = key_column_count; i < entry_schema->GetColumnCount(); i++) {
+    values.push_back(is_entry ? key.GetValue(entry_schema, i)
+                              : ValueFactory::GetNullValueByType(entry_schema->GetColumn(i).GetType()));
+  }
+  SetTreeKey(&index_key, Tuple(values, tree_key_schema_.get()));
+  if (rid == nullptr) {
+    // 查找用的key里NULL都是补上去的列(没给出的键列、RID列、include列),去掉NULL标记当通配符用
+    index_key.SetNullsAsWildcards(*tree_key_schema_);
+  }
+  return index_key;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::EntryFromTreeKey(const KeyType &index_key) const -> Tuple {
+  const Schema *entry_schema = GetEntrySchema();
+  uint32_t key_column_count = GetIndexColumnCount();
+  // 非唯一索引的RID列夹在键列和include列之间,要跳过去
+  uint32_t include_offset = IsUnique() ? 0 : 1;
+  std::vector<Value> values;
+  values.reserve(entry_schema->GetColumnCount());
+  for (uint32_t i = 0; i < entry_schema->GetColumnCount(); i++) {
+    values.push_back(index_key.ToValue(tree_key_schema_.get(), i < key_column_count ? i : i + include_offset));
+  }
+  return {values, entry_schema};
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::SetTreeKey(KeyType *index_key, const Tuple &key) const {
+  // SetFromKey会把整个tuple拷进定长的key里,VARCHAR超过声明的长度时key放不下,截断会让比较出错,这里直接报错
+  auto key_length = key.GetLength();
+  if (key_length > sizeof(KeyType)) {
+    throw Exception(ExceptionType::OUT_OF_RANGE,
+                    fmt::format("key of index {} is {} bytes long, which exceeds the {}-byte index key",
+                                GetMetadata()->GetName(), key_length, sizeof(KeyType)));
+  }
+  index_key->SetFromKey(key);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid, Transaction *transaction) -> bool {
   // construct insert index key
-  KeyType index_key;
-  index_key.SetFromKey(key);
+  KeyType index_key = MakeTreeKey(key, &rid, true);
+
+  bool inserted;
+  if (key_filter_ == nullptr) {
+    inserted = container_->Insert(index_key, rid, transaction);
+  } else {
+    inserted =
+        key_filter_->Insert(key, GetEntrySchema(), [&] { return container_->Insert(index_key, rid, transaction); });
+  }
+  if (inserted) {
+    stats_.Insert(key, GetEntrySchema());
+  }
+  return inserted;
+}
 
-  return container_->Insert(index_key, rid, transaction);
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::BulkLoad(const std::function<bool(Tuple *key, RID *rid)> &next, Transaction *transaction) {
+  std::optional<KeyType> last_key;
+  bool loaded = container_->BulkLoad([&](KeyType *index_key, RID *value) {
+    Tuple key;
+    RID rid;
+    while (next(&key, &rid)) {
+      *index_key = MakeTreeKey(key, &rid, true);
+      // 唯一索引里重复的键和InsertEntry一样只留第一个
+      if (last_key.has_value() && comparator_(*last_key, *index_key) == 0) {
+        continue;
+      }
+      last_key = *index_key;
+      *value = rid;
+      if (key_filter_ != nullptr) {
+        key_filter_->Insert(key, GetEntrySchema(), [] { return true; });
+      }
+      stats_.Insert(key, GetEntrySchema());
+      return true;
+    }
+    return false;
+  });
+  if (!loaded) {
+    Index::BulkLoad(next, transaction);
+  }
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) {
-  // construct delete index key
-  KeyType index_key;
-  index_key.SetFromKey(key);
+  // construct delete index key, a non-unique index removes exactly the entry of this rid
+  KeyType index_key = MakeTreeKey(key, &rid);
 
-  container_->Remove(index_key, transaction);
+  if (!container_->Remove(index_key, transaction)) {
+    return;
+  }
+  if (key_filter_ != nullptr) {
+    key_filter_->Delete();
+  }
+  stats_.Delete(key, GetKeySchema());
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) {
+  if (key_filter_ != nullptr && !key_filter_->MayContain(key, GetKeySchema())) {
+    return;
+  }
+  if (!IsUnique()) {
+    // all RIDs of the key are adjacent in the tree, collect them with one range scan
+    ScanRange(&key, true, &key, true, result, transaction);
+    return;
+  }
   // construct scan index key
-  KeyType index_key;
-  index_key.SetFromKey(key);
+  KeyType index_key = MakeTreeKey(key, nullptr);
 
   container_->GetValue(index_key, result, transaction);
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *result,
+                                    Transaction *transaction) {
+  if (!IsUnique()) {
+    Index::ScanKeys(keys, result, transaction);
+    return;
+  }
+  // sort the probe keys so that the tree is walked once, then scatter the results back to the caller's order. Keys the
+  // filter rules out are not probed at all.
+  std::vector<KeyType> index_keys(keys.size());
+  std::vector<size_t> order;
+  order.reserve(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    if (key_filter_ != nullptr && !key_filter_->MayContain(keys[i], GetKeySchema())) {
+      continue;
+    }
+    index_keys[i] = MakeTreeKey(keys[i], nullptr);
+    order.push_back(i);
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [&](size_t a, size_t b) { return comparator_(index_keys[a], index_keys[b]) < 0; });
+  std::vector<KeyType> sorted_keys;
+  sorted_keys.reserve(keys.size());
+  for (auto i : order) {
+    sorted_keys.push_back(index_keys[i]);
+  }
+  std::vector<std::vector<RID>> sorted_result;
+  container_->GetValues(sorted_keys, &sorted_result, transaction);
+  result->assign(keys.size(), {});
+  for (size_t i = 0; i < order.size(); i++) {
+    (*result)[order[i]] = std::move(sorted_result[i]);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::ScanRange(const Tuple *low_key, bool low_inclusive, const Tuple *high_key,
+                                     bool high_inclusive, std::vector<RID> *result, Transaction *transaction) {
+  for (auto iter = GetRangeIterator(low_key, low_inclusive, high_key, high_inclusive); !iter.IsEnd(); ++iter) {
+    result->push_back((*iter).second);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::GetRangeIterator(const Tuple *low_key, bool low_inclusive, const Tuple *high_key,
+                                            bool high_inclusive, bool reverse) -> INDEXITERATOR_TYPE {
+  KeyType low_index_key;
+  if (low_key != nullptr) {
+    low_index_key = MakeTreeKey(*low_key, nullptr);
+  }
+  KeyType high_index_key;
+  if (high_key != nullptr) {
+    high_index_key = MakeTreeKey(*high_key, nullptr);
+  }
+  // the iterator starts at the near bound and stops at the far one
+  const Tuple *start_key = reverse ? high_key : low_key;
+  const Tuple *stop_key = reverse ? low_key : high_key;
+  const KeyType &start_index_key = reverse ? high_index_key : low_index_key;
+  bool start_inclusive = reverse ? high_inclusive : low_inclusive;
+  bool stop_inclusive = reverse ? low_inclusive : high_inclusive;
+
+  INDEXITERATOR_TYPE iter = container_->End();
+  if (reverse) {
+    iter = start_key == nullptr ? container_->RBegin() : container_->RBegin(start_index_key);
+  } else {
+    iter = start_key == nullptr ? container_->Begin() : container_->Begin(start_index_key);
+  }
+  if (stop_key != nullptr) {
+    iter.SetStopKey(reverse ? low_index_key : high_index_key, stop_inclusive, &comparator_);
+  }
+  if (start_key != nullptr && !start_inclusive) {
+    // skip the keys equal to the exclusive starting bound
+    while (!iter.IsEnd() && comparator_((*iter).first, start_index_key) == 0) {
+      ++iter;
+    }
+  }
+  return iter;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::MakeScanIterator(const Tuple *low_key, bool low_inclusive, const Tuple *high_key,
+                                            bool high_inclusive, bool reverse) -> std::unique_ptr<IndexScanIterator> {
+  if (key_filter_ != nullptr && IsPointLookup(low_key, low_inclusive, high_key, high_inclusive) &&
+      !key_filter_->MayContain(*low_key, GetKeySchema())) {
+    return std::make_unique<BPlusTreeIndexScanIterator<KeyType, ValueType, KeyComparator>>(this, GetEndIterator());
+  }
+  return std::make_unique<BPlusTreeIndexScanIterator<KeyType, ValueType, KeyComparator>>(
+      this, GetRangeIterator(low_key, low_inclusive, high_key, high_inclusive, reverse));
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_INDEX_TYPE::GetBeginIterator() -> INDEXITERATOR_TYPE { return container_->Begin(); }
 
@@ -60,6 +284,35 @@ auto BPLUSTREE_INDEX_TYPE::GetBeginIterator(const KeyType &key) -> INDEXITERATOR
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_INDEX_TYPE::GetEndIterator() -> INDEXITERATOR_TYPE { return container_->End(); }
 
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::GetStatistics(bool with_shape) -> std::optional<IndexStatistics> {
+  IndexStatistics stats;
+  stats_.Snapshot(&stats);
+  if (with_shape) {
+    auto shape = container_->GetShape();
+    stats.height_ = shape.height_;
+    stats.internal_pages_ = shape.internal_pages_;
+    stats.leaf_pages_ = shape.leaf_pages_;
+    if (shape.leaf_pages_ > 0) {
+      stats.leaf_fill_ = static_cast<double>(stats.num_entries_) /
+                         (static_cast<double>(shape.leaf_pages_) * container_->GetLeafMaxSize());
+    }
+  }
+  return stats;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::RefreshStatistics() {
+  stats_.Refresh([this](const auto &callback) { ScanEntries(callback); });
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::ScanEntries(const std::function<void(const Tuple &entry, const Schema *schema)> &callback) {
+  for (auto iter = container_->Begin(); !iter.IsEnd(); ++iter) {
+    callback(EntryFromTreeKey((*iter).first), GetEntrySchema());
+  }
+}
+
 template class BPlusTreeIndex<GenericKey<4>, RID, GenericComparator<4>>;
 template class BPlusTreeIndex<GenericKey<8>, RID, GenericComparator<8>>;
 template class BPlusTreeIndex<GenericKey<16>, RID, GenericComparator<16>>;
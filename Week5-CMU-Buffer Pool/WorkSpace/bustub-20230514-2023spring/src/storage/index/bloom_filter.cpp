@@ -0,0 +1,148 @@
+#include <algorithm>
+#include <mutex>  // NOLINT
+#include <string>
+
+#include "murmur3/MurmurHash3.h"
+#include "storage/index/bloom_filter.h"
+#include "type/type.h"
+
+namespace bustub {
+
+namespace {
+
+/** 刚建出来的filter和重建时最少按这么多键分配 */
+constexpr size_t MIN_FILTER_KEYS = 64;
+
+constexpr size_t BITS_PER_BLOCK = 512;
+constexpr uint32_t PROBE_BITS = 9;  // 2^9 = 512,一次探测在块里选一位
+
+/** 块号用哈希本身取模,块里的位从另一个散列出来的值里取,两者不相关 */
+inline auto ProbeSeed(uint64_t hash) -> uint64_t { return hash * 0x9E3779B97F4A7C15ULL; }
+
+}  // namespace
+
+auto SerializeIndexKey(const Tuple &key, const Schema *schema, uint32_t column_count, std::string *bytes,
+                       std::vector<size_t> *column_ends) -> uint32_t {
+  for (uint32_t i = 0; i < column_count; i++) {
+    Value value = key.GetValue(schema, i);
+    if (value.IsNull()) {
+      return i;
+    }
+    size_t offset = bytes->size();
+    bytes->resize(offset + (value.GetTypeId() == TypeId::VARCHAR ? sizeof(uint32_t) + value.GetLength()
+                                                                  : Type::GetTypeSize(value.GetTypeId())));
+    value.SerializeTo(bytes->data() + offset);
+    if (column_ends != nullptr) {
+      column_ends->push_back(bytes->size());
+    }
+  }
+  return column_count;
+}
+
+auto HashIndexKeyBytes(const std::string &bytes, size_t length) -> uint64_t {
+  uint64_t out[2];
+  murmur3::MurmurHash3_x64_128(bytes.data(), static_cast<int>(length), 0, out);
+  return out[0];
+}
+
+BloomFilter::BloomFilter(size_t num_keys)
+    : capacity_(num_keys),
+      blocks_(std::max<size_t>((num_keys * BLOOM_FILTER_BITS_PER_KEY + BITS_PER_BLOCK - 1) / BITS_PER_BLOCK, 1)) {}
+
+void BloomFilter::Insert(uint64_t hash) {
+  auto &block = blocks_[BlockOf(hash)];
+  uint64_t seed = ProbeSeed(hash);
+  for (uint32_t i = 0; i < PROBES; i++) {
+    uint32_t bit = (seed >> (i * PROBE_BITS)) & (BITS_PER_BLOCK - 1);
+    block.words_[bit / 64].fetch_or(1ULL << (bit % 64), std::memory_order_relaxed);
+  }
+}
+
+auto BloomFilter::MayContain(uint64_t hash) const -> bool {
+  const auto &block = blocks_[BlockOf(hash)];
+  uint64_t seed = ProbeSeed(hash);
+  for (uint32_t i = 0; i < PROBES; i++) {
+    uint32_t bit = (seed >> (i * PROBE_BITS)) & (BITS_PER_BLOCK - 1);
+    if ((block.words_[bit / 64].load(std::memory_order_relaxed) & (1ULL << (bit % 64))) == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+IndexKeyFilter::IndexKeyFilter(uint32_t key_column_count, EntryScanner scan_entries)
+    : key_column_count_(key_column_count),
+      scan_entries_(std::move(scan_entries)),
+      filter_(std::make_unique<BloomFilter>(MIN_FILTER_KEYS)) {}
+
+auto IndexKeyFilter::Insert(const Tuple &entry, const Schema *schema, const std::function<bool()> &insert) -> bool {
+  std::shared_lock lock(latch_);
+  uint64_t hash;
+  if (!HashKey(entry, schema, &hash)) {
+    // 带NULL的键查找时不过filter,不用放进去
+    return insert();
+  }
+  // 先放进filter再插入索引,filter里多一个键只是多一次误判
+  filter_->Insert(hash);
+  num_keys_++;
+  return insert();
+}
+
+void IndexKeyFilter::Delete() { num_deletes_++; }
+
+auto IndexKeyFilter::MayContain(const Tuple &key, const Schema *schema) -> bool {
+  uint64_t hash;
+  if (!HashKey(key, schema, &hash)) {
+    return true;
+  }
+  {
+    std::shared_lock lock(latch_);
+    // 删掉的项超过一半,或者插入的键超过了filter的容量,误判率都上去了,要重建
+    if (num_keys_ <= filter_->GetCapacity() && num_deletes_ * 2 <= num_keys_) {
+      return filter_->MayContain(hash);
+    }
+  }
+  {
+    // 别的线程正在重建或者插入的时候不等,旧的filter包含所有的键,用它照样是对的
+    std::unique_lock rebuild_lock(latch_, std::try_to_lock);
+    if (rebuild_lock.owns_lock()) {
+      Rebuild();
+    }
+  }
+  std::shared_lock lock(latch_);
+  return filter_->MayContain(hash);
+}
+
+auto IndexKeyFilter::GetCapacity() -> size_t {
+  std::shared_lock lock(latch_);
+  return filter_->GetCapacity();
+}
+
+auto IndexKeyFilter::HashKey(const Tuple &key, const Schema *schema, uint64_t *hash) const -> bool {
+  // 把键列按列序列化到一起再整体哈希,插入时传的是索引项,查找时传的是键,两边序列化出来是一样的
+  std::string bytes;
+  if (SerializeIndexKey(key, schema, key_column_count_, &bytes) < key_column_count_) {
+    return false;
+  }
+  *hash = HashIndexKeyBytes(bytes, bytes.size());
+  return true;
+}
+
+void IndexKeyFilter::Rebuild() {
+  std::vector<uint64_t> hashes;
+  scan_entries_([&](const Tuple &entry, const Schema *schema) {
+    uint64_t hash;
+    if (HashKey(entry, schema, &hash)) {
+      hashes.push_back(hash);
+    }
+  });
+  // 留一倍的余量,之后插入的键不会马上又把filter塞满
+  filter_ = std::make_unique<BloomFilter>(std::max(hashes.size() * 2, MIN_FILTER_KEYS));
+  for (auto hash : hashes) {
+    filter_->Insert(hash);
+  }
+  num_keys_ = hashes.size();
+  num_deletes_ = 0;
+}
+
+}  // namespace bustub
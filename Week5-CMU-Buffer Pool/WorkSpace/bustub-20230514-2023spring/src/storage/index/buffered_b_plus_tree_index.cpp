@@ -0,0 +1,299 @@
+#include <algorithm>
+#include <iterator>
+#include <mutex>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "storage/index/buffered_b_plus_tree_index.h"
+
+namespace bustub {
+
+// 不带filter: 消息刷下去时直接写进树里,不经过InsertEntry,filter会漏掉这些键
+INDEX_TEMPLATE_ARGUMENTS
+BUFFERED_BPLUSTREE_INDEX_TYPE::BufferedBPlusTreeIndex(std::unique_ptr<IndexMetadata> &&metadata,
+                                                      BufferPoolManager *buffer_pool_manager, size_t buffer_capacity)
+    : BPlusTreeIndex<KeyType, ValueType, KeyComparator>(std::move(metadata), buffer_pool_manager, false),
+      buffer_capacity_(std::max<size_t>(buffer_capacity, 1)),
+      owners_(KeyLess{this->comparator_}) {}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BUFFERED_BPLUSTREE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid, Transaction *transaction) -> bool {
+  KeyType index_key = this->MakeTreeKey(key, &rid, true);
+
+  std::unique_lock lock(buffer_latch_);
+  if (this->IsUnique()) {
+    // 唯一索引要先看这个键最后一条消息是插入还是删除,没有消息才需要去树里查
+    if (auto message = FindMessage(index_key); message != nullptr) {
+      if (message->has_value()) {
+        return false;
+      }
+    } else {
+      std::vector<RID> existing;
+      if (this->container_->GetValue(index_key, &existing, transaction)) {
+        return false;
+      }
+    }
+  }
+  PutMessage(index_key, rid);
+  this->stats_.Insert(key, this->GetEntrySchema());
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BUFFERED_BPLUSTREE_INDEX_TYPE::DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) {
+  KeyType index_key = this->MakeTreeKey(key, &rid);
+
+  std::unique_lock lock(buffer_latch_);
+  PutMessage(index_key, std::nullopt);
+  this->stats_.Delete(key, this->GetKeySchema());
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BUFFERED_BPLUSTREE_INDEX_TYPE::ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) {
+  if (!this->IsUnique()) {
+    // 非唯一索引的一个键是一段范围,树里的RID和消息按RID的顺序合并
+    ScanRange(&key, true, &key, true, result, transaction);
+    return;
+  }
+  std::shared_lock lock(buffer_latch_);
+  KeyType index_key = this->MakeTreeKey(key, nullptr);
+  if (auto message = FindMessage(index_key); message != nullptr) {
+    if (message->has_value()) {
+      result->push_back(**message);
+    }
+    return;
+  }
+  this->container_->GetValue(index_key, result, transaction);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BUFFERED_BPLUSTREE_INDEX_TYPE::ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *result,
+                                             Transaction *transaction) {
+  if (!this->IsUnique()) {
+    Index::ScanKeys(keys, result, transaction);
+    return;
+  }
+  std::shared_lock lock(buffer_latch_);
+  BPlusTreeIndex<KeyType, ValueType, KeyComparator>::ScanKeys(keys, result, transaction);
+  if (owners_.empty()) {
+    return;
+  }
+  for (size_t i = 0; i < keys.size(); i++) {
+    if (auto message = FindMessage(this->MakeTreeKey(keys[i], nullptr)); message != nullptr) {
+      (*result)[i].clear();
+      if (message->has_value()) {
+        (*result)[i].push_back(**message);
+      }
+    }
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BUFFERED_BPLUSTREE_INDEX_TYPE::ScanRange(const Tuple *low_key, bool low_inclusive, const Tuple *high_key,
+                                              bool high_inclusive, std::vector<RID> *result,
+                                              Transaction *transaction) {
+  for (auto iter = MakeScanIterator(low_key, low_inclusive, high_key, high_inclusive, false); !iter->IsEnd();
+       iter->Next()) {
+    result->push_back(iter->GetRID());
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BUFFERED_BPLUSTREE_INDEX_TYPE::MakeScanIterator(const Tuple *low_key, bool low_inclusive, const Tuple *high_key,
+                                                     bool high_inclusive, bool reverse)
+    -> std::unique_ptr<IndexScanIterator> {
+  std::shared_lock lock(buffer_latch_);
+  auto messages = CollectMessages(low_key, low_inclusive, high_key, high_inclusive);
+  if (reverse) {
+    std::reverse(messages.begin(), messages.end());
+  }
+  return std::make_unique<BufferedBPlusTreeIndexScanIterator<KeyType, ValueType, KeyComparator>>(
+      this, this->GetRangeIterator(low_key, low_inclusive, high_key, high_inclusive, reverse), std::move(messages),
+      this->comparator_, reverse);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BUFFERED_BPLUSTREE_INDEX_TYPE::GetStatistics(bool with_shape) -> std::optional<IndexStatistics> {
+  if (with_shape) {
+    Flush();
+  }
+  return BPlusTreeIndex<KeyType, ValueType, KeyComparator>::GetStatistics(with_shape);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BUFFERED_BPLUSTREE_INDEX_TYPE::RefreshStatistics() {
+  // 统计信息从树里扫出来,缓冲区里的消息要先刷下去
+  Flush();
+  BPlusTreeIndex<KeyType, ValueType, KeyComparator>::RefreshStatistics();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BUFFERED_BPLUSTREE_INDEX_TYPE::Flush() {
+  std::unique_lock lock(buffer_latch_);
+  // 所有缓冲区的消息按键的顺序一起写进树里,同一个叶子的只往下走一次
+  std::vector<std::pair<KeyType, std::optional<RID>>> batch;
+  batch.reserve(owners_.size());
+  for (const auto &[index_key, node_id] : owners_) {
+    batch.emplace_back(index_key, buffers_.at(node_id).at(index_key));
+  }
+  this->container_->ApplyBatch(batch);
+  owners_.clear();
+  buffers_.clear();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BUFFERED_BPLUSTREE_INDEX_TYPE::GetPendingCount() -> size_t {
+  std::shared_lock lock(buffer_latch_);
+  return owners_.size();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BUFFERED_BPLUSTREE_INDEX_TYPE::FindMessage(const KeyType &index_key) const -> const std::optional<RID> * {
+  auto owner = owners_.find(index_key);
+  if (owner == owners_.end()) {
+    return nullptr;
+  }
+  return &buffers_.at(owner->second).at(owner->first);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BUFFERED_BPLUSTREE_INDEX_TYPE::PutMessage(const KeyType &index_key, const std::optional<RID> &message) {
+  // 一个键只留最新的一条消息,旧的不管在哪一层都删掉。map里的键是const的,覆盖索引更新时新旧两项的include列不同,
+  // 只能删掉重新放
+  if (auto owner = owners_.find(index_key); owner != owners_.end()) {
+    auto buffer = buffers_.find(owner->second);
+    buffer->second.erase(owner->first);
+    if (buffer->second.empty()) {
+      buffers_.erase(buffer);
+    }
+    owners_.erase(owner);
+  }
+  owners_.emplace(index_key, INVALID_PAGE_ID);
+  auto &root_buffer = GetBuffer(INVALID_PAGE_ID);
+  root_buffer.emplace(index_key, message);
+  if (root_buffer.size() >= buffer_capacity_) {
+    FlushNode(INVALID_PAGE_ID);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BUFFERED_BPLUSTREE_INDEX_TYPE::GetBuffer(page_id_t node_id) -> MessageBuffer & {
+  return buffers_.try_emplace(node_id, KeyLess{this->comparator_}).first->second;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BUFFERED_BPLUSTREE_INDEX_TYPE::FlushNode(page_id_t node_id) {
+  auto &buffer = buffers_.at(node_id);
+  std::vector<KeyType> keys;
+  keys.reserve(buffer.size());
+  for (const auto &[index_key, message] : buffer) {
+    keys.push_back(index_key);
+  }
+  std::vector<page_id_t> children;
+  bool leaf_children = false;
+  if (!this->container_->RouteBatch(node_id, keys, &children, &leaf_children)) {
+    // 结点已经被合并掉了,或者树还只有一个叶子,整个缓冲区直接写进树里
+    ApplyMessages(buffer.begin(), buffer.end());
+    buffers_.erase(node_id);
+    return;
+  }
+  // 键是排好序的,去同一个孩子的消息是连续的一段。从最长的一段开始往下刷,刷到缓冲区剩一半为止:
+  // 一次路由的开销摊到多条消息上,孩子比缓冲区的容量还多时也不会每来一条消息就刷一次
+  std::vector<std::pair<size_t, size_t>> runs;
+  for (size_t begin = 0; begin < children.size();) {
+    size_t end = begin + 1;
+    while (end < children.size() && children[end] == children[begin]) {
+      end++;
+    }
+    runs.emplace_back(begin, end);
+    begin = end;
+  }
+  std::stable_sort(runs.begin(), runs.end(),
+                   [](const auto &a, const auto &b) { return a.second - a.first > b.second - b.first; });
+  size_t remaining = buffer.size();
+  size_t flushed_runs = 0;
+  while (flushed_runs < runs.size() && (flushed_runs == 0 || remaining > buffer_capacity_ / 2)) {
+    remaining -= runs[flushed_runs].second - runs[flushed_runs].first;
+    flushed_runs++;
+  }
+  runs.resize(flushed_runs);
+  std::sort(runs.begin(), runs.end());
+
+  std::vector<std::pair<KeyType, std::optional<RID>>> leaf_batch;
+  std::vector<page_id_t> child_ids;
+  auto it = buffer.begin();
+  size_t pos = 0;
+  for (auto [begin, end] : runs) {
+    it = std::next(it, begin - pos);
+    pos = begin;
+    page_id_t child_id = children[begin];
+    child_ids.push_back(child_id);
+    for (; pos < end; pos++) {
+      if (leaf_children) {
+        leaf_batch.emplace_back(it->first, it->second);
+        owners_.erase(it->first);
+      } else {
+        GetBuffer(child_id).emplace(it->first, it->second);
+        owners_.find(it->first)->second = child_id;
+      }
+      it = buffer.erase(it);
+    }
+  }
+  if (buffer.empty()) {
+    buffers_.erase(node_id);
+  }
+  if (leaf_children) {
+    this->container_->ApplyBatch(leaf_batch);
+    return;
+  }
+  for (auto child_id : child_ids) {
+    if (auto child_buffer = buffers_.find(child_id);
+        child_buffer != buffers_.end() && child_buffer->second.size() >= buffer_capacity_) {
+      FlushNode(child_id);
+    }
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BUFFERED_BPLUSTREE_INDEX_TYPE::ApplyMessages(typename MessageBuffer::const_iterator begin,
+                                                  typename MessageBuffer::const_iterator end) {
+  std::vector<std::pair<KeyType, std::optional<RID>>> batch(begin, end);
+  for (const auto &[index_key, message] : batch) {
+    owners_.erase(index_key);
+  }
+  this->container_->ApplyBatch(batch);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BUFFERED_BPLUSTREE_INDEX_TYPE::CollectMessages(const Tuple *low_key, bool low_inclusive, const Tuple *high_key,
+                                                    bool high_inclusive) const
+    -> std::vector<std::pair<KeyType, std::optional<RID>>> {
+  std::vector<std::pair<KeyType, std::optional<RID>>> messages;
+  auto owner = owners_.begin();
+  if (low_key != nullptr) {
+    KeyType low_index_key = this->MakeTreeKey(*low_key, nullptr);
+    owner = low_inclusive ? owners_.lower_bound(low_index_key) : owners_.upper_bound(low_index_key);
+  }
+  std::optional<KeyType> high_index_key = std::nullopt;
+  if (high_key != nullptr) {
+    high_index_key = this->MakeTreeKey(*high_key, nullptr);
+  }
+  for (; owner != owners_.end(); ++owner) {
+    if (high_index_key.has_value()) {
+      int cmp = this->comparator_(owner->first, *high_index_key);
+      if (cmp > 0 || (cmp == 0 && !high_inclusive)) {
+        break;
+      }
+    }
+    messages.emplace_back(owner->first, buffers_.at(owner->second).at(owner->first));
+  }
+  return messages;
+}
+
+template class BufferedBPlusTreeIndex<GenericKey<4>, RID, GenericComparator<4>>;
+template class BufferedBPlusTreeIndex<GenericKey<8>, RID, GenericComparator<8>>;
+template class BufferedBPlusTreeIndex<GenericKey<16>, RID, GenericComparator<16>>;
+template class BufferedBPlusTreeIndex<GenericKey<32>, RID, GenericComparator<32>>;
+template class BufferedBPlusTreeIndex<GenericKey<64>, RID, GenericComparator<64>>;
+
+}  // namespace bustub
@@ -1,6 +1,7 @@
 #include <vector>
 
 #include "storage/index/extendible_hash_table_index.h"
+#include "fmt/format.h"
 
 namespace bustub {
 /*
@@ -12,34 +13,93 @@ HASH_TABLE_INDEX_TYPE::ExtendibleHashTableIndex(std::unique_ptr<IndexMetadata> &
                                                 const HashFunction<KeyType> &hash_fn)
     : Index(std::move(metadata)),
       comparator_(GetMetadata()->GetKeySchema()),
-      container_(GetMetadata()->GetName(), buffer_pool_manager, comparator_, hash_fn) {}
+      container_(GetMetadata()->GetName(), buffer_pool_manager, comparator_, hash_fn),
+      key_filter_(GetIndexColumnCount(), [this](const auto &callback) {
+        std::vector<KeyType> keys;
+        container_.GetAllKeys(nullptr, &keys);
+        for (const auto &index_key : keys) {
+          callback(KeyFromHashKey(index_key), GetKeySchema());
+        }
+      }) {}
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid, Transaction *transaction) -> bool {
   // construct insert index key
-  KeyType index_key;
-  index_key.SetFromKey(key);
+  KeyType index_key = MakeHashKey(key);
 
-  return container_.Insert(transaction, index_key, rid);
+  return key_filter_.Insert(key, GetKeySchema(), [&] {
+    if (IsUnique()) {
+      std::vector<RID> existing;
+      if (container_.GetValue(transaction, index_key, &existing)) {
+        return false;
+      }
+    }
+    if (!container_.Insert(transaction, index_key, rid)) {
+      // 同一个(key, rid)不会插两次,桶满了也会接溢出页,插不进去只能是缓冲池腾不出页来给新桶
+      throw Exception(ExceptionType::OUT_OF_RANGE,
+                      fmt::format("hash index {} is full, no page left for a new bucket", GetMetadata()->GetName()));
+    }
+    return true;
+  });
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_INDEX_TYPE::DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) {
   // construct delete index key
-  KeyType index_key;
-  index_key.SetFromKey(key);
+  KeyType index_key = MakeHashKey(key);
 
-  container_.Remove(transaction, index_key, rid);
+  if (container_.Remove(transaction, index_key, rid)) {
+    key_filter_.Delete();
+  }
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_INDEX_TYPE::ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) {
+  if (!key_filter_.MayContain(key, GetKeySchema())) {
+    return;
+  }
   // construct scan index key
+  KeyType index_key = MakeHashKey(key);
+
+  container_.GetValue(transaction, index_key, result);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_INDEX_TYPE::MakeScanIterator(const Tuple *low_key, bool low_inclusive, const Tuple *high_key,
+                                             bool high_inclusive, bool reverse) -> std::unique_ptr<IndexScanIterator> {
+  // 哈希表只能按完整的键做等值查找,范围和前缀(缺的列填NULL)都做不了
+  if (!IsPointLookup(low_key, low_inclusive, high_key, high_inclusive)) {
+    throw NotImplementedException("hash index " + GetName() + " only supports equality lookups on the full key");
+  }
+  std::vector<RID> rids;
+  ScanKey(*low_key, &rids, nullptr);
+  return std::make_unique<HashTableIndexScanIterator>(*low_key, std::move(rids));
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_INDEX_TYPE::MakeHashKey(const Tuple &key) const -> KeyType {
+  // 和BPlusTreeIndex::SetTreeKey一样,放不下的key截断之后哈希和比较都会出错,直接报错
+  auto key_length = key.GetLength();
+  if (key_length > sizeof(KeyType)) {
+    throw Exception(ExceptionType::OUT_OF_RANGE,
+                    fmt::format("key of index {} is {} bytes long, which exceeds the {}-byte index key",
+                                GetMetadata()->GetName(), key_length, sizeof(KeyType)));
+  }
   KeyType index_key;
   index_key.SetFromKey(key);
+  return index_key;
+}
 
-  container_.GetValue(transaction, index_key, result);
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_INDEX_TYPE::KeyFromHashKey(const KeyType &index_key) const -> Tuple {
+  std::vector<Value> values;
+  values.reserve(GetIndexColumnCount());
+  for (uint32_t i = 0; i < GetIndexColumnCount(); i++) {
+    values.push_back(index_key.ToValue(GetKeySchema(), i));
+  }
+  return {values, GetKeySchema()};
 }
+
 template class ExtendibleHashTableIndex<GenericKey<4>, RID, GenericComparator<4>>;
 template class ExtendibleHashTableIndex<GenericKey<8>, RID, GenericComparator<8>>;
 template class ExtendibleHashTableIndex<GenericKey<16>, RID, GenericComparator<16>>;
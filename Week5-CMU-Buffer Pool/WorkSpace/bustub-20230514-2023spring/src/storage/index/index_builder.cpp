@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <exception>
+#include <queue>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "storage/index/index_builder.h"
+
+namespace bustub {
+
+namespace {
+
+/** 一个worker至少扫描这么多页,表很小的时候不值得开线程 */
+constexpr size_t MIN_PAGES_PER_WORKER = 16;
+
+struct BuildEntry {
+  // 键列的值,排序时反复比较,先取出来免得每次都从tuple里反序列化
+  std::vector<Value> key_;
+  Tuple entry_;
+  RID rid_;
+};
+
+/** 按键列比较,NULL排在最前面,键相同再按RID比较,这样排序是一个全序 */
+auto CompareEntries(const BuildEntry &a, const BuildEntry &b) -> int {
+  for (size_t i = 0; i < a.key_.size(); i++) {
+    const Value &x = a.key_[i];
+    const Value &y = b.key_[i];
+    if (x.IsNull() || y.IsNull()) {
+      if (x.IsNull() != y.IsNull()) {
+        return x.IsNull() ? -1 : 1;
+      }
+      continue;
+    }
+    if (x.CompareLessThan(y) == CmpBool::CmpTrue) {
+      return -1;
+    }
+    if (x.CompareGreaterThan(y) == CmpBool::CmpTrue) {
+      return 1;
+    }
+  }
+  if (a.rid_.Get() != b.rid_.Get()) {
+    return a.rid_.Get() < b.rid_.Get() ? -1 : 1;
+  }
+  return 0;
+}
+
+/** 把一个索引项的键列取出来,准备排序 */
+auto MakeBuildEntry(Index *index, Tuple entry_tuple, RID rid) -> BuildEntry {
+  const Schema *entry_schema = index->GetEntrySchema();
+  uint32_t key_column_count = index->GetIndexColumnCount();
+  BuildEntry entry;
+  entry.entry_ = std::move(entry_tuple);
+  entry.rid_ = rid;
+  entry.key_.reserve(key_column_count);
+  for (uint32_t col = 0; col < key_column_count; col++) {
+    entry.key_.push_back(entry.entry_.GetValue(entry_schema, col));
+  }
+  return entry;
+}
+
+/** 提取[begin, end)这些页上所有没被删除的tuple的索引项,排好序 */
+void ExtractRun(Index *index, TableHeap *table_heap, const Schema &schema, const std::vector<page_id_t> &page_ids,
+                size_t begin, size_t end, std::vector<BuildEntry> *run) {
+  const Schema *entry_schema = index->GetEntrySchema();
+  for (size_t i = begin; i < end; i++) {
+    for (auto &[meta, tuple] : table_heap->GetPageTuples(page_ids[i])) {
+      if (meta.is_deleted_) {
+        continue;
+      }
+      run->push_back(
+          MakeBuildEntry(index, tuple.KeyFromTuple(schema, *entry_schema, index->GetEntryAttrs()), tuple.GetRid()));
+    }
+  }
+  std::sort(run->begin(), run->end(),
+            [](const BuildEntry &a, const BuildEntry &b) { return CompareEntries(a, b) < 0; });
+}
+
+/** 离开作用域时join所有还在跑的worker,当前线程抛异常时也不会析构一个joinable的std::thread */
+class WorkerJoiner {
+ public:
+  explicit WorkerJoiner(std::vector<std::thread> *workers) : workers_(workers) {}
+  ~WorkerJoiner() {
+    for (auto &worker : *workers_) {
+      if (worker.joinable()) {
+        worker.join();
+      }
+    }
+  }
+
+ private:
+  std::vector<std::thread> *workers_;
+};
+
+}  // namespace
+
+void BuildIndexFromHeap(Index *index, TableHeap *table_heap, const Schema &schema, Transaction *txn,
+                        size_t num_workers) {
+  auto page_ids = table_heap->GetPageIds();
+  if (num_workers == 0) {
+    num_workers = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  }
+  num_workers = std::clamp<size_t>(page_ids.size() / MIN_PAGES_PER_WORKER, 1, num_workers);
+
+  // 每个worker负责页链上连续的一段,各自提取并排序
+  // worker里抛的异常存下来,join完以后在当前线程重新抛出
+  std::vector<std::vector<BuildEntry>> runs(num_workers);
+  std::vector<std::exception_ptr> errors(num_workers);
+  std::vector<std::thread> workers;
+  workers.reserve(num_workers);
+  {
+    WorkerJoiner joiner(&workers);
+    size_t pages_per_worker = (page_ids.size() + num_workers - 1) / num_workers;
+    for (size_t w = 0; w < num_workers; w++) {
+      size_t begin = std::min(w * pages_per_worker, page_ids.size());
+      size_t end = std::min(begin + pages_per_worker, page_ids.size());
+      if (w + 1 == num_workers) {
+        // 最后一段在当前线程里做
+        ExtractRun(index, table_heap, schema, page_ids, begin, end, &runs[w]);
+        break;
+      }
+      workers.emplace_back([&, w, begin, end] {
+        try {
+          ExtractRun(index, table_heap, schema, page_ids, begin, end, &runs[w]);
+        } catch (...) {
+          errors[w] = std::current_exception();
+        }
+      });
+    }
+  }
+  for (const auto &error : errors) {
+    if (error != nullptr) {
+      std::rethrow_exception(error);
+    }
+  }
+
+  // k路归并,按键的顺序交给索引批量装载,B+树从叶子往上直接建,不用每一项都从根往下走
+  using RunCursor = std::pair<size_t, size_t>;  // (run, position)
+  auto greater = [&](const RunCursor &a, const RunCursor &b) {
+    return CompareEntries(runs[a.first][a.second], runs[b.first][b.second]) > 0;
+  };
+  std::priority_queue<RunCursor, std::vector<RunCursor>, decltype(greater)> heads(greater);
+  for (size_t r = 0; r < runs.size(); r++) {
+    if (!runs[r].empty()) {
+      heads.emplace(r, 0);
+    }
+  }
+  index->BulkLoad(
+      [&](Tuple *key, RID *rid) {
+        if (heads.empty()) {
+          return false;
+        }
+        auto [r, pos] = heads.top();
+        heads.pop();
+        auto &entry = runs[r][pos];
+        *key = std::move(entry.entry_);
+        *rid = entry.rid_;
+        if (pos + 1 < runs[r].size()) {
+          heads.emplace(r, pos + 1);
+        }
+        return true;
+      },
+      txn);
+}
+
+void InsertEntriesInKeyOrder(Index *index, std::vector<std::pair<Tuple, RID>> entries, Transaction *txn) {
+  std::vector<BuildEntry> sorted;
+  sorted.reserve(entries.size());
+  for (auto &[entry_tuple, rid] : entries) {
+    sorted.push_back(MakeBuildEntry(index, std::move(entry_tuple), rid));
+  }
+  std::sort(sorted.begin(), sorted.end(),
+            [](const BuildEntry &a, const BuildEntry &b) { return CompareEntries(a, b) < 0; });
+  for (const auto &entry : sorted) {
+    index->InsertEntry(entry.entry_, entry.rid_, txn);
+  }
+}
+
+}  // namespace bustub
@@ -1,9 +1,12 @@
 /**
  * index_iterator.cpp
  */
+#include <algorithm>
 #include <cassert>
 
 #include "storage/index/index_iterator.h"
+#include "storage/page/b_plus_tree_header_page.h"
+#include "storage/page/b_plus_tree_internal_page.h"
 
 namespace bustub {
 
@@ -27,11 +30,39 @@ INDEXITERATOR_TYPE::IndexIterator(BufferPoolManager *bpm, ReadPageGuard &&page_g
     : bpm_(bpm), page_guard_(std::move(page_guard_)), index_(index) {
   if (bpm_ != nullptr && index != -233) {
     this->page_id_ = this->page_guard_.PageId();
+    this->SkipExhaustedLeaves();
   } else {
     this->page_id_ = INVALID_PAGE_ID;
   }
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::IndexIterator(BufferPoolManager *bpm, page_id_t header_page_id, const KeyComparator *comparator,
+                                  const std::optional<KeyType> &key)
+    : bpm_(bpm),
+      page_guard_(nullptr, nullptr),
+      index_(-233),
+      page_id_(INVALID_PAGE_ID),
+      comparator_(comparator),
+      reverse_(true),
+      header_page_id_(header_page_id) {
+  this->SeekBackward(key, true);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::IndexIterator(IndexIterator &&that) noexcept
+    : bpm_(that.bpm_),
+      page_guard_(std::move(that.page_guard_)),
+      index_(that.index_),
+      page_id_(that.page_id_),
+      stop_key_(that.stop_key_),
+      stop_inclusive_(that.stop_inclusive_),
+      comparator_(that.comparator_),
+      reverse_(that.reverse_),
+      header_page_id_(that.header_page_id_) {
+  that.bpm_ = nullptr;
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 auto INDEXITERATOR_TYPE::operator=(IndexIterator &&that) noexcept -> IndexIterator & {
   this->bpm_ = that.bpm_;
@@ -39,6 +70,11 @@ auto INDEXITERATOR_TYPE::operator=(IndexIterator &&that) noexcept -> IndexIterat
   this->page_guard_ = std::move(that.page_guard_);
   this->index_ = that.index_;
   this->page_id_ = that.page_id_;
+  this->stop_key_ = that.stop_key_;
+  this->stop_inclusive_ = that.stop_inclusive_;
+  this->comparator_ = that.comparator_;
+  this->reverse_ = that.reverse_;
+  this->header_page_id_ = that.header_page_id_;
   return *this;
 }
 
@@ -51,30 +87,148 @@ auto INDEXITERATOR_TYPE::IsEnd() -> bool { return this->page_id_ == INVALID_PAGE
 INDEX_TEMPLATE_ARGUMENTS
 auto INDEXITERATOR_TYPE::operator*() -> const MappingType & {
   auto leaf_page = this->page_guard_.template As<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>();
-  return leaf_page->KeyValueAt(this->index_);
+  // 叶子里的键是压缩存放的,解出来放在迭代器里
+  this->current_ = leaf_page->KeyValueAt(this->index_);
+  return this->current_;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 auto INDEXITERATOR_TYPE::operator++() -> INDEXITERATOR_TYPE & {
-  if (!this->IsEnd()) {
+  if (!this->IsEnd() && this->reverse_) {
     auto leaf = this->page_guard_.template As<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>();
+    this->index_--;
+    if (this->index_ < 0) {
+      // 先放掉当前叶子再从根往下找,避免从右往左加锁和从左往右加锁的线程互相等待
+      KeyType first_key = leaf->KeyAt(0);
+      this->page_guard_.Drop();
+      this->SeekBackward(first_key, false);
+    }
+    this->CheckStopKey();
+  } else if (!this->IsEnd()) {
     this->index_++;
-    if (this->index_ == leaf->GetSize()) {
-      if (leaf->GetNextPageId() == INVALID_PAGE_ID) {
-        bpm_ = nullptr;
-        this->index_ = -233;
-        this->page_guard_.Drop();
-        // this->head_guard_.Drop();
-        this->page_id_ = INVALID_PAGE_ID;
-        return *this;
+    this->SkipExhaustedLeaves();
+    this->CheckStopKey();
+  }
+  return *this;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::SetStopKey(const KeyType &stop_key, bool stop_inclusive, const KeyComparator *comparator) {
+  this->stop_key_ = stop_key;
+  this->stop_inclusive_ = stop_inclusive;
+  this->comparator_ = comparator;
+  this->CheckStopKey();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::CheckStopKey() {
+  if (this->IsEnd() || this->stop_key_ == std::nullopt) {
+    return;
+  }
+  auto leaf = this->page_guard_.template As<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>();
+  int cmp = (*this->comparator_)(leaf->KeyAt(this->index_), *this->stop_key_);
+  if (this->reverse_) {
+    cmp = -cmp;
+  }
+  if (cmp > 0 || (cmp == 0 && !this->stop_inclusive_)) {
+    // 已经越过终止键,提前释放叶子结点,后面的叶子不会再被访问
+    this->SetEnd();
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::SeekBackward(const std::optional<KeyType> &key, bool inclusive) {
+  using InternalPage = BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator>;
+  using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
+  // 是否在key的左边(inclusive时包含等于)
+  auto before_key = [&](const KeyType &k) -> bool {
+    if (key == std::nullopt) {
+      return true;
+    }
+    int cmp = (*this->comparator_)(k, *key);
+    return cmp < 0 || (inclusive && cmp == 0);
+  };
+
+  ReadPageGuard header_guard = bpm_->FetchPageRead(this->header_page_id_);
+  auto header_page = header_guard.As<BPlusTreeHeaderPage>();
+  if (header_page->root_page_id_ == INVALID_PAGE_ID) {
+    this->SetEnd();
+    return;
+  }
+  // 从根往下的路径上的读锁以及选择的孩子下标,叶子里没有满足条件的键时退回到最近的还有左兄弟的祖先
+  std::vector<std::pair<ReadPageGuard, int>> path;
+  path.emplace_back(bpm_->FetchPageRead(header_page->root_page_id_), 0);
+  header_guard.Drop();
+  bool rightmost = false;
+  while (true) {
+    auto now_page = path.back().first.template As<BPlusTreePage>();
+    if (!now_page->IsLeafPage()) {
+      auto internal = reinterpret_cast<const InternalPage *>(now_page);
+      int child = internal->GetSize() - 1;
+      if (!rightmost) {
+        // 最后一个满足before_key的分隔键对应的孩子,第0个孩子没有分隔键
+        while (child > 0 && !before_key(internal->KeyAt(child))) {
+          child--;
+        }
+      }
+      path.back().second = child;
+      path.emplace_back(bpm_->FetchPageRead(internal->ValueAt(child)), 0);
+      continue;
+    }
+    auto leaf = reinterpret_cast<const LeafPage *>(now_page);
+    int index = leaf->GetSize() - 1;
+    if (!rightmost) {
+      while (index >= 0 && !before_key(leaf->KeyAt(index))) {
+        index--;
       }
-      this->page_guard_ = bpm_->FetchPageRead(leaf->GetNextPageId());
-      this->page_id_ = this->page_guard_.PageId();
-      // 代表读到第一个
-      this->index_ = 0;
     }
+    if (index >= 0) {
+      this->page_id_ = path.back().first.PageId();
+      this->page_guard_ = std::move(path.back().first);
+      this->index_ = index;
+      return;
+    }
+    // 这个叶子里都不满足,退回到还能往左走的祖先,再沿着左边子树的最右路径下去
+    path.pop_back();
+    while (!path.empty() && path.back().second == 0) {
+      path.pop_back();
+    }
+    if (path.empty()) {
+      this->SetEnd();
+      return;
+    }
+    auto internal = path.back().first.template As<InternalPage>();
+    path.back().second--;
+    path.emplace_back(bpm_->FetchPageRead(internal->ValueAt(path.back().second)), 0);
+    rightmost = true;
   }
-  return *this;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::SkipExhaustedLeaves() {
+  while (!this->IsEnd()) {
+    auto leaf = this->page_guard_.template As<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>();
+    if (this->index_ < leaf->GetSize()) {
+      return;
+    }
+    page_id_t next_page_id = leaf->GetNextPageId();
+    if (next_page_id == INVALID_PAGE_ID) {
+      this->SetEnd();
+      return;
+    }
+    this->page_guard_ = bpm_->FetchPageRead(next_page_id);
+    this->page_id_ = this->page_guard_.PageId();
+    // 代表读到第一个
+    this->index_ = 0;
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::SetEnd() {
+  bpm_ = nullptr;
+  this->index_ = -233;
+  this->page_guard_.Drop();
+  this->page_id_ = INVALID_PAGE_ID;
 }
 
 template class IndexIterator<GenericKey<4>, RID, GenericComparator<4>>;
@@ -0,0 +1,218 @@
+#include <algorithm>
+#include <cmath>
+#include <mutex>  // NOLINT
+#include <string>
+
+#include "storage/index/index_statistics.h"
+
+namespace bustub {
+
+namespace {
+
+/** 没有直方图可用时,一个范围条件估计能选中三分之一的项 */
+constexpr double RANGE_SELECTIVITY = 1.0 / 3;
+
+auto Less(const Value &a, const Value &b) -> bool { return a.CompareLessThan(b) == CmpBool::CmpTrue; }
+
+/** 减到0为止,直方图的边界过时以后,删除可能落到和插入时不同的桶里 */
+void DecrementIfPositive(std::atomic<size_t> *counter) {
+  size_t current = counter->load();
+  while (current > 0 && !counter->compare_exchange_weak(current, current - 1)) {
+  }
+}
+
+}  // namespace
+
+void HyperLogLog::Add(uint64_t hash) {
+  // 高PRECISION位选寄存器,剩下的位里第一个1的位置越靠后,说明见过的不同哈希越多
+  size_t index = hash >> (64 - PRECISION);
+  uint64_t rest = hash << PRECISION;
+  auto rank = static_cast<uint8_t>(rest == 0 ? 64 - PRECISION + 1 : __builtin_clzll(rest) + 1);
+  auto &reg = registers_[index];
+  uint8_t current = reg.load(std::memory_order_relaxed);
+  while (current < rank && !reg.compare_exchange_weak(current, rank, std::memory_order_relaxed)) {
+  }
+}
+
+auto HyperLogLog::Estimate() const -> double {
+  double sum = 0;
+  size_t zeros = 0;
+  for (const auto &reg : registers_) {
+    uint8_t value = reg.load(std::memory_order_relaxed);
+    sum += std::ldexp(1.0, -value);
+    zeros += value == 0 ? 1 : 0;
+  }
+  auto m = static_cast<double>(NUM_REGISTERS);
+  double alpha = 0.7213 / (1 + 1.079 / m);
+  double estimate = alpha * m * m / sum;
+  // 基数小的时候还有很多空寄存器,按线性计数估计更准
+  if (estimate <= 2.5 * m && zeros > 0) {
+    estimate = m * std::log(m / static_cast<double>(zeros));
+  }
+  return estimate;
+}
+
+auto IndexStatistics::EstimateRows(const std::vector<Value> &low_key, bool low_inclusive,
+                                   const std::vector<Value> &high_key, bool high_inclusive) const -> double {
+  auto rows = static_cast<double>(num_entries_);
+  if (num_entries_ == 0) {
+    return rows;
+  }
+  size_t equal_columns = 0;
+  while (equal_columns < low_key.size() && equal_columns < high_key.size() &&
+         low_key[equal_columns].CompareEquals(high_key[equal_columns]) == CmpBool::CmpTrue) {
+    equal_columns++;
+  }
+  bool has_range = low_key.size() > equal_columns || high_key.size() > equal_columns;
+  if (equal_columns > 0 && !has_range && (!low_inclusive || !high_inclusive)) {
+    // 上下界相同又不包含边界,什么都选不中
+    return 0;
+  }
+
+  if (equal_columns > 0) {
+    // 等值前缀按不同前缀的个数平均分,后面再跟一个范围就再乘一个固定的选择率
+    size_t distinct = 1;
+    if (!distinct_prefixes_.empty()) {
+      distinct = distinct_prefixes_[std::min(equal_columns, distinct_prefixes_.size()) - 1];
+    }
+    rows /= static_cast<double>(std::max<size_t>(distinct, 1));
+    return has_range ? rows * RANGE_SELECTIVITY : rows;
+  }
+  if (!has_range) {
+    return rows;
+  }
+
+  // 第一列上的范围: 完全落在范围里的桶整个算上,跨过边界的桶算一半
+  const Value *low = low_key.empty() ? nullptr : &low_key[0];
+  const Value *high = high_key.empty() ? nullptr : &high_key[0];
+  size_t total = 0;
+  double selected = 0;
+  for (size_t i = 0; i < histogram_counts_.size(); i++) {
+    const Value &bucket_low = histogram_bounds_[i];
+    const Value &bucket_high = histogram_bounds_[i + 1];
+    total += histogram_counts_[i];
+    if ((low != nullptr && Less(bucket_high, *low)) || (high != nullptr && Less(*high, bucket_low))) {
+      continue;
+    }
+    bool inside = (low == nullptr || !Less(bucket_low, *low)) && (high == nullptr || !Less(*high, bucket_high));
+    selected += inside ? static_cast<double>(histogram_counts_[i]) : static_cast<double>(histogram_counts_[i]) / 2;
+  }
+  if (total == 0) {
+    return rows * RANGE_SELECTIVITY;
+  }
+  return rows * selected / static_cast<double>(total);
+}
+
+IndexStatisticsCollector::IndexStatisticsCollector(uint32_t key_column_count) : key_column_count_(key_column_count) {
+  for (uint32_t i = 0; i < key_column_count_; i++) {
+    sketches_.push_back(std::make_unique<HyperLogLog>());
+  }
+}
+
+void IndexStatisticsCollector::Insert(const Tuple &key, const Schema *schema) {
+  std::shared_lock lock(latch_);
+  num_entries_++;
+  AddToSketches(key, schema);
+  Value value = key.GetValue(schema, 0);
+  if (!histogram_bounds_.empty() && !value.IsNull()) {
+    histogram_counts_[BucketOf(value)]++;
+  }
+}
+
+void IndexStatisticsCollector::Delete(const Tuple &key, const Schema *schema) {
+  std::shared_lock lock(latch_);
+  DecrementIfPositive(&num_entries_);
+  Value value = key.GetValue(schema, 0);
+  if (!histogram_bounds_.empty() && !value.IsNull()) {
+    DecrementIfPositive(&histogram_counts_[BucketOf(value)]);
+  }
+}
+
+void IndexStatisticsCollector::Refresh(const IndexEntryScanner &scan_entries) {
+  // 第一遍数项数,重建sketch,删掉的键这时候才从sketch里去掉
+  std::vector<std::unique_ptr<HyperLogLog>> sketches;
+  for (uint32_t i = 0; i < key_column_count_; i++) {
+    sketches.push_back(std::make_unique<HyperLogLog>());
+  }
+  size_t num_entries = 0;
+  scan_entries([&](const Tuple &entry, const Schema *schema) {
+    num_entries++;
+    std::string bytes;
+    std::vector<size_t> column_ends;
+    SerializeIndexKey(entry, schema, key_column_count_, &bytes, &column_ends);
+    for (size_t i = 0; i < column_ends.size(); i++) {
+      sketches[i]->Add(HashIndexKeyBytes(bytes, column_ends[i]));
+    }
+  });
+
+  // 第二遍按键的顺序切桶,每个桶装满depth项就在下一个不同的值之前切开,相同的值不会跨桶
+  size_t depth = std::max<size_t>((num_entries + INDEX_HISTOGRAM_BUCKETS - 1) / INDEX_HISTOGRAM_BUCKETS, 1);
+  std::vector<Value> bounds;
+  std::vector<size_t> counts;
+  Value last;
+  size_t in_bucket = 0;
+  scan_entries([&](const Tuple &entry, const Schema *schema) {
+    Value value = entry.GetValue(schema, 0);
+    if (value.IsNull()) {
+      return;
+    }
+    if (bounds.empty()) {
+      bounds.push_back(value);
+    } else if (in_bucket >= depth && value.CompareNotEquals(last) == CmpBool::CmpTrue) {
+      bounds.push_back(last);
+      counts.push_back(in_bucket);
+      in_bucket = 0;
+    }
+    in_bucket++;
+    last = value;
+  });
+  if (in_bucket > 0) {
+    bounds.push_back(last);
+    counts.push_back(in_bucket);
+  }
+
+  std::unique_lock lock(latch_);
+  num_entries_ = num_entries;
+  sketches_ = std::move(sketches);
+  histogram_bounds_ = std::move(bounds);
+  histogram_counts_ = std::make_unique<std::atomic<size_t>[]>(counts.size());
+  for (size_t i = 0; i < counts.size(); i++) {
+    histogram_counts_[i] = counts[i];
+  }
+}
+
+void IndexStatisticsCollector::Snapshot(IndexStatistics *stats) {
+  std::shared_lock lock(latch_);
+  stats->num_entries_ = num_entries_;
+  // 估计值不会超过项数,更长的前缀也不会比更短的前缀少
+  stats->distinct_prefixes_.clear();
+  size_t previous = 0;
+  for (const auto &sketch : sketches_) {
+    auto distinct = static_cast<size_t>(std::llround(sketch->Estimate()));
+    previous = std::min(std::max(distinct, previous), stats->num_entries_);
+    stats->distinct_prefixes_.push_back(previous);
+  }
+  stats->histogram_bounds_ = histogram_bounds_;
+  stats->histogram_counts_.clear();
+  for (size_t i = 0; i + 1 < histogram_bounds_.size(); i++) {
+    stats->histogram_counts_.push_back(histogram_counts_[i]);
+  }
+}
+
+void IndexStatisticsCollector::AddToSketches(const Tuple &key, const Schema *schema) {
+  std::string bytes;
+  std::vector<size_t> column_ends;
+  SerializeIndexKey(key, schema, key_column_count_, &bytes, &column_ends);
+  for (size_t i = 0; i < column_ends.size(); i++) {
+    sketches_[i]->Add(HashIndexKeyBytes(bytes, column_ends[i]));
+  }
+}
+
+auto IndexStatisticsCollector::BucketOf(const Value &value) const -> size_t {
+  // 第一个上界不小于value的桶,比最小值还小的算第一个桶,比最大值还大的算最后一个桶
+  auto it = std::lower_bound(histogram_bounds_.begin() + 1, histogram_bounds_.end(), value, Less);
+  auto bucket = static_cast<size_t>(it - histogram_bounds_.begin()) - 1;
+  return std::min(bucket, histogram_bounds_.size() - 2);
+}
+
+}  // namespace bustub
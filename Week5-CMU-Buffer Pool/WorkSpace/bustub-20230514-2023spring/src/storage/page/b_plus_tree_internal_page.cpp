@@ -9,6 +9,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 
@@ -66,6 +67,7 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(int max_size) {
   this->SetPageType(IndexPageType::INTERNAL_PAGE);
   this->SetSize(0);
   this->SetMaxSize(max_size);
+  this->array_.Init();
 }
 /*
  * Helper method to get/set the key associated with input "index"(a.k.a
@@ -74,44 +76,89 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(int max_size) {
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::KeyAt(int index) const -> KeyType {
   // replace with your own code
-  KeyType key = this->array_[index].first;
-  return key;
+  return this->array_.KeyAt(index);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) { this->array_[index].first = key; }
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) -> bool {
+  return this->array_.SetKeyAt(this->GetSize(), 1, index, key, INTERNAL_PAGE_SPACE);
+}
 
 /*
  * Helper method to get the value associated with input "index"(a.k.a array
  * offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const -> ValueType { return this->array_[index].second; }
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const -> ValueType { return this->array_.ValueAt(index); }
 
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetValueAt(int index, const page_id_t &value) {
-  this->array_[index].second = value;
+  this->array_.SetValueAt(index, value);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetArray() const -> const MappingType * { return this->array_; }
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetMinSize() const -> int {
+  int max_size = std::min<int>(this->GetMaxSize(), INTERNAL_PAGE_SLOT_COUNT);
+  return (max_size & 1) != 0 ? max_size / 2 + 1 : max_size / 2;
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetArrayAt(int index, std::pair<KeyType, page_id_t> value) {
-  this->array_[index] = value;
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::LowerBound(const KeyType &key, const KeyComparator &comparator) const -> int {
+  // 第0个键没有意义,从1开始二分
+  int left = 1;
+  int right = this->GetSize();
+  while (left < right) {
+    int mid = (left + right) / 2;
+    if (comparator(this->array_.KeyAt(mid), key) < 0) {
+      left = mid + 1;
+    } else {
+      right = mid;
+    }
+  }
+  return left;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetMinSize() const -> int {
-  int max_size = this->GetMaxSize();
-  return (max_size & 1) != 0 ? max_size / 2 + 1 : max_size / 2;
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::UpperBound(const KeyType &key, const KeyComparator &comparator) const -> int {
+  int left = 1;
+  int right = this->GetSize();
+  while (left < right) {
+    int mid = (left + right) / 2;
+    if (comparator(key, this->array_.KeyAt(mid)) < 0) {
+      right = mid;
+    } else {
+      left = mid + 1;
+    }
+  }
+  return left;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::DeleteAValue(int pos) {
-  for (int i = pos + 1; i < this->GetSize(); i++) {
-    this->SetArrayAt(i - 1, std::make_pair(this->KeyAt(i), this->ValueAt(i)));
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertAt(int index, const KeyType &key, const ValueType &value) -> bool {
+  if (!this->array_.Insert(this->GetSize(), 1, index, key, value, INTERNAL_PAGE_SPACE)) {
+    return false;
+  }
+  this->IncreaseSize(1);
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetEntries() const -> std::vector<MappingType> {
+  return this->array_.Entries(this->GetSize());
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetEntries(const std::vector<MappingType> &entries) -> bool {
+  if (!this->array_.Assign(entries, 1, INTERNAL_PAGE_SPACE)) {
+    return false;
   }
+  this->SetSize(entries.size());
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::DeleteAValue(int pos) {
+  this->array_.Erase(this->GetSize(), pos);
   this->IncreaseSize(-1);
 }
 
@@ -9,6 +9,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <sstream>
 
 #include "common/exception.h"
@@ -31,6 +32,7 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(int max_size) {
   this->SetSize(0);
   this->next_page_id_ = INVALID_PAGE_ID;
   this->SetMaxSize(max_size);
+  this->array_.Init();
 }
 
 /**
@@ -42,40 +44,67 @@ auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetNextPageId() const -> page_id_t { return thi
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) { this->next_page_id_ = next_page_id; }
 
-INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) { this->array_[index].first = key; }
-
 /*
  * Helper method to find and return the key associated with input "index"(a.k.a
  * array offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_LEAF_PAGE_TYPE::KeyAt(int index) const -> KeyType {
-  // replace with your own code
-  KeyType key = this->array_[index].first;
-  return key;
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::KeyAt(int index) const -> KeyType { return this->array_.KeyAt(index); }
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::ValueAt(int index) const -> ValueType { return this->array_.ValueAt(index); }
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::KeyValueAt(int index) const -> MappingType {
+  return std::make_pair(this->array_.KeyAt(index), this->array_.ValueAt(index));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetMinSize() const -> int {
+  return std::min<int>(this->GetMaxSize(), LEAF_PAGE_SLOT_COUNT) / 2;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_LEAF_PAGE_TYPE::ValueAt(int index) const -> ValueType {
-  ValueType value = this->array_[index].second;
-  return value;
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::LowerBound(const KeyType &key, const KeyComparator &comparator) const -> int {
+  int left = 0;
+  int right = this->GetSize();
+  while (left < right) {
+    int mid = (left + right) / 2;
+    if (comparator(this->array_.KeyAt(mid), key) < 0) {
+      left = mid + 1;
+    } else {
+      right = mid;
+    }
+  }
+  return left;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_LEAF_PAGE_TYPE::KeyValueAt(int index) const -> const MappingType & { return this->array_[index]; }
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::InsertAt(int index, const KeyType &key, const ValueType &value) -> bool {
+  if (!this->array_.Insert(this->GetSize(), 0, index, key, value, LEAF_PAGE_SPACE)) {
+    return false;
+  }
+  this->IncreaseSize(1);
+  return true;
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::SetArrayAt(int index, MappingType value) { this->array_[index] = value; }
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetEntries() const -> std::vector<MappingType> {
+  return this->array_.Entries(this->GetSize());
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetArray() const -> const MappingType * { return this->array_; }
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::SetEntries(const std::vector<MappingType> &entries) -> bool {
+  if (!this->array_.Assign(entries, 0, LEAF_PAGE_SPACE)) {
+    return false;
+  }
+  this->SetSize(entries.size());
+  return true;
+}
 
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::DeleteAValue(int pos) {
-  for (int i = pos + 1; i < this->GetSize(); i++) {
-    this->SetArrayAt(i - 1, std::make_pair(this->KeyAt(i), this->ValueAt(i)));
-  }
+  this->array_.Erase(this->GetSize(), pos);
   this->IncreaseSize(-1);
 }
 
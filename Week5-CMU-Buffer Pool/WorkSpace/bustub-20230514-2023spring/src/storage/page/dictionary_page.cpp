@@ -0,0 +1,42 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// dictionary_page.cpp
+//
+// Identification: src/storage/page/dictionary_page.cpp
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/dictionary_page.h"
+
+#include <cstring>
+
+namespace bustub {
+
+void DictionaryPage::Init() {
+  next_page_id_ = INVALID_PAGE_ID;
+  num_strings_ = 0;
+  data_end_ = DICTIONARY_PAGE_HEADER_SIZE;
+}
+
+auto DictionaryPage::AppendString(std::string_view str) -> std::optional<uint16_t> {
+  if (data_end_ + sizeof(uint16_t) + str.size() > BUSTUB_PAGE_SIZE) {
+    return std::nullopt;
+  }
+  auto offset = data_end_;
+  auto len = static_cast<uint16_t>(str.size());
+  memcpy(page_start_ + offset, &len, sizeof(uint16_t));
+  memcpy(page_start_ + offset + sizeof(uint16_t), str.data(), str.size());
+  data_end_ += sizeof(uint16_t) + len;
+  num_strings_++;
+  return offset;
+}
+
+auto DictionaryPage::GetString(uint16_t offset) const -> std::string_view {
+  uint16_t len;
+  memcpy(&len, page_start_ + offset, sizeof(uint16_t));
+  return {page_start_ + offset + sizeof(uint16_t), len};
+}
+
+}  // namespace bustub
@@ -10,6 +10,9 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <cstring>
+
 #include "storage/page/hash_table_bucket_page.h"
 #include "common/logger.h"
 #include "common/util/hash_util.h"
@@ -19,63 +22,131 @@
 
 namespace bustub {
 
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_BUCKET_TYPE::Init() {
+  overflow_page_id_ = INVALID_PAGE_ID;
+  memset(occupied_, 0, sizeof(occupied_));
+  memset(readable_, 0, sizeof(readable_));
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_BUCKET_TYPE::GetOverflowPageId() const -> page_id_t {
+  return overflow_page_id_;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_BUCKET_TYPE::SetOverflowPageId(page_id_t overflow_page_id) {
+  overflow_page_id_ = overflow_page_id;
+}
+
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BUCKET_TYPE::GetValue(KeyType key, KeyComparator cmp, std::vector<ValueType> *result) -> bool {
-  return false;
+  bool found = false;
+  // 槽位是从前往后依次占用的,遇到第一个从未占用过的槽位就说明后面都是空的
+  for (uint32_t bucket_idx = 0; bucket_idx < BUCKET_ARRAY_SIZE && IsOccupied(bucket_idx); bucket_idx++) {
+    if (IsReadable(bucket_idx) && cmp(array_[bucket_idx].first, key) == 0) {
+      result->push_back(array_[bucket_idx].second);
+      found = true;
+    }
+  }
+  return found;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BUCKET_TYPE::Insert(KeyType key, ValueType value, KeyComparator cmp) -> bool {
+  // 优先复用墓碑槽位;同时要扫完所有已占用的槽位,确认没有完全相同的键值对
+  uint32_t free_idx = BUCKET_ARRAY_SIZE;
+  uint32_t bucket_idx = 0;
+  for (; bucket_idx < BUCKET_ARRAY_SIZE && IsOccupied(bucket_idx); bucket_idx++) {
+    if (!IsReadable(bucket_idx)) {
+      free_idx = std::min(free_idx, bucket_idx);
+      continue;
+    }
+    if (cmp(array_[bucket_idx].first, key) == 0 && array_[bucket_idx].second == value) {
+      return false;
+    }
+  }
+  if (free_idx == BUCKET_ARRAY_SIZE) {
+    free_idx = bucket_idx;
+  }
+  if (free_idx == BUCKET_ARRAY_SIZE) {
+    return false;
+  }
+  array_[free_idx] = MappingType(key, value);
+  SetOccupied(free_idx);
+  SetReadable(free_idx);
   return true;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BUCKET_TYPE::Remove(KeyType key, ValueType value, KeyComparator cmp) -> bool {
+  for (uint32_t bucket_idx = 0; bucket_idx < BUCKET_ARRAY_SIZE && IsOccupied(bucket_idx); bucket_idx++) {
+    if (IsReadable(bucket_idx) && cmp(array_[bucket_idx].first, key) == 0 && array_[bucket_idx].second == value) {
+      RemoveAt(bucket_idx);
+      return true;
+    }
+  }
   return false;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BUCKET_TYPE::KeyAt(uint32_t bucket_idx) const -> KeyType {
-  return {};
+  return array_[bucket_idx].first;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BUCKET_TYPE::ValueAt(uint32_t bucket_idx) const -> ValueType {
-  return {};
+  return array_[bucket_idx].second;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_BUCKET_TYPE::RemoveAt(uint32_t bucket_idx) {}
+void HASH_TABLE_BUCKET_TYPE::RemoveAt(uint32_t bucket_idx) {
+  // 只清掉readable位,occupied位保留下来当墓碑,这样查找时不会提前停下
+  readable_[bucket_idx / 8] &= static_cast<char>(~(1 << (bucket_idx % 8)));
+}
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BUCKET_TYPE::IsOccupied(uint32_t bucket_idx) const -> bool {
-  return false;
+  return (occupied_[bucket_idx / 8] & (1 << (bucket_idx % 8))) != 0;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_BUCKET_TYPE::SetOccupied(uint32_t bucket_idx) {}
+void HASH_TABLE_BUCKET_TYPE::SetOccupied(uint32_t bucket_idx) {
+  occupied_[bucket_idx / 8] |= static_cast<char>(1 << (bucket_idx % 8));
+}
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BUCKET_TYPE::IsReadable(uint32_t bucket_idx) const -> bool {
-  return false;
+  return (readable_[bucket_idx / 8] & (1 << (bucket_idx % 8))) != 0;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_BUCKET_TYPE::SetReadable(uint32_t bucket_idx) {}
+void HASH_TABLE_BUCKET_TYPE::SetReadable(uint32_t bucket_idx) {
+  readable_[bucket_idx / 8] |= static_cast<char>(1 << (bucket_idx % 8));
+}
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BUCKET_TYPE::IsFull() -> bool {
-  return false;
+  return NumReadable() == BUCKET_ARRAY_SIZE;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BUCKET_TYPE::NumReadable() -> uint32_t {
-  return 0;
+  uint32_t num = 0;
+  for (auto byte : readable_) {
+    num += __builtin_popcount(static_cast<unsigned char>(byte));
+  }
+  return num;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BUCKET_TYPE::IsEmpty() -> bool {
-  return false;
+  for (auto byte : readable_) {
+    if (byte != 0) {
+      return false;
+    }
+  }
+  return true;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
@@ -0,0 +1,354 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// pax_page.cpp
+//
+// Identification: src/storage/page/pax_page.cpp
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/pax_page.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "common/exception.h"
+#include "storage/page/table_page.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+static_assert(PAX_PAGE_HEADER_SIZE >= TABLE_PAGE_HEADER_SIZE);
+
+namespace {
+
+constexpr uint32_t VARLEN_ENTRY_SIZE = 2 * sizeof(uint16_t);
+
+/** @return where the data of a VARCHAR value starts in a tuple */
+auto VarlenData(const Tuple &tuple, uint32_t tuple_offset) -> const char * {
+  tuple_offset_t offset;
+  memcpy(&offset, tuple.GetData() + tuple_offset, sizeof(tuple_offset_t));
+  return tuple.GetData() + offset + sizeof(tuple_offset_t);
+}
+
+}  // namespace
+
+PaxLayout::PaxLayout(const Schema &schema) : schema_(schema) {
+  slot_size_ = TUPLE_META_SIZE + 1;
+  uint32_t varlen_per_slot = 0;
+  for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+    const auto &column = schema.GetColumn(i);
+    auto width = column.IsInlined() ? column.GetFixedLength() : VARLEN_ENTRY_SIZE;
+    columns_.push_back(ColumnInfo{column.GetOffset(), width, column.IsInlined(), 0});
+    slot_size_ += width;
+    if (!column.IsInlined()) {
+      varlen_columns_.push_back(i);
+      // 按一半的声明长度估计变长数据,写满声明长度的行也放得进空页
+      varlen_per_slot += column.GetLength() / 2;
+    }
+  }
+  // 空值位图也当成一列定长的小页存
+  bitmap_ = ColumnInfo{schema.GetLength(), Tuple::GetNullBitmapSize(&schema), true, 0};
+  slot_size_ += bitmap_.width_;
+  if (slot_size_ > BUSTUB_PAGE_SIZE - PAX_PAGE_HEADER_SIZE) {
+    throw Exception("too many columns for a PAX page");
+  }
+  capacity_ = std::max<uint32_t>((BUSTUB_PAGE_SIZE - PAX_PAGE_HEADER_SIZE) / (slot_size_ + varlen_per_slot), 1);
+
+  // 元数据和回收标记之后依次是每一列的小页
+  uint32_t offset = PAX_PAGE_HEADER_SIZE + (TUPLE_META_SIZE + 1) * capacity_;
+  for (auto &column : columns_) {
+    column.page_offset_ = offset;
+    offset += column.width_ * capacity_;
+  }
+  bitmap_.page_offset_ = offset;
+  offset += bitmap_.width_ * capacity_;
+  fixed_end_ = offset;
+
+  std::vector<Value> nulls;
+  for (const auto &column : schema.GetColumns()) {
+    nulls.push_back(ValueFactory::GetNullValueByType(column.GetType()));
+  }
+  Tuple null_tuple(nulls, &schema);
+  null_tuple_.assign(null_tuple.GetData(), null_tuple.GetData() + bitmap_.tuple_offset_ + bitmap_.width_);
+}
+
+auto PaxLayout::VarlenLength(const Tuple &tuple, uint32_t col_idx) const -> uint32_t {
+  if (tuple.IsNull(&schema_, col_idx)) {
+    return BUSTUB_VALUE_NULL;
+  }
+  tuple_offset_t offset;
+  memcpy(&offset, tuple.GetData() + columns_[col_idx].tuple_offset_, sizeof(tuple_offset_t));
+  tuple_offset_t len;
+  memcpy(&len, tuple.GetData() + offset, sizeof(tuple_offset_t));
+  return len;
+}
+
+void PaxPage::Init() {
+  next_page_id_ = INVALID_PAGE_ID;
+  num_tuples_ = 0;
+  num_deleted_tuples_ = 0;
+  varlen_offset_ = BUSTUB_PAGE_SIZE;
+  reserved_ = 0;
+}
+
+auto PaxPage::GetFreeSpace(const PaxLayout &layout) const -> size_t {
+  if (num_tuples_ >= layout.capacity_) {
+    return 0;
+  }
+  if (layout.varlen_columns_.empty()) {
+    return (layout.capacity_ - num_tuples_) * layout.slot_size_;
+  }
+  // 变长区只够下一行用多少算多少,报多了插入线程会反复拿到放不下的页
+  return layout.slot_size_ + (varlen_offset_ - layout.fixed_end_);
+}
+
+auto PaxPage::GetUnusedSpace(const PaxLayout &layout) const -> size_t {
+  return (layout.capacity_ - num_tuples_) * layout.slot_size_ + (varlen_offset_ - layout.fixed_end_);
+}
+
+auto PaxPage::GetSpaceNeeded(const PaxLayout &layout, const Tuple &tuple) -> size_t {
+  size_t space = layout.slot_size_;
+  for (auto col_idx : layout.varlen_columns_) {
+    auto len = layout.VarlenLength(tuple, col_idx);
+    space += len == BUSTUB_VALUE_NULL ? 0 : len;
+  }
+  return space;
+}
+
+auto PaxPage::InsertTuple(const PaxLayout &layout, const TupleMeta &meta, const Tuple &tuple)
+    -> std::optional<uint16_t> {
+  if (num_tuples_ >= layout.capacity_ ||
+      GetSpaceNeeded(layout, tuple) - layout.slot_size_ > static_cast<size_t>(varlen_offset_ - layout.fixed_end_)) {
+    return std::nullopt;
+  }
+  auto slot = num_tuples_;
+  memcpy(page_start_ + MetaOffset(slot), &meta, TUPLE_META_SIZE);
+  page_start_[ReclaimedOffset(layout, slot)] = 0;
+  memcpy(page_start_ + BitmapOffset(layout, slot), tuple.GetData() + layout.bitmap_.tuple_offset_,
+         layout.bitmap_.width_);
+  for (uint32_t col_idx = 0; col_idx < layout.columns_.size(); col_idx++) {
+    const auto &column = layout.columns_[col_idx];
+    if (column.inlined_) {
+      memcpy(page_start_ + ValueOffset(layout, col_idx, slot), tuple.GetData() + column.tuple_offset_, column.width_);
+      continue;
+    }
+    auto len = layout.VarlenLength(tuple, col_idx);
+    VarlenEntry entry{0, VARLEN_NULL};
+    if (len != BUSTUB_VALUE_NULL) {
+      varlen_offset_ -= len;
+      memcpy(page_start_ + varlen_offset_, VarlenData(tuple, column.tuple_offset_), len);
+      entry = {varlen_offset_, static_cast<uint16_t>(len)};
+    }
+    memcpy(page_start_ + ValueOffset(layout, col_idx, slot), &entry, VARLEN_ENTRY_SIZE);
+  }
+  num_tuples_++;
+  return slot;
+}
+
+auto PaxPage::CheckSlot(const RID &rid) const -> uint16_t {
+  if (rid.GetSlotNum() >= num_tuples_) {
+    throw bustub::Exception("Tuple ID out of range");
+  }
+  return rid.GetSlotNum();
+}
+
+void PaxPage::UpdateTupleMeta(const TupleMeta &meta, const RID &rid) {
+  auto slot = CheckSlot(rid);
+  if (!GetTupleMeta(rid).is_deleted_ && meta.is_deleted_) {
+    num_deleted_tuples_++;
+  }
+  memcpy(page_start_ + MetaOffset(slot), &meta, TUPLE_META_SIZE);
+}
+
+auto PaxPage::GetTupleMeta(const RID &rid) const -> TupleMeta {
+  auto slot = CheckSlot(rid);
+  TupleMeta meta;
+  memcpy(&meta, page_start_ + MetaOffset(slot), TUPLE_META_SIZE);
+  return meta;
+}
+
+auto PaxPage::GetTuple(const PaxLayout &layout, const RID &rid, const std::vector<uint32_t> *columns) const
+    -> std::pair<TupleMeta, Tuple> {
+  auto slot = CheckSlot(rid);
+  auto meta = GetTupleMeta(rid);
+  Tuple tuple(rid);
+  if (page_start_[ReclaimedOffset(layout, slot)] == 0) {
+    ReadTupleData(layout, slot, columns, &tuple.data_);
+  }
+  return std::make_pair(meta, std::move(tuple));
+}
+
+auto PaxPage::GetTupleView(const PaxLayout &layout, const RID &rid, const std::vector<uint32_t> *columns,
+                           std::vector<char> *buffer) const -> std::pair<TupleMeta, TupleView> {
+  auto slot = CheckSlot(rid);
+  auto meta = GetTupleMeta(rid);
+  if (page_start_[ReclaimedOffset(layout, slot)] != 0) {
+    return std::make_pair(meta, TupleView(nullptr, 0, rid));
+  }
+  ReadTupleData(layout, slot, columns, buffer);
+  return std::make_pair(meta, TupleView(buffer->data(), buffer->size(), rid));
+}
+
+void PaxPage::ReadTupleData(const PaxLayout &layout, uint16_t slot, const std::vector<uint32_t> *columns,
+                            std::vector<char> *out) const {
+  auto is_read = [&](uint32_t col_idx) {
+    return columns == nullptr || std::find(columns->begin(), columns->end(), col_idx) != columns->end();
+  };
+  auto read_varlen = [&](uint32_t col_idx) {
+    VarlenEntry entry{0, VARLEN_NULL};
+    if (is_read(col_idx)) {
+      memcpy(&entry, page_start_ + ValueOffset(layout, col_idx, slot), VARLEN_ENTRY_SIZE);
+    }
+    return entry;
+  };
+
+  // 和Tuple的格式一样:定长部分和空值位图之后按列的顺序放变长数据,没读的列都是NULL
+  size_t size = layout.null_tuple_.size();
+  for (auto col_idx : layout.varlen_columns_) {
+    auto entry = read_varlen(col_idx);
+    size += entry.len_ == VARLEN_NULL ? 0 : sizeof(tuple_offset_t) + entry.len_;
+  }
+  // 反复用同一块缓冲区读的时候,resize不会再分配
+  out->resize(size);
+  auto data = out->data();
+  memcpy(data, layout.null_tuple_.data(), layout.null_tuple_.size());
+  auto data_offset = static_cast<tuple_offset_t>(layout.null_tuple_.size());
+  for (auto col_idx : layout.varlen_columns_) {
+    auto entry = read_varlen(col_idx);
+    if (entry.len_ == VARLEN_NULL) {
+      continue;
+    }
+    memcpy(data + layout.columns_[col_idx].tuple_offset_, &data_offset, sizeof(tuple_offset_t));
+    memcpy(data + data_offset, &entry.len_, sizeof(tuple_offset_t));
+    data_offset += sizeof(tuple_offset_t);
+    memcpy(data + data_offset, page_start_ + entry.offset_, entry.len_);
+    data_offset += entry.len_;
+  }
+
+  // 位图里没读的列保持NULL,读了的列从页上的位图拿
+  auto bitmap = data + layout.bitmap_.tuple_offset_;
+  const auto *stored_bitmap = page_start_ + BitmapOffset(layout, slot);
+  if (columns == nullptr) {
+    memcpy(bitmap, stored_bitmap, layout.bitmap_.width_);
+  } else {
+    for (auto col_idx : *columns) {
+      auto mask = static_cast<char>(1 << (col_idx % 8));
+      bitmap[col_idx / 8] = static_cast<char>((bitmap[col_idx / 8] & ~mask) | (stored_bitmap[col_idx / 8] & mask));
+    }
+  }
+
+  // 定长的列只读要的那几个小页
+  auto read_value = [&](uint32_t col_idx) {
+    const auto &column = layout.columns_[col_idx];
+    if (column.inlined_) {
+      memcpy(data + column.tuple_offset_, page_start_ + ValueOffset(layout, col_idx, slot), column.width_);
+    }
+  };
+  if (columns == nullptr) {
+    for (uint32_t col_idx = 0; col_idx < layout.columns_.size(); col_idx++) {
+      read_value(col_idx);
+    }
+  } else {
+    std::for_each(columns->begin(), columns->end(), read_value);
+  }
+}
+
+auto PaxPage::CanUpdateInPlace(const PaxLayout &layout, const Tuple &tuple, const RID &rid) const -> bool {
+  if (rid.GetSlotNum() >= num_tuples_) {
+    return false;
+  }
+  auto slot = static_cast<uint16_t>(rid.GetSlotNum());
+  if (page_start_[ReclaimedOffset(layout, slot)] != 0) {
+    return false;
+  }
+  for (auto col_idx : layout.varlen_columns_) {
+    VarlenEntry entry;
+    memcpy(&entry, page_start_ + ValueOffset(layout, col_idx, slot), VARLEN_ENTRY_SIZE);
+    auto len = layout.VarlenLength(tuple, col_idx);
+    if (len != BUSTUB_VALUE_NULL && (entry.len_ == VARLEN_NULL || len > entry.len_)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void PaxPage::UpdateTupleInPlaceUnsafe(const PaxLayout &layout, const TupleMeta &meta, const Tuple &tuple, RID rid) {
+  CheckSlot(rid);
+  // 先检查所有变长的值都放得回原来的位置,再动页上的数据
+  if (!CanUpdateInPlace(layout, tuple, rid)) {
+    throw bustub::Exception("Tuple size mismatch");
+  }
+  auto slot = static_cast<uint16_t>(rid.GetSlotNum());
+  UpdateTupleMeta(meta, rid);
+  memcpy(page_start_ + BitmapOffset(layout, slot), tuple.GetData() + layout.bitmap_.tuple_offset_,
+         layout.bitmap_.width_);
+  for (uint32_t col_idx = 0; col_idx < layout.columns_.size(); col_idx++) {
+    const auto &column = layout.columns_[col_idx];
+    auto value = page_start_ + ValueOffset(layout, col_idx, slot);
+    if (column.inlined_) {
+      memcpy(value, tuple.GetData() + column.tuple_offset_, column.width_);
+      continue;
+    }
+    VarlenEntry entry;
+    memcpy(&entry, value, VARLEN_ENTRY_SIZE);
+    auto len = layout.VarlenLength(tuple, col_idx);
+    if (len == BUSTUB_VALUE_NULL) {
+      entry.len_ = VARLEN_NULL;
+    } else {
+      memcpy(page_start_ + entry.offset_, VarlenData(tuple, column.tuple_offset_), len);
+      entry.len_ = static_cast<uint16_t>(len);
+    }
+    memcpy(value, &entry, VARLEN_ENTRY_SIZE);
+  }
+}
+
+auto PaxPage::Compact(const PaxLayout &layout) -> size_t {
+  auto old_unused_space = GetUnusedSpace(layout);
+  while (num_tuples_ > 0 && GetTupleMeta(RID{0, static_cast<uint32_t>(num_tuples_ - 1)}).is_deleted_) {
+    num_tuples_--;
+  }
+  // 死行的变长值置成NULL,活着的变长值按位置从高到低往页尾挪,挪过去不会盖掉还没挪的值
+  std::vector<size_t> entry_offsets;
+  uint16_t num_deleted_tuples = 0;
+  for (uint16_t slot = 0; slot < num_tuples_; slot++) {
+    auto is_deleted = GetTupleMeta(RID{0, slot}).is_deleted_;
+    if (is_deleted) {
+      num_deleted_tuples++;
+      page_start_[ReclaimedOffset(layout, slot)] = 1;
+    }
+    for (auto col_idx : layout.varlen_columns_) {
+      auto entry_offset = ValueOffset(layout, col_idx, slot);
+      if (is_deleted) {
+        VarlenEntry entry{0, VARLEN_NULL};
+        memcpy(page_start_ + entry_offset, &entry, VARLEN_ENTRY_SIZE);
+      } else {
+        entry_offsets.push_back(entry_offset);
+      }
+    }
+  }
+  auto entry_at = [&](size_t entry_offset) {
+    VarlenEntry entry;
+    memcpy(&entry, page_start_ + entry_offset, VARLEN_ENTRY_SIZE);
+    return entry;
+  };
+  std::sort(entry_offsets.begin(), entry_offsets.end(),
+            [&](size_t a, size_t b) { return entry_at(a).offset_ > entry_at(b).offset_; });
+  uint16_t data_end = BUSTUB_PAGE_SIZE;
+  for (auto entry_offset : entry_offsets) {
+    auto entry = entry_at(entry_offset);
+    if (entry.len_ == VARLEN_NULL) {
+      continue;
+    }
+    data_end -= entry.len_;
+    memmove(page_start_ + data_end, page_start_ + entry.offset_, entry.len_);
+    entry.offset_ = data_end;
+    memcpy(page_start_ + entry_offset, &entry, VARLEN_ENTRY_SIZE);
+  }
+  varlen_offset_ = data_end;
+  num_deleted_tuples_ = num_deleted_tuples;
+  return GetUnusedSpace(layout) - old_unused_space;
+}
+
+}  // namespace bustub
@@ -28,6 +28,11 @@ void TablePage::Init() {
   num_deleted_tuples_ = 0;
 }
 
+auto TablePage::GetFreeSpace() const -> size_t {
+  size_t slot_end_offset = num_tuples_ > 0 ? std::get<0>(tuple_info_[num_tuples_ - 1]) : BUSTUB_PAGE_SIZE;
+  return slot_end_offset - TABLE_PAGE_HEADER_SIZE - TUPLE_INFO_SIZE * num_tuples_;
+}
+
 auto TablePage::GetNextTupleOffset(const TupleMeta &meta, const Tuple &tuple) const -> std::optional<uint16_t> {
   size_t slot_end_offset;
   if (num_tuples_ > 0) {
@@ -36,12 +41,12 @@ auto TablePage::GetNextTupleOffset(const TupleMeta &meta, const Tuple &tuple) co
   } else {
     slot_end_offset = BUSTUB_PAGE_SIZE;
   }
-  auto tuple_offset = slot_end_offset - tuple.GetLength();
   auto offset_size = TABLE_PAGE_HEADER_SIZE + TUPLE_INFO_SIZE * (num_tuples_ + 1);
-  if (tuple_offset < offset_size) {
+  // 先比长度再相减,无符号数减成负的会绕回去
+  if (slot_end_offset < offset_size + tuple.GetLength()) {
     return std::nullopt;
   }
-  return tuple_offset;
+  return slot_end_offset - tuple.GetLength();
 }
 
 auto TablePage::InsertTuple(const TupleMeta &meta, const Tuple &tuple) -> std::optional<uint16_t> {
@@ -81,6 +86,15 @@ auto TablePage::GetTuple(const RID &rid) const -> std::pair<TupleMeta, Tuple> {
   return std::make_pair(meta, std::move(tuple));
 }
 
+auto TablePage::GetTupleView(const RID &rid) const -> std::pair<TupleMeta, TupleView> {
+  auto tuple_id = rid.GetSlotNum();
+  if (tuple_id >= num_tuples_) {
+    throw bustub::Exception("Tuple ID out of range");
+  }
+  auto &[offset, size, meta] = tuple_info_[tuple_id];
+  return std::make_pair(meta, TupleView(page_start_ + offset, size, rid));
+}
+
 auto TablePage::GetTupleMeta(const RID &rid) const -> TupleMeta {
   auto tuple_id = rid.GetSlotNum();
   if (tuple_id >= num_tuples_) {
@@ -90,6 +104,11 @@ auto TablePage::GetTupleMeta(const RID &rid) const -> TupleMeta {
   return meta;
 }
 
+auto TablePage::CanUpdateInPlace(const Tuple &tuple, const RID &rid) const -> bool {
+  auto tuple_id = rid.GetSlotNum();
+  return tuple_id < num_tuples_ && std::get<1>(tuple_info_[tuple_id]) == tuple.GetLength();
+}
+
 void TablePage::UpdateTupleInPlaceUnsafe(const TupleMeta &meta, const Tuple &tuple, RID rid) {
   auto tuple_id = rid.GetSlotNum();
   if (tuple_id >= num_tuples_) {
@@ -106,4 +125,28 @@ void TablePage::UpdateTupleInPlaceUnsafe(const TupleMeta &meta, const Tuple &tup
   memcpy(page_start_ + offset, tuple.data_.data(), tuple.GetLength());
 }
 
+auto TablePage::Compact() -> size_t {
+  auto old_free_space = GetFreeSpace();
+  // 末尾的死行连槽一起去掉,槽号留给新插入的行
+  while (num_tuples_ > 0 && std::get<2>(tuple_info_[num_tuples_ - 1]).is_deleted_) {
+    num_tuples_--;
+  }
+  // 中间的死行留着空槽,活着的行rid不变。数据按槽号从页尾往前重新排,
+  // 前面的槽只会往页尾挪,按顺序memmove不会盖掉还没挪的数据
+  size_t data_end = BUSTUB_PAGE_SIZE;
+  uint16_t num_deleted_tuples = 0;
+  for (uint16_t tuple_id = 0; tuple_id < num_tuples_; tuple_id++) {
+    auto &[offset, size, meta] = tuple_info_[tuple_id];
+    if (meta.is_deleted_) {
+      num_deleted_tuples++;
+      size = 0;
+    }
+    data_end -= size;
+    memmove(page_start_ + data_end, page_start_ + offset, size);
+    offset = data_end;
+  }
+  num_deleted_tuples_ = num_deleted_tuples;
+  return GetFreeSpace() - old_free_space;
+}
+
 }  // namespace bustub
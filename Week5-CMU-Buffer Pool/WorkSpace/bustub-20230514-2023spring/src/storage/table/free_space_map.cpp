@@ -0,0 +1,87 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map.cpp
+//
+// Identification: src/storage/table/free_space_map.cpp
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/table/free_space_map.h"
+
+#include <algorithm>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+auto FreeSpaceMap::CategoryOf(size_t free_space) -> uint8_t {
+  return static_cast<uint8_t>(std::min<size_t>(free_space / CATEGORY_BYTES, MAX_CATEGORY));
+}
+
+void FreeSpaceMap::AddPage(page_id_t page_id, size_t free_space) {
+  std::scoped_lock guard(latch_);
+  BUSTUB_ASSERT(index_of_.count(page_id) == 0, "page is already tracked");
+  if (page_ids_.size() == capacity_) {
+    // 叶子满了就把树扩成两倍,重新算一遍内部节点
+    auto old_capacity = capacity_;
+    capacity_ = std::max<size_t>(capacity_ * 2, 16);
+    std::vector<uint8_t> tree(capacity_ * 2, 0);
+    std::copy(tree_.begin() + old_capacity, tree_.begin() + old_capacity * 2, tree.begin() + capacity_);
+    for (size_t i = capacity_ - 1; i > 0; i--) {
+      tree[i] = std::max(tree[i * 2], tree[i * 2 + 1]);
+    }
+    tree_ = std::move(tree);
+  }
+  index_of_[page_id] = page_ids_.size();
+  page_ids_.push_back(page_id);
+  SetCategory(page_ids_.size() - 1, CategoryOf(free_space));
+}
+
+void FreeSpaceMap::Update(page_id_t page_id, size_t free_space) {
+  std::scoped_lock guard(latch_);
+  auto it = index_of_.find(page_id);
+  BUSTUB_ASSERT(it != index_of_.end(), "page is not tracked");
+  SetCategory(it->second, CategoryOf(free_space));
+}
+
+auto FreeSpaceMap::TakePage(size_t free_space) -> page_id_t {
+  // 向上取整,拿到的页一定放得下
+  auto category = std::max<size_t>((free_space + CATEGORY_BYTES - 1) / CATEGORY_BYTES, REUSE_CATEGORY);
+  if (category > MAX_CATEGORY) {
+    return INVALID_PAGE_ID;
+  }
+  std::scoped_lock guard(latch_);
+  if (capacity_ == 0 || tree_[1] < category) {
+    return INVALID_PAGE_ID;
+  }
+  // 从根往下走,左边够就走左边,找到的是第一个放得下的页
+  size_t node = 1;
+  while (node < capacity_) {
+    node = tree_[node * 2] >= category ? node * 2 : node * 2 + 1;
+  }
+  SetCategory(node - capacity_, 0);
+  return page_ids_[node - capacity_];
+}
+
+auto FreeSpaceMap::GetFreeSpace(page_id_t page_id) -> size_t {
+  std::scoped_lock guard(latch_);
+  auto it = index_of_.find(page_id);
+  BUSTUB_ASSERT(it != index_of_.end(), "page is not tracked");
+  return tree_[capacity_ + it->second] * CATEGORY_BYTES;
+}
+
+void FreeSpaceMap::SetCategory(size_t index, uint8_t category) {
+  size_t node = capacity_ + index;
+  tree_[node] = category;
+  for (node /= 2; node > 0; node /= 2) {
+    auto max = std::max(tree_[node * 2], tree_[node * 2 + 1]);
+    if (tree_[node] == max) {
+      break;
+    }
+    tree_[node] = max;
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,201 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// table_dictionary.cpp
+//
+// Identification: src/storage/table/table_dictionary.cpp
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/table/table_dictionary.h"
+
+#include <mutex>  // NOLINT
+
+#include "common/exception.h"
+#include "common/macros.h"
+#include "fmt/format.h"
+#include "storage/page/dictionary_page.h"
+#include "storage/page/page_guard.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+auto MakeStoredSchema(const Schema &schema) -> Schema {
+  std::vector<Column> columns;
+  columns.reserve(schema.GetColumnCount());
+  for (const auto &column : schema.GetColumns()) {
+    if (column.GetType() == TypeId::VARCHAR) {
+      columns.emplace_back(column.GetName(), TypeId::INTEGER);
+    } else {
+      columns.push_back(column);
+    }
+  }
+  return Schema(columns);
+}
+
+}  // namespace
+
+TableDictionary::TableDictionary(BufferPoolManager *bpm, const Schema &schema)
+    : bpm_(bpm), schema_(schema), stored_schema_(MakeStoredSchema(schema)) {
+  encoded_.reserve(schema.GetColumnCount());
+  for (const auto &column : schema.GetColumns()) {
+    encoded_.push_back(column.GetType() == TypeId::VARCHAR);
+  }
+}
+
+auto TableDictionary::HasEncodableColumns(const Schema &schema) -> bool {
+  for (const auto &column : schema.GetColumns()) {
+    if (column.GetType() == TypeId::VARCHAR) {
+      return true;
+    }
+  }
+  return false;
+}
+
+auto TableDictionary::Encode(const Tuple &tuple) -> Tuple {
+  std::vector<Value> values;
+  values.reserve(encoded_.size());
+  for (uint32_t i = 0; i < encoded_.size(); i++) {
+    values.push_back(tuple.GetValue(&schema_, i));
+  }
+
+  // 大多数字符串字典里已经有了,先拿读锁查;有没见过的再拿写锁重新查一遍,顺便加进去
+  auto to_codes = [&](const auto &get_code) {
+    std::vector<Value> stored;
+    stored.reserve(values.size());
+    for (uint32_t i = 0; i < values.size(); i++) {
+      if (!encoded_[i]) {
+        stored.push_back(values[i]);
+      } else if (values[i].IsNull()) {
+        stored.push_back(ValueFactory::GetNullValueByType(TypeId::INTEGER));
+      } else {
+        auto code = get_code(std::string(values[i].GetData(), values[i].GetLength()));
+        if (code == std::nullopt) {
+          return std::optional<std::vector<Value>>{};
+        }
+        stored.push_back(ValueFactory::GetIntegerValue(*code));
+      }
+    }
+    return std::make_optional(std::move(stored));
+  };
+
+  std::optional<std::vector<Value>> stored;
+  {
+    std::shared_lock<std::shared_mutex> guard(latch_);
+    stored = to_codes([&](const std::string &str) -> std::optional<int32_t> {
+      auto it = codes_.find(str);
+      return it == codes_.end() ? std::nullopt : std::make_optional(it->second);
+    });
+  }
+  if (stored == std::nullopt) {
+    std::unique_lock<std::shared_mutex> guard(latch_);
+    stored = to_codes([&](const std::string &str) -> std::optional<int32_t> { return AddString(str); });
+  }
+  Tuple result(std::move(*stored), &stored_schema_);
+  result.SetRid(tuple.GetRid());
+  return result;
+}
+
+auto TableDictionary::Decode(const TupleView &view) -> Tuple {
+  std::vector<Value> values;
+  values.reserve(encoded_.size());
+  std::shared_lock<std::shared_mutex> guard(latch_);
+  // 低基数的列字典一般就一页,同一页的字符串连着读不用每列都去缓冲池拿一次
+  ReadPageGuard page_guard;
+  page_id_t guarded_page_id = INVALID_PAGE_ID;
+  for (uint32_t i = 0; i < encoded_.size(); i++) {
+    if (!encoded_[i]) {
+      values.push_back(view.GetValue(&stored_schema_, i));
+      continue;
+    }
+    if (view.IsNull(&stored_schema_, i)) {
+      values.push_back(ValueFactory::GetNullValueByType(TypeId::VARCHAR));
+      continue;
+    }
+    auto code = view.GetValue(&stored_schema_, i).GetAs<int32_t>();
+    BUSTUB_ASSERT(code >= 0 && static_cast<size_t>(code) < entries_.size(), "code is not in the dictionary");
+    const auto &entry = entries_[code];
+    if (entry.page_id_ != guarded_page_id) {
+      page_guard = bpm_->FetchPageRead(entry.page_id_);
+      guarded_page_id = entry.page_id_;
+    }
+    auto str = page_guard.As<DictionaryPage>()->GetString(entry.offset_);
+    values.push_back(ValueFactory::GetVarcharValue(str.data(), str.size(), true));
+  }
+  Tuple result(std::move(values), &schema_);
+  result.SetRid(view.GetRid());
+  return result;
+}
+
+auto TableDictionary::DecodeValue(const Value &code) -> Value {
+  if (code.IsNull()) {
+    return ValueFactory::GetNullValueByType(TypeId::VARCHAR);
+  }
+  auto index = code.GetAs<int32_t>();
+  std::shared_lock<std::shared_mutex> guard(latch_);
+  BUSTUB_ASSERT(index >= 0 && static_cast<size_t>(index) < entries_.size(), "code is not in the dictionary");
+  const auto &entry = entries_[index];
+  auto page_guard = bpm_->FetchPageRead(entry.page_id_);
+  auto str = page_guard.As<DictionaryPage>()->GetString(entry.offset_);
+  return ValueFactory::GetVarcharValue(str.data(), str.size(), true);
+}
+
+auto TableDictionary::Lookup(const Value &value) -> std::optional<int32_t> {
+  BUSTUB_ASSERT(value.GetTypeId() == TypeId::VARCHAR && !value.IsNull(), "only a VARCHAR string has a code");
+  std::shared_lock<std::shared_mutex> guard(latch_);
+  auto it = codes_.find(std::string(value.GetData(), value.GetLength()));
+  if (it == codes_.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+auto TableDictionary::GetNumCodes() -> size_t {
+  std::shared_lock<std::shared_mutex> guard(latch_);
+  return entries_.size();
+}
+
+auto TableDictionary::AddString(const std::string &str) -> int32_t {
+  auto it = codes_.find(str);
+  if (it != codes_.end()) {
+    return it->second;
+  }
+  if (str.size() > DictionaryPage::MaxStringLength()) {
+    throw Exception(ExceptionType::OUT_OF_RANGE,
+                    fmt::format("string of {} bytes is too long for the dictionary of the table", str.size()));
+  }
+
+  std::optional<uint16_t> offset;
+  if (last_page_id_ != INVALID_PAGE_ID) {
+    auto page_guard = bpm_->FetchPageWrite(last_page_id_);
+    offset = page_guard.AsMut<DictionaryPage>()->AppendString(str);
+    if (offset == std::nullopt) {
+      // 最后一页放不下,接一页新的上去
+      page_id_t page_id = INVALID_PAGE_ID;
+      auto new_guard = bpm_->NewPageGuarded(&page_id);
+      BUSTUB_ENSURE(page_id != INVALID_PAGE_ID, "cannot allocate page");
+      auto page = new_guard.AsMut<DictionaryPage>();
+      page->Init();
+      offset = page->AppendString(str);
+      page_guard.AsMut<DictionaryPage>()->SetNextPageId(page_id);
+      last_page_id_ = page_id;
+    }
+  } else {
+    auto page_guard = bpm_->NewPageGuarded(&last_page_id_);
+    BUSTUB_ENSURE(last_page_id_ != INVALID_PAGE_ID, "cannot allocate page");
+    auto page = page_guard.AsMut<DictionaryPage>();
+    page->Init();
+    offset = page->AppendString(str);
+  }
+  BUSTUB_ASSERT(offset != std::nullopt, "an empty dictionary page holds any string");
+
+  auto code = static_cast<int32_t>(entries_.size());
+  entries_.push_back({last_page_id_, *offset});
+  codes_.emplace(str, code);
+  return code;
+}
+
+}  // namespace bustub
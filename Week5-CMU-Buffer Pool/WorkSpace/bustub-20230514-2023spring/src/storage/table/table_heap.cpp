@@ -10,8 +10,11 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <cassert>
-#include <mutex>  // NOLINT
+#include <functional>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
 #include <utility>
 
 #include "common/config.h"
@@ -21,88 +24,192 @@
 #include "concurrency/transaction.h"
 #include "fmt/format.h"
 #include "storage/page/page_guard.h"
+#include "storage/page/pax_page.h"
 #include "storage/page/table_page.h"
 #include "storage/table/table_heap.h"
 
 namespace bustub {
 
-TableHeap::TableHeap(BufferPoolManager *bpm) : bpm_(bpm) {
+TableHeap::TableHeap(BufferPoolManager *bpm, const Schema *schema, TableLayout layout, TableEncoding encoding)
+    : bpm_(bpm) {
+  if (encoding == TableEncoding::Dictionary) {
+    BUSTUB_ASSERT(schema != nullptr, "a dictionary-encoded table heap needs the schema of its tuples");
+    if (TableDictionary::HasEncodableColumns(*schema)) {
+      dictionary_ = std::make_unique<TableDictionary>(bpm, *schema);
+    }
+  }
+  if (layout == TableLayout::PAX) {
+    BUSTUB_ASSERT(schema != nullptr, "a PAX table heap needs the schema of its tuples");
+    // PAX页里存的是编码以后的行,按存储的schema分列
+    pax_layout_ = std::make_unique<PaxLayout>(dictionary_ != nullptr ? dictionary_->GetStoredSchema() : *schema);
+  }
   // Initialize the first table page.
   auto guard = bpm->NewPageGuarded(&first_page_id_);
   last_page_id_ = first_page_id_;
-  auto first_page = guard.AsMut<TablePage>();
-  BUSTUB_ASSERT(first_page != nullptr,
+  BUSTUB_ASSERT(guard.GetDataMut() != nullptr,
                 "Couldn't create a page for the table heap. Have you completed the buffer pool manager project?");
-  first_page->Init();
+  free_space_map_.AddPage(first_page_id_, PageInit(guard.GetDataMut()));
+  for (auto &page_id : insert_pages_) {
+    page_id = INVALID_PAGE_ID;
+  }
+  if (schema != nullptr && ZoneMap::HasTrackedColumns(*schema)) {
+    zone_map_ = std::make_unique<ZoneMap>(*schema);
+  }
+}
+
+TableHeap::~TableHeap() = default;
+
+auto TableHeap::StoredTuple(const Tuple &tuple, Tuple *encoded) -> const Tuple & {
+  if (dictionary_ == nullptr) {
+    return tuple;
+  }
+  *encoded = dictionary_->Encode(tuple);
+  return *encoded;
 }
 
 auto TableHeap::InsertTuple(const TupleMeta &meta, const Tuple &tuple, LockManager *lock_mgr, Transaction *txn,
                             table_oid_t oid) -> std::optional<RID> {
-  std::unique_lock<std::mutex> guard(latch_);
-  auto page_guard = bpm_->FetchPageWrite(last_page_id_);
+  Tuple encoded;
+  const auto &stored = StoredTuple(tuple, &encoded);
+  // 按线程分到不同的插入页上,每个线程只拿自己那一页的写锁
+  auto &insert_page =
+      insert_pages_[std::hash<std::thread::id>{}(std::this_thread::get_id()) % TABLE_HEAP_INSERT_PAGES];
+  auto space_needed = PageGetSpaceNeeded(stored);
+  page_id_t page_id = insert_page.load();
+  // 从空闲空间表拿到的页没能装进插入页槽(同组的线程先装了别的页),这一页只有这个线程在用,用完要自己还回去
+  bool private_page = false;
   while (true) {
-    auto page = page_guard.AsMut<TablePage>();
-    if (page->GetNextTupleOffset(meta, tuple) != std::nullopt) {
-      break;
+    if (page_id == INVALID_PAGE_ID) {
+      page_id = free_space_map_.TakePage(space_needed);
+      if (page_id == INVALID_PAGE_ID) {
+        page_id = AppendPage();
+      }
+      page_id_t expected = INVALID_PAGE_ID;
+      private_page = !insert_page.compare_exchange_strong(expected, page_id);
     }
 
-    // if there's no tuple in the page, and we can't insert the tuple, then this tuple is too large.
-    BUSTUB_ENSURE(page->GetNumTuples() != 0, "tuple is too large, cannot insert");
-
-    page_id_t next_page_id = INVALID_PAGE_ID;
-    auto npg = bpm_->NewPage(&next_page_id);
-    BUSTUB_ENSURE(next_page_id != INVALID_PAGE_ID, "cannot allocate page");
-
-    page->SetNextPageId(next_page_id);
+    auto page_guard = bpm_->FetchPageWrite(page_id);
+    auto page = page_guard.GetDataMut();
+    auto slot_id = PageInsertTuple(page, meta, stored);
+    if (slot_id != std::nullopt) {
+      // 还拿着页的写锁的时候记进zone map,zone map记的是解码以后的值
+      if (zone_map_ != nullptr) {
+        zone_map_->Add(page_id, tuple);
+      }
+      // 槽里的页只由把它从槽里摘下来的线程还回去;这里再还一次的话,别的组可能已经拿走了它,又会被第三个组拿到
+      if (private_page) {
+        free_space_map_.Update(page_id, PageGetFreeSpace(page));
+      }
+      if (lock_mgr != nullptr) {
+        BUSTUB_ENSURE(lock_mgr->LockRow(txn, LockManager::LockMode::EXCLUSIVE, oid, RID{page_id, *slot_id}),
+                      "failed to lock when inserting new tuple");
+      }
+      page_guard.Drop();
+      return RID(page_id, *slot_id);
+    }
 
-    auto next_page = reinterpret_cast<TablePage *>(npg->GetData());
-    next_page->Init();
+    // if there's no tuple in the page, and we can't insert the tuple, then this tuple is too large.
+    BUSTUB_ENSURE(page_guard.As<TablePage>()->GetNumTuples() != 0, "tuple is too large, cannot insert");
 
+    // 放不下就把这一页还回去,换一页。剩的空间不多的页空闲空间表不会再给出去
+    // 同组几个线程可能同时发现这一页满了,只有CAS把它从槽里摘下来的那个线程还,一页只还一次
+    page_id_t expected = page_id;
+    if (private_page || insert_page.compare_exchange_strong(expected, INVALID_PAGE_ID)) {
+      free_space_map_.Update(page_id, PageGetFreeSpace(page));
+    }
     page_guard.Drop();
-
-    // acquire latch here as TSAN complains. Given we only have one insertion thread, this is fine.
-    npg->WLatch();
-    auto next_page_guard = WritePageGuard{bpm_, npg};
-
-    last_page_id_ = next_page_id;
-    page_guard = std::move(next_page_guard);
+    page_id = INVALID_PAGE_ID;
   }
-  auto last_page_id = last_page_id_;
-
-  auto page = page_guard.AsMut<TablePage>();
-  auto slot_id = *page->InsertTuple(meta, tuple);
+}
 
-  // only allow one insertion at a time, otherwise it will deadlock.
-  guard.unlock();
+auto TableHeap::BulkInsertTuples(const TupleMeta &meta, const std::vector<Tuple> &tuples) -> std::vector<RID> {
+  std::vector<RID> rids;
+  rids.reserve(tuples.size());
+  // 刚建好的表只有一个空页,先把它填上,免得表开头一直留着一个空页
+  {
+    std::unique_lock<std::mutex> guard(latch_);
+    page_id_t page_id = last_page_id_;
+    guard.unlock();
+    auto page_guard = bpm_->FetchPageWrite(page_id);
+    if (!tuples.empty() && page_guard.As<TablePage>()->GetNumTuples() == 0) {
+      auto page = page_guard.GetDataMut();
+      PageInsertTuples(page, page_id, meta, tuples, &rids);
+      free_space_map_.Update(page_id, PageGetFreeSpace(page));
+    }
+  }
 
-  if (lock_mgr != nullptr) {
-    BUSTUB_ENSURE(lock_mgr->LockRow(txn, LockManager::LockMode::EXCLUSIVE, oid, RID{last_page_id, slot_id}),
-                  "failed to lock when inserting new tuple");
+  while (rids.size() < tuples.size()) {
+    page_id_t page_id = INVALID_PAGE_ID;
+    size_t free_space;
+    {
+      // 分配页号和接到链表末尾都在表锁里做,链表上的页才是按页号递增的,迭代器靠这个判断停在哪
+      std::scoped_lock guard(latch_);
+      auto page_guard = bpm_->NewPageGuarded(&page_id);
+      BUSTUB_ENSURE(page_id != INVALID_PAGE_ID, "cannot allocate page");
+      auto page = page_guard.GetDataMut();
+      PageInit(page);
+      // 新页还没接到链表上,也不在空闲空间表里,别的线程都看不到,写的时候不用拿页锁
+      PageInsertTuples(page, page_id, meta, tuples, &rids);
+      free_space = PageGetFreeSpace(page);
+      auto last_page_guard = bpm_->FetchPageWrite(last_page_id_);
+      last_page_guard.AsMut<TablePage>()->SetNextPageId(page_id);
+      last_page_id_ = page_id;
+    }
+    // 最后一页没填满的部分留给以后的插入
+    free_space_map_.AddPage(page_id, free_space);
   }
+  return rids;
+}
 
-  page_guard.Drop();
+void TableHeap::PageInsertTuples(char *page, page_id_t page_id, const TupleMeta &meta, const std::vector<Tuple> &tuples,
+                                 std::vector<RID> *rids) {
+  size_t first = rids->size();
+  Tuple encoded;
+  for (size_t i = first; i < tuples.size(); i++) {
+    auto slot_id = PageInsertTuple(page, meta, StoredTuple(tuples[i], &encoded));
+    if (slot_id == std::nullopt) {
+      break;
+    }
+    if (zone_map_ != nullptr) {
+      zone_map_->Add(page_id, tuples[i]);
+    }
+    rids->emplace_back(page_id, *slot_id);
+  }
+  BUSTUB_ENSURE(rids->size() > first, "tuple is too large, cannot insert");
+}
 
-  return RID(last_page_id, slot_id);
+auto TableHeap::AppendPage() -> page_id_t {
+  page_id_t page_id = INVALID_PAGE_ID;
+  {
+    // 分配页号和接到链表末尾要在同一把表锁里,否则并发追加的页会不按页号顺序接上
+    std::scoped_lock guard(latch_);
+    auto page_guard = bpm_->NewPageGuarded(&page_id);
+    BUSTUB_ENSURE(page_id != INVALID_PAGE_ID, "cannot allocate page");
+    PageInit(page_guard.GetDataMut());
+    auto last_page_guard = bpm_->FetchPageWrite(last_page_id_);
+    last_page_guard.AsMut<TablePage>()->SetNextPageId(page_id);
+    last_page_id_ = page_id;
+  }
+  // 接上链表之后再交给空闲空间表,插到这一页的行扫描一定看得到
+  free_space_map_.AddPage(page_id, 0);
+  return page_id;
 }
 
 void TableHeap::UpdateTupleMeta(const TupleMeta &meta, RID rid) {
   auto page_guard = bpm_->FetchPageWrite(rid.GetPageId());
-  auto page = page_guard.AsMut<TablePage>();
-  page->UpdateTupleMeta(meta, rid);
+  PageUpdateTupleMeta(page_guard.GetDataMut(), meta, rid);
 }
 
 auto TableHeap::GetTuple(RID rid) -> std::pair<TupleMeta, Tuple> {
   auto page_guard = bpm_->FetchPageRead(rid.GetPageId());
-  auto page = page_guard.As<TablePage>();
-  auto [meta, tuple] = page->GetTuple(rid);
+  auto [meta, tuple] = PageGetTuple(page_guard.GetData(), rid);
   tuple.rid_ = rid;
   return std::make_pair(meta, std::move(tuple));
 }
 
 auto TableHeap::GetTupleMeta(RID rid) -> TupleMeta {
   auto page_guard = bpm_->FetchPageRead(rid.GetPageId());
-  auto page = page_guard.As<TablePage>();
-  return page->GetTupleMeta(rid);
+  return PageGetTupleMeta(page_guard.GetData(), rid);
 }
 
 auto TableHeap::MakeIterator() -> TableIterator {
@@ -117,10 +224,183 @@ auto TableHeap::MakeIterator() -> TableIterator {
 
 auto TableHeap::MakeEagerIterator() -> TableIterator { return {this, {first_page_id_, 0}, {INVALID_PAGE_ID, 0}}; }
 
+auto TableHeap::GetPageIds() -> std::vector<page_id_t> {
+  std::vector<page_id_t> page_ids;
+  for (page_id_t page_id = first_page_id_; page_id != INVALID_PAGE_ID;) {
+    page_ids.push_back(page_id);
+    auto page_guard = bpm_->FetchPageRead(page_id);
+    page_id = page_guard.As<TablePage>()->GetNextPageId();
+  }
+  return page_ids;
+}
+
+auto TableHeap::GetPageTuples(page_id_t page_id) -> std::vector<std::pair<TupleMeta, Tuple>> {
+  auto page_guard = bpm_->FetchPageRead(page_id);
+  auto num_tuples = page_guard.As<TablePage>()->GetNumTuples();
+  std::vector<std::pair<TupleMeta, Tuple>> tuples;
+  tuples.reserve(num_tuples);
+  for (uint32_t slot = 0; slot < num_tuples; slot++) {
+    tuples.push_back(PageGetTuple(page_guard.GetData(), RID{page_id, slot}));
+  }
+  return tuples;
+}
+
+auto TableHeap::Vacuum(const std::function<void(const Tuple &tuple, RID rid)> &on_reclaim) -> VacuumResult {
+  VacuumResult result;
+  for (auto page_id : GetPageIds()) {
+    auto page_guard = bpm_->FetchPageWrite(page_id);
+    auto page = page_guard.AsMut<TablePage>();
+    auto data = page_guard.GetDataMut();
+    if (page->GetNumDeletedTuples() == 0) {
+      continue;
+    }
+    for (uint32_t slot = 0; slot < page->GetNumTuples(); slot++) {
+      RID rid{page_id, slot};
+      auto [meta, tuple] = PageGetTuple(data, rid);
+      // 之前压缩过的死行只剩一个空槽
+      if (meta.is_deleted_ && tuple.GetLength() > 0) {
+        on_reclaim(tuple, rid);
+        result.tuples_++;
+      }
+    }
+    auto had_tuples = page->GetNumTuples() > 0;
+    result.bytes_ += PageCompact(data);
+    if (had_tuples && page->GetNumTuples() == 0) {
+      result.pages_emptied_++;
+    }
+    // 死行不再算进zone map,按剩下的行重新统计
+    if (zone_map_ != nullptr) {
+      zone_map_->Reset(page_id);
+      for (uint32_t slot = 0; slot < page->GetNumTuples(); slot++) {
+        auto [meta, tuple] = PageGetTuple(data, RID{page_id, slot});
+        if (!meta.is_deleted_) {
+          zone_map_->Add(page_id, tuple);
+        }
+      }
+    }
+    // 正在被插入的页留给插入线程,别的页把腾出来的空间登记到空闲空间表
+    if (std::find(insert_pages_.begin(), insert_pages_.end(), page_id) == insert_pages_.end()) {
+      free_space_map_.Update(page_id, PageGetFreeSpace(data));
+    }
+  }
+  return result;
+}
+
+auto TableHeap::UpdateTupleInPlace(const TupleMeta &meta, const Tuple &tuple, RID rid) -> bool {
+  // 编码列是定长的code,只改编码列的更新总能原地改
+  Tuple encoded;
+  const auto &stored = StoredTuple(tuple, &encoded);
+  auto page_guard = bpm_->FetchPageWrite(rid.GetPageId());
+  if (!PageCanUpdateInPlace(page_guard.GetData(), stored, rid)) {
+    return false;
+  }
+  PageUpdateTupleInPlace(page_guard.GetDataMut(), meta, stored, rid);
+  if (zone_map_ != nullptr) {
+    zone_map_->Add(rid.GetPageId(), tuple);
+  }
+  return true;
+}
+
 void TableHeap::UpdateTupleInPlaceUnsafe(const TupleMeta &meta, const Tuple &tuple, RID rid) {
+  Tuple encoded;
+  const auto &stored = StoredTuple(tuple, &encoded);
   auto page_guard = bpm_->FetchPageWrite(rid.GetPageId());
-  auto page = page_guard.AsMut<TablePage>();
-  page->UpdateTupleInPlaceUnsafe(meta, tuple, rid);
+  PageUpdateTupleInPlace(page_guard.GetDataMut(), meta, stored, rid);
+  if (zone_map_ != nullptr) {
+    zone_map_->Add(rid.GetPageId(), tuple);
+  }
+}
+
+auto TableHeap::PageInit(char *page) -> size_t {
+  if (pax_layout_ != nullptr) {
+    reinterpret_cast<PaxPage *>(page)->Init();
+  } else {
+    reinterpret_cast<TablePage *>(page)->Init();
+  }
+  return PageGetFreeSpace(page);
+}
+
+auto TableHeap::PageGetFreeSpace(const char *page) const -> size_t {
+  if (pax_layout_ != nullptr) {
+    return reinterpret_cast<const PaxPage *>(page)->GetFreeSpace(*pax_layout_);
+  }
+  return reinterpret_cast<const TablePage *>(page)->GetFreeSpace();
+}
+
+auto TableHeap::PageGetSpaceNeeded(const Tuple &tuple) const -> size_t {
+  if (pax_layout_ != nullptr) {
+    return PaxPage::GetSpaceNeeded(*pax_layout_, tuple);
+  }
+  return TablePage::GetSpaceNeeded(tuple);
+}
+
+auto TableHeap::PageInsertTuple(char *page, const TupleMeta &meta, const Tuple &tuple) -> std::optional<uint16_t> {
+  if (pax_layout_ != nullptr) {
+    return reinterpret_cast<PaxPage *>(page)->InsertTuple(*pax_layout_, meta, tuple);
+  }
+  return reinterpret_cast<TablePage *>(page)->InsertTuple(meta, tuple);
+}
+
+auto TableHeap::PageGetTuple(const char *page, RID rid, const std::vector<uint32_t> *columns) const
+    -> std::pair<TupleMeta, Tuple> {
+  auto result = pax_layout_ != nullptr ? reinterpret_cast<const PaxPage *>(page)->GetTuple(*pax_layout_, rid, columns)
+                                       : reinterpret_cast<const TablePage *>(page)->GetTuple(rid);
+  // vacuum过的死行只剩一个空槽,没什么可解码的
+  if (dictionary_ != nullptr && result.second.GetLength() > 0) {
+    result.second = dictionary_->Decode(TupleView(result.second));
+  }
+  return result;
+}
+
+auto TableHeap::PageGetTupleView(const char *page, RID rid, const std::vector<uint32_t> *columns,
+                                 std::vector<char> *buffer, bool decode) const -> std::pair<TupleMeta, TupleView> {
+  auto result = pax_layout_ != nullptr
+                    ? reinterpret_cast<const PaxPage *>(page)->GetTupleView(*pax_layout_, rid, columns, buffer)
+                    : reinterpret_cast<const TablePage *>(page)->GetTupleView(rid);
+  if (decode && dictionary_ != nullptr && result.second.GetLength() > 0) {
+    // 解码出来的行搬进buffer,PAX表拼行用的也是它,但拼好的行已经解码完用不上了
+    auto tuple = dictionary_->Decode(result.second);
+    *buffer = std::move(tuple.data_);
+    result.second = TupleView(buffer->data(), buffer->size(), rid);
+  }
+  return result;
+}
+
+auto TableHeap::PageGetTupleMeta(const char *page, RID rid) const -> TupleMeta {
+  if (pax_layout_ != nullptr) {
+    return reinterpret_cast<const PaxPage *>(page)->GetTupleMeta(rid);
+  }
+  return reinterpret_cast<const TablePage *>(page)->GetTupleMeta(rid);
+}
+
+void TableHeap::PageUpdateTupleMeta(char *page, const TupleMeta &meta, RID rid) {
+  if (pax_layout_ != nullptr) {
+    reinterpret_cast<PaxPage *>(page)->UpdateTupleMeta(meta, rid);
+  } else {
+    reinterpret_cast<TablePage *>(page)->UpdateTupleMeta(meta, rid);
+  }
+}
+
+auto TableHeap::PageCanUpdateInPlace(const char *page, const Tuple &tuple, RID rid) const -> bool {
+  if (pax_layout_ != nullptr) {
+    return reinterpret_cast<const PaxPage *>(page)->CanUpdateInPlace(*pax_layout_, tuple, rid);
+  }
+  return reinterpret_cast<const TablePage *>(page)->CanUpdateInPlace(tuple, rid);
+}
+
+void TableHeap::PageUpdateTupleInPlace(char *page, const TupleMeta &meta, const Tuple &tuple, RID rid) {
+  if (pax_layout_ != nullptr) {
+    reinterpret_cast<PaxPage *>(page)->UpdateTupleInPlaceUnsafe(*pax_layout_, meta, tuple, rid);
+  } else {
+    reinterpret_cast<TablePage *>(page)->UpdateTupleInPlaceUnsafe(meta, tuple, rid);
+  }
+}
+
+auto TableHeap::PageCompact(char *page) -> size_t {
+  if (pax_layout_ != nullptr) {
+    return reinterpret_cast<PaxPage *>(page)->Compact(*pax_layout_);
+  }
+  return reinterpret_cast<TablePage *>(page)->Compact();
 }
 
 }  // namespace bustub
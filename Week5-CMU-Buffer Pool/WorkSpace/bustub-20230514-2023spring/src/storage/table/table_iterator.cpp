@@ -24,47 +24,100 @@ TableIterator::TableIterator(TableHeap *table_heap, RID rid, RID stop_at_rid)
     : table_heap_(table_heap), rid_(rid), stop_at_rid_(stop_at_rid) {
   // If the rid doesn't correspond to a tuple (i.e., the table has just been initialized), then
   // we set rid_ to invalid.
-  auto page_guard = table_heap_->bpm_->FetchPageRead(rid_.GetPageId());
-  auto page = page_guard.As<TablePage>();
-  if (rid_.GetSlotNum() >= page->GetNumTuples()) {
-    rid_ = RID{INVALID_PAGE_ID, 0};
-  }
+  SkipToTuple();
+}
+
+TableIterator::TableIterator(TableIterator &&that) noexcept
+    : table_heap_(that.table_heap_), rid_(that.rid_), stop_at_rid_(that.stop_at_rid_),
+      page_(that.page_),
+      buffer_(std::move(that.buffer_)) {
+  that.page_ = nullptr;
+}
+
+TableIterator::~TableIterator() { MoveToPage(INVALID_PAGE_ID); }
+
+auto TableIterator::GetTuple(const std::vector<uint32_t> *columns) -> std::pair<TupleMeta, Tuple> {
+  auto page_guard = LatchPage();
+  return table_heap_->PageGetTuple(page_guard.GetData(), rid_, columns);
 }
 
-auto TableIterator::GetTuple() -> std::pair<TupleMeta, Tuple> { return table_heap_->GetTuple(rid_); }
+auto TableIterator::GetTupleView(ReadPageGuard &guard, const std::vector<uint32_t> *columns)
+    -> std::pair<TupleMeta, TupleView> {
+  BUSTUB_ASSERT(guard.PageId() == rid_.GetPageId(), "the guard must latch the page under the cursor");
+  return table_heap_->PageGetTupleView(guard.GetData(), rid_, columns, &buffer_);
+}
+
+auto TableIterator::GetStoredTupleView(ReadPageGuard &guard, const std::vector<uint32_t> *columns)
+    -> std::pair<TupleMeta, TupleView> {
+  BUSTUB_ASSERT(guard.PageId() == rid_.GetPageId(), "the guard must latch the page under the cursor");
+  return table_heap_->PageGetTupleView(guard.GetData(), rid_, columns, &buffer_, false);
+}
+
+auto TableIterator::GetTupleMeta() -> TupleMeta {
+  auto page_guard = LatchPage();
+  return table_heap_->PageGetTupleMeta(page_guard.GetData(), rid_);
+}
 
 auto TableIterator::GetRID() -> RID { return rid_; }
 
 auto TableIterator::IsEnd() -> bool { return rid_.GetPageId() == INVALID_PAGE_ID; }
 
 auto TableIterator::operator++() -> TableIterator & {
-  auto page_guard = table_heap_->bpm_->FetchPageRead(rid_.GetPageId());
-  auto page = page_guard.As<TablePage>();
-  auto next_tuple_id = rid_.GetSlotNum() + 1;
-
-  if (stop_at_rid_.GetPageId() != INVALID_PAGE_ID) {
-    BUSTUB_ASSERT(
-        /* case 1: cursor before the page of the stop tuple */ rid_.GetPageId() < stop_at_rid_.GetPageId() ||
-            /* case 2: cursor at the page before the tuple */
-            (rid_.GetPageId() == stop_at_rid_.GetPageId() && next_tuple_id <= stop_at_rid_.GetSlotNum()),
-        "iterate out of bound");
-  }
+  BUSTUB_ASSERT(!IsEnd(), "iterate out of bound");
+  rid_ = RID{rid_.GetPageId(), rid_.GetSlotNum() + 1};
+  SkipToTuple();
+  return *this;
+}
 
-  rid_ = RID{rid_.GetPageId(), next_tuple_id};
+void TableIterator::NextPage() {
+  BUSTUB_ASSERT(!IsEnd(), "iterate out of bound");
+  {
+    auto page_guard = LatchPage();
+    rid_ = RID{page_guard.As<TablePage>()->GetNextPageId(), 0};
+  }
+  SkipToTuple();
+}
 
-  if (rid_ == stop_at_rid_) {
-    rid_ = RID{INVALID_PAGE_ID, 0};
-  } else if (next_tuple_id < page->GetNumTuples()) {
-    // that's fine
-  } else {
-    auto next_page_id = page->GetNextPageId();
-    // if next page is invalid, RID is set to invalid page; otherwise, it's the first tuple in that page.
-    rid_ = RID{next_page_id, 0};
+void TableIterator::SkipToTuple() {
+  while (!IsEnd()) {
+    // 停在停止页的停止槽上,不比较页号大小
+    if (rid_.GetPageId() == stop_at_rid_.GetPageId() && rid_.GetSlotNum() >= stop_at_rid_.GetSlotNum()) {
+      rid_ = RID{INVALID_PAGE_ID, 0};
+      break;
+    }
+    // 只有换页的时候才经过缓冲池
+    if (page_ == nullptr || page_->GetPageId() != rid_.GetPageId()) {
+      MoveToPage(rid_.GetPageId());
+    }
+    auto page_guard = LatchPage();
+    auto page = page_guard.As<TablePage>();
+    if (rid_.GetSlotNum() < page->GetNumTuples()) {
+      return;
+    }
+    // 这一页走完了。离开停止页就结束,后面接上的页都是迭代器建好之后才有的
+    if (rid_.GetPageId() == stop_at_rid_.GetPageId()) {
+      rid_ = RID{INVALID_PAGE_ID, 0};
+      break;
+    }
+    // vacuum清空的页和刚接上还没插入的页一行都没有,接着往后找
+    rid_ = RID{page->GetNextPageId(), 0};
   }
+  MoveToPage(INVALID_PAGE_ID);
+}
 
-  page_guard.Drop();
+void TableIterator::MoveToPage(page_id_t page_id) {
+  if (page_ != nullptr) {
+    table_heap_->bpm_->UnpinPage(page_->GetPageId(), false);
+    page_ = nullptr;
+  }
+  if (page_id != INVALID_PAGE_ID) {
+    page_ = table_heap_->bpm_->FetchPage(page_id);
+  }
+}
 
-  return *this;
+auto TableIterator::LatchPage() -> ReadPageGuard {
+  page_->RLatch();
+  return {nullptr, page_};
 }
 
 }  // namespace bustub
@@ -12,26 +12,31 @@
 
 #include <cassert>
 #include <cstdlib>
+#include <cstring>
+#include <limits>
 #include <sstream>
 #include <string>
 #include <vector>
 
+#include "common/exception.h"
 #include "storage/table/tuple.h"
+#include "type/value_factory.h"
 
 namespace bustub {
 
-// TODO(Amadou): It does not look like nulls are supported. Add a null bitmap?
 Tuple::Tuple(std::vector<Value> values, const Schema *schema) {
   assert(values.size() == schema->GetColumnCount());
 
-  // 1. Calculate the size of the tuple.
-  uint32_t tuple_size = schema->GetLength();
+  // 1. Calculate the size of the tuple. NULL VARCHARs only take their bit in the bitmap.
+  uint32_t bitmap_offset = schema->GetLength();
+  uint32_t tuple_size = bitmap_offset + GetNullBitmapSize(schema);
   for (auto &i : schema->GetUnlinedColumns()) {
-    auto len = values[i].GetLength();
-    if (len == BUSTUB_VALUE_NULL) {
-      len = 0;
+    if (!values[i].IsNull()) {
+      tuple_size += sizeof(tuple_offset_t) + values[i].GetLength();
     }
-    tuple_size += (len + sizeof(uint32_t));
+  }
+  if (tuple_size > std::numeric_limits<tuple_offset_t>::max()) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "tuple is too large");
   }
 
   // 2. Allocate memory.
@@ -40,20 +45,28 @@ Tuple::Tuple(std::vector<Value> values, const Schema *schema) {
 
   // 3. Serialize each attribute based on the input value.
   uint32_t column_count = schema->GetColumnCount();
-  uint32_t offset = schema->GetLength();
+  auto offset = static_cast<tuple_offset_t>(bitmap_offset + GetNullBitmapSize(schema));
 
   for (uint32_t i = 0; i < column_count; i++) {
     const auto &col = schema->GetColumn(i);
+    if (values[i].IsNull()) {
+      data_[bitmap_offset + i / 8] |= static_cast<char>(1 << (i % 8));
+    }
     if (!col.IsInlined()) {
+      if (values[i].IsNull()) {
+        continue;
+      }
       // Serialize relative offset, where the actual varchar data is stored.
-      *reinterpret_cast<uint32_t *>(data_.data() + col.GetOffset()) = offset;
+      memcpy(data_.data() + col.GetOffset(), &offset, sizeof(tuple_offset_t));
       // Serialize varchar value, in place (size+data).
-      values[i].SerializeTo(data_.data() + offset);
-      auto len = values[i].GetLength();
-      if (len == BUSTUB_VALUE_NULL) {
-        len = 0;
-      }
-      offset += (len + sizeof(uint32_t));
+      auto len = static_cast<tuple_offset_t>(values[i].GetLength());
+      memcpy(data_.data() + offset, &len, sizeof(tuple_offset_t));
+      memcpy(data_.data() + offset + sizeof(tuple_offset_t), values[i].GetData(), len);
+      offset += sizeof(tuple_offset_t) + len;
+    } else if (values[i].IsNull()) {
+      // A NULL keeps its slot and holds the null value of the column type, so that an index key still reads it as
+      // NULL once a search bound has cleared its null flag, see GenericKey::SetNullsAsWildcards
+      ValueFactory::GetNullValueByType(col.GetType()).SerializeTo(data_.data() + col.GetOffset());
     } else {
       values[i].SerializeTo(data_.data() + col.GetOffset());
     }
@@ -61,37 +74,20 @@ Tuple::Tuple(std::vector<Value> values, const Schema *schema) {
 }
 
 auto Tuple::GetValue(const Schema *schema, const uint32_t column_idx) const -> Value {
-  assert(schema);
-  const TypeId column_type = schema->GetColumn(column_idx).GetType();
-  const char *data_ptr = GetDataPtr(schema, column_idx);
-  // the third parameter "is_inlined" is unused
-  return Value::DeserializeFrom(data_ptr, column_type);
+  return TupleView(*this).CopyValue(schema, column_idx);
 }
 
 auto Tuple::KeyFromTuple(const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs)
-    -> Tuple {
+    const -> Tuple {
   std::vector<Value> values;
   values.reserve(key_attrs.size());
   for (auto idx : key_attrs) {
-    values.emplace_back(this->GetValue(&schema, idx));
+    // key tuple会把值拷进去,读的时候不用先拷一份字符串
+    values.emplace_back(TupleView(*this).GetValue(&schema, idx));
   }
   return {values, &key_schema};
 }
 
-auto Tuple::GetDataPtr(const Schema *schema, const uint32_t column_idx) const -> const char * {
-  assert(schema);
-  const auto &col = schema->GetColumn(column_idx);
-  bool is_inlined = col.IsInlined();
-  // For inline type, data is stored where it is.
-  if (is_inlined) {
-    return (data_.data() + col.GetOffset());
-  }
-  // We read the relative offset from the tuple data.
-  int32_t offset = *reinterpret_cast<const int32_t *>(data_.data() + col.GetOffset());
-  // And return the beginning address of the real data for the VARCHAR type.
-  return (data_.data() + offset);
-}
-
 auto Tuple::ToString(const Schema *schema) const -> std::string {
   std::stringstream os;
 
@@ -117,6 +113,54 @@ auto Tuple::ToString(const Schema *schema) const -> std::string {
   return os.str();
 }
 
+TupleView::TupleView(const Tuple &tuple) : data_(tuple.data_.data()), size_(tuple.data_.size()), rid_(tuple.rid_) {}
+
+auto TupleView::GetValue(const Schema *schema, const uint32_t column_idx) const -> Value {
+  // 不拷贝字符串,Value直接指着视图里的数据
+  return ReadValue(schema, column_idx, false);
+}
+
+auto TupleView::CopyValue(const Schema *schema, const uint32_t column_idx) const -> Value {
+  return ReadValue(schema, column_idx, true);
+}
+
+auto TupleView::ReadValue(const Schema *schema, const uint32_t column_idx, bool copy_varlen) const -> Value {
+  assert(schema);
+  const TypeId column_type = schema->GetColumn(column_idx).GetType();
+  // NULL看位图就知道,不用反序列化
+  if (IsNull(schema, column_idx)) {
+    return ValueFactory::GetNullValueByType(column_type);
+  }
+  const char *data_ptr = GetDataPtr(schema, column_idx);
+  if (column_type != TypeId::VARCHAR) {
+    return Value::DeserializeFrom(data_ptr, column_type);
+  }
+  tuple_offset_t len;
+  memcpy(&len, data_ptr, sizeof(tuple_offset_t));
+  return {TypeId::VARCHAR, data_ptr + sizeof(tuple_offset_t), len, copy_varlen};
+}
+
+auto TupleView::Materialize() const -> Tuple {
+  Tuple tuple(rid_);
+  tuple.data_.assign(data_, data_ + size_);
+  return tuple;
+}
+
+auto TupleView::GetDataPtr(const Schema *schema, const uint32_t column_idx) const -> const char * {
+  assert(schema);
+  const auto &col = schema->GetColumn(column_idx);
+  bool is_inlined = col.IsInlined();
+  // For inline type, data is stored where it is.
+  if (is_inlined) {
+    return (data_ + col.GetOffset());
+  }
+  // We read the relative offset from the tuple data.
+  tuple_offset_t offset;
+  memcpy(&offset, data_ + col.GetOffset(), sizeof(tuple_offset_t));
+  // And return the beginning address of the real data for the VARCHAR type.
+  return (data_ + offset);
+}
+
 void Tuple::SerializeTo(char *storage) const {
   int32_t sz = data_.size();
   memcpy(storage, &sz, sizeof(int32_t));
@@ -0,0 +1,139 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// zone_map.cpp
+//
+// Identification: src/storage/table/zone_map.cpp
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/table/zone_map.h"
+
+#include <mutex>  // NOLINT
+
+namespace bustub {
+
+ZoneMap::ZoneMap(const Schema &schema) : schema_(schema), range_of_column_(schema.GetColumnCount(), -1) {
+  for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+    if (IsTracked(schema.GetColumn(i).GetType())) {
+      range_of_column_[i] = static_cast<int>(columns_.size());
+      columns_.push_back(i);
+    }
+  }
+}
+
+auto ZoneMap::IsTracked(TypeId type) -> bool {
+  // TIMESTAMP和别的数值类型比较不了,常量的类型对不上就没法剪枝,干脆不记
+  switch (type) {
+    case TypeId::TINYINT:
+    case TypeId::SMALLINT:
+    case TypeId::INTEGER:
+    case TypeId::BIGINT:
+    case TypeId::DECIMAL:
+      return true;
+    default:
+      return false;
+  }
+}
+
+auto ZoneMap::HasTrackedColumns(const Schema &schema) -> bool {
+  for (const auto &column : schema.GetColumns()) {
+    if (IsTracked(column.GetType())) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void ZoneMap::Add(page_id_t page_id, const Tuple &tuple) {
+  std::vector<Value> values;
+  values.reserve(columns_.size());
+  for (auto col_idx : columns_) {
+    values.push_back(tuple.GetValue(&schema_, col_idx));
+  }
+
+  // 调用方拿着这一页的写锁,改这一页的范围不用再拿整张表的锁
+  auto &ranges = GetPageRanges(page_id);
+  for (size_t i = 0; i < columns_.size(); i++) {
+    if (values[i].IsNull()) {
+      continue;
+    }
+    auto &range = ranges[i];
+    if (range.empty_) {
+      range.empty_ = false;
+      range.min_ = values[i];
+      range.max_ = values[i];
+      continue;
+    }
+    if (values[i].CompareLessThan(range.min_) == CmpBool::CmpTrue) {
+      range.min_ = values[i];
+    }
+    if (values[i].CompareGreaterThan(range.max_) == CmpBool::CmpTrue) {
+      range.max_ = values[i];
+    }
+  }
+}
+
+void ZoneMap::Reset(page_id_t page_id) { GetPageRanges(page_id).assign(columns_.size(), ColumnRange{}); }
+
+auto ZoneMap::GetPageRanges(page_id_t page_id) -> std::vector<ColumnRange> & {
+  {
+    std::shared_lock<std::shared_mutex> guard(latch_);
+    auto it = ranges_.find(page_id);
+    if (it != ranges_.end()) {
+      return it->second;
+    }
+  }
+  // 第一次见到这一页才拿写锁,unordered_map的元素在rehash以后地址也不变
+  std::unique_lock<std::shared_mutex> guard(latch_);
+  auto &ranges = ranges_[page_id];
+  if (ranges.empty()) {
+    ranges.resize(columns_.size());
+  }
+  return ranges;
+}
+
+auto ZoneMap::MayContain(page_id_t page_id, uint32_t col_idx, const Value *low, bool low_inclusive,
+                         const Value *high, bool high_inclusive) -> bool {
+  if (col_idx >= range_of_column_.size() || range_of_column_[col_idx] < 0) {
+    return true;
+  }
+  // 只和数值常量比,别的类型的常量要转换,交给filter去算
+  for (const auto *bound : {low, high}) {
+    if (bound != nullptr && (bound->IsNull() || !IsTracked(bound->GetTypeId()))) {
+      return true;
+    }
+  }
+
+  const std::vector<ColumnRange> *ranges;
+  {
+    std::shared_lock<std::shared_mutex> guard(latch_);
+    auto it = ranges_.find(page_id);
+    if (it == ranges_.end()) {
+      // 新接上的页可能已经插进了行,还没来得及记
+      return true;
+    }
+    ranges = &it->second;
+  }
+  // 范围本身由调用方拿着的页读锁保护
+  const auto &range = (*ranges)[range_of_column_[col_idx]];
+  if (range.empty_) {
+    return false;
+  }
+  if (low != nullptr) {
+    auto cmp = low_inclusive ? range.max_.CompareLessThan(*low) : range.max_.CompareLessThanEquals(*low);
+    if (cmp == CmpBool::CmpTrue) {
+      return false;
+    }
+  }
+  if (high != nullptr) {
+    auto cmp = high_inclusive ? range.min_.CompareGreaterThan(*high) : range.min_.CompareGreaterThanEquals(*high);
+    if (cmp == CmpBool::CmpTrue) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace bustub
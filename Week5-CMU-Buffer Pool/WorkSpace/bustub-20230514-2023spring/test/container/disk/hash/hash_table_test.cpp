@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <thread>  // NOLINT
 #include <vector>
 
@@ -18,13 +19,14 @@
 #include "container/disk/hash/disk_extendible_hash_table.h"
 #include "gtest/gtest.h"
 #include "murmur3/MurmurHash3.h"
+#include "test_util.h"  // NOLINT
 
 namespace bustub {
 
 // NOLINTNEXTLINE
 
 // NOLINTNEXTLINE
-TEST(HashTableTest, DISABLED_SampleTest) {
+TEST(HashTableTest, SampleTest) {
   auto *disk_manager = new DiskManager("test.db");
   auto *bpm = new BufferPoolManager(50, disk_manager);
   DiskExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
@@ -117,4 +119,157 @@ TEST(HashTableTest, DISABLED_SampleTest) {
   delete bpm;
 }
 
+// NOLINTNEXTLINE
+TEST(HashTableTest, GrowShrinkTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  DiskExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  const int num_keys = 10000;
+  for (int i = 0; i < num_keys; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+  }
+  ht.VerifyIntegrity();
+  EXPECT_GT(ht.GetGlobalDepth(), 0);
+
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(1, res.size()) << "Failed to keep " << i << std::endl;
+    EXPECT_EQ(i, res[0]);
+  }
+
+  // 删光以后桶应当逐个合并回去,目录收缩到一个槽位
+  for (int i = 0; i < num_keys; i++) {
+    EXPECT_TRUE(ht.Remove(nullptr, i, i));
+  }
+  ht.VerifyIntegrity();
+  EXPECT_EQ(0, ht.GetGlobalDepth());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, OverflowChainTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  DiskExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  // 同一个键的项比一个桶能放的还多,分裂分不开,只能接溢出页
+  const int num_values = 2000;
+  const int num_keys = 1000;
+  for (int i = 0; i < num_values; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, 0, i));
+  }
+  for (int i = 1; i < num_keys; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+  }
+  EXPECT_FALSE(ht.Insert(nullptr, 0, num_values - 1));
+  ht.VerifyIntegrity();
+
+  std::vector<int> res;
+  ht.GetValue(nullptr, 0, &res);
+  ASSERT_EQ(num_values, res.size());
+  std::sort(res.begin(), res.end());
+  for (int i = 0; i < num_values; i++) {
+    EXPECT_EQ(i, res[i]);
+  }
+  for (int i = 1; i < num_keys; i++) {
+    res.clear();
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(1, res.size()) << "Failed to keep " << i << std::endl;
+  }
+
+  for (int i = 0; i < num_values; i++) {
+    EXPECT_TRUE(ht.Remove(nullptr, 0, i));
+  }
+  for (int i = 1; i < num_keys; i++) {
+    EXPECT_TRUE(ht.Remove(nullptr, i, i));
+  }
+  ht.VerifyIntegrity();
+  EXPECT_EQ(0, ht.GetGlobalDepth());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, FullDirectoryTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<64> comparator(key_schema.get());
+  DiskExtendibleHashTable<GenericKey<64>, RID, GenericComparator<64>> ht("blah", bpm, comparator,
+                                                                          HashFunction<GenericKey<64>>());
+
+  // 键宽的桶只放得下几十项,键比一页目录的桶能放下的还多,目录长到头以后桶接着挂溢出页
+  const int64_t num_keys = 40000;
+  GenericKey<64> index_key;
+  for (int64_t key = 0; key < num_keys; key++) {
+    index_key.SetFromInteger(key);
+    ASSERT_TRUE(ht.Insert(nullptr, index_key, RID(key))) << "Failed to insert " << key << std::endl;
+  }
+  ht.VerifyIntegrity();
+  EXPECT_EQ(1U << ht.GetGlobalDepth(), DIRECTORY_ARRAY_SIZE);
+
+  for (int64_t key = 0; key < num_keys; key++) {
+    std::vector<RID> res;
+    index_key.SetFromInteger(key);
+    ht.GetValue(nullptr, index_key, &res);
+    ASSERT_EQ(1, res.size()) << "Failed to keep " << key << std::endl;
+    EXPECT_EQ(RID(key), res[0]);
+  }
+
+  for (int64_t key = 0; key < num_keys; key++) {
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(ht.Remove(nullptr, index_key, RID(key)));
+  }
+  ht.VerifyIntegrity();
+  EXPECT_EQ(0, ht.GetGlobalDepth());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, ConcurrentInsertTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  DiskExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  const int num_threads = 4;
+  const int keys_per_thread = 2000;
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&ht, tid]() {
+      for (int i = tid * keys_per_thread; i < (tid + 1) * keys_per_thread; i++) {
+        ht.Insert(nullptr, i, i);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  ht.VerifyIntegrity();
+
+  for (int i = 0; i < num_threads * keys_per_thread; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(1, res.size()) << "Failed to keep " << i << std::endl;
+    EXPECT_EQ(i, res[0]);
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
 }  // namespace bustub
@@ -0,0 +1,121 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// art_index_test.cpp
+//
+// Identification: test/storage/art_index_test.cpp
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/index/art_index.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+TEST(ARTIndexTest, InsertRemoveTest) {
+  Schema schema({Column("a", TypeId::INTEGER), Column("b", TypeId::INTEGER)});
+  ARTIndex index(std::make_unique<IndexMetadata>("art", "t", &schema, std::vector<uint32_t>{0}, true));
+  auto key = [&](int v) { return Tuple({ValueFactory::GetIntegerValue(v)}, index.GetKeySchema()); };
+
+  // 负数和正数混在一起,最低的字节取遍0到255,下面几层的结点会一路长到Node256
+  std::vector<int> keys;
+  for (int i = -5000; i < 5000; i++) {
+    keys.push_back(i * 7);
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+  for (auto k : keys) {
+    ASSERT_TRUE(index.InsertEntry(key(k), RID(k, 0), nullptr));
+  }
+  EXPECT_FALSE(index.InsertEntry(key(keys[0]), RID(0, 1), nullptr));
+  for (auto k : keys) {
+    std::vector<RID> result;
+    index.ScanKey(key(k), &result, nullptr);
+    ASSERT_EQ(result.size(), 1);
+    EXPECT_EQ(result[0], RID(k, 0));
+  }
+  std::vector<RID> result;
+  index.ScanKey(key(1), &result, nullptr);
+  EXPECT_TRUE(result.empty());
+
+  // 删掉一半,结点会一路缩小并合并回前缀
+  for (size_t i = 0; i < keys.size(); i += 2) {
+    index.DeleteEntry(key(keys[i]), RID(keys[i], 0), nullptr);
+  }
+  for (size_t i = 0; i < keys.size(); i++) {
+    result.clear();
+    index.ScanKey(key(keys[i]), &result, nullptr);
+    ASSERT_EQ(result.size(), i % 2 == 0 ? 0 : 1) << keys[i];
+  }
+  for (size_t i = 1; i < keys.size(); i += 2) {
+    index.DeleteEntry(key(keys[i]), RID(keys[i], 0), nullptr);
+  }
+  for (auto k : keys) {
+    result.clear();
+    index.ScanKey(key(k), &result, nullptr);
+    ASSERT_TRUE(result.empty());
+  }
+  // 清空之后还能继续用
+  EXPECT_TRUE(index.InsertEntry(key(42), RID(42, 0), nullptr));
+  index.ScanKey(key(42), &result, nullptr);
+  EXPECT_EQ(result.size(), 1);
+}
+
+TEST(ARTIndexTest, PrefixLookupTest) {
+  Schema schema({Column("name", TypeId::VARCHAR, 16), Column("n", TypeId::INTEGER), Column("v", TypeId::INTEGER)});
+  ARTIndex index(std::make_unique<IndexMetadata>("art", "t", &schema, std::vector<uint32_t>{0, 1}, false,
+                                                 std::vector<uint32_t>{2}));
+  auto entry = [&](const std::string &name, int n, int v) {
+    return Tuple({ValueFactory::GetVarcharValue(name), ValueFactory::GetIntegerValue(n), ValueFactory::GetIntegerValue(v)},
+                 index.GetEntrySchema());
+  };
+  std::vector<std::string> names{"corgi", "corg", "corgis", "husky", ""};
+  int64_t slot = 0;
+  for (const auto &name : names) {
+    for (int n = 0; n < 3; n++) {
+      // 每个键两个RID
+      ASSERT_TRUE(index.InsertEntry(entry(name, n, n * 10), RID(slot++), nullptr));
+      ASSERT_TRUE(index.InsertEntry(entry(name, n, n * 10 + 1), RID(slot++), nullptr));
+    }
+  }
+
+  auto bound = [&](const std::string &name) {
+    return Tuple({ValueFactory::GetVarcharValue(name), ValueFactory::GetNullValueByType(TypeId::INTEGER)},
+                 index.GetKeySchema());
+  };
+  for (const auto &name : names) {
+    // "corg"不能匹配到"corgi",字符串后面有结束符
+    auto key = bound(name);
+    auto iter = index.MakeScanIterator(&key, true, &key, true, false);
+    int count = 0;
+    for (; !iter->IsEnd(); iter->Next()) {
+      auto e = iter->GetEntry();
+      EXPECT_EQ(e.GetValue(index.GetEntrySchema(), 0).ToString(), name);
+      // 同一个前缀下按n的顺序出来
+      EXPECT_EQ(e.GetValue(index.GetEntrySchema(), 1).GetAs<int32_t>(), count / 2);
+      count++;
+    }
+    EXPECT_EQ(count, 6) << name;
+  }
+
+  Tuple full({ValueFactory::GetVarcharValue("corgi"), ValueFactory::GetIntegerValue(2)}, index.GetKeySchema());
+  std::vector<RID> result;
+  index.ScanKey(full, &result, nullptr);
+  EXPECT_EQ(result.size(), 2);
+  index.DeleteEntry(full, result[0], nullptr);
+  result.clear();
+  index.ScanKey(full, &result, nullptr);
+  EXPECT_EQ(result.size(), 1);
+
+  auto low = bound("corgi");
+  auto high = bound("husky");
+  EXPECT_THROW(index.MakeScanIterator(&low, true, &high, true, false), NotImplementedException);
+}
+
+}  // namespace bustub
@@ -0,0 +1,254 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_compaction_test.cpp
+//
+// Identification: test/storage/b_plus_tree_compaction_test.cpp
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/index/b_plus_tree.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+using Tree = BPlusTree<GenericKey<8>, RID, GenericComparator<8>>;
+
+static auto MakeKey(int64_t key) -> GenericKey<8> {
+  GenericKey<8> index_key;
+  index_key.SetFromInteger(key);
+  return index_key;
+}
+
+static auto CollectKeys(Tree *tree) -> std::vector<int64_t> {
+  std::vector<int64_t> keys;
+  for (auto iter = tree->Begin(); !iter.IsEnd(); ++iter) {
+    keys.push_back((*iter).second.GetSlotNum());
+  }
+  return keys;
+}
+
+TEST(BPlusTreeCompactionTest, LazyDeleteThenCompact) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+  bpm->UnpinPage(header_page_id, true);
+  Tree tree("foo_pk", header_page_id, bpm.get(), comparator, 4, 4, 0, true);
+
+  const int64_t num_keys = 400;
+  for (int64_t key = 0; key < num_keys; key++) {
+    ASSERT_TRUE(tree.Insert(MakeKey(key), RID(0, key)));
+  }
+  auto full_shape = tree.GetShape();
+
+  // 只留下10的倍数,叶子大多被删空,删除本身不合并
+  for (int64_t key = 0; key < num_keys; key++) {
+    if (key % 10 != 0) {
+      tree.Remove(MakeKey(key), nullptr);
+    }
+  }
+  std::vector<int64_t> expected;
+  for (int64_t key = 0; key < num_keys; key += 10) {
+    expected.push_back(key);
+  }
+  std::vector<RID> rids;
+  EXPECT_TRUE(tree.GetValue(MakeKey(30), &rids));
+  EXPECT_FALSE(tree.GetValue(MakeKey(31), &rids));
+  // 迭代器要跳过空的叶子
+  EXPECT_EQ(CollectKeys(&tree), expected);
+  {
+    // 迭代器拿着叶子的读锁,用完就放掉
+    auto iter = tree.Begin(MakeKey(31));
+    ASSERT_FALSE(iter.IsEnd());
+    EXPECT_EQ((*iter).second.GetSlotNum(), 40);
+  }
+
+  // 后台的压缩线程这时也可能被叫醒了,拿不到锁就再来
+  while (!tree.Compact()) {
+  }
+  auto compact_shape = tree.GetShape();
+  EXPECT_LT(compact_shape.leaf_pages_, full_shape.leaf_pages_ / 4);
+  EXPECT_LT(compact_shape.height_, full_shape.height_);
+  EXPECT_EQ(CollectKeys(&tree), expected);
+  for (auto key : expected) {
+    rids.clear();
+    EXPECT_TRUE(tree.GetValue(MakeKey(key), &rids));
+  }
+
+  // 合并过的树照常插入
+  for (int64_t key = 1; key < num_keys; key += 10) {
+    ASSERT_TRUE(tree.Insert(MakeKey(key), RID(0, key)));
+  }
+  EXPECT_EQ(CollectKeys(&tree).size(), expected.size() * 2);
+
+  // 删空以后压缩,根也被释放掉
+  for (int64_t key = 0; key < num_keys; key++) {
+    tree.Remove(MakeKey(key), nullptr);
+  }
+  EXPECT_TRUE(tree.Begin().IsEnd());
+  while (!tree.Compact()) {
+  }
+  EXPECT_TRUE(tree.IsEmpty());
+}
+
+TEST(BPlusTreeCompactionTest, CompactOnlyRecordedLeaves) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+  bpm->UnpinPage(header_page_id, true);
+  Tree tree("foo_pk", header_page_id, bpm.get(), comparator, 4, 4, 0, true);
+
+  const int64_t num_keys = 400;
+  for (int64_t key = 0; key < num_keys; key++) {
+    ASSERT_TRUE(tree.Insert(MakeKey(key), RID(0, key)));
+  }
+  auto full_shape = tree.GetShape();
+
+  // 只删中间的一段,删空的叶子都在这一段里
+  std::vector<int64_t> expected;
+  for (int64_t key = 0; key < num_keys; key++) {
+    if (key >= 200 && key < 300) {
+      tree.Remove(MakeKey(key), nullptr);
+    } else {
+      expected.push_back(key);
+    }
+  }
+  {
+    // 左边的叶子一直有读者拿着,只合并记下来的叶子,不会等它也不会因为它失败
+    auto iter = tree.Begin();
+    while (!tree.Compact()) {
+    }
+    EXPECT_EQ((*iter).second.GetSlotNum(), 0);
+  }
+  auto compact_shape = tree.GetShape();
+  EXPECT_LT(compact_shape.leaf_pages_, full_shape.leaf_pages_ - 100 / 3 + 2);
+  EXPECT_EQ(CollectKeys(&tree), expected);
+  std::vector<RID> rids;
+  for (auto key : expected) {
+    rids.clear();
+    EXPECT_TRUE(tree.GetValue(MakeKey(key), &rids));
+  }
+
+  // 没有记下稀疏的叶子时什么也不做
+  while (!tree.Compact()) {
+  }
+  EXPECT_EQ(tree.GetShape().leaf_pages_, compact_shape.leaf_pages_);
+}
+
+TEST(BPlusTreeCompactionTest, BackgroundCompactor) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(64, disk_manager.get());
+  page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+  bpm->UnpinPage(header_page_id, true);
+  Tree tree("foo_pk", header_page_id, bpm.get(), comparator, 8, 8, 2, true);
+
+  const int64_t num_keys = 4000;
+  for (int64_t key = 0; key < num_keys; key++) {
+    ASSERT_TRUE(tree.Insert(MakeKey(key), RID(0, key)));
+  }
+  auto full_shape = tree.GetShape();
+
+  // 删除线程删掉奇数键的同时,读线程一直在扫描和点查,压缩线程在后台合并
+  const int num_deleters = 4;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_deleters; t++) {
+    threads.emplace_back([&tree, t] {
+      for (int64_t key = 2 * t + 1; key < num_keys; key += 2 * num_deleters) {
+        tree.Remove(MakeKey(key), nullptr);
+      }
+    });
+  }
+  threads.emplace_back([&tree] {
+    for (int round = 0; round < 20; round++) {
+      int64_t last = -1;
+      for (auto iter = tree.Begin(); !iter.IsEnd(); ++iter) {
+        int64_t key = (*iter).second.GetSlotNum();
+        EXPECT_LT(last, key);
+        last = key;
+      }
+      std::vector<RID> rids;
+      EXPECT_TRUE(tree.GetValue(MakeKey(round * 100), &rids));
+    }
+  });
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  // 后台线程可能正赶上树忙,最后再同步压缩一遍
+  while (!tree.Compact()) {
+  }
+  std::vector<int64_t> expected;
+  for (int64_t key = 0; key < num_keys; key += 2) {
+    expected.push_back(key);
+  }
+  EXPECT_EQ(CollectKeys(&tree), expected);
+  EXPECT_LT(tree.GetShape().leaf_pages_, full_shape.leaf_pages_);
+}
+
+
+TEST(BPlusTreeCompactionTest, RemoveWhileCompacting) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(32, disk_manager.get());
+  page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+  bpm->UnpinPage(header_page_id, true);
+  Tree tree("foo_pk", header_page_id, bpm.get(), comparator, 8, 8, 0, true);
+
+  const int64_t num_keys = 20000;
+  for (int64_t key = 0; key < num_keys; key++) {
+    ASSERT_TRUE(tree.Insert(MakeKey(key), RID(0, key)));
+  }
+
+  // 只留下每8个里的一个,叶子一路变稀疏,删除和合并同一批叶子时删掉的键不能再冒出来
+  const int num_deleters = 4;
+  std::atomic<int> running{num_deleters};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_deleters; t++) {
+    threads.emplace_back([&tree, &running, t] {
+      for (int64_t key = t * num_keys / num_deleters; key < (t + 1) * num_keys / num_deleters; key++) {
+        if (key % 8 != 0) {
+          EXPECT_TRUE(tree.Remove(MakeKey(key), nullptr));
+        }
+      }
+      running--;
+    });
+  }
+  threads.emplace_back([&tree, &running] {
+    while (running > 0) {
+      tree.Compact();
+    }
+  });
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  while (!tree.Compact()) {
+  }
+  std::vector<int64_t> expected;
+  for (int64_t key = 0; key < num_keys; key += 8) {
+    expected.push_back(key);
+  }
+  EXPECT_EQ(CollectKeys(&tree), expected);
+}
+
+}  // namespace bustub
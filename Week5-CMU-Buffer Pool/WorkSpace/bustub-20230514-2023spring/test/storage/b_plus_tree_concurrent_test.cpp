@@ -402,4 +402,112 @@ TEST(BPlusTreeConcurrentTest, DISABLED_MixTest2) {
   delete bpm;
 }
 
+TEST(BPlusTreeConcurrentTest, ResidentUpperLevelsMixTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+
+  // create and fetch header_page
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+  bpm->UnpinPage(page_id, true);
+
+  {
+    // 结点很小,树有好几层,常驻的两层内部结点会随着分裂、合并和换根不断重新挑选
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", page_id, bpm, comparator, 4, 4, 2);
+
+    std::vector<int64_t> perserved_keys;
+    std::vector<int64_t> dynamic_keys;
+    int64_t total_keys = 2000;
+    int64_t sieve = 5;
+    for (int64_t i = 1; i <= total_keys; i++) {
+      if (i % sieve == 0) {
+        perserved_keys.push_back(i);
+      } else {
+        dynamic_keys.push_back(i);
+      }
+    }
+    InsertHelper(&tree, perserved_keys, 1);
+
+    auto insert_task = [&](int tid) { InsertHelper(&tree, dynamic_keys, tid); };
+    auto delete_task = [&](int tid) { DeleteHelper(&tree, dynamic_keys, tid); };
+    auto lookup_task = [&](int tid) { LookupHelper(&tree, perserved_keys, tid); };
+
+    std::vector<std::thread> threads;
+    std::vector<std::function<void(int)>> tasks;
+    tasks.emplace_back(insert_task);
+    tasks.emplace_back(delete_task);
+    tasks.emplace_back(lookup_task);
+
+    size_t num_threads = 6;
+    for (size_t i = 0; i < num_threads; i++) {
+      threads.emplace_back(std::thread{tasks[i % tasks.size()], i});
+    }
+    for (size_t i = 0; i < num_threads; i++) {
+      threads[i].join();
+    }
+
+    DeleteHelper(&tree, dynamic_keys);
+    LookupHelper(&tree, perserved_keys, 0);
+    size_t size = 0;
+    for (auto iter = tree.Begin(); iter != tree.End(); ++iter) {
+      size++;
+    }
+    ASSERT_EQ(size, perserved_keys.size());
+  }
+
+  // 树析构时放掉了常驻结点的pin,缓冲池里的frame应该都能再用起来
+  std::vector<page_id_t> page_ids(50);
+  for (auto &new_page_id : page_ids) {
+    ASSERT_NE(nullptr, bpm->NewPage(&new_page_id));
+  }
+  for (auto new_page_id : page_ids) {
+    bpm->UnpinPage(new_page_id, false);
+  }
+  delete bpm;
+}
+
+TEST(BPlusTreeConcurrentTest, ResidentBudgetSharedTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  const size_t pool_size = 64;
+  auto *bpm = new BufferPoolManager(pool_size, disk_manager.get());
+
+  {
+    // 每棵树都有好几层内部结点,各自按缓冲池的1/8常驻的话,8棵树就把缓冲池pin满了
+    std::vector<std::unique_ptr<BPlusTree<GenericKey<8>, RID, GenericComparator<8>>>> trees;
+    std::vector<int64_t> keys;
+    for (int64_t key = 1; key <= 200; key++) {
+      keys.push_back(key);
+    }
+    for (int i = 0; i < 8; i++) {
+      page_id_t page_id;
+      bpm->NewPage(&page_id);
+      bpm->UnpinPage(page_id, true);
+      trees.push_back(std::make_unique<BPlusTree<GenericKey<8>, RID, GenericComparator<8>>>(
+          "foo_pk", page_id, bpm, comparator, 4, 4, 2));
+      InsertHelper(trees.back().get(), keys);
+    }
+
+    // 所有树加起来只占共用的那一份预算,其余的frame都还能拿来用
+    std::vector<page_id_t> page_ids(pool_size - pool_size / RESIDENT_FRAMES_DIVISOR);
+    for (auto &new_page_id : page_ids) {
+      ASSERT_NE(nullptr, bpm->NewPage(&new_page_id));
+    }
+    for (auto new_page_id : page_ids) {
+      bpm->UnpinPage(new_page_id, false);
+    }
+    for (auto &tree : trees) {
+      LookupHelper(tree.get(), keys, 0);
+    }
+  }
+
+  delete bpm;
+}
+
 }  // namespace bustub
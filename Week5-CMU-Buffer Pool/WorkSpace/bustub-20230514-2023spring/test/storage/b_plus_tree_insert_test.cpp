@@ -12,6 +12,7 @@
 
 #include <algorithm>
 #include <cstdio>
+#include <random>
 
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
@@ -184,4 +185,523 @@ TEST(BPlusTreeTests, DISABLED_InsertTest3) {
   delete transaction;
   delete bpm;
 }
+
+TEST(BPlusTreeTests, RangeScanTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  ASSERT_EQ(page_id, HEADER_PAGE_ID);
+
+  // create b+ tree, small pages so that the range spans several leaves
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", header_page->GetPageId(), bpm, comparator, 3, 3);
+  GenericKey<8> index_key;
+  GenericKey<8> stop_key;
+  RID rid;
+  // create transaction
+  auto *transaction = new Transaction(0);
+
+  // only even keys: 2, 4, ..., 100
+  for (int64_t key = 2; key <= 100; key += 2) {
+    rid.Set(0, key);
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid, transaction);
+  }
+
+  // a missing start key seeks to the next larger key
+  index_key.SetFromInteger(31);
+  {
+    auto iterator = tree.Begin(index_key);
+    ASSERT_FALSE(iterator.IsEnd());
+    EXPECT_EQ((*iterator).second.GetSlotNum(), 32);
+  }
+
+  // start key larger than every key
+  index_key.SetFromInteger(101);
+  EXPECT_TRUE(tree.Begin(index_key).IsEnd());
+
+  // [10, 20]
+  index_key.SetFromInteger(10);
+  stop_key.SetFromInteger(20);
+  int64_t current_key = 10;
+  for (auto iter = tree.Begin(index_key, stop_key, true); !iter.IsEnd(); ++iter) {
+    EXPECT_EQ((*iter).second.GetSlotNum(), current_key);
+    current_key += 2;
+  }
+  EXPECT_EQ(current_key, 22);
+
+  // [10, 20)
+  current_key = 10;
+  for (auto iter = tree.Begin(index_key, stop_key, false); !iter.IsEnd(); ++iter) {
+    EXPECT_EQ((*iter).second.GetSlotNum(), current_key);
+    current_key += 2;
+  }
+  EXPECT_EQ(current_key, 20);
+
+  // empty range
+  index_key.SetFromInteger(21);
+  stop_key.SetFromInteger(21);
+  EXPECT_TRUE(tree.Begin(index_key, stop_key, true).IsEnd());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete bpm;
+}
+
+TEST(BPlusTreeTests, GetValuesTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  ASSERT_EQ(page_id, HEADER_PAGE_ID);
+
+  // create b+ tree
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", header_page->GetPageId(), bpm, comparator, 3, 3);
+  GenericKey<8> index_key;
+  RID rid;
+  // create transaction
+  auto *transaction = new Transaction(0);
+
+  std::vector<GenericKey<8>> probe_keys;
+  std::vector<std::vector<RID>> result;
+  EXPECT_EQ(tree.GetValues(probe_keys, &result), 0);
+
+  // only multiples of 3
+  for (int64_t key = 0; key < 300; key += 3) {
+    rid.Set(0, key);
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid, transaction);
+  }
+
+  // sorted probes, with duplicates and keys beyond both ends
+  for (int64_t key = -5; key < 310; key++) {
+    index_key.SetFromInteger(key);
+    probe_keys.push_back(index_key);
+    if (key % 7 == 0) {
+      probe_keys.push_back(index_key);
+    }
+  }
+  size_t found = tree.GetValues(probe_keys, &result, transaction);
+  ASSERT_EQ(result.size(), probe_keys.size());
+  size_t expected_found = 0;
+  for (size_t i = 0; i < probe_keys.size(); i++) {
+    std::vector<RID> rids;
+    tree.GetValue(probe_keys[i], &rids);
+    ASSERT_EQ(result[i].size(), rids.size());
+    if (!rids.empty()) {
+      EXPECT_EQ(result[i][0], rids[0]);
+      expected_found++;
+    }
+  }
+  EXPECT_EQ(found, expected_found);
+  // 100 multiples of 3, the ones that are also multiples of 7 are probed twice
+  EXPECT_EQ(found, 100 + 300 / 21 + 1);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete bpm;
+}
+
+TEST(BPlusTreeTests, ReverseIteratorTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  ASSERT_EQ(page_id, HEADER_PAGE_ID);
+
+  // create b+ tree
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", header_page->GetPageId(), bpm, comparator, 3, 3);
+  GenericKey<8> index_key;
+  RID rid;
+  // create transaction
+  auto *transaction = new Transaction(0);
+
+  EXPECT_TRUE(tree.RBegin().IsEnd());
+
+  for (int64_t key = 1; key <= 100; key++) {
+    rid.Set(0, key);
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid, transaction);
+  }
+  // remove every key in [41, 60] so that some separators no longer exist in the leaves
+  for (int64_t key = 41; key <= 60; key++) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key, transaction);
+  }
+
+  int64_t current_key = 100;
+  for (auto iter = tree.RBegin(); !iter.IsEnd(); ++iter) {
+    if (current_key == 60) {
+      current_key = 40;
+    }
+    EXPECT_EQ((*iter).second.GetSlotNum(), current_key);
+    current_key--;
+  }
+  EXPECT_EQ(current_key, 0);
+
+  // a missing start key seeks to the next smaller key
+  index_key.SetFromInteger(55);
+  current_key = 40;
+  for (auto iter = tree.RBegin(index_key); !iter.IsEnd(); ++iter) {
+    EXPECT_EQ((*iter).second.GetSlotNum(), current_key);
+    current_key--;
+  }
+  EXPECT_EQ(current_key, 0);
+
+  // start key smaller than every key
+  index_key.SetFromInteger(0);
+  EXPECT_TRUE(tree.RBegin(index_key).IsEnd());
+
+  // (35, 70] in descending order
+  GenericKey<8> stop_key;
+  index_key.SetFromInteger(70);
+  stop_key.SetFromInteger(35);
+  auto iter = tree.RBegin(index_key);
+  iter.SetStopKey(stop_key, false, &comparator);
+  std::vector<int64_t> keys;
+  for (; !iter.IsEnd(); ++iter) {
+    keys.push_back((*iter).second.GetSlotNum());
+  }
+  ASSERT_EQ(keys.size(), 15);
+  EXPECT_EQ(keys.front(), 70);
+  EXPECT_EQ(keys[9], 61);
+  EXPECT_EQ(keys[10], 40);
+  EXPECT_EQ(keys.back(), 36);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete bpm;
+}
+
+TEST(BPlusTreeTests, SequentialInsertFillTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  using LeafPage = BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>>;
+  using InternalPage = BPlusTreeInternalPage<GenericKey<8>, page_id_t, GenericComparator<8>>;
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  ASSERT_EQ(page_id, HEADER_PAGE_ID);
+
+  // create b+ tree
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", header_page->GetPageId(), bpm, comparator, 5, 5);
+  GenericKey<8> index_key;
+  RID rid;
+  // create transaction
+  auto *transaction = new Transaction(0);
+
+  const int64_t total = 200;
+  for (int64_t key = 1; key <= total; key++) {
+    rid.Set(0, key);
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid, transaction);
+  }
+
+  // ascending inserts should leave every leaf but the last one holding leaf_max_size - 1 entries
+  auto leaf_page_id = tree.GetRootPageId();
+  while (true) {
+    auto guard = bpm->FetchPageRead(leaf_page_id);
+    auto page = guard.As<BPlusTreePage>();
+    if (page->IsLeafPage()) {
+      break;
+    }
+    leaf_page_id = guard.As<InternalPage>()->ValueAt(0);
+  }
+  int leaf_count = 0;
+  while (leaf_page_id != INVALID_PAGE_ID) {
+    auto guard = bpm->FetchPageRead(leaf_page_id);
+    auto leaf = guard.As<LeafPage>();
+    if (leaf->GetNextPageId() != INVALID_PAGE_ID) {
+      EXPECT_EQ(leaf->GetSize(), 4);
+    }
+    leaf_count++;
+    leaf_page_id = leaf->GetNextPageId();
+  }
+  EXPECT_EQ(leaf_count, total / 4);
+
+  std::vector<RID> rids;
+  for (int64_t key = 1; key <= total; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    ASSERT_TRUE(tree.GetValue(index_key, &rids));
+    EXPECT_EQ(rids[0].GetSlotNum(), key);
+  }
+  int64_t current_key = 1;
+  for (auto iter = tree.Begin(); !iter.IsEnd(); ++iter) {
+    EXPECT_EQ((*iter).second.GetSlotNum(), current_key);
+    current_key++;
+  }
+  EXPECT_EQ(current_key, total + 1);
+
+  // the packed nodes must still merge and borrow correctly
+  std::vector<int64_t> remove_keys;
+  for (int64_t key = 1; key <= total; key++) {
+    remove_keys.push_back(key);
+  }
+  std::shuffle(remove_keys.begin(), remove_keys.end(), std::mt19937(2023));
+  for (auto key : remove_keys) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key, transaction);
+    rids.clear();
+    EXPECT_FALSE(tree.GetValue(index_key, &rids));
+  }
+  EXPECT_TRUE(tree.IsEmpty());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete bpm;
+}
+
+TEST(BPlusTreeTests, BulkLoadTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  using LeafPage = BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>>;
+  using InternalPage = BPlusTreeInternalPage<GenericKey<8>, page_id_t, GenericComparator<8>>;
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  auto *transaction = new Transaction(0);
+  GenericKey<8> index_key;
+  RID rid;
+
+  // sizes that leave the last leaf and the last internal pages underfull, or exactly full
+  for (int64_t total : {0, 1, 4, 5, 17, 64, 65, 333}) {
+    page_id_t page_id;
+    auto header_page = bpm->NewPage(&page_id);
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", header_page->GetPageId(), bpm, comparator, 5,
+                                                             4);
+    int64_t next_key = 1;
+    ASSERT_TRUE(tree.BulkLoad([&](GenericKey<8> *key, RID *value) {
+      if (next_key > total) {
+        return false;
+      }
+      key->SetFromInteger(next_key);
+      value->Set(0, next_key);
+      next_key++;
+      return true;
+    }));
+    EXPECT_EQ(tree.IsEmpty(), total == 0);
+    // a loaded tree is never loaded again
+    EXPECT_EQ(tree.BulkLoad([](GenericKey<8> *key, RID *value) { return false; }), total == 0);
+
+    // every leaf but the root holds at least its min size, and all but the last two are full
+    if (total > 0) {
+      auto leaf_page_id = tree.GetRootPageId();
+      while (true) {
+        auto guard = bpm->FetchPageRead(leaf_page_id);
+        if (guard.As<BPlusTreePage>()->IsLeafPage()) {
+          break;
+        }
+        auto internal = guard.As<InternalPage>();
+        if (leaf_page_id != tree.GetRootPageId()) {
+          EXPECT_GE(internal->GetSize(), internal->GetMinSize());
+        }
+        leaf_page_id = internal->ValueAt(0);
+      }
+      int64_t counted = 0;
+      while (leaf_page_id != INVALID_PAGE_ID) {
+        auto guard = bpm->FetchPageRead(leaf_page_id);
+        auto leaf = guard.As<LeafPage>();
+        if (counted + 2 * 4 < total) {
+          EXPECT_EQ(leaf->GetSize(), 4);
+        }
+        if (total > 4) {
+          EXPECT_GE(leaf->GetSize(), leaf->GetMinSize());
+        }
+        counted += leaf->GetSize();
+        leaf_page_id = leaf->GetNextPageId();
+      }
+      EXPECT_EQ(counted, total);
+    }
+
+    std::vector<RID> rids;
+    for (int64_t key = 1; key <= total; key++) {
+      rids.clear();
+      index_key.SetFromInteger(key);
+      ASSERT_TRUE(tree.GetValue(index_key, &rids));
+      EXPECT_EQ(rids[0].GetSlotNum(), key);
+    }
+    int64_t current_key = 1;
+    for (auto iter = tree.Begin(); !iter.IsEnd(); ++iter) {
+      EXPECT_EQ((*iter).second.GetSlotNum(), current_key);
+      current_key++;
+    }
+    EXPECT_EQ(current_key, total + 1);
+
+    // the loaded tree takes further inserts and removes like any other
+    for (int64_t key = total + 1; key <= total + 20; key++) {
+      rid.Set(0, key);
+      index_key.SetFromInteger(key);
+      EXPECT_TRUE(tree.Insert(index_key, rid, transaction));
+    }
+    std::vector<int64_t> remove_keys;
+    for (int64_t key = 1; key <= total + 20; key++) {
+      remove_keys.push_back(key);
+    }
+    std::shuffle(remove_keys.begin(), remove_keys.end(), std::mt19937(2023));
+    for (auto key : remove_keys) {
+      index_key.SetFromInteger(key);
+      EXPECT_TRUE(tree.Remove(index_key, transaction));
+    }
+    EXPECT_TRUE(tree.IsEmpty());
+    bpm->UnpinPage(page_id, true);
+  }
+
+  // keys out of order are rejected
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", header_page->GetPageId(), bpm, comparator, 5, 4);
+  int64_t next_key = 10;
+  EXPECT_THROW(tree.BulkLoad([&](GenericKey<8> *key, RID *value) {
+    key->SetFromInteger(next_key--);
+    return true;
+  }),
+               std::logic_error);
+  bpm->UnpinPage(page_id, true);
+
+  delete transaction;
+  delete bpm;
+}
+
+/**
+ * Insert the VARCHAR keys into a tree with the default page sizes, check lookups, the order and the separators, then
+ * remove every key again.
+ * @param[out] separator_length the longest separator in the root of the full tree
+ * @return the largest leaf of the full tree
+ */
+static auto InsertAndRemoveWideKeys(const std::vector<std::string> &keys, size_t *separator_length) -> int {
+  using LeafPage = BPlusTreeLeafPage<GenericKey<64>, RID, GenericComparator<64>>;
+  using InternalPage = BPlusTreeInternalPage<GenericKey<64>, page_id_t, GenericComparator<64>>;
+  auto key_schema = ParseCreateStatement("a varchar(40)");
+  GenericComparator<64> comparator(key_schema.get());
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  BPlusTree<GenericKey<64>, RID, GenericComparator<64>> tree("foo_pk", header_page->GetPageId(), bpm, comparator);
+  auto *transaction = new Transaction(0);
+  auto make_key = [&](const std::string &key) {
+    GenericKey<64> index_key;
+    index_key.SetFromKey(Tuple({ValueFactory::GetVarcharValue(key)}, key_schema.get()));
+    return index_key;
+  };
+
+  RID rid;
+  for (size_t i = 0; i < keys.size(); i++) {
+    rid.Set(0, i);
+    EXPECT_TRUE(tree.Insert(make_key(keys[i]), rid, transaction));
+  }
+  std::vector<RID> rids;
+  for (size_t i = 0; i < keys.size(); i++) {
+    rids.clear();
+    EXPECT_TRUE(tree.GetValue(make_key(keys[i]), &rids));
+    EXPECT_EQ(rids[0].GetSlotNum(), i);
+  }
+  std::vector<std::string> sorted_keys = keys;
+  std::sort(sorted_keys.begin(), sorted_keys.end());
+  size_t scanned = 0;
+  for (auto iter = tree.Begin(); !iter.IsEnd(); ++iter, scanned++) {
+    EXPECT_EQ((*iter).first.ToValue(key_schema.get(), 0).ToString(), sorted_keys[scanned]);
+  }
+  EXPECT_EQ(scanned, keys.size());
+
+  // the separators of the root are truncated keys, the first key of each child is the first key not less than them
+  auto root_guard = bpm->FetchPageRead(tree.GetRootPageId());
+  EXPECT_FALSE(root_guard.As<BPlusTreePage>()->IsLeafPage());
+  auto root = root_guard.As<InternalPage>();
+  *separator_length = 0;
+  for (int i = 1; i < root->GetSize(); i++) {
+    auto separator = root->KeyAt(i).ToValue(key_schema.get(), 0).ToString();
+    *separator_length = std::max(*separator_length, separator.size());
+    auto child_guard = bpm->FetchPageRead(root->ValueAt(i));
+    while (!child_guard.As<BPlusTreePage>()->IsLeafPage()) {
+      child_guard = bpm->FetchPageRead(child_guard.As<InternalPage>()->ValueAt(0));
+    }
+    auto first_key = child_guard.As<LeafPage>()->KeyAt(0).ToValue(key_schema.get(), 0).ToString();
+    EXPECT_EQ(first_key, *std::lower_bound(sorted_keys.begin(), sorted_keys.end(), separator));
+  }
+  page_id_t leaf_page_id = root->ValueAt(0);
+  root_guard.Drop();
+  while (!bpm->FetchPageRead(leaf_page_id).As<BPlusTreePage>()->IsLeafPage()) {
+    leaf_page_id = bpm->FetchPageRead(leaf_page_id).As<InternalPage>()->ValueAt(0);
+  }
+  int max_leaf_size = 0;
+  while (leaf_page_id != INVALID_PAGE_ID) {
+    auto guard = bpm->FetchPageRead(leaf_page_id);
+    max_leaf_size = std::max(max_leaf_size, guard.As<LeafPage>()->GetSize());
+    leaf_page_id = guard.As<LeafPage>()->GetNextPageId();
+  }
+
+  std::vector<std::string> remove_keys = keys;
+  std::shuffle(remove_keys.begin(), remove_keys.end(), std::mt19937(2023));
+  for (size_t i = 0; i < remove_keys.size(); i++) {
+    tree.Remove(make_key(remove_keys[i]), transaction);
+    if (i % 97 == 0) {
+      rids.clear();
+      EXPECT_FALSE(tree.GetValue(make_key(remove_keys[i]), &rids));
+      if (i + 1 < remove_keys.size()) {
+        EXPECT_TRUE(tree.GetValue(make_key(remove_keys[i + 1]), &rids));
+      }
+    }
+  }
+  EXPECT_TRUE(tree.IsEmpty());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete bpm;
+  return max_leaf_size;
+}
+
+TEST(BPlusTreeTests, CompressedKeysTest) {
+  // what a leaf of GenericKey<64> holds without compression
+  const int slot_count = (BUSTUB_PAGE_SIZE - 16 - BPlusTreeKeyArray<GenericKey<64>, RID>::HEADER_SIZE) /
+                         sizeof(std::pair<GenericKey<64>, RID>);
+
+  // keys that only differ in a few leading characters compress to a few bytes per slot
+  std::vector<std::string> keys;
+  for (int i = 0; i < 5000; i++) {
+    char prefix[8];
+    snprintf(prefix, sizeof(prefix), "%05d", i);
+    keys.push_back(std::string(prefix) + "_shared_suffix_of_every_key");
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(2023));
+  size_t separator_length;
+  EXPECT_GT(InsertAndRemoveWideKeys(keys, &separator_length), slot_count);
+  EXPECT_LE(separator_length, 5);
+
+  // random keys barely compress, the pages split when they are full in bytes
+  keys.clear();
+  std::mt19937 gen(2023);
+  std::uniform_int_distribution<int> letter('a', 'z');
+  for (int i = 0; i < 5000; i++) {
+    std::string key(30, ' ');
+    for (auto &c : key) {
+      c = static_cast<char>(letter(gen));
+    }
+    keys.push_back(key);
+  }
+  EXPECT_LE(InsertAndRemoveWideKeys(keys, &separator_length), 2 * slot_count);
+  EXPECT_LT(separator_length, 30);
+}
 }  // namespace bustub
@@ -0,0 +1,145 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// bloom_filter_test.cpp
+//
+// Identification: test/storage/bloom_filter_test.cpp
+//
+//===----------------------------------------------------------------------===//
+
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "murmur3/MurmurHash3.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/index/b_plus_tree_index.h"
+#include "storage/index/bloom_filter.h"
+#include "storage/index/extendible_hash_table_index.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+static auto HashOf(int64_t v) -> uint64_t {
+  uint64_t out[2];
+  murmur3::MurmurHash3_x64_128(&v, sizeof(v), 0, out);
+  return out[0];
+}
+
+TEST(BloomFilterTest, FalsePositiveTest) {
+  const int num_keys = 10000;
+  BloomFilter filter(num_keys);
+  for (int i = 0; i < num_keys; i++) {
+    filter.Insert(HashOf(i));
+  }
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(filter.MayContain(HashOf(i)));
+  }
+  // 每个键10位,分块的filter误判率在1%左右,这里放宽到3%
+  int false_positives = 0;
+  for (int i = num_keys; i < num_keys * 11; i++) {
+    false_positives += filter.MayContain(HashOf(i)) ? 1 : 0;
+  }
+  EXPECT_LT(false_positives, num_keys * 10 * 3 / 100);
+}
+
+TEST(BloomFilterTest, RebuildTest) {
+  Schema schema({Column("a", TypeId::INTEGER)});
+  std::multiset<int> stored;
+  IndexKeyFilter filter(1, [&](const auto &callback) {
+    for (auto v : stored) {
+      callback(Tuple({ValueFactory::GetIntegerValue(v)}, &schema), &schema);
+    }
+  });
+  auto key = [&](int v) { return Tuple({ValueFactory::GetIntegerValue(v)}, &schema); };
+  auto insert = [&](int v) {
+    filter.Insert(key(v), &schema, [&] {
+      stored.insert(v);
+      return true;
+    });
+  };
+
+  // 插入超过初始容量,下一次查找时按现在的键数重建
+  for (int i = 0; i < 1000; i++) {
+    insert(i);
+  }
+  EXPECT_LT(filter.GetCapacity(), 1000);
+  EXPECT_TRUE(filter.MayContain(key(0), &schema));
+  EXPECT_GE(filter.GetCapacity(), 1000);
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_TRUE(filter.MayContain(key(i), &schema));
+  }
+
+  // 删掉大部分键之后重建,删掉的键基本都查不到了
+  for (int i = 0; i < 900; i++) {
+    stored.erase(i);
+    filter.Delete();
+  }
+  int hits = 0;
+  for (int i = 0; i < 900; i++) {
+    hits += filter.MayContain(key(i), &schema) ? 1 : 0;
+  }
+  EXPECT_LT(hits, 900 / 10);
+  EXPECT_LT(filter.GetCapacity(), 1000);
+  for (int i = 900; i < 1000; i++) {
+    ASSERT_TRUE(filter.MayContain(key(i), &schema));
+  }
+
+  // 带NULL的键从来不过滤
+  EXPECT_TRUE(filter.MayContain(Tuple({ValueFactory::GetNullValueByType(TypeId::INTEGER)}, &schema), &schema));
+}
+
+TEST(BloomFilterTest, IndexLookupTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(64, disk_manager.get());
+  Schema schema({Column("name", TypeId::VARCHAR, 8), Column("n", TypeId::INTEGER)});
+  std::vector<uint32_t> key_attrs{0, 1};
+  BPlusTreeIndex<GenericKey<32>, RID, GenericComparator<32>> tree_index(
+      std::make_unique<IndexMetadata>("tree", "t", &schema, key_attrs, false), bpm.get());
+  ExtendibleHashTableIndex<GenericKey<32>, RID, GenericComparator<32>> hash_index(
+      std::make_unique<IndexMetadata>("hash", "t", &schema, key_attrs, false), bpm.get(),
+      HashFunction<GenericKey<32>>());
+  std::vector<Index *> indexes{&tree_index, &hash_index};
+
+  auto key = [&](int n) {
+    return Tuple({ValueFactory::GetVarcharValue("k" + std::to_string(n % 10)), ValueFactory::GetIntegerValue(n)},
+                 tree_index.GetKeySchema());
+  };
+  for (auto *index : indexes) {
+    for (int n = 0; n < 500; n += 2) {
+      ASSERT_TRUE(index->InsertEntry(key(n), RID(n, 0), nullptr));
+      ASSERT_TRUE(index->InsertEntry(key(n), RID(n, 1), nullptr));
+    }
+    // 删掉3/4的键,之后的查找会重建filter,留下来的键一个都不能漏
+    for (int n = 0; n < 500; n += 2) {
+      if (n % 8 != 0) {
+        index->DeleteEntry(key(n), RID(n, 0), nullptr);
+        index->DeleteEntry(key(n), RID(n, 1), nullptr);
+      }
+    }
+    std::vector<Tuple> probes;
+    for (int n = 0; n < 500; n++) {
+      probes.push_back(key(n));
+      std::vector<RID> result;
+      index->ScanKey(key(n), &result, nullptr);
+      ASSERT_EQ(result.size(), n % 8 == 0 ? 2 : 0) << index->GetName() << " " << n;
+      auto probe = key(n);
+      size_t count = 0;
+      for (auto iter = index->MakeScanIterator(&probe, true, &probe, true, false); !iter->IsEnd(); iter->Next()) {
+        count++;
+      }
+      ASSERT_EQ(count, result.size()) << index->GetName() << " " << n;
+    }
+    std::vector<std::vector<RID>> results;
+    index->ScanKeys(probes, &results, nullptr);
+    for (int n = 0; n < 500; n++) {
+      ASSERT_EQ(results[n].size(), n % 8 == 0 ? 2 : 0) << index->GetName() << " " << n;
+    }
+  }
+}
+
+}  // namespace bustub
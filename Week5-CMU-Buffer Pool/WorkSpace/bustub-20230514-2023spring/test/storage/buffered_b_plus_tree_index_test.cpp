@@ -0,0 +1,112 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffered_b_plus_tree_index_test.cpp
+//
+// Identification: test/storage/buffered_b_plus_tree_index_test.cpp
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/index/buffered_b_plus_tree_index.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+TEST(BufferedBPlusTreeIndexTest, MessagesFlushDownTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(2000, disk_manager.get());
+  Schema schema({Column("a", TypeId::INTEGER)});
+  BufferedBPlusTreeIndex<GenericKey<16>, RID, GenericComparator<16>> index(
+      std::make_unique<IndexMetadata>("a", "t", &schema, std::vector<uint32_t>{0}, false), bpm.get(), 64);
+  auto key = [&](int i) { return Tuple({ValueFactory::GetIntegerValue(i)}, index.GetKeySchema()); };
+
+  // 乱序插入,树长到三层,根上面的缓冲区满了只把最满的几个孩子的消息挪到下一层的缓冲区,消息不会都堆在根上面
+  std::vector<int> keys(100000);
+  std::iota(keys.begin(), keys.end(), 0);
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+  for (auto k : keys) {
+    ASSERT_TRUE(index.InsertEntry(key(k), RID(k, 0), nullptr));
+  }
+  EXPECT_GT(index.GetPendingCount(), 64);
+  std::set<int> expected(keys.begin(), keys.end());
+  for (size_t i = 0; i < keys.size(); i += 3) {
+    index.DeleteEntry(key(keys[i]), RID(keys[i], 0), nullptr);
+    expected.erase(keys[i]);
+  }
+  // 删掉的键在消息还没刷下去的时候又插回来
+  ASSERT_TRUE(index.InsertEntry(key(keys[0]), RID(keys[0], 1), nullptr));
+  expected.insert(keys[0]);
+
+  for (int k = 0; k < 100000; k += 7) {
+    std::vector<RID> result;
+    index.ScanKey(key(k), &result, nullptr);
+    ASSERT_EQ(result.size(), expected.count(k)) << k;
+  }
+
+  // 范围扫描把还没刷下去的消息合并进来,一条都不刷
+  size_t pending = index.GetPendingCount();
+  Tuple low = key(20000);
+  Tuple high = key(60000);
+  std::vector<RID> result;
+  index.ScanRange(&low, false, &high, true, &result, nullptr);
+  std::vector<int> scanned;
+  for (auto rid : result) {
+    scanned.push_back(rid.GetPageId());
+  }
+  std::vector<int> expected_range(expected.upper_bound(20000), expected.upper_bound(60000));
+  EXPECT_EQ(scanned, expected_range);
+  std::vector<int> reversed;
+  for (auto iter = index.MakeScanIterator(&low, true, &high, false, true); !iter->IsEnd(); iter->Next()) {
+    reversed.push_back(iter->GetRID().GetPageId());
+  }
+  std::vector<int> expected_reversed(expected.lower_bound(20000), expected.lower_bound(60000));
+  std::reverse(expected_reversed.begin(), expected_reversed.end());
+  EXPECT_EQ(reversed, expected_reversed);
+  EXPECT_EQ(index.GetPendingCount(), pending);
+
+  index.Flush();
+  EXPECT_EQ(index.GetPendingCount(), 0);
+  result.clear();
+  index.ScanRange(nullptr, true, nullptr, true, &result, nullptr);
+  ASSERT_EQ(result.size(), expected.size());
+  auto it = expected.begin();
+  for (auto rid : result) {
+    EXPECT_EQ(rid.GetPageId(), *it++);
+  }
+}
+
+TEST(BufferedBPlusTreeIndexTest, NonUniqueKeyTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(64, disk_manager.get());
+  Schema schema({Column("a", TypeId::INTEGER)});
+  BufferedBPlusTreeIndex<GenericKey<16>, RID, GenericComparator<16>> index(
+      std::make_unique<IndexMetadata>("a", "t", &schema, std::vector<uint32_t>{0}, false), bpm.get(), 16);
+  auto key = [&](int i) { return Tuple({ValueFactory::GetIntegerValue(i)}, index.GetKeySchema()); };
+
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_TRUE(index.InsertEntry(key(i % 10), RID(i, 0), nullptr));
+  }
+  index.DeleteEntry(key(3), RID(503, 0), nullptr);
+  // 一个键的RID一部分在树里一部分还在缓冲区里,合起来还是按RID的顺序
+  std::vector<RID> result;
+  index.ScanKey(key(3), &result, nullptr);
+  ASSERT_EQ(result.size(), 99);
+  for (size_t i = 1; i < result.size(); i++) {
+    EXPECT_LT(result[i - 1].GetPageId(), result[i].GetPageId());
+    EXPECT_EQ(result[i].GetPageId() % 10, 3);
+  }
+  EXPECT_EQ(std::count(result.begin(), result.end(), RID(503, 0)), 0);
+}
+
+}  // namespace bustub
@@ -0,0 +1,91 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// index_builder_test.cpp
+//
+// Identification: test/storage/index_builder_test.cpp
+//
+//===----------------------------------------------------------------------===//
+
+#include <memory>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/index/b_plus_tree_index.h"
+#include "storage/index/index_builder.h"
+#include "storage/table/table_heap.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+TEST(IndexBuilderTest, ParallelBuildTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(64, disk_manager.get());
+  Schema schema({Column("a", TypeId::INTEGER), Column("b", TypeId::INTEGER)});
+  TableHeap table(bpm.get());
+
+  // 倒序插入,每个worker拿到的都是乱序的键,a % 10 == 3的行插入后删除
+  const int num_rows = 20000;
+  std::vector<RID> rids;
+  for (int i = num_rows - 1; i >= 0; i--) {
+    Tuple tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetIntegerValue(i % 7)}, &schema);
+    auto rid = table.InsertTuple(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, false}, tuple);
+    ASSERT_TRUE(rid.has_value());
+    if (i % 10 == 3) {
+      table.UpdateTupleMeta(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, true}, *rid);
+    }
+  }
+  ASSERT_GE(table.GetPageIds().size(), 4 * 16);
+
+  using KeyType = GenericKey<8>;
+  BPlusTreeIndex<KeyType, RID, GenericComparator<8>> unique_index(
+      std::make_unique<IndexMetadata>("a", "t", &schema, std::vector<uint32_t>{0}, true), bpm.get());
+  BuildIndexFromHeap(&unique_index, &table, schema, nullptr, 4);
+
+  int expected = 0;
+  for (auto iter = unique_index.GetBeginIterator(); !iter.IsEnd(); ++iter) {
+    if (expected % 10 == 3) {
+      expected++;
+    }
+    auto entry = unique_index.EntryFromTreeKey((*iter).first);
+    ASSERT_EQ(entry.GetValue(unique_index.GetEntrySchema(), 0).GetAs<int32_t>(), expected);
+    auto [meta, tuple] = table.GetTuple((*iter).second);
+    ASSERT_EQ(tuple.GetValue(&schema, 0).GetAs<int32_t>(), expected);
+    expected++;
+  }
+  EXPECT_EQ(expected, num_rows);
+  // 批量装载时统计信息和filter也跟着更新,装好的树照常插入和删除
+  auto stats = unique_index.GetStatistics(false);
+  ASSERT_TRUE(stats.has_value());
+  EXPECT_EQ(stats->num_entries_, num_rows - num_rows / 10);
+  Tuple key3({ValueFactory::GetIntegerValue(3)}, unique_index.GetKeySchema());
+  std::vector<RID> result;
+  unique_index.ScanKey(key3, &result, nullptr);
+  EXPECT_TRUE(result.empty());
+  ASSERT_TRUE(unique_index.InsertEntry(key3, RID(0, 3), nullptr));
+  unique_index.ScanKey(key3, &result, nullptr);
+  ASSERT_EQ(result.size(), 1);
+  unique_index.DeleteEntry(key3, RID(0, 3), nullptr);
+  EXPECT_EQ(unique_index.GetStatistics(false)->num_entries_, num_rows - num_rows / 10);
+
+  BPlusTreeIndex<GenericKey<16>, RID, GenericComparator<16>> dup_index(
+      std::make_unique<IndexMetadata>("b", "t", &schema, std::vector<uint32_t>{1}, false), bpm.get());
+  BuildIndexFromHeap(&dup_index, &table, schema, nullptr, 4);
+  size_t total = 0;
+  for (int b = 0; b < 7; b++) {
+    std::vector<RID> result;
+    dup_index.ScanKey(Tuple({ValueFactory::GetIntegerValue(b)}, dup_index.GetKeySchema()), &result, nullptr);
+    for (const auto &rid : result) {
+      auto [meta, tuple] = table.GetTuple(rid);
+      ASSERT_FALSE(meta.is_deleted_);
+      ASSERT_EQ(tuple.GetValue(&schema, 1).GetAs<int32_t>(), b);
+    }
+    total += result.size();
+  }
+  EXPECT_EQ(total, num_rows - num_rows / 10);
+}
+
+}  // namespace bustub
@@ -0,0 +1,150 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// index_statistics_test.cpp
+//
+// Identification: test/storage/index_statistics_test.cpp
+//
+//===----------------------------------------------------------------------===//
+
+#include <memory>
+#include <numeric>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "murmur3/MurmurHash3.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/index/b_plus_tree_index.h"
+#include "storage/index/buffered_b_plus_tree_index.h"
+#include "storage/index/index_statistics.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+static auto HashOf(int64_t v) -> uint64_t {
+  uint64_t out[2];
+  murmur3::MurmurHash3_x64_128(&v, sizeof(v), 0, out);
+  return out[0];
+}
+
+TEST(IndexStatisticsTest, HyperLogLogTest) {
+  HyperLogLog small;
+  for (int i = 0; i < 100; i++) {
+    small.Add(HashOf(i));
+    small.Add(HashOf(i));
+  }
+  EXPECT_NEAR(small.Estimate(), 100, 5);
+
+  HyperLogLog large;
+  for (int i = 0; i < 100000; i++) {
+    large.Add(HashOf(i % 50000));
+  }
+  // 标准误差3%左右,放宽到10%
+  EXPECT_NEAR(large.Estimate(), 50000, 5000);
+}
+
+TEST(IndexStatisticsTest, BPlusTreeIndexTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(128, disk_manager.get());
+  Schema schema({Column("a", TypeId::INTEGER), Column("b", TypeId::INTEGER)});
+  BPlusTreeIndex<GenericKey<32>, RID, GenericComparator<32>> index(
+      std::make_unique<IndexMetadata>("ab", "t", &schema, std::vector<uint32_t>{0, 1}, false), bpm.get());
+  auto key = [&](int i) {
+    return Tuple({ValueFactory::GetIntegerValue(i % 100), ValueFactory::GetIntegerValue(i)}, index.GetKeySchema());
+  };
+
+  const int num_entries = 10000;
+  for (int i = 0; i < num_entries; i++) {
+    ASSERT_TRUE(index.InsertEntry(key(i), RID(i, 0), nullptr));
+  }
+  // 插入时就在维护项数和不同键的个数,直方图要等刷新之后才有
+  auto stats = index.GetStatistics(true);
+  ASSERT_TRUE(stats.has_value());
+  EXPECT_EQ(stats->num_entries_, num_entries);
+  ASSERT_EQ(stats->distinct_prefixes_.size(), 2);
+  EXPECT_NEAR(stats->distinct_prefixes_[0], 100, 10);
+  EXPECT_NEAR(stats->GetDistinctKeys(), num_entries, num_entries / 10);
+  EXPECT_GE(stats->height_, 2);
+  EXPECT_GE(stats->internal_pages_, 1);
+  EXPECT_GT(stats->leaf_pages_, 1);
+  EXPECT_GT(stats->leaf_fill_, 0);
+  EXPECT_LE(stats->leaf_fill_, 1);
+  EXPECT_TRUE(stats->histogram_counts_.empty());
+
+  index.RefreshStatistics();
+  stats = index.GetStatistics(false);
+  ASSERT_EQ(stats->histogram_bounds_.size(), stats->histogram_counts_.size() + 1);
+  EXPECT_LE(stats->histogram_counts_.size(), INDEX_HISTOGRAM_BUCKETS);
+  EXPECT_EQ(std::accumulate(stats->histogram_counts_.begin(), stats->histogram_counts_.end(), size_t{0}),
+            num_entries);
+  EXPECT_EQ(stats->histogram_bounds_.front().GetAs<int32_t>(), 0);
+  EXPECT_EQ(stats->histogram_bounds_.back().GetAs<int32_t>(), 99);
+
+  // a = 5命中100项,a < 10命中1000项,跨边界的桶算一半,误差在一个桶以内
+  auto a = [](int v) { return std::vector<Value>{ValueFactory::GetIntegerValue(v)}; };
+  EXPECT_NEAR(stats->EstimateRows(a(5), true, a(5), true), 100, 10);
+  EXPECT_NEAR(stats->EstimateRows({}, true, a(10), false), 1000, num_entries / INDEX_HISTOGRAM_BUCKETS + 1);
+  EXPECT_NEAR(stats->EstimateRows(a(90), true, {}, true), 1000, num_entries / INDEX_HISTOGRAM_BUCKETS + 1);
+  EXPECT_GT(stats->EstimateRows(a(5), true, a(5), true), stats->EstimateRows(a(5), false, a(5), false));
+
+  // 删掉a >= 50的项,项数和直方图马上变,不同键的个数要刷新之后才降下来
+  for (int i = 0; i < num_entries; i++) {
+    if (i % 100 >= 50) {
+      index.DeleteEntry(key(i), RID(i, 0), nullptr);
+    }
+  }
+  stats = index.GetStatistics(true);
+  EXPECT_EQ(stats->num_entries_, num_entries / 2);
+  EXPECT_EQ(std::accumulate(stats->histogram_counts_.begin(), stats->histogram_counts_.end(), size_t{0}),
+            num_entries / 2);
+  EXPECT_NEAR(stats->distinct_prefixes_[0], 100, 10);
+  EXPECT_LE(stats->leaf_fill_, 1);
+
+  // 再删一遍已经不在的项,树里什么也没删,统计也不能跟着减
+  for (int i = 50; i < num_entries; i += 100) {
+    index.DeleteEntry(key(i), RID(i, 0), nullptr);
+  }
+  stats = index.GetStatistics(true);
+  EXPECT_EQ(stats->num_entries_, num_entries / 2);
+  EXPECT_EQ(std::accumulate(stats->histogram_counts_.begin(), stats->histogram_counts_.end(), size_t{0}),
+            num_entries / 2);
+
+  index.RefreshStatistics();
+  stats = index.GetStatistics(false);
+  EXPECT_EQ(stats->num_entries_, num_entries / 2);
+  EXPECT_NEAR(stats->distinct_prefixes_[0], 50, 5);
+  EXPECT_EQ(stats->histogram_bounds_.back().GetAs<int32_t>(), 49);
+  EXPECT_NEAR(stats->EstimateRows(a(60), true, {}, true), 0, num_entries / INDEX_HISTOGRAM_BUCKETS + 1);
+}
+
+TEST(IndexStatisticsTest, BufferedIndexTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(64, disk_manager.get());
+  Schema schema({Column("a", TypeId::INTEGER)});
+  BufferedBPlusTreeIndex<GenericKey<8>, RID, GenericComparator<8>> index(
+      std::make_unique<IndexMetadata>("a", "t", &schema, std::vector<uint32_t>{0}, true), bpm.get(), 64);
+  auto key = [&](int i) { return Tuple({ValueFactory::GetIntegerValue(i)}, index.GetKeySchema()); };
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_TRUE(index.InsertEntry(key(i), RID(i, 0), nullptr));
+  }
+  ASSERT_FALSE(index.InsertEntry(key(0), RID(0, 1), nullptr));
+  for (int i = 0; i < 1000; i += 2) {
+    index.DeleteEntry(key(i), RID(i, 0), nullptr);
+  }
+  EXPECT_GT(index.GetPendingCount(), 0);
+
+  // 缓冲区里的消息刷下去之后再统计,和树里的项对得上
+  index.RefreshStatistics();
+  EXPECT_EQ(index.GetPendingCount(), 0);
+  auto stats = index.GetStatistics(true);
+  ASSERT_TRUE(stats.has_value());
+  EXPECT_EQ(stats->num_entries_, 500);
+  EXPECT_NEAR(stats->GetDistinctKeys(), 500, 25);
+  EXPECT_GT(stats->leaf_pages_, 0);
+  EXPECT_EQ(stats->histogram_bounds_.front().GetAs<int32_t>(), 1);
+  EXPECT_EQ(stats->histogram_bounds_.back().GetAs<int32_t>(), 999);
+}
+
+}  // namespace bustub
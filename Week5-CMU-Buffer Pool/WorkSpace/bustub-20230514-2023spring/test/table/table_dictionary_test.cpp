@@ -0,0 +1,120 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// table_dictionary_test.cpp
+//
+// Identification: test/table/table_dictionary_test.cpp
+//
+//===----------------------------------------------------------------------===//
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/table/table_dictionary.h"
+#include "storage/table/table_heap.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+TEST(TableDictionaryTest, EncodeDecodeTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(8, disk_manager.get());
+  Schema schema({Column("a", TypeId::INTEGER), Column("s", TypeId::VARCHAR, 128), Column("t", TypeId::VARCHAR, 16)});
+  ASSERT_TRUE(TableDictionary::HasEncodableColumns(schema));
+  ASSERT_FALSE(TableDictionary::HasEncodableColumns(Schema({Column("a", TypeId::INTEGER)})));
+  TableDictionary dictionary(bpm.get(), schema);
+  EXPECT_FALSE(dictionary.IsEncoded(0));
+  EXPECT_TRUE(dictionary.IsEncoded(1));
+  EXPECT_EQ(dictionary.GetStoredSchema().GetColumn(1).GetType(), TypeId::INTEGER);
+
+  auto varchar = [](const std::string &s) {
+    return s.empty() ? ValueFactory::GetNullValueByType(TypeId::VARCHAR) : ValueFactory::GetVarcharValue(s);
+  };
+  auto make_tuple = [&](int a, const std::string &s, const std::string &t) {
+    return Tuple({ValueFactory::GetIntegerValue(a), varchar(s), varchar(t)}, &schema);
+  };
+
+  // 两列共用一个字典,同一个字符串是同一个code,NULL还是NULL
+  auto encoded = dictionary.Encode(make_tuple(1, "apple", "apple"));
+  const auto &stored_schema = dictionary.GetStoredSchema();
+  EXPECT_EQ(encoded.GetValue(&stored_schema, 0).GetAs<int32_t>(), 1);
+  EXPECT_EQ(encoded.GetValue(&stored_schema, 1).GetAs<int32_t>(), 0);
+  EXPECT_EQ(encoded.GetValue(&stored_schema, 2).GetAs<int32_t>(), 0);
+  encoded = dictionary.Encode(make_tuple(2, "pear", ""));
+  EXPECT_EQ(encoded.GetValue(&stored_schema, 1).GetAs<int32_t>(), 1);
+  EXPECT_TRUE(encoded.IsNull(&stored_schema, 2));
+  EXPECT_EQ(dictionary.GetNumCodes(), 2);
+  EXPECT_EQ(*dictionary.Lookup(ValueFactory::GetVarcharValue("pear")), 1);
+  EXPECT_EQ(dictionary.Lookup(ValueFactory::GetVarcharValue("plum")), std::nullopt);
+
+  auto decoded = dictionary.Decode(TupleView(encoded));
+  EXPECT_EQ(decoded.GetValue(&schema, 0).GetAs<int32_t>(), 2);
+  EXPECT_EQ(decoded.GetValue(&schema, 1).ToString(), "pear");
+  EXPECT_TRUE(decoded.IsNull(&schema, 2));
+
+  // 字符串多到一页放不下,接着往新的字典页里放,码还是连续的
+  const int num_strings = 200;
+  std::vector<Tuple> tuples;
+  for (int i = 0; i < num_strings; i++) {
+    tuples.push_back(dictionary.Encode(make_tuple(i, std::string(100, 'a' + i % 26) + std::to_string(i), "pear")));
+  }
+  EXPECT_EQ(dictionary.GetNumCodes(), 2 + num_strings);
+  for (int i = 0; i < num_strings; i++) {
+    EXPECT_EQ(tuples[i].GetValue(&stored_schema, 1).GetAs<int32_t>(), 2 + i);
+    auto tuple = dictionary.Decode(TupleView(tuples[i]));
+    EXPECT_EQ(tuple.GetValue(&schema, 1).ToString(), std::string(100, 'a' + i % 26) + std::to_string(i));
+    EXPECT_EQ(tuple.GetValue(&schema, 2).ToString(), "pear");
+  }
+}
+
+TEST(TableDictionaryTest, TableHeapTest) {
+  for (auto layout : {TableLayout::Row, TableLayout::PAX}) {
+    auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+    auto bpm = std::make_unique<BufferPoolManager>(16, disk_manager.get());
+    Schema schema({Column("a", TypeId::INTEGER), Column("s", TypeId::VARCHAR, 64)});
+    TableHeap table(bpm.get(), &schema, layout, TableEncoding::Dictionary);
+    ASSERT_NE(table.GetDictionary(), nullptr);
+    auto make_tuple = [&](int a, const std::string &s) {
+      return Tuple({ValueFactory::GetIntegerValue(a), ValueFactory::GetVarcharValue(s)}, &schema);
+    };
+    const TupleMeta meta{INVALID_TXN_ID, INVALID_TXN_ID, false};
+
+    // 低基数的列只存code,一页能放下的行数不随字符串变长而变少
+    const int num_tuples = 1000;
+    std::vector<RID> rids;
+    for (int i = 0; i < num_tuples; i++) {
+      rids.push_back(*table.InsertTuple(meta, make_tuple(i, std::string(40, 'a' + i % 4))));
+    }
+    EXPECT_EQ(table.GetDictionary()->GetNumCodes(), 4);
+    auto [tuple_meta, tuple] = table.GetTuple(rids[5]);
+    EXPECT_EQ(tuple.GetValue(&schema, 1).ToString(), std::string(40, 'b'));
+    EXPECT_EQ(tuple.GetRid(), rids[5]);
+
+    // 迭代器读出来的是解码以后的行,要编码的行得单独要
+    int count = 0;
+    auto code_of_c = *table.GetDictionary()->Lookup(ValueFactory::GetVarcharValue(std::string(40, 'c')));
+    for (auto it = table.MakeIterator(); !it.IsEnd(); ++it) {
+      auto guard = it.LatchPage();
+      auto [view_meta, view] = it.GetTupleView(guard);
+      auto a = view.GetValue(&schema, 0).GetAs<int32_t>();
+      EXPECT_EQ(view.GetValue(&schema, 1).ToString(), std::string(40, 'a' + a % 4));
+      auto [stored_meta, stored] = it.GetStoredTupleView(guard);
+      auto code = stored.GetValue(&table.GetDictionary()->GetStoredSchema(), 1).GetAs<int32_t>();
+      EXPECT_EQ(code == code_of_c, a % 4 == 2);
+      count++;
+    }
+    EXPECT_EQ(count, num_tuples);
+
+    // 换成字典里没有的字符串也是定长的code,原地就能改
+    ASSERT_TRUE(table.UpdateTupleInPlace(meta, make_tuple(0, "a much longer string than before"), rids[0]));
+    EXPECT_EQ(table.GetTuple(rids[0]).second.GetValue(&schema, 1).ToString(), "a much longer string than before");
+    EXPECT_EQ(table.GetDictionary()->GetNumCodes(), 5);
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,323 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// table_heap_test.cpp
+//
+// Identification: test/table/table_heap_test.cpp
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_set>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/table/free_space_map.h"
+#include "storage/table/table_heap.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+TEST(TableHeapTest, FreeSpaceMapTest) {
+  FreeSpaceMap map;
+  const size_t unit = FreeSpaceMap::CATEGORY_BYTES;
+  for (page_id_t page_id = 0; page_id < 100; page_id++) {
+    map.AddPage(page_id, page_id % 10 == 9 ? unit * 5 + 1 : unit);
+  }
+  // 只有一格空闲的页不会再给出去
+  EXPECT_EQ(map.TakePage(10), 9);
+  EXPECT_EQ(map.GetFreeSpace(9), 0);
+  EXPECT_EQ(map.TakePage(unit * 5), 19);
+  // 按格子向下取整,5格多一点也只算5格
+  EXPECT_EQ(map.TakePage(unit * 5 + 1), INVALID_PAGE_ID);
+  EXPECT_EQ(map.GetFreeSpace(29), unit * 5);
+
+  map.Update(9, BUSTUB_PAGE_SIZE);
+  EXPECT_EQ(map.GetFreeSpace(9), unit * FreeSpaceMap::MAX_CATEGORY);
+  EXPECT_EQ(map.TakePage(unit * 10), 9);
+  for (page_id_t page_id = 29; page_id < 100; page_id += 10) {
+    EXPECT_EQ(map.TakePage(1), page_id);
+  }
+  EXPECT_EQ(map.TakePage(1), INVALID_PAGE_ID);
+}
+
+TEST(TableHeapTest, ConcurrentInsertTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(64, disk_manager.get());
+  TableHeap table(bpm.get());
+  Schema schema({Column("thread", TypeId::INTEGER), Column("i", TypeId::INTEGER)});
+
+  const int num_threads = 8;
+  const int num_tuples = 2000;
+  std::vector<std::vector<RID>> rids(num_threads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < num_tuples; i++) {
+        Tuple tuple({ValueFactory::GetIntegerValue(t), ValueFactory::GetIntegerValue(i)}, &schema);
+        rids[t].push_back(*table.InsertTuple(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, false}, tuple));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  std::unordered_set<RID> all_rids;
+  for (int t = 0; t < num_threads; t++) {
+    for (int i = 0; i < num_tuples; i++) {
+      ASSERT_TRUE(all_rids.insert(rids[t][i]).second);
+      auto tuple = table.GetTuple(rids[t][i]).second;
+      ASSERT_EQ(tuple.GetValue(&schema, 0).GetAs<int32_t>(), t);
+      ASSERT_EQ(tuple.GetValue(&schema, 1).GetAs<int32_t>(), i);
+    }
+  }
+  int count = 0;
+  for (auto iter = table.MakeEagerIterator(); !iter.IsEnd(); ++iter) {
+    EXPECT_EQ(all_rids.count(iter.GetRID()), 1);
+    count++;
+  }
+  EXPECT_EQ(count, num_threads * num_tuples);
+
+  // 并发追加的页也按页号的顺序接在链表上,停在最后一页的迭代器一行不漏
+  auto page_ids = table.GetPageIds();
+  EXPECT_TRUE(std::is_sorted(page_ids.begin(), page_ids.end()));
+  count = 0;
+  for (auto iter = table.MakeIterator(); !iter.IsEnd(); ++iter) {
+    count++;
+  }
+  EXPECT_EQ(count, num_threads * num_tuples);
+
+  // 每个插入页最多剩一页没填满
+  auto tuples_per_page = table.GetPageTuples(rids[0][0].GetPageId()).size();
+  EXPECT_LE(table.GetPageIds().size(), num_threads * num_tuples / tuples_per_page + TABLE_HEAP_INSERT_PAGES + 1);
+}
+
+TEST(TableHeapTest, ReuseFreeSpaceTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(16, disk_manager.get());
+  TableHeap table(bpm.get());
+  Schema schema({Column("s", TypeId::VARCHAR, 4000)});
+  auto make_tuple = [&](size_t length) {
+    return Tuple({ValueFactory::GetVarcharValue(std::string(length, 'x'))}, &schema);
+  };
+  TupleMeta meta{INVALID_TXN_ID, INVALID_TXN_ID, false};
+
+  // 两个1500字节的行占满一页后剩下一千多字节,第三个放不下,换新页
+  auto first = *table.InsertTuple(meta, make_tuple(1500));
+  EXPECT_EQ(table.InsertTuple(meta, make_tuple(1500))->GetPageId(), first.GetPageId());
+  auto third = *table.InsertTuple(meta, make_tuple(1500));
+  EXPECT_NE(third.GetPageId(), first.GetPageId());
+  EXPECT_EQ(table.InsertTuple(meta, make_tuple(1500))->GetPageId(), third.GetPageId());
+  auto fifth = *table.InsertTuple(meta, make_tuple(1500));
+  EXPECT_NE(fifth.GetPageId(), third.GetPageId());
+
+  // 新页写满以后,小的行回填前面剩了空间的页
+  auto big = *table.InsertTuple(meta, make_tuple(2500));
+  EXPECT_EQ(big.GetPageId(), fifth.GetPageId());
+  auto small = *table.InsertTuple(meta, make_tuple(100));
+  EXPECT_EQ(small.GetPageId(), first.GetPageId());
+  EXPECT_EQ(table.GetPageIds().size(), 3);
+}
+
+TEST(TableHeapTest, BulkInsertTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(16, disk_manager.get());
+  Schema schema({Column("v", TypeId::INTEGER), Column("s", TypeId::VARCHAR, 128)});
+  TableHeap table(bpm.get(), &schema);
+  auto make_tuple = [&](int i) {
+    return Tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(std::string(i % 100, 'x'))},
+                 &schema);
+  };
+  TupleMeta meta{INVALID_TXN_ID, INVALID_TXN_ID, false};
+  const int num_tuples = 2000;
+  auto first = *table.InsertTuple(meta, make_tuple(num_tuples));
+
+  // 整批追加到新页上,按顺序一页一页写满,第一页剩的空间不用
+  std::vector<Tuple> tuples;
+  for (int i = 0; i < num_tuples; i++) {
+    tuples.push_back(make_tuple(i));
+  }
+  auto rids = table.BulkInsertTuples(meta, tuples);
+  ASSERT_EQ(rids.size(), num_tuples);
+  EXPECT_NE(rids[0].GetPageId(), first.GetPageId());
+  for (int i = 1; i < num_tuples; i++) {
+    ASSERT_TRUE(rids[i].GetPageId() == rids[i - 1].GetPageId() || rids[i].GetSlotNum() == 0);
+  }
+
+  // 迭代器按插入的顺序读到所有的行
+  int count = 0;
+  for (auto iter = table.MakeIterator(); !iter.IsEnd(); ++iter) {
+    auto [tuple_meta, tuple] = iter.GetTuple();
+    auto i = tuple.GetValue(&schema, 0).GetAs<int32_t>();
+    EXPECT_EQ(i, count == 0 ? num_tuples : count - 1);
+    if (count > 0) {
+      EXPECT_EQ(iter.GetRID(), rids[i]);
+      EXPECT_EQ(tuple.GetValue(&schema, 1).ToString(), std::string(i % 100, 'x'));
+    }
+    count++;
+  }
+  EXPECT_EQ(count, num_tuples + 1);
+
+  // 页上剩下的空间留给之后的逐行插入,不用再开新页
+  auto num_pages = table.GetPageIds().size();
+  table.InsertTuple(meta, make_tuple(0));
+  EXPECT_EQ(table.GetPageIds().size(), num_pages);
+}
+
+TEST(TableHeapTest, UpdateInPlaceTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(16, disk_manager.get());
+  Schema schema({Column("v", TypeId::INTEGER), Column("s", TypeId::VARCHAR, 16)});
+  auto make_tuple = [&](int v, const std::string &s) {
+    return Tuple({ValueFactory::GetIntegerValue(v), ValueFactory::GetVarcharValue(s)}, &schema);
+  };
+  TupleMeta meta{INVALID_TXN_ID, INVALID_TXN_ID, false};
+  for (auto layout : {TableLayout::Row, TableLayout::PAX}) {
+    TableHeap table(bpm.get(), &schema, layout);
+    auto rid = *table.InsertTuple(meta, make_tuple(1, "abc"));
+
+    // 大小不变就在原地改,rid不变
+    ASSERT_TRUE(table.UpdateTupleInPlace(meta, make_tuple(2, "xyz"), rid));
+    EXPECT_EQ(table.GetTuple(rid).second.GetValue(&schema, 0).GetAs<int32_t>(), 2);
+    EXPECT_EQ(table.GetTuple(rid).second.GetValue(&schema, 1).ToString(), "xyz");
+
+    // 变长以后放不下,原来的tuple不动
+    ASSERT_FALSE(table.UpdateTupleInPlace(meta, make_tuple(3, "longer"), rid));
+    EXPECT_EQ(table.GetTuple(rid).second.GetValue(&schema, 0).GetAs<int32_t>(), 2);
+    EXPECT_EQ(table.GetTuple(rid).second.GetValue(&schema, 1).ToString(), "xyz");
+    EXPECT_FALSE(table.UpdateTupleInPlace(meta, make_tuple(3, "xyz"), RID(rid.GetPageId(), rid.GetSlotNum() + 1)));
+  }
+}
+
+TEST(TableHeapTest, VacuumTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(16, disk_manager.get());
+  TableHeap table(bpm.get());
+  Schema schema({Column("a", TypeId::INTEGER), Column("b", TypeId::INTEGER)});
+  auto make_tuple = [&](int i) {
+    return Tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetIntegerValue(i * 2)}, &schema);
+  };
+
+  const int num_tuples = 3000;
+  std::vector<RID> rids;
+  for (int i = 0; i < num_tuples; i++) {
+    rids.push_back(*table.InsertTuple(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, false}, make_tuple(i)));
+  }
+  auto num_pages = table.GetPageIds().size();
+  // 删掉前面一半里的奇数行和后面的一半,后面的页整页都空了
+  for (int i = 0; i < num_tuples; i++) {
+    if (i >= num_tuples / 2 || i % 2 == 1) {
+      table.UpdateTupleMeta(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, true}, rids[i]);
+    }
+  }
+
+  std::unordered_set<RID> reclaimed;
+  auto result = table.Vacuum([&](const Tuple &tuple, RID rid) {
+    EXPECT_EQ(rids[tuple.GetValue(&schema, 0).GetAs<int32_t>()], rid);
+    reclaimed.insert(rid);
+  });
+  EXPECT_EQ(result.tuples_, num_tuples * 3 / 4);
+  EXPECT_EQ(reclaimed.size(), result.tuples_);
+  EXPECT_GT(result.bytes_, 0);
+  EXPECT_GE(result.pages_emptied_, num_pages / 2 - 1);
+  EXPECT_EQ(table.GetPageIds().size(), num_pages);
+
+  // 活着的行rid不变
+  int count = 0;
+  for (auto iter = table.MakeIterator(); !iter.IsEnd(); ++iter) {
+    auto [meta, tuple] = iter.GetTuple();
+    if (meta.is_deleted_) {
+      continue;
+    }
+    auto i = tuple.GetValue(&schema, 0).GetAs<int32_t>();
+    EXPECT_EQ(iter.GetRID(), rids[i]);
+    EXPECT_EQ(tuple.GetValue(&schema, 1).GetAs<int32_t>(), i * 2);
+    count++;
+  }
+  EXPECT_EQ(count, num_tuples / 4);
+
+  // 再压一遍没有可回收的了
+  EXPECT_EQ(table.Vacuum([](const Tuple &, RID) { FAIL(); }).tuples_, 0);
+
+  // 腾出来的空间先被填上,表不会变长
+  for (int i = 0; i < num_tuples / 2; i++) {
+    table.InsertTuple(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, false}, make_tuple(i));
+  }
+  EXPECT_EQ(table.GetPageIds().size(), num_pages);
+}
+
+TEST(TableHeapTest, PaxLayoutTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(16, disk_manager.get());
+  Schema schema({Column("a", TypeId::INTEGER), Column("s", TypeId::VARCHAR, 64), Column("b", TypeId::BIGINT),
+                 Column("t", TypeId::VARCHAR, 16)});
+  TableHeap table(bpm.get(), &schema, TableLayout::PAX);
+  ASSERT_EQ(table.GetLayout(), TableLayout::PAX);
+  auto make_tuple = [&](int i) {
+    auto s = i % 7 == 0 ? ValueFactory::GetNullValueByType(TypeId::VARCHAR)
+                        : ValueFactory::GetVarcharValue(std::string(i % 50, 'a' + i % 26));
+    auto b = i % 5 == 0 ? ValueFactory::GetNullValueByType(TypeId::BIGINT) : ValueFactory::GetBigIntValue(i * 3);
+    return Tuple({ValueFactory::GetIntegerValue(i), s, b, ValueFactory::GetVarcharValue(std::to_string(i))}, &schema);
+  };
+
+  const int num_tuples = 2000;
+  std::vector<RID> rids;
+  for (int i = 0; i < num_tuples; i++) {
+    rids.push_back(*table.InsertTuple(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, false}, make_tuple(i)));
+  }
+  // 整行读出来和插进去的一模一样
+  for (int i = 0; i < num_tuples; i++) {
+    auto tuple = table.GetTuple(rids[i]).second;
+    auto expected = make_tuple(i);
+    ASSERT_EQ(std::string(tuple.GetData(), tuple.GetLength()), std::string(expected.GetData(), expected.GetLength()));
+  }
+
+  // 只读两列,别的列是NULL
+  std::vector<uint32_t> columns{0, 3};
+  int count = 0;
+  for (auto iter = table.MakeIterator(); !iter.IsEnd(); ++iter) {
+    auto tuple = iter.GetTuple(&columns).second;
+    auto i = tuple.GetValue(&schema, 0).GetAs<int32_t>();
+    EXPECT_EQ(iter.GetRID(), rids[i]);
+    EXPECT_EQ(tuple.GetValue(&schema, 3).ToString(), std::to_string(i));
+    EXPECT_TRUE(tuple.IsNull(&schema, 1));
+    EXPECT_TRUE(tuple.IsNull(&schema, 2));
+    count++;
+  }
+  EXPECT_EQ(count, num_tuples);
+
+  // 原地更新:变长的值不能比原来长
+  table.UpdateTupleInPlaceUnsafe(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, false},
+                                 Tuple({ValueFactory::GetIntegerValue(-1), ValueFactory::GetVarcharValue(""),
+                                        ValueFactory::GetBigIntValue(7), ValueFactory::GetVarcharValue("1")},
+                                       &schema),
+                                 rids[1]);
+  EXPECT_EQ(table.GetTuple(rids[1]).second.GetValue(&schema, 0).GetAs<int32_t>(), -1);
+  EXPECT_THROW(
+      table.UpdateTupleInPlaceUnsafe(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, false}, make_tuple(49), rids[1]),
+      Exception);
+
+  // 删掉一半,vacuum以后剩下的行rid不变,数据也不变
+  for (int i = 0; i < num_tuples; i += 2) {
+    table.UpdateTupleMeta(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, true}, rids[i]);
+  }
+  auto result = table.Vacuum([](const Tuple &, RID) {});
+  EXPECT_EQ(result.tuples_, num_tuples / 2);
+  EXPECT_GT(result.bytes_, 0);
+  for (int i = 3; i < num_tuples; i += 2) {
+    auto [meta, tuple] = table.GetTuple(rids[i]);
+    auto expected = make_tuple(i);
+    ASSERT_FALSE(meta.is_deleted_);
+    ASSERT_EQ(std::string(tuple.GetData(), tuple.GetLength()), std::string(expected.GetData(), expected.GetLength()));
+  }
+  EXPECT_EQ(table.Vacuum([](const Tuple &, RID) { FAIL(); }).tuples_, 0);
+}
+
+}  // namespace bustub
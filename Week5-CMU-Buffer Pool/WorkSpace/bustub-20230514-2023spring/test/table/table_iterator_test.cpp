@@ -0,0 +1,83 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// table_iterator_test.cpp
+//
+// Identification: test/table/table_iterator_test.cpp
+//
+//===----------------------------------------------------------------------===//
+
+#include <memory>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/table/table_heap.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+TEST(TableIteratorTest, PinsOnePageAtATime) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  // 缓冲池比表小得多,迭代器如果不放掉走过的页,后面的页就换不进来
+  const size_t pool_size = 4;
+  auto bpm = std::make_unique<BufferPoolManager>(pool_size, disk_manager.get());
+  TableHeap table(bpm.get());
+  Schema schema({Column("a", TypeId::INTEGER), Column("b", TypeId::INTEGER)});
+
+  const int num_tuples = 3000;
+  std::vector<RID> rids;
+  for (int i = 0; i < num_tuples; i++) {
+    Tuple tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetIntegerValue(i * 2)}, &schema);
+    rids.push_back(*table.InsertTuple(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, i % 3 == 0}, tuple));
+  }
+  ASSERT_GT(table.GetPageIds().size(), pool_size * 2);
+
+  {
+    // 两个迭代器同时扫,各自pin着一页
+    auto first = table.MakeIterator();
+    auto second = table.MakeEagerIterator();
+    int count = 0;
+    for (; !first.IsEnd(); ++first, ++second) {
+      ASSERT_FALSE(second.IsEnd());
+      ASSERT_EQ(first.GetRID(), rids[count]);
+      auto [meta, tuple] = first.GetTuple();
+      EXPECT_EQ(meta.is_deleted_, count % 3 == 0);
+      EXPECT_EQ(first.GetTupleMeta().is_deleted_, meta.is_deleted_);
+      EXPECT_EQ(tuple.GetValue(&schema, 1).GetAs<int32_t>(), count * 2);
+      EXPECT_EQ(tuple.GetRid(), rids[count]);
+      EXPECT_EQ(second.GetTuple().second.GetValue(&schema, 0).GetAs<int32_t>(), count);
+      count++;
+    }
+    EXPECT_EQ(count, num_tuples);
+    EXPECT_TRUE(second.IsEnd());
+  }
+
+  // 迭代器不拿锁,扫描的同时可以改当前页;eager的迭代器还能看到扫描期间追加的行
+  auto iter = table.MakeEagerIterator();
+  auto moved = std::move(iter);
+  int count = 0;
+  for (; !moved.IsEnd(); ++moved) {
+    table.UpdateTupleMeta(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, true}, moved.GetRID());
+    EXPECT_TRUE(moved.GetTupleMeta().is_deleted_);
+    if (count == num_tuples - 1) {
+      Tuple tuple({ValueFactory::GetIntegerValue(-1), ValueFactory::GetIntegerValue(-1)}, &schema);
+      table.InsertTuple(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, false}, tuple);
+    }
+    count++;
+  }
+  EXPECT_EQ(count, num_tuples + 1);
+
+  // 所有的pin都放掉了,整个缓冲池都能换出去
+  std::vector<page_id_t> new_pages(pool_size);
+  for (auto &page_id : new_pages) {
+    ASSERT_NE(bpm->NewPage(&page_id), nullptr);
+  }
+  for (auto page_id : new_pages) {
+    bpm->UnpinPage(page_id, false);
+  }
+}
+
+}  // namespace bustub
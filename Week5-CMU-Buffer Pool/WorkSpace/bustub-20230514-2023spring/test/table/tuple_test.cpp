@@ -20,7 +20,10 @@
 #include "gtest/gtest.h"
 #include "logging/common.h"
 #include "storage/table/table_heap.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/index/generic_key.h"
 #include "storage/table/tuple.h"
+#include "type/value_factory.h"
 
 namespace bustub {
 // NOLINTNEXTLINE
@@ -61,4 +64,119 @@ TEST(TupleTest, DISABLED_TableHeapTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(TupleTest, NullBitmapTest) {
+  Schema schema({Column("a", TypeId::INTEGER), Column("s", TypeId::VARCHAR, 16), Column("b", TypeId::BIGINT),
+                 Column("t", TypeId::VARCHAR, 16)});
+  ASSERT_EQ(schema.GetLength(), 4 + 2 + 8 + 2);
+  ASSERT_EQ(Tuple::GetNullBitmapSize(&schema), 1);
+
+  // NULL的VARCHAR只占位图里的一位,不为空的带2字节长度
+  Tuple nulls({ValueFactory::GetNullValueByType(TypeId::INTEGER), ValueFactory::GetNullValueByType(TypeId::VARCHAR),
+               ValueFactory::GetNullValueByType(TypeId::BIGINT), ValueFactory::GetNullValueByType(TypeId::VARCHAR)},
+              &schema);
+  EXPECT_EQ(nulls.GetLength(), schema.GetLength() + 1);
+  for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+    EXPECT_TRUE(nulls.IsNull(&schema, i));
+    EXPECT_TRUE(nulls.GetValue(&schema, i).IsNull());
+    EXPECT_EQ(nulls.GetValue(&schema, i).GetTypeId(), schema.GetColumn(i).GetType());
+  }
+
+  Tuple tuple({ValueFactory::GetIntegerValue(1), ValueFactory::GetNullValueByType(TypeId::VARCHAR),
+               ValueFactory::GetBigIntValue(2), ValueFactory::GetVarcharValue("abc")},
+              &schema);
+  EXPECT_EQ(tuple.GetLength(), schema.GetLength() + 1 + 2 + 4);
+  EXPECT_FALSE(tuple.IsNull(&schema, 0));
+  EXPECT_TRUE(tuple.IsNull(&schema, 1));
+  EXPECT_FALSE(tuple.IsNull(&schema, 2));
+  EXPECT_FALSE(tuple.IsNull(&schema, 3));
+  EXPECT_EQ(tuple.GetValue(&schema, 0).GetAs<int32_t>(), 1);
+  EXPECT_EQ(tuple.GetValue(&schema, 2).GetAs<int64_t>(), 2);
+  EXPECT_EQ(tuple.GetValue(&schema, 3).ToString(), "abc");
+
+  // key连着位图一起存,存下来的NULL带NULL标记,排在所有值前面;查找边界去掉标记的NULL和什么都相等
+  Schema key_schema({Column("a", TypeId::INTEGER)});
+  Tuple null_key({ValueFactory::GetNullValueByType(TypeId::INTEGER)}, &key_schema);
+  ASSERT_EQ(null_key.GetLength(), 5);
+  GenericKey<8> key;
+  key.SetFromKey(null_key);
+  EXPECT_TRUE(key.ToValue(&key_schema, 0).IsNull());
+  EXPECT_TRUE(key.HasNullFlag(key_schema.GetLength(), 0));
+  GenericKey<8> value_key;
+  value_key.SetFromKey(Tuple({ValueFactory::GetIntegerValue(-5)}, &key_schema));
+  GenericComparator<8> comparator(&key_schema);
+  EXPECT_LT(comparator(key, value_key), 0);
+  EXPECT_EQ(comparator(key, key), 0);
+  GenericKey<8> bound_key = key;
+  bound_key.SetNullsAsWildcards(key_schema);
+  EXPECT_TRUE(bound_key.ToValue(&key_schema, 0).IsNull());
+  EXPECT_EQ(comparator(value_key, bound_key), 0);
+  EXPECT_EQ(comparator(key, bound_key), 0);
+  Schema varchar_key_schema({Column("s", TypeId::VARCHAR, 8), Column("a", TypeId::INTEGER)});
+  Tuple varchar_key({ValueFactory::GetNullValueByType(TypeId::VARCHAR), ValueFactory::GetIntegerValue(7)},
+                    &varchar_key_schema);
+  GenericKey<16> key16;
+  key16.SetFromKey(varchar_key);
+  EXPECT_TRUE(key16.ToValue(&varchar_key_schema, 0).IsNull());
+  EXPECT_EQ(key16.ToValue(&varchar_key_schema, 1).GetAs<int32_t>(), 7);
+  varchar_key = Tuple({ValueFactory::GetVarcharValue("xy"), ValueFactory::GetIntegerValue(7)}, &varchar_key_schema);
+  key16.SetFromKey(varchar_key);
+  EXPECT_EQ(key16.ToValue(&varchar_key_schema, 0).ToString(), "xy");
+}
+
+// NOLINTNEXTLINE
+TEST(TupleTest, TupleViewTest) {
+  Schema schema({Column("a", TypeId::INTEGER), Column("s", TypeId::VARCHAR, 16), Column("b", TypeId::BIGINT)});
+  auto make_tuple = [&](int i) {
+    return Tuple({ValueFactory::GetIntegerValue(i),
+                  i % 2 == 0 ? ValueFactory::GetVarcharValue(std::to_string(i))
+                             : ValueFactory::GetNullValueByType(TypeId::VARCHAR),
+                  ValueFactory::GetBigIntValue(i * 10)},
+                 &schema);
+  };
+
+  // 视图读出来的值和Tuple一样,VARCHAR直接指着视图里的数据
+  auto tuple = make_tuple(42);
+  TupleView view(tuple);
+  EXPECT_EQ(view.GetValue(&schema, 0).GetAs<int32_t>(), 42);
+  EXPECT_EQ(view.GetValue(&schema, 2).GetAs<int64_t>(), 420);
+  auto s = view.GetValue(&schema, 1);
+  EXPECT_EQ(s.ToString(), "42");
+  EXPECT_GE(s.GetData(), tuple.GetData());
+  EXPECT_LT(s.GetData(), tuple.GetData() + tuple.GetLength());
+  EXPECT_TRUE(TupleView(make_tuple(1)).GetValue(&schema, 1).IsNull());
+  auto copy = view.Materialize();
+  EXPECT_NE(copy.GetData(), tuple.GetData());
+  ASSERT_EQ(copy.GetLength(), tuple.GetLength());
+  EXPECT_EQ(memcmp(copy.GetData(), tuple.GetData(), tuple.GetLength()), 0);
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(16, disk_manager.get());
+  for (auto layout : {TableLayout::Row, TableLayout::PAX}) {
+    TableHeap table(bpm.get(), &schema, layout);
+    const int num_tuples = 1000;
+    for (int i = 0; i < num_tuples; i++) {
+      table.InsertTuple(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, false}, make_tuple(i));
+    }
+    // 迭代器上的视图和GetTuple读到的一样,行表的视图指着页,PAX表的指着迭代器的缓冲区
+    auto it = table.MakeIterator();
+    int i = 0;
+    for (; !it.IsEnd(); ++it, ++i) {
+      auto [meta, expected] = it.GetTuple();
+      auto page_guard = it.LatchPage();
+      auto [view_meta, view] = it.GetTupleView(page_guard);
+      EXPECT_EQ(view_meta.is_deleted_, meta.is_deleted_);
+      EXPECT_EQ(view.GetRid(), it.GetRID());
+      ASSERT_EQ(view.GetLength(), expected.GetLength());
+      EXPECT_EQ(memcmp(view.GetData(), expected.GetData(), expected.GetLength()), 0);
+      if (layout == TableLayout::Row) {
+        EXPECT_GE(view.GetData(), page_guard.GetData());
+        EXPECT_LT(view.GetData(), page_guard.GetData() + BUSTUB_PAGE_SIZE);
+      }
+      EXPECT_EQ(view.Materialize().GetValue(&schema, 0).GetAs<int32_t>(), i);
+    }
+    EXPECT_EQ(i, num_tuples);
+  }
+}
+
 }  // namespace bustub
@@ -0,0 +1,109 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// zone_map_test.cpp
+//
+// Identification: test/table/zone_map_test.cpp
+//
+//===----------------------------------------------------------------------===//
+
+#include <memory>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/table/table_heap.h"
+#include "storage/table/zone_map.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+TEST(ZoneMapTest, RangeTest) {
+  Schema schema({Column("a", TypeId::INTEGER), Column("s", TypeId::VARCHAR, 16), Column("b", TypeId::BIGINT)});
+  ASSERT_TRUE(ZoneMap::HasTrackedColumns(schema));
+  ASSERT_FALSE(ZoneMap::HasTrackedColumns(Schema({Column("s", TypeId::VARCHAR, 16)})));
+  ZoneMap zone_map(schema);
+  auto add = [&](page_id_t page_id, int a, int64_t b) {
+    zone_map.Add(page_id, Tuple({ValueFactory::GetIntegerValue(a), ValueFactory::GetVarcharValue("x"),
+                                 b < 0 ? ValueFactory::GetNullValueByType(TypeId::BIGINT)
+                                       : ValueFactory::GetBigIntValue(b)},
+                                &schema));
+  };
+  add(1, 10, 100);
+  add(1, 20, -1);
+  add(1, 15, 300);
+  add(2, 30, -1);
+
+  auto v = [](int i) { return ValueFactory::GetIntegerValue(i); };
+  auto v5 = v(5);
+  auto v10 = v(10);
+  auto v20 = v(20);
+  auto v21 = v(21);
+  auto v200 = v(200);
+  auto v301 = v(301);
+  EXPECT_TRUE(zone_map.MayContain(1, 0, &v10, true, &v10, true));
+  EXPECT_FALSE(zone_map.MayContain(1, 0, &v5, true, &v5, true));
+  EXPECT_FALSE(zone_map.MayContain(1, 0, nullptr, true, &v10, false));
+  EXPECT_TRUE(zone_map.MayContain(1, 0, &v20, true, nullptr, true));
+  EXPECT_FALSE(zone_map.MayContain(1, 0, &v20, false, nullptr, true));
+  EXPECT_FALSE(zone_map.MayContain(1, 0, &v21, true, nullptr, true));
+  // BIGINT列和INTEGER常量照样能比,NULL不算进范围
+  EXPECT_TRUE(zone_map.MayContain(1, 2, &v200, true, &v200, true));
+  EXPECT_FALSE(zone_map.MayContain(1, 2, &v301, true, nullptr, true));
+  EXPECT_FALSE(zone_map.MayContain(2, 2, nullptr, true, &v301, true));
+  // 不记的列、不是数值的常量、没记过的页都不能跳
+  auto s = ValueFactory::GetVarcharValue("y");
+  EXPECT_TRUE(zone_map.MayContain(1, 1, &s, true, &s, true));
+  EXPECT_TRUE(zone_map.MayContain(1, 0, &s, true, &s, true));
+  EXPECT_TRUE(zone_map.MayContain(3, 0, &v5, true, &v5, true));
+
+  zone_map.Reset(1);
+  EXPECT_FALSE(zone_map.MayContain(1, 0, &v10, true, &v10, true));
+  add(1, 5, 1);
+  EXPECT_TRUE(zone_map.MayContain(1, 0, &v5, true, &v5, true));
+  EXPECT_FALSE(zone_map.MayContain(1, 0, &v10, true, &v10, true));
+}
+
+TEST(ZoneMapTest, TableHeapTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(16, disk_manager.get());
+  Schema schema({Column("ts", TypeId::BIGINT), Column("v", TypeId::INTEGER)});
+  TableHeap table(bpm.get(), &schema);
+  ASSERT_NE(table.GetZoneMap(), nullptr);
+  auto make_tuple = [&](int64_t ts) {
+    return Tuple({ValueFactory::GetBigIntValue(ts), ValueFactory::GetIntegerValue(0)}, &schema);
+  };
+
+  // 按时间顺序追加,每页的范围互不重叠
+  const int num_tuples = 5000;
+  std::vector<RID> rids;
+  for (int64_t ts = 0; ts < num_tuples; ts++) {
+    rids.push_back(*table.InsertTuple(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, false}, make_tuple(ts)));
+  }
+  auto page_ids = table.GetPageIds();
+  ASSERT_GT(page_ids.size(), 10);
+  auto low = ValueFactory::GetIntegerValue(num_tuples - 100);
+  size_t matching_pages = 0;
+  for (auto page_id : page_ids) {
+    matching_pages += table.GetZoneMap()->MayContain(page_id, 0, &low, true, nullptr, true) ? 1 : 0;
+  }
+  EXPECT_LE(matching_pages, 2);
+  EXPECT_TRUE(table.GetZoneMap()->MayContain(rids.back().GetPageId(), 0, &low, true, nullptr, true));
+
+  // 原地更新只会把范围撑大
+  auto first_page = rids[0].GetPageId();
+  EXPECT_FALSE(table.GetZoneMap()->MayContain(first_page, 0, &low, true, nullptr, true));
+  table.UpdateTupleInPlaceUnsafe(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, false}, make_tuple(num_tuples), rids[0]);
+  EXPECT_TRUE(table.GetZoneMap()->MayContain(first_page, 0, &low, true, nullptr, true));
+
+  // 删掉以后vacuum,范围按剩下的行重算
+  table.UpdateTupleMeta(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, true}, rids[0]);
+  table.Vacuum([](const Tuple &, RID) {});
+  EXPECT_FALSE(table.GetZoneMap()->MayContain(first_page, 0, &low, true, nullptr, true));
+  auto one = ValueFactory::GetIntegerValue(1);
+  EXPECT_TRUE(table.GetZoneMap()->MayContain(first_page, 0, &one, true, &one, true));
+}
+
+}  // namespace bustub